@@ -1,9 +1,25 @@
+#include "ble_lifecycle.h"
 #include "common_macros.h"
+#include "commissioning_trace.h"
+#include "deferred_log.h"
+#include "device_config.h"
+#include "event_loop_monitor.h"
+#include "latency_stats.h"
+#include "model_arena.h"
+#include "ota_update.h"
+#include "power_manager.h"
+#include "report_throttle.h"
+#include "thread_diagnostics.h"
 #include "generated_config.h"
 #include "device_modules/device_module.h"
 #include "device_modules/light/light_module.h"
+#include "device_modules/sensor/sensor_module.h"
 #include "device_modules/switch/switch_module.h"
+#include "device_modules/common/bound_client.h"
 #include "device_modules/common/button_module.h"
+#include "device_modules/common/encoder_module.h"
+#include "device_modules/common/lp_buttons.h"
+#include "device_modules/common/rule_engine.h"
 
 #include <esp_err.h>
 #include <esp_log.h>
@@ -14,6 +30,9 @@
 #include <esp_matter_cluster.h>
 #include <esp_matter_data_model.h>
 #include <esp_matter_providers.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
 #include <app-common/zap-generated/cluster-objects.h>
 
 #include <freertos/FreeRTOS.h>
@@ -37,7 +56,6 @@ using namespace esp_matter::endpoint;
 
 // Log tag
 static const char *TAG = "APP_MAIN";
-constexpr uint32_t kMainLoopDelayMs = 10000;
 
 #if CONFIG_CUSTOM_DEVICE_INSTANCE_INFO_PROVIDER
 namespace {
@@ -121,6 +139,7 @@ namespace {
 const DeviceModule *const kAvailableModules[] = {
     &device_modules::light::kModule,
     &device_modules::switch_module::kModule,
+    &device_modules::sensor::kModule,
 };
 
 constexpr size_t kAvailableModuleCount = sizeof(kAvailableModules) / sizeof(kAvailableModules[0]);
@@ -133,8 +152,8 @@ void detect_enabled_modules()
         g_module_enabled[idx] = false;
         g_module_handles[idx] = nullptr;
     }
-    for (size_t ep_idx = 0; ep_idx < generated_config::num_endpoints; ++ep_idx) {
-        const auto &ep = generated_config::endpoints[ep_idx];
+    for (size_t ep_idx = 0; ep_idx < device_config::endpoint_count(); ++ep_idx) {
+        const auto &ep = device_config::endpoint(ep_idx);
         for (size_t mod_idx = 0; mod_idx < kAvailableModuleCount; ++mod_idx) {
             if (g_module_enabled[mod_idx]) {
                 continue;
@@ -160,8 +179,8 @@ bool module_is_enabled(const DeviceModule *module)
 
 const generated_config::endpoint_raw *find_endpoint_config(uint16_t endpoint_id)
 {
-    for (size_t idx = 0; idx < generated_config::num_endpoints; ++idx) {
-        const auto &config = generated_config::endpoints[idx];
+    for (size_t idx = 0; idx < device_config::endpoint_count(); ++idx) {
+        const auto &config = device_config::endpoint(idx);
         if (config.id == endpoint_id) {
             return &config;
         }
@@ -202,8 +221,14 @@ void app_event_cb(const chip::DeviceLayer::ChipDeviceEvent *event, intptr_t arg)
 // --- Main function ---
 extern "C" void app_main(void)
 {
-    ESP_LOGI(TAG, "Starting Matter Application with device type: %s", generated_config::device_type);
-    esp_err_t err_esp = ESP_OK;
+    esp_err_t err_esp = deferred_log::init();
+    if (err_esp != ESP_OK) {
+        ESP_LOGW(TAG, "Deferred logging unavailable; hot-path logs stay synchronous.");
+    }
+
+    err_esp = device_config::init();
+    ABORT_APP_ON_FAILURE(err_esp == ESP_OK, ESP_LOGE(TAG, "Failed to load device configuration"));
+    ESP_LOGI(TAG, "Starting Matter Application with device type: %s", device_config::device().device_type);
 
     // 1. Initialize NVS (non-volatile storage)
     err_esp = nvs_flash_init();
@@ -215,6 +240,9 @@ extern "C" void app_main(void)
     }
     ABORT_APP_ON_FAILURE(err_esp == ESP_OK, ESP_LOGE(TAG, "Failed to initialize NVS: %s", esp_err_to_name(err_esp)));
     ESP_LOGI(TAG, "NVS Initialized.");
+    commissioning_trace::init();
+    power_manager::init();
+    ota_update::init();
 
     // 2. Initialize hardware drivers
     ESP_LOGI(TAG, "Initializing application drivers...");
@@ -244,7 +272,7 @@ extern "C" void app_main(void)
         }
     }
 
-    if (BUTTON_COUNT > 0) {
+    if (device_config::button_count() > 0) {
         app_driver_handle_t button_handle = device_modules::button::init();
         if (!primary_driver_handle && button_handle) {
             primary_driver_handle = button_handle;
@@ -252,6 +280,13 @@ extern "C" void app_main(void)
     } else {
         ESP_LOGI(TAG, "Button module disabled by configuration.");
     }
+
+    if (device_config::encoder_count() > 0) {
+        app_driver_handle_t encoder_handle = device_modules::encoder::init();
+        if (!primary_driver_handle && encoder_handle) {
+            primary_driver_handle = encoder_handle;
+        }
+    }
     ESP_LOGI(TAG, "Application drivers initialized.");
 
 #if CONFIG_CUSTOM_DEVICE_INSTANCE_INFO_PROVIDER
@@ -260,6 +295,7 @@ extern "C" void app_main(void)
 
     // 3. Create the Matter node
     ESP_LOGI(TAG, "Creating Matter node...");
+    model_arena::begin();
     node::config_t node_config;
     node_t *node = node::create(&node_config, app_attribute_update_cb, app_identification_cb, primary_driver_handle);
     ABORT_APP_ON_FAILURE(node != nullptr, ESP_LOGE(TAG, "Failed to create Matter node"));
@@ -267,10 +303,10 @@ extern "C" void app_main(void)
 
     // 4. Create endpoints from generated config
     ESP_LOGI(TAG, "Creating endpoints from generated configuration...");
-    ABORT_APP_ON_FAILURE(generated_config::num_endpoints > 0, ESP_LOGE(TAG, "No endpoints defined in config.yaml"));
+    ABORT_APP_ON_FAILURE(device_config::endpoint_count() > 0, ESP_LOGE(TAG, "No endpoints defined in config.yaml"));
 
-    for (int i = 0; i < generated_config::num_endpoints; ++i) {
-        const auto &ep_config = generated_config::endpoints[i];
+    for (size_t i = 0; i < device_config::endpoint_count(); ++i) {
+        const auto &ep_config = device_config::endpoint(i);
         ESP_LOGI(TAG, "Creating endpoint %d: type='%s'", ep_config.id, ep_config.device_type);
 
         size_t module_index = 0;
@@ -292,6 +328,8 @@ extern "C" void app_main(void)
 
         ESP_LOGI(TAG, "Endpoint %d created with ID: %u", ep_config.id, endpoint_id);
     }
+    model_arena::end();
+    model_arena::log_stats();
 
 #if CHIP_DEVICE_CONFIG_ENABLE_THREAD
     ESP_LOGI(TAG, "Configuring OpenThread platform...");
@@ -304,8 +342,8 @@ extern "C" void app_main(void)
         },
         .port_config = {
             .storage_partition_name = "nvs",
-            .netif_queue_size = 10,
-            .task_queue_size = 10,
+            .netif_queue_size = APP_OT_NETIF_QUEUE_SIZE,
+            .task_queue_size = APP_OT_TASK_QUEUE_SIZE,
         },
     };
     set_openthread_platform_config(&ot_config);
@@ -322,6 +360,27 @@ extern "C" void app_main(void)
     ABORT_APP_ON_FAILURE(err_esp == ESP_OK, ESP_LOGE(TAG, "Failed to start Matter stack: %s", esp_err_to_name(err_esp)));
 
     ESP_LOGI(TAG, "Matter stack started successfully.");
+    ble_lifecycle::start();
+    thread_diagnostics::start();
+    power_manager::start();
+
+#if CONFIG_ENABLE_CHIP_SHELL
+    latency_stats::register_commands();
+    event_loop_monitor::register_commands();
+    device_modules::bound_client::register_commands();
+    device_modules::button::register_commands();
+    commissioning_trace::register_commands();
+    ble_lifecycle::register_commands();
+    thread_diagnostics::register_commands();
+    power_manager::register_commands();
+    report_throttle::register_commands();
+    ota_update::register_commands();
+    device_modules::light::register_commands();
+    device_modules::lp_buttons::register_commands();
+    device_modules::rules::register_commands();
+    device_modules::sensor::register_commands();
+    esp_matter::console::init();
+#endif
 
     // 7. Allow modules to apply post-start defaults
     ESP_LOGI(TAG, "Applying post-start actions for active modules...");
@@ -334,22 +393,18 @@ extern "C" void app_main(void)
             module->apply_post_stack_start();
         }
     }
+    device_modules::rules::start();
 
     // 8. Log device configuration
     ESP_LOGI(TAG, "Device ready. Logging configuration...");
     chip::DeviceLayer::ConfigurationMgr().LogDeviceConfig();
 
-    ESP_LOGI(TAG, "Setup complete. Entering main loop.");
+    ESP_LOGI(TAG, "Setup complete. Monitoring the Matter event loop.");
 
-    // 9. Main loop (FreeRTOS task)
-    while (true)
-    {
-        vTaskDelay(pdMS_TO_TICKS(kMainLoopDelayMs));
-    }
+    // 9. Main loop: probe CHIP event-loop responsiveness (never returns)
+    event_loop_monitor::run();
 }
 
-// --- Callback Implementations (unchanged) ---
-
 esp_err_t app_attribute_update_cb(esp_matter::attribute::callback_type_t type,
                                   uint16_t endpoint_id,
                                   uint32_t cluster_id,
@@ -357,9 +412,15 @@ esp_err_t app_attribute_update_cb(esp_matter::attribute::callback_type_t type,
                                   esp_matter_attr_val_t *val,
                                   void * /*priv_data*/)
 {
+    if (type == esp_matter::attribute::POST_UPDATE) {
+        device_modules::rules::on_attribute_changed(endpoint_id, cluster_id, attribute_id, *val);
+        return ESP_OK;
+    }
     if (type != esp_matter::attribute::PRE_UPDATE) {
         return ESP_OK;
     }
+    latency_stats::Scope scope(latency_stats::Probe::AttributeUpdateCb);
+    event_loop_monitor::Activity activity("attribute_update");
 
     const auto *config = find_endpoint_config(endpoint_id);
     if (!config) {
@@ -373,6 +434,7 @@ esp_err_t app_attribute_update_cb(esp_matter::attribute::callback_type_t type,
     }
 
     app_driver_handle_t driver_handle = g_module_handles[module_index];
+    latency_stats::Scope module_scope(latency_stats::Probe::ModuleAttributeUpdate);
     return module->attribute_update(driver_handle, endpoint_id, cluster_id, attribute_id, val);
 }
 
@@ -388,6 +450,8 @@ esp_err_t app_identification_cb(identification::callback_type_t type, uint16_t e
     const DeviceModule *module = find_module_for_endpoint(*config, &module_index);
     if (module && module->perform_identification) {
         app_driver_handle_t driver_handle = g_module_handles[module_index];
+        latency_stats::Scope scope(latency_stats::Probe::Identification);
+        event_loop_monitor::Activity activity("identification");
         module->perform_identification(driver_handle, type, effect_id);
     }
     return ESP_OK;
@@ -397,6 +461,9 @@ void app_event_cb(const chip::DeviceLayer::ChipDeviceEvent *event, intptr_t arg)
 {
     if (event)
     {
+        commissioning_trace::on_device_event(*event);
+        ble_lifecycle::on_device_event(*event);
+        ota_update::on_device_event(*event);
         switch (event->Type)
         {
         case chip::DeviceLayer::DeviceEventType::kCommissioningComplete:
@@ -0,0 +1,259 @@
+#include "ble_lifecycle.h"
+
+#include "generated_config.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#if APP_BLE_RELEASE_AFTER_COMMISSIONING && CONFIG_BT_NIMBLE_ENABLED
+#define BLE_RELEASE_SUPPORTED 1
+#else
+#define BLE_RELEASE_SUPPORTED 0
+#endif
+
+#if BLE_RELEASE_SUPPORTED
+#include <esp_matter.h>
+#include <host/ble_hs.h>
+#include <nimble/nimble_port.h>
+
+#include <app/server/Server.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <platform/internal/BLEManager.h>
+#endif
+
+namespace ble_lifecycle {
+
+namespace {
+
+constexpr const char *TAG = "ble_lifecycle";
+
+portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+Stats s_stats = {State::Running, 0, 0, 0, 0};
+
+const char *state_name(State state)
+{
+    switch (state) {
+    case State::Running:
+        return "running";
+    case State::Releasing:
+        return "releasing";
+    case State::Released:
+        return "released";
+    case State::Restarting:
+        return "restarting";
+    default:
+        return "unknown";
+    }
+}
+
+#if BLE_RELEASE_SUPPORTED
+constexpr uint32_t kSettleMs = 200;
+constexpr uint32_t kReleaseTaskStackSize = 3072;
+bool s_restart_pending = false;
+
+State current_state()
+{
+    portENTER_CRITICAL(&s_lock);
+    const State state = s_stats.state;
+    portEXIT_CRITICAL(&s_lock);
+    return state;
+}
+
+void set_state(State state)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_stats.state = state;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// Runs on the CHIP task.
+void restart_work(intptr_t)
+{
+    if (current_state() != State::Released) {
+        return;
+    }
+    set_state(State::Restarting);
+    // Init() re-arms the CHIPoBLE state machine, which brings the NimBLE host
+    // and controller back up before advertising starts.
+    CHIP_ERROR err = chip::DeviceLayer::Internal::BLEMgr().Init();
+    if (err == CHIP_NO_ERROR) {
+        err = chip::DeviceLayer::ConnectivityMgr().SetBLEAdvertisingEnabled(true);
+    }
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGE(TAG, "Failed to restart BLE: %" CHIP_ERROR_FORMAT, err.Format());
+        set_state(State::Released);
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.state = State::Running;
+    ++s_stats.restarts;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "BLE restarted for the commissioning window.");
+}
+
+// NimBLE is stopped from its own task: ble_hs_stop() waits for GAP callbacks
+// that post back to the CHIP task, so it must not run there.
+void release_task(void *)
+{
+    const size_t free_before = esp_get_free_heap_size();
+
+    if (esp_matter::lock::chip_stack_lock(portMAX_DELAY) == esp_matter::lock::status::SUCCESS) {
+        chip::DeviceLayer::Internal::BLEMgr().Shutdown();
+        esp_matter::lock::chip_stack_unlock();
+    }
+    // Give the CHIPoBLE state machine time to stop the GATT service.
+    vTaskDelay(pdMS_TO_TICKS(kSettleMs));
+
+    if (ble_hs_is_enabled()) {
+        if (nimble_port_stop() == ESP_OK) {
+            nimble_port_deinit();
+        } else {
+            ESP_LOGW(TAG, "NimBLE host did not stop; BLE memory stays allocated.");
+        }
+    }
+
+    const size_t free_after = esp_get_free_heap_size();
+    const size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    const int32_t reclaimed = static_cast<int32_t>(free_after) - static_cast<int32_t>(free_before);
+    bool restart = false;
+    portENTER_CRITICAL(&s_lock);
+    s_stats.state = State::Released;
+    ++s_stats.releases;
+    s_stats.last_reclaimed_bytes = reclaimed;
+    s_stats.last_largest_block = static_cast<uint32_t>(largest);
+    restart = s_restart_pending;
+    s_restart_pending = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "BLE released: %" PRId32 " bytes reclaimed, free heap %u, largest block %u.",
+             reclaimed, static_cast<unsigned int>(free_after), static_cast<unsigned int>(largest));
+
+    if (restart) {
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(restart_work, 0);
+    }
+    vTaskDelete(nullptr);
+}
+
+void request_release()
+{
+    portENTER_CRITICAL(&s_lock);
+    const bool running = s_stats.state == State::Running;
+    if (running) {
+        s_stats.state = State::Releasing;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    if (!running) {
+        return;
+    }
+    if (xTaskCreate(release_task, "ble_release", kReleaseTaskStackSize, nullptr, tskIDLE_PRIORITY + 2, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create BLE release task.");
+        set_state(State::Running);
+    }
+}
+
+void request_restart()
+{
+    portENTER_CRITICAL(&s_lock);
+    const State state = s_stats.state;
+    if (state == State::Releasing) {
+        s_restart_pending = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    if (state == State::Released) {
+        restart_work(0);
+    }
+}
+#endif // BLE_RELEASE_SUPPORTED
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t ble_command(int, char **)
+{
+    print();
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+void start()
+{
+#if BLE_RELEASE_SUPPORTED
+    if (esp_matter::lock::chip_stack_lock(portMAX_DELAY) != esp_matter::lock::status::SUCCESS) {
+        return;
+    }
+    chip::Server &server = chip::Server::GetInstance();
+    const bool commissioned = server.GetFabricTable().FabricCount() > 0;
+    const bool window_open = server.GetCommissioningWindowManager().IsCommissioningWindowOpen();
+    esp_matter::lock::chip_stack_unlock();
+
+    if (commissioned && !window_open) {
+        ESP_LOGI(TAG, "Already commissioned; releasing BLE.");
+        request_release();
+    }
+#endif
+}
+
+void on_device_event(const chip::DeviceLayer::ChipDeviceEvent &event)
+{
+#if BLE_RELEASE_SUPPORTED
+    switch (event.Type) {
+    case chip::DeviceLayer::DeviceEventType::kCommissioningComplete:
+        request_release();
+        break;
+    case chip::DeviceLayer::DeviceEventType::kCommissioningWindowOpened:
+        request_restart();
+        break;
+    default:
+        break;
+    }
+#else
+    (void)event;
+#endif
+}
+
+Stats stats()
+{
+    portENTER_CRITICAL(&s_lock);
+    const Stats copy = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+    return copy;
+}
+
+void print()
+{
+    const Stats s = stats();
+    printf("BLE %s (release after commissioning: %s)\n", state_name(s.state),
+           BLE_RELEASE_SUPPORTED ? "enabled" : "disabled");
+    printf("releases=%" PRIu32 " restarts=%" PRIu32 " last_reclaimed=%" PRId32 " bytes largest_block=%" PRIu32 "\n",
+           s.releases, s.restarts, s.last_reclaimed_bytes, s.last_largest_block);
+    printf("free heap now: %u bytes\n", static_cast<unsigned int>(esp_get_free_heap_size()));
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "ble",
+            .description = "BLE lifecycle and reclaimed memory. Usage: matter esp ble",
+            .handler = ble_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace ble_lifecycle
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <esp_err.h>
+#include <platform/CHIPDeviceEvent.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ble_lifecycle {
+
+enum class State : uint8_t { Running, Releasing, Released, Restarting };
+
+struct Stats {
+    State state;
+    uint32_t releases;
+    uint32_t restarts;
+    int32_t last_reclaimed_bytes;     // free-heap delta of the last release
+    uint32_t last_largest_block;      // largest free internal block after it
+};
+
+/**
+ * @brief Releases BLE at boot if the node is already commissioned.
+ *
+ * Call after esp_matter::start(). Everything in this module is a no-op unless
+ * `network.ble_after_commissioning: release` is set in the YAML and NimBLE is
+ * enabled in sdkconfig.
+ */
+void start();
+
+/**
+ * @brief Feeds CHIP device events; call from app_event_cb.
+ *
+ * Commissioning complete shuts CHIPoBLE down and deinitialises the NimBLE
+ * host and controller, returning their heap to the allocator. A commissioning
+ * window opening brings BLE back and re-enables advertising.
+ */
+void on_device_event(const chip::DeviceLayer::ChipDeviceEvent &event);
+
+Stats stats();
+void print();
+
+/** @brief Registers `matter esp ble`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace ble_lifecycle
@@ -0,0 +1,339 @@
+#include "commissioning_trace.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <esp_log.h>
+#include <esp_matter_core.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+namespace commissioning_trace {
+
+namespace {
+
+constexpr const char *TAG = "commissioning";
+constexpr const char *kNvsNamespace = "comm_trace";
+constexpr const char *kNvsKey = "timelines";
+constexpr uint8_t kStoreVersion = 1;
+constexpr size_t kMilestoneCount = static_cast<size_t>(Milestone::Count);
+
+struct Store {
+    uint8_t version;
+    uint8_t boot_count;
+    uint8_t count;
+    uint8_t head; // slot of the most recent timeline
+    Timeline timelines[kMaxTimelines];
+};
+
+Store s_store = {};
+Timeline s_active = {};
+bool s_has_active = false;
+
+uint32_t now_ms()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+void save()
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(kNvsNamespace, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, kNvsKey, &s_store, sizeof(s_store));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save commissioning timelines: %s", esp_err_to_name(err));
+    }
+}
+
+void format_phases(const Timeline &timeline, char *out, size_t size)
+{
+    size_t used = 0;
+    uint32_t previous_ms = 0;
+    out[0] = '\0';
+    for (size_t idx = 0; idx < kMilestoneCount && used < size; ++idx) {
+        const uint32_t offset_ms = timeline.offsets_ms[idx];
+        if (offset_ms == kNotReached) {
+            continue;
+        }
+        // Milestones normally arrive in enum order; one that shows up early
+        // (e.g. on-network commissioning without BLE) reports a zero phase.
+        const uint32_t phase_ms = offset_ms > previous_ms ? offset_ms - previous_ms : 0;
+        const int written = snprintf(out + used, size - used, "%s%s +%" PRIu32 "ms",
+                                     used ? ", " : "", name(static_cast<Milestone>(idx)), phase_ms);
+        if (written < 0) {
+            break;
+        }
+        used += static_cast<size_t>(written);
+        if (offset_ms > previous_ms) {
+            previous_ms = offset_ms;
+        }
+    }
+}
+
+uint32_t total_ms(const Timeline &timeline)
+{
+    uint32_t last = 0;
+    for (uint32_t offset_ms : timeline.offsets_ms) {
+        if (offset_ms != kNotReached && offset_ms > last) {
+            last = offset_ms;
+        }
+    }
+    return last;
+}
+
+const char *outcome_name(Outcome outcome)
+{
+    switch (outcome) {
+    case Outcome::Complete:
+        return "complete";
+    case Outcome::FailSafeExpired:
+        return "fail-safe expired";
+    default:
+        return "in progress";
+    }
+}
+
+void mark(Milestone milestone)
+{
+    const uint32_t now = now_ms();
+    if (!s_has_active) {
+        s_active.start_ms = now;
+        for (uint32_t &offset_ms : s_active.offsets_ms) {
+            offset_ms = kNotReached;
+        }
+        s_active.outcome = Outcome::InProgress;
+        s_active.boot_count = s_store.boot_count;
+        s_has_active = true;
+    }
+    uint32_t &offset_ms = s_active.offsets_ms[static_cast<size_t>(milestone)];
+    // Keep the first occurrence: re-advertising or reconnects after the phase
+    // was reached do not move it.
+    if (offset_ms == kNotReached) {
+        offset_ms = now - s_active.start_ms;
+    }
+}
+
+void finish(Outcome outcome)
+{
+    if (!s_has_active) {
+        return;
+    }
+    s_active.outcome = outcome;
+    s_store.head = static_cast<uint8_t>((s_store.head + 1) % kMaxTimelines);
+    s_store.timelines[s_store.head] = s_active;
+    if (s_store.count < kMaxTimelines) {
+        ++s_store.count;
+    }
+    s_has_active = false;
+
+    char phases[256];
+    format_phases(s_active, phases, sizeof(phases));
+    ESP_LOGI(TAG, "Commissioning %s in %" PRIu32 " ms: %s", outcome_name(outcome), total_ms(s_active), phases);
+    save();
+}
+
+const Timeline &stored(const Store &store, size_t index)
+{
+    return store.timelines[(store.head + kMaxTimelines - index) % kMaxTimelines];
+}
+
+void print_snapshot(const Store &store, const Timeline *active, uint32_t now)
+{
+    char phases[256];
+    if (active) {
+        format_phases(*active, phases, sizeof(phases));
+        printf("active: %" PRIu32 " ms so far: %s\n", now - active->start_ms, phases);
+    }
+    if (store.count == 0) {
+        printf("No commissioning timelines recorded.\n");
+    }
+    for (size_t idx = 0; idx < store.count; ++idx) {
+        const Timeline &timeline = stored(store, idx);
+        format_phases(timeline, phases, sizeof(phases));
+        printf("#%u boot %u %s in %" PRIu32 " ms: %s\n", static_cast<unsigned int>(idx),
+               static_cast<unsigned int>(timeline.boot_count), outcome_name(timeline.outcome),
+               total_ms(timeline), phases);
+    }
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t commissioning_command(int argc, char **argv)
+{
+    if (argc > 0 && strcmp(argv[0], "clear") == 0) {
+        const auto lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+        if (lock_status == esp_matter::lock::status::FAILED) {
+            return ESP_FAIL;
+        }
+        s_store.count = 0;
+        s_store.head = 0;
+        save();
+        if (lock_status == esp_matter::lock::status::SUCCESS) {
+            esp_matter::lock::chip_stack_unlock();
+        }
+        printf("Commissioning timelines cleared.\n");
+        return ESP_OK;
+    }
+    print();
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+esp_err_t init()
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(kNvsNamespace, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(err));
+        return err;
+    }
+    Store loaded = {};
+    size_t size = sizeof(loaded);
+    err = nvs_get_blob(handle, kNvsKey, &loaded, &size);
+    nvs_close(handle);
+
+    if (err == ESP_OK && size == sizeof(loaded) && loaded.version == kStoreVersion &&
+        loaded.count <= kMaxTimelines && loaded.head < kMaxTimelines) {
+        s_store = loaded;
+    } else {
+        s_store = {};
+        s_store.version = kStoreVersion;
+    }
+    // Saved right away, so boots without a commissioning attempt still count.
+    ++s_store.boot_count;
+    save();
+    return ESP_OK;
+}
+
+void on_device_event(const chip::DeviceLayer::ChipDeviceEvent &event)
+{
+    using namespace chip::DeviceLayer;
+
+    switch (event.Type) {
+    case DeviceEventType::kCommissioningWindowOpened:
+        mark(Milestone::WindowOpened);
+        break;
+    case DeviceEventType::kCHIPoBLEAdvertisingChange:
+        if (event.CHIPoBLEAdvertisingChange.Result == kActivity_Started) {
+            mark(Milestone::BleAdvertising);
+        }
+        break;
+    case DeviceEventType::kCHIPoBLEConnectionEstablished:
+        mark(Milestone::BleConnected);
+        break;
+    case DeviceEventType::kCommissioningSessionStarted:
+        mark(Milestone::PaseEstablished);
+        break;
+    case DeviceEventType::kCommissioningWindowClosed:
+        // A window that closes before PASE is not a commissioning attempt.
+        if (s_has_active && s_active.offsets_ms[static_cast<size_t>(Milestone::PaseEstablished)] == kNotReached) {
+            s_has_active = false;
+        }
+        break;
+    case DeviceEventType::kOperationalNetworkEnabled:
+        if (s_has_active) {
+            mark(Milestone::NetworkEnabled);
+        }
+        break;
+    case DeviceEventType::kWiFiConnectivityChange:
+        if (s_has_active && event.WiFiConnectivityChange.Result == kConnectivity_Established) {
+            mark(Milestone::NetworkAttached);
+        }
+        break;
+    case DeviceEventType::kThreadConnectivityChange:
+        if (s_has_active && event.ThreadConnectivityChange.Result == kConnectivity_Established) {
+            mark(Milestone::NetworkAttached);
+        }
+        break;
+    case DeviceEventType::kCommissioningComplete:
+        mark(Milestone::Complete);
+        finish(Outcome::Complete);
+        break;
+    case DeviceEventType::kFailSafeTimerExpired:
+        finish(Outcome::FailSafeExpired);
+        break;
+    default:
+        break;
+    }
+}
+
+size_t count()
+{
+    return s_store.count;
+}
+
+const Timeline *get(size_t index)
+{
+    if (index >= s_store.count) {
+        return nullptr;
+    }
+    return &stored(s_store, index);
+}
+
+const char *name(Milestone milestone)
+{
+    switch (milestone) {
+    case Milestone::WindowOpened:
+        return "window_opened";
+    case Milestone::BleAdvertising:
+        return "ble_advertising";
+    case Milestone::BleConnected:
+        return "ble_connected";
+    case Milestone::PaseEstablished:
+        return "pase";
+    case Milestone::NetworkEnabled:
+        return "network_enabled";
+    case Milestone::NetworkAttached:
+        return "network_attached";
+    case Milestone::Complete:
+        return "case_complete";
+    default:
+        return "unknown";
+    }
+}
+
+void print()
+{
+    // The CHIP task writes the timelines; copy them under its lock and print outside it.
+    const auto lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+    if (lock_status == esp_matter::lock::status::FAILED) {
+        return;
+    }
+    const Store store = s_store;
+    const Timeline active = s_active;
+    const bool has_active = s_has_active;
+    if (lock_status == esp_matter::lock::status::SUCCESS) {
+        esp_matter::lock::chip_stack_unlock();
+    }
+    print_snapshot(store, has_active ? &active : nullptr, now_ms());
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "commissioning",
+            .description = "Commissioning timelines. Usage: matter esp commissioning [clear]",
+            .handler = commissioning_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace commissioning_trace
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <esp_err.h>
+#include <platform/CHIPDeviceEvent.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace commissioning_trace {
+
+enum class Milestone : uint8_t {
+    WindowOpened,     // commissioning window opened
+    BleAdvertising,   // CHIPoBLE advertising started
+    BleConnected,     // commissioner connected over BLE
+    PaseEstablished,  // commissioning (PASE) session started
+    NetworkEnabled,   // operational network credentials applied
+    NetworkAttached,  // Wi-Fi station connected or Thread attached
+    Complete,         // CommissioningComplete received over CASE
+    Count,
+};
+
+enum class Outcome : uint8_t { InProgress, Complete, FailSafeExpired };
+
+constexpr size_t kMaxTimelines = 4;
+constexpr uint32_t kNotReached = UINT32_MAX;
+
+struct Timeline {
+    uint32_t start_ms;                                              // uptime at the first milestone
+    uint32_t offsets_ms[static_cast<size_t>(Milestone::Count)];    // relative to start_ms
+    Outcome outcome;
+    uint8_t boot_count;                                             // wraps; tells timelines of different boots apart
+};
+
+/**
+ * @brief Loads the timelines saved by previous boots and counts this boot.
+ * Call after nvs_flash_init().
+ */
+esp_err_t init();
+
+/**
+ * @brief Feeds a CHIP device event; call from app_event_cb.
+ *
+ * The first commissioning-related event opens a timeline. Commissioning
+ * complete or fail-safe expiry closes it, logs the per-phase breakdown and
+ * writes the last kMaxTimelines timelines to NVS.
+ */
+void on_device_event(const chip::DeviceLayer::ChipDeviceEvent &event);
+
+/** Number of stored timelines; index 0 is the most recent. Call from the CHIP task. */
+size_t count();
+const Timeline *get(size_t index);
+
+const char *name(Milestone milestone);
+
+/** Prints every stored timeline with the time spent in each phase. Takes the CHIP stack lock. */
+void print();
+
+/** @brief Registers `matter esp commissioning [clear]`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace commissioning_trace
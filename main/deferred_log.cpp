@@ -0,0 +1,177 @@
+#include "deferred_log.h"
+
+#include <atomic>
+#include <cinttypes>
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace deferred_log {
+
+namespace {
+
+constexpr const char *TAG = "deferred_log";
+constexpr uint32_t kCapacity = 64; // power of two
+constexpr uint32_t kDrainPeriodMs = 50;
+constexpr uint32_t kTaskStackSize = 3072;
+constexpr UBaseType_t kTaskPriority = tskIDLE_PRIORITY + 1;
+constexpr size_t kMessageSize = 160;
+
+struct Record {
+    uint32_t timestamp_ms;
+    const char *tag;
+    const char *format;
+    uint8_t level;
+    uint8_t arg_count;
+    uint32_t args[kMaxArgs];
+};
+
+// Bounded multi-producer queue: a slot is free for position `pos` when its
+// sequence equals `pos`, and readable once the producer stores `pos + 1`.
+struct Slot {
+    std::atomic<uint32_t> sequence;
+    Record record;
+};
+
+Slot s_slots[kCapacity];
+std::atomic<uint32_t> s_enqueue_pos{0};
+uint32_t s_dequeue_pos = 0;
+std::atomic<uint32_t> s_dropped{0};
+std::atomic<bool> s_started{false};
+std::atomic<bool> s_raw_output{false};
+
+char level_letter(uint8_t level)
+{
+    switch (level) {
+    case ESP_LOG_ERROR:
+        return 'E';
+    case ESP_LOG_WARN:
+        return 'W';
+    case ESP_LOG_INFO:
+        return 'I';
+    case ESP_LOG_DEBUG:
+        return 'D';
+    default:
+        return 'V';
+    }
+}
+
+void emit(const Record &record)
+{
+    const auto level = static_cast<esp_log_level_t>(record.level);
+    if (s_raw_output.load(std::memory_order_relaxed)) {
+        esp_log_write(level, record.tag, "DLOG:%" PRIu32 ":%u:%08" PRIx32 ":%08" PRIx32 ":%" PRIx32 ",%" PRIx32 ",%" PRIx32 ",%" PRIx32 "\n",
+                      record.timestamp_ms, static_cast<unsigned int>(record.level),
+                      static_cast<uint32_t>(reinterpret_cast<uintptr_t>(record.tag)),
+                      static_cast<uint32_t>(reinterpret_cast<uintptr_t>(record.format)),
+                      record.args[0], record.args[1], record.args[2], record.args[3]);
+        return;
+    }
+
+    // Every argument is a 32-bit word, matching int, long and pointers on the
+    // ILP32 targets; unused trailing words are ignored by the formatter.
+    char message[kMessageSize];
+    snprintf(message, sizeof(message), record.format,
+             record.args[0], record.args[1], record.args[2], record.args[3]);
+    esp_log_write(level, record.tag, "%c (%" PRIu32 ") %s: %s\n",
+                  level_letter(record.level), record.timestamp_ms, record.tag, message);
+}
+
+bool dequeue(Record &out)
+{
+    Slot &slot = s_slots[s_dequeue_pos & (kCapacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != s_dequeue_pos + 1) {
+        return false;
+    }
+    out = slot.record;
+    slot.sequence.store(s_dequeue_pos + kCapacity, std::memory_order_release);
+    ++s_dequeue_pos;
+    return true;
+}
+
+void drain_task(void *)
+{
+    uint32_t reported_drops = 0;
+    Record record;
+    while (true) {
+        while (dequeue(record)) {
+            emit(record);
+        }
+        const uint32_t drops = s_dropped.load(std::memory_order_relaxed);
+        if (drops != reported_drops) {
+            ESP_LOGW(TAG, "%" PRIu32 " log records dropped.", drops - reported_drops);
+            reported_drops = drops;
+        }
+        vTaskDelay(pdMS_TO_TICKS(kDrainPeriodMs));
+    }
+}
+
+} // namespace
+
+esp_err_t init()
+{
+    if (s_started.load()) {
+        return ESP_OK;
+    }
+    for (uint32_t i = 0; i < kCapacity; ++i) {
+        s_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    if (xTaskCreate(drain_task, "dlog", kTaskStackSize, nullptr, kTaskPriority, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create log drain task.");
+        return ESP_ERR_NO_MEM;
+    }
+    s_started.store(true, std::memory_order_release);
+    return ESP_OK;
+}
+
+void set_raw_output(bool raw)
+{
+    s_raw_output.store(raw, std::memory_order_relaxed);
+}
+
+uint32_t dropped()
+{
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
+void write(esp_log_level_t level, const char *tag, const char *format, size_t arg_count, const uint32_t *args)
+{
+    // Runtime tag levels are applied by esp_log_write() when the record is
+    // emitted; looking them up here would take the log lock.
+    Record record = {};
+    record.timestamp_ms = static_cast<uint32_t>(esp_timer_get_time() / 1000);
+    record.tag = tag;
+    record.format = format;
+    record.level = static_cast<uint8_t>(level);
+    record.arg_count = static_cast<uint8_t>(arg_count);
+    for (size_t i = 0; i < arg_count; ++i) {
+        record.args[i] = args[i];
+    }
+
+    if (!s_started.load(std::memory_order_acquire)) {
+        emit(record);
+        return;
+    }
+
+    uint32_t pos = s_enqueue_pos.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+        slot = &s_slots[pos & (kCapacity - 1)];
+        const int32_t diff = static_cast<int32_t>(slot->sequence.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (s_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = s_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->record = record;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+} // namespace deferred_log
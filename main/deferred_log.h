@@ -0,0 +1,99 @@
+#pragma once
+
+#include <esp_err.h>
+#include <esp_log.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+/**
+ * @brief Compile-time level per module for the DLOG* macros.
+ *
+ * Override with a compile definition (e.g. `-DDLOG_LEVEL_LIGHT=ESP_LOG_WARN`);
+ * calls above the module level compile to nothing, arguments included.
+ */
+#ifndef DLOG_DEFAULT_LEVEL
+#define DLOG_DEFAULT_LEVEL LOG_LOCAL_LEVEL
+#endif
+#ifndef DLOG_LEVEL_LIGHT
+#define DLOG_LEVEL_LIGHT DLOG_DEFAULT_LEVEL
+#endif
+#ifndef DLOG_LEVEL_BUTTON
+#define DLOG_LEVEL_BUTTON DLOG_DEFAULT_LEVEL
+#endif
+#ifndef DLOG_LEVEL_ENCODER
+#define DLOG_LEVEL_ENCODER DLOG_DEFAULT_LEVEL
+#endif
+#ifndef DLOG_LEVEL_BOUND
+#define DLOG_LEVEL_BOUND DLOG_DEFAULT_LEVEL
+#endif
+#ifndef DLOG_LEVEL_RULES
+#define DLOG_LEVEL_RULES DLOG_DEFAULT_LEVEL
+#endif
+
+// The unevaluated printf keeps -Wformat checking the call site.
+#define DLOG(module, level, tag, format, ...)                                         \
+    do {                                                                              \
+        if constexpr ((level) <= DLOG_LEVEL_##module) {                               \
+            (void)sizeof(printf(format, ##__VA_ARGS__));                              \
+            ::deferred_log::log((level), (tag), (format), ##__VA_ARGS__);             \
+        }                                                                             \
+    } while (0)
+
+#define DLOGE(module, tag, format, ...) DLOG(module, ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOGW(module, tag, format, ...) DLOG(module, ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define DLOGI(module, tag, format, ...) DLOG(module, ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define DLOGD(module, tag, format, ...) DLOG(module, ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+
+namespace deferred_log {
+
+constexpr size_t kMaxArgs = 4;
+
+/**
+ * @brief Starts the low-priority task that formats queued records.
+ *
+ * Records are a timestamp, the tag and format pointers and up to four 32-bit
+ * arguments; producers only copy those into a lock-free ring, so logging from
+ * Matter callbacks and esp_timer handlers costs no formatting or UART time.
+ * `%s` arguments must point to storage that outlives the record (literals,
+ * config strings). Before init() the macros log synchronously.
+ */
+esp_err_t init();
+
+/**
+ * @brief Emits records as `DLOG:` hex lines instead of formatting them.
+ *
+ * Saves the formatting time on the device; tools/decode_dlog.py rebuilds the
+ * messages from the captured output and the firmware ELF.
+ */
+void set_raw_output(bool raw);
+
+/** @brief Records dropped because the ring was full. */
+uint32_t dropped();
+
+void write(esp_log_level_t level, const char *tag, const char *format, size_t arg_count, const uint32_t *args);
+
+template <typename T>
+uint32_t to_word(T value)
+{
+    static_assert(sizeof(T) <= sizeof(uint32_t), "deferred_log arguments must fit in 32 bits");
+    // %f reads a double from the argument list, which a 32-bit word cannot rebuild.
+    static_assert(!std::is_floating_point_v<T>, "deferred_log cannot carry floats; scale to an integer");
+    if constexpr (std::is_pointer_v<T>) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+    } else {
+        return static_cast<uint32_t>(value);
+    }
+}
+
+template <typename... Args>
+void log(esp_log_level_t level, const char *tag, const char *format, Args... args)
+{
+    static_assert(sizeof...(Args) <= kMaxArgs, "deferred_log supports at most 4 arguments");
+    const uint32_t words[sizeof...(Args) + 1] = {to_word(args)..., 0};
+    write(level, tag, format, sizeof...(Args), words);
+}
+
+} // namespace deferred_log
@@ -0,0 +1,239 @@
+#include "device_config.h"
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstring>
+
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+
+namespace device_config {
+
+namespace {
+
+constexpr const char *TAG = "device_config";
+constexpr const char *kPartitionLabel = "devcfg";
+
+struct View {
+    bool from_partition;
+    const generated_config::device_info *device;
+    const generated_config::button::config_t *buttons;
+    size_t button_count;
+    const generated_config::encoder::config_t *encoders;
+    size_t encoder_count;
+    const generated_config::endpoint_raw *endpoints;
+    size_t endpoint_count;
+};
+
+View s_view = {
+    .from_partition = false,
+    .device = &generated_config::device,
+    .buttons = generated_config::button::configs,
+    .button_count = generated_config::button::count,
+    .encoders = generated_config::encoder::configs,
+    .encoder_count = generated_config::encoder::count,
+    .endpoints = generated_config::endpoints,
+    .endpoint_count = generated_config::num_endpoints,
+};
+
+esp_partition_mmap_handle_t s_mmap_handle = 0;
+
+// Written so that nothing wraps: the offsets come from flash and are only
+// trusted once they are known to lie inside total_size.
+bool section_fits(const generated_config::blob_header &header, uint32_t offset, size_t count, size_t record_size)
+{
+    return offset % 4 == 0 && offset >= header.header_size && offset <= header.total_size &&
+           count <= (header.total_size - offset) / record_size;
+}
+
+template <size_t N>
+bool terminated(const char (&str)[N])
+{
+    return std::memchr(str, '\0', N) != nullptr;
+}
+
+bool terminated(const generated_config::optional_string &str)
+{
+    return terminated(str.value);
+}
+
+bool terminated(const generated_config::string_list &list)
+{
+    for (const auto &item : list.items) {
+        if (!terminated(item)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every string is used with strcmp() or logged, so each must end inside its record.
+bool strings_terminated(const generated_config::device_info &device)
+{
+    return terminated(device.device_type) && terminated(device.device_name) && terminated(device.led_type);
+}
+
+bool strings_terminated(const generated_config::button::config_t &button)
+{
+    return terminated(button.id) && terminated(button.mode) && terminated(button.action_cluster) &&
+           terminated(button.action_command) && terminated(button.driver) && terminated(button.gesture_policy) &&
+           terminated(button.double_action_cluster) && terminated(button.double_action_command) &&
+           terminated(button.triple_action_cluster) && terminated(button.triple_action_command);
+}
+
+bool strings_terminated(const generated_config::encoder::config_t &encoder)
+{
+    return terminated(encoder.id) && terminated(encoder.mode);
+}
+
+bool strings_terminated(const generated_config::endpoint_raw &endpoint)
+{
+    return terminated(endpoint.device_type) && terminated(endpoint.on_off.features) &&
+           terminated(endpoint.level_control.features) && terminated(endpoint.color_control.color_mode) &&
+           terminated(endpoint.color_control.enhanced_color_mode) && terminated(endpoint.color_control.features);
+}
+
+template <typename Record>
+bool records_terminated(const uint8_t *base, uint32_t offset, size_t count)
+{
+    const auto *records = reinterpret_cast<const Record *>(base + offset);
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (!strings_terminated(records[idx])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool validate(const uint8_t *base, size_t partition_size)
+{
+    const auto &header = *reinterpret_cast<const generated_config::blob_header *>(base);
+    if (header.magic != generated_config::blob_magic) {
+        // Erased partition: not an error, the image simply runs with built-in tables.
+        ESP_LOGI(TAG, "No config blob in '%s' partition.", kPartitionLabel);
+        return false;
+    }
+    if (header.version != generated_config::blob_version ||
+        header.header_size != sizeof(generated_config::blob_header) ||
+        header.layout_hash != generated_config::blob_layout_hash) {
+        ESP_LOGW(TAG, "Config blob layout mismatch (version %u, hash 0x%08" PRIx32 ", expected 0x%08" PRIx32 ").",
+                 static_cast<unsigned int>(header.version), header.layout_hash, generated_config::blob_layout_hash);
+        return false;
+    }
+    if (header.total_size > partition_size ||
+        header.button_count > generated_config::button::max_count ||
+        header.encoder_count > generated_config::encoder::max_count ||
+        header.endpoint_count > generated_config::max_endpoints ||
+        !section_fits(header, header.device_offset, 1, sizeof(generated_config::device_info)) ||
+        !section_fits(header, header.button_offset, header.button_count, sizeof(generated_config::button::config_t)) ||
+        !section_fits(header, header.encoder_offset, header.encoder_count, sizeof(generated_config::encoder::config_t)) ||
+        !section_fits(header, header.endpoint_offset, header.endpoint_count, sizeof(generated_config::endpoint_raw))) {
+        ESP_LOGW(TAG, "Config blob has out-of-range sections.");
+        return false;
+    }
+
+    // The CRC covers the header too, with its crc32 field taken as zero.
+    generated_config::blob_header unsigned_header = header;
+    unsigned_header.crc32 = 0;
+    uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t *>(&unsigned_header), sizeof(unsigned_header));
+    crc = esp_rom_crc32_le(crc, base + header.header_size, header.total_size - header.header_size);
+    if (crc != header.crc32) {
+        ESP_LOGW(TAG, "Config blob CRC mismatch (0x%08" PRIx32 " != 0x%08" PRIx32 ").", crc, header.crc32);
+        return false;
+    }
+
+    if (!records_terminated<generated_config::device_info>(base, header.device_offset, 1) ||
+        !records_terminated<generated_config::button::config_t>(base, header.button_offset, header.button_count) ||
+        !records_terminated<generated_config::encoder::config_t>(base, header.encoder_offset, header.encoder_count) ||
+        !records_terminated<generated_config::endpoint_raw>(base, header.endpoint_offset, header.endpoint_count)) {
+        ESP_LOGW(TAG, "Config blob has unterminated strings.");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+esp_err_t init()
+{
+    const esp_partition_t *partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, kPartitionLabel);
+    if (!partition) {
+        ESP_LOGI(TAG, "No '%s' partition; using built-in configuration.", kPartitionLabel);
+        return ESP_OK;
+    }
+
+    const void *mapped = nullptr;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &s_mmap_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map '%s' partition: %s", kPartitionLabel, esp_err_to_name(err));
+        return err;
+    }
+
+    const auto *base = static_cast<const uint8_t *>(mapped);
+    if (!validate(base, partition->size)) {
+        esp_partition_munmap(s_mmap_handle);
+        s_mmap_handle = 0;
+        ESP_LOGI(TAG, "Using built-in configuration.");
+        return ESP_OK;
+    }
+
+    // The mapping stays alive for the lifetime of the firmware.
+    const auto &header = *reinterpret_cast<const generated_config::blob_header *>(base);
+    s_view.from_partition = true;
+    s_view.device = reinterpret_cast<const generated_config::device_info *>(base + header.device_offset);
+    s_view.buttons = reinterpret_cast<const generated_config::button::config_t *>(base + header.button_offset);
+    s_view.button_count = header.button_count;
+    s_view.encoders = reinterpret_cast<const generated_config::encoder::config_t *>(base + header.encoder_offset);
+    s_view.encoder_count = header.encoder_count;
+    s_view.endpoints = reinterpret_cast<const generated_config::endpoint_raw *>(base + header.endpoint_offset);
+    s_view.endpoint_count = header.endpoint_count;
+
+    ESP_LOGI(TAG, "Loaded '%s' from partition: %u buttons, %u encoders, %u endpoints.",
+             s_view.device->device_name, static_cast<unsigned int>(s_view.button_count),
+             static_cast<unsigned int>(s_view.encoder_count), static_cast<unsigned int>(s_view.endpoint_count));
+    return ESP_OK;
+}
+
+bool from_partition()
+{
+    return s_view.from_partition;
+}
+
+const generated_config::device_info &device()
+{
+    return *s_view.device;
+}
+
+size_t button_count()
+{
+    return s_view.button_count;
+}
+
+const generated_config::button::config_t &button(size_t idx)
+{
+    return s_view.buttons[idx];
+}
+
+size_t encoder_count()
+{
+    return s_view.encoder_count;
+}
+
+const generated_config::encoder::config_t &encoder(size_t idx)
+{
+    return s_view.encoders[idx];
+}
+
+size_t endpoint_count()
+{
+    return s_view.endpoint_count;
+}
+
+const generated_config::endpoint_raw &endpoint(size_t idx)
+{
+    return s_view.endpoints[idx];
+}
+
+} // namespace device_config
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "generated_config.h"
+
+#include <esp_err.h>
+
+#include <cstddef>
+
+namespace device_config {
+
+/**
+ * @brief Selects where the device configuration is read from.
+ *
+ * When the `devcfg` partition holds a blob with a matching layout hash and
+ * CRC, it is memory-mapped and every accessor below points straight into
+ * flash. Otherwise the tables compiled into generated_config.h are used. Must
+ * run before any module reads its configuration.
+ */
+esp_err_t init();
+
+bool from_partition();
+
+const generated_config::device_info &device();
+
+size_t button_count();
+const generated_config::button::config_t &button(size_t idx);
+
+size_t encoder_count();
+const generated_config::encoder::config_t &encoder(size_t idx);
+
+size_t endpoint_count();
+const generated_config::endpoint_raw &endpoint(size_t idx);
+
+} // namespace device_config
@@ -0,0 +1,423 @@
+#include "common/bound_client.h"
+
+#include "event_loop_monitor.h"
+#include "latency_stats.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <inttypes.h>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_matter_client.h>
+#include <esp_matter_core.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+
+#include <app-common/zap-generated/cluster-objects.h>
+#include <app/OperationalSessionSetup.h>
+#include <app/server/Server.h>
+#include <app/util/binding-table.h>
+#include <lib/core/Optional.h>
+
+namespace device_modules::bound_client {
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+namespace {
+
+constexpr const char *TAG = "bound_client";
+
+// Unicast fan-out limits. CASE session setup dominates the per-peer cost, so a
+// few peers are brought up in parallel instead of walking the table serially.
+constexpr size_t kMaxInFlight = 4;
+constexpr size_t kMaxFanOutPeers = 48;
+constexpr size_t kMaxQueuedJobs = 3;
+
+struct Peer {
+    chip::ScopedNodeId id;
+    chip::EndpointId endpoint;
+};
+
+struct FanOutJob {
+    bool active = false;
+    Command cmd{};
+    int64_t start_us = 0;
+    std::array<Peer, kMaxFanOutPeers> peers{};
+    size_t peer_count = 0;
+    size_t next_peer = 0;
+    size_t outstanding = 0;
+};
+
+void on_peer_connected(void *context, chip::Messaging::ExchangeManager &exchange_mgr,
+                       const chip::SessionHandle &session_handle);
+void on_peer_connection_failure(void *context, const chip::ScopedNodeId &peer_id, CHIP_ERROR error);
+
+struct FanOutSlot {
+    bool busy = false;
+    FanOutJob *job = nullptr;
+    Peer peer{};
+    chip::Callback::Callback<chip::OnDeviceConnected> on_connected{on_peer_connected, this};
+    chip::Callback::Callback<chip::OnDeviceConnectionFailure> on_failure{on_peer_connection_failure, this};
+};
+
+bool s_bindings_ready = false;
+bool s_pumping = false;
+std::array<FanOutJob, kMaxQueuedJobs> s_jobs{};
+size_t s_job_head = 0;
+std::array<FanOutSlot, kMaxInFlight> s_slots{};
+std::array<PeerStats, kMaxFanOutPeers> s_peer_stats{};
+
+PeerStats &stats_for(const chip::ScopedNodeId &peer)
+{
+    PeerStats *oldest = &s_peer_stats[0];
+    for (PeerStats &entry : s_peer_stats) {
+        if (entry.sent > 0 && entry.fabric_index == peer.GetFabricIndex() && entry.node_id == peer.GetNodeId()) {
+            return entry;
+        }
+        if (entry.last_seen_us < oldest->last_seen_us) {
+            oldest = &entry;
+        }
+    }
+    *oldest = PeerStats{};
+    oldest->fabric_index = peer.GetFabricIndex();
+    oldest->node_id = peer.GetNodeId();
+    return *oldest;
+}
+
+void pump();
+
+void finish_slot(FanOutSlot &slot, bool ok)
+{
+    FanOutJob *job = slot.job;
+    const int64_t now_us = esp_timer_get_time();
+    const uint32_t latency_ms = static_cast<uint32_t>((now_us - job->start_us) / 1000);
+
+    PeerStats &stats = stats_for(slot.peer.id);
+    ++stats.sent;
+    stats.last_seen_us = now_us;
+    if (ok) {
+        stats.last_latency_ms = latency_ms;
+        if (latency_ms > stats.max_latency_ms) {
+            stats.max_latency_ms = latency_ms;
+        }
+    } else {
+        ++stats.failed;
+    }
+
+    slot.busy = false;
+    slot.job = nullptr;
+    --job->outstanding;
+    if (job->next_peer >= job->peer_count && job->outstanding == 0) {
+        ESP_LOGI(TAG, "Fan-out of cluster 0x%08" PRIx32 " to %u peers done in %" PRIu32 " ms.",
+                 static_cast<uint32_t>(job->cmd.cluster_id), static_cast<unsigned int>(job->peer_count), latency_ms);
+        job->active = false;
+        s_job_head = (s_job_head + 1) % kMaxQueuedJobs;
+    }
+    pump();
+}
+
+void fan_out_success_callback(void *ctx, const chip::app::ConcreteCommandPath &,
+                              const chip::app::StatusIB &, chip::TLV::TLVReader *)
+{
+    finish_slot(*static_cast<FanOutSlot *>(ctx), true);
+}
+
+void fan_out_failure_callback(void *ctx, CHIP_ERROR error)
+{
+    auto *slot = static_cast<FanOutSlot *>(ctx);
+    ESP_LOGW(TAG, "Command to node 0x%016" PRIx64 " failed: %" CHIP_ERROR_FORMAT,
+             slot->peer.id.GetNodeId(), error.Format());
+    finish_slot(*slot, false);
+}
+
+void on_peer_connected(void *context, chip::Messaging::ExchangeManager &exchange_mgr,
+                       const chip::SessionHandle &session_handle)
+{
+    auto *slot = static_cast<FanOutSlot *>(context);
+    const Command &cmd = slot->job->cmd;
+    client::peer_device_t device(&exchange_mgr, session_handle);
+    chip::app::CommandPathParams path(slot->peer.endpoint, 0, cmd.cluster_id, cmd.command_id,
+                                      chip::app::CommandPathFlags::kEndpointIdValid);
+    esp_err_t err = client::interaction::invoke::send_request(slot, &device, path,
+                                                              cmd.data[0] != '\0' ? cmd.data : "{}",
+                                                              fan_out_success_callback,
+                                                              fan_out_failure_callback,
+                                                              chip::NullOptional);
+    if (err != ESP_OK) {
+        fan_out_failure_callback(slot, CHIP_ERROR_INTERNAL);
+    }
+}
+
+void on_peer_connection_failure(void *context, const chip::ScopedNodeId &peer_id, CHIP_ERROR error)
+{
+    ESP_LOGW(TAG, "Session to node 0x%016" PRIx64 " failed: %" CHIP_ERROR_FORMAT,
+             peer_id.GetNodeId(), error.Format());
+    finish_slot(*static_cast<FanOutSlot *>(context), false);
+}
+
+// Starts queued unicast sends until every slot is busy. Session callbacks can
+// fire synchronously from FindOrEstablishSession, so re-entry only marks work.
+void pump()
+{
+    if (s_pumping) {
+        return;
+    }
+    s_pumping = true;
+
+    chip::CASESessionManager *session_mgr = chip::Server::GetInstance().GetCASESessionManager();
+    for (FanOutSlot &slot : s_slots) {
+        FanOutJob &job = s_jobs[s_job_head];
+        if (!job.active || job.next_peer >= job.peer_count) {
+            break;
+        }
+        if (slot.busy) {
+            continue;
+        }
+        slot.busy = true;
+        slot.job = &job;
+        slot.peer = job.peers[job.next_peer++];
+        ++job.outstanding;
+        session_mgr->FindOrEstablishSession(slot.peer.id, &slot.on_connected, &slot.on_failure);
+    }
+
+    s_pumping = false;
+    // A completion during the loop may have freed a slot behind the cursor.
+    for (const FanOutSlot &slot : s_slots) {
+        const FanOutJob &job = s_jobs[s_job_head];
+        if (!slot.busy && job.active && job.next_peer < job.peer_count) {
+            pump();
+            break;
+        }
+    }
+}
+
+bool binding_matches(const EmberBindingTableEntry &entry, chip::EndpointId binding_endpoint, chip::ClusterId cluster_id)
+{
+    return entry.local == binding_endpoint &&
+           (!entry.clusterId.HasValue() || entry.clusterId.Value() == cluster_id);
+}
+
+FanOutJob *reserve_job()
+{
+    size_t tail = s_job_head;
+    while (s_jobs[tail].active) {
+        tail = (tail + 1) % kMaxQueuedJobs;
+        if (tail == s_job_head) {
+            return nullptr;
+        }
+    }
+    return &s_jobs[tail];
+}
+
+/**
+ * Sends one groupcast per bound group and queues every unicast peer. Nothing
+ * goes out unless the unicast part fits the queue, so a command is either
+ * sent to all bindings or reported as not sent.
+ */
+esp_err_t fan_out(chip::EndpointId binding_endpoint, const Command &cmd, const char *name)
+{
+    size_t group_count = 0;
+    size_t unicast_count = 0;
+    for (const EmberBindingTableEntry &entry : chip::BindingTable::GetInstance()) {
+        if (!binding_matches(entry, binding_endpoint, cmd.cluster_id)) {
+            continue;
+        }
+        if (entry.type == MATTER_MULTICAST_BINDING) {
+            ++group_count;
+        } else if (entry.type == MATTER_UNICAST_BINDING) {
+            ++unicast_count;
+        }
+    }
+    if (group_count == 0 && unicast_count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    FanOutJob *job = nullptr;
+    if (unicast_count > 0) {
+        job = reserve_job();
+        if (!job) {
+            ESP_LOGW(TAG, "%s: fan-out queue full, command not sent.", name);
+            return ESP_ERR_NO_MEM;
+        }
+        // Reset in place; a FanOutJob temporary is too large for the esp_timer stack.
+        job->cmd = cmd;
+        job->start_us = esp_timer_get_time();
+        job->peer_count = 0;
+        job->next_peer = 0;
+        job->outstanding = 0;
+    }
+
+    size_t skipped = 0;
+    for (const EmberBindingTableEntry &entry : chip::BindingTable::GetInstance()) {
+        if (!binding_matches(entry, binding_endpoint, cmd.cluster_id)) {
+            continue;
+        }
+        if (entry.type == MATTER_MULTICAST_BINDING) {
+            chip::app::CommandPathParams path(0, entry.groupId, cmd.cluster_id, cmd.command_id,
+                                              chip::app::CommandPathFlags::kGroupIdValid);
+            client::interaction::invoke::send_group_request(entry.fabricIndex, path,
+                                                            cmd.data[0] != '\0' ? cmd.data : "{}");
+        } else if (entry.type == MATTER_UNICAST_BINDING) {
+            if (job->peer_count >= kMaxFanOutPeers) {
+                ++skipped;
+                continue;
+            }
+            job->peers[job->peer_count++] = Peer{chip::ScopedNodeId(entry.nodeId, entry.fabricIndex), entry.remote};
+        }
+    }
+
+    ESP_LOGD(TAG, "%s: %u groupcast, %u unicast.", name, static_cast<unsigned int>(group_count),
+             static_cast<unsigned int>(unicast_count));
+    if (skipped > 0) {
+        ESP_LOGW(TAG, "%s: %u unicast bindings over the limit of %u not sent.", name,
+                 static_cast<unsigned int>(skipped), static_cast<unsigned int>(kMaxFanOutPeers));
+    }
+    if (job) {
+        job->active = true;
+        pump();
+    }
+    return ESP_OK;
+}
+
+} // namespace
+
+void build_on_off(Command &cmd, chip::CommandId command_id)
+{
+    cmd.cluster_id = OnOff::Id;
+    cmd.command_id = command_id;
+    std::strcpy(cmd.data, "{}");
+}
+
+void build_identify(Command &cmd, uint16_t duration_s)
+{
+    cmd.cluster_id = Identify::Id;
+    cmd.command_id = Identify::Commands::Identify::Id;
+    std::snprintf(cmd.data, sizeof(cmd.data), "{\"0:U16\": %u}", static_cast<unsigned int>(duration_s));
+}
+
+void build_level_step(Command &cmd, bool up, uint8_t step_size, uint16_t transition_ds)
+{
+    const auto mode = up ? LevelControl::StepModeEnum::kUp : LevelControl::StepModeEnum::kDown;
+    cmd.cluster_id = LevelControl::Id;
+    cmd.command_id = LevelControl::Commands::StepWithOnOff::Id;
+    std::snprintf(cmd.data, sizeof(cmd.data),
+                  "{\"0:U8\": %u, \"1:U8\": %u, \"2:U16\": %u, \"3:U8\": 0, \"4:U8\": 0}",
+                  static_cast<unsigned int>(mode),
+                  static_cast<unsigned int>(step_size),
+                  static_cast<unsigned int>(transition_ds));
+}
+
+void build_level_move(Command &cmd, bool up, uint8_t rate)
+{
+    const auto mode = up ? LevelControl::MoveModeEnum::kUp : LevelControl::MoveModeEnum::kDown;
+    cmd.cluster_id = LevelControl::Id;
+    cmd.command_id = LevelControl::Commands::MoveWithOnOff::Id;
+    std::snprintf(cmd.data, sizeof(cmd.data),
+                  "{\"0:U8\": %u, \"1:U8\": %u, \"2:U8\": 0, \"3:U8\": 0}",
+                  static_cast<unsigned int>(mode),
+                  static_cast<unsigned int>(rate));
+}
+
+void build_level_move_to(Command &cmd, uint8_t level, uint16_t transition_ds)
+{
+    cmd.cluster_id = LevelControl::Id;
+    cmd.command_id = LevelControl::Commands::MoveToLevelWithOnOff::Id;
+    std::snprintf(cmd.data, sizeof(cmd.data), "{\"0:U8\": %u, \"1:U16\": %u, \"2:U8\": 0, \"3:U8\": 0}",
+                  static_cast<unsigned int>(level), static_cast<unsigned int>(transition_ds));
+}
+
+void build_level_stop(Command &cmd)
+{
+    cmd.cluster_id = LevelControl::Id;
+    cmd.command_id = LevelControl::Commands::StopWithOnOff::Id;
+    std::strcpy(cmd.data, "{\"0:U8\": 0, \"1:U8\": 0}");
+}
+
+void build_recall_scene(Command &cmd, uint16_t group_id, uint8_t scene_id)
+{
+    cmd.cluster_id = ScenesManagement::Id;
+    cmd.command_id = ScenesManagement::Commands::RecallScene::Id;
+    std::snprintf(cmd.data, sizeof(cmd.data), "{\"0:U16\": %u, \"1:U8\": %u}",
+                  static_cast<unsigned int>(group_id), static_cast<unsigned int>(scene_id));
+}
+
+esp_err_t ensure_bindings()
+{
+    if (s_bindings_ready) {
+        return ESP_OK;
+    }
+#ifdef CONFIG_ESP_MATTER_ENABLE_MATTER_SERVER
+    esp_matter::client::binding_init();
+#endif
+    // fan_out() reads the binding table and invokes peers itself, so no
+    // esp_matter request callbacks are registered.
+    s_bindings_ready = true;
+    return ESP_OK;
+}
+
+esp_err_t send(chip::EndpointId binding_endpoint, const Command &cmd, const char *source)
+{
+    latency_stats::Scope scope(latency_stats::Probe::BoundSend);
+    event_loop_monitor::Activity activity("bound_send");
+    const char *name = source ? source : "input";
+    if (binding_endpoint == chip::kInvalidEndpointId) {
+        ESP_LOGW(TAG, "%s: no binding endpoint available for remote command.", name);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ensure_bindings() != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    if (!endpoint::get(binding_endpoint)) {
+        ESP_LOGW(TAG, "%s: endpoint %u not created yet; retrying later.",
+                 name, static_cast<unsigned int>(binding_endpoint));
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    auto lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+    if (lock_status != esp_matter::lock::status::SUCCESS) {
+        ESP_LOGE(TAG, "%s: failed to acquire CHIP stack lock (status=%d).",
+                 name, static_cast<int>(lock_status));
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = fan_out(binding_endpoint, cmd, name);
+    esp_matter::lock::chip_stack_unlock();
+
+    if (err == ESP_ERR_NOT_FOUND) {
+        ESP_LOGW(TAG, "%s: no bindings configured for endpoint %u.",
+                 name, static_cast<unsigned int>(binding_endpoint));
+    } else if (err != ESP_OK) {
+        ESP_LOGE(TAG, "%s: fan-out failed for cluster 0x%08" PRIx32 ": %s",
+                 name, static_cast<uint32_t>(cmd.cluster_id), esp_err_to_name(err));
+    }
+    return err;
+}
+
+void log_peer_stats()
+{
+    auto lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+    if (lock_status != esp_matter::lock::status::SUCCESS) {
+        return;
+    }
+    for (const PeerStats &stats : s_peer_stats) {
+        if (stats.sent == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "peer %u:0x%016" PRIx64 " sent=%" PRIu32 " failed=%" PRIu32 " last=%" PRIu32 " ms max=%" PRIu32 " ms",
+                 static_cast<unsigned int>(stats.fabric_index), stats.node_id, stats.sent, stats.failed,
+                 stats.last_latency_ms, stats.max_latency_ms);
+    }
+    esp_matter::lock::chip_stack_unlock();
+}
+
+esp_err_t register_commands()
+{
+    return latency_stats::add_subcommand("peers", log_peer_stats);
+}
+
+} // namespace device_modules::bound_client
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <esp_err.h>
+#include <lib/core/DataModelTypes.h>
+#include <lib/core/NodeId.h>
+
+#include <cstdint>
+
+namespace device_modules::bound_client {
+
+/**
+ * @brief Command sent to every peer bound to a local endpoint.
+ *
+ * `data` holds the argument list in the JSON/TLV notation understood by the
+ * esp_matter invoke helpers (e.g. `{"0:U8": 1}`). send() copies it into the
+ * fan-out queue, so callers may reuse the instance right away.
+ */
+struct Command {
+    chip::ClusterId cluster_id;
+    chip::CommandId command_id;
+    char data[96];
+};
+
+void build_on_off(Command &cmd, chip::CommandId command_id);
+void build_identify(Command &cmd, uint16_t duration_s);
+void build_level_step(Command &cmd, bool up, uint8_t step_size, uint16_t transition_ds);
+void build_level_move(Command &cmd, bool up, uint8_t rate);
+void build_level_move_to(Command &cmd, uint8_t level, uint16_t transition_ds);
+void build_level_stop(Command &cmd);
+void build_recall_scene(Command &cmd, uint16_t group_id, uint8_t scene_id);
+
+/** @brief Starts esp_matter's binding manager once; send() calls it too. */
+esp_err_t ensure_bindings();
+
+/** Per-peer delivery record; latency is measured from send() to the response. */
+struct PeerStats {
+    chip::FabricIndex fabric_index;
+    chip::NodeId node_id;
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t last_latency_ms;
+    uint32_t max_latency_ms;
+    int64_t last_seen_us;
+};
+
+/**
+ * @brief Sends `cmd` to every binding on `binding_endpoint` for its cluster.
+ *
+ * Every group binding gets a groupcast and every unicast binding its own
+ * invoke, with sessions brought up with bounded parallelism. Returns
+ * ESP_ERR_NO_MEM, with nothing sent, when the unicast queue is full.
+ */
+esp_err_t send(chip::EndpointId binding_endpoint, const Command &cmd, const char *source);
+
+void log_peer_stats();
+
+/** @brief Registers `matter esp latency peers`. */
+esp_err_t register_commands();
+
+} // namespace device_modules::bound_client
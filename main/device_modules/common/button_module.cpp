@@ -1,11 +1,19 @@
 #include "common/button_module.h"
-
+#include "common/bound_client.h"
+#include "common/endpoint_utils.h"
+#include "common/gesture_classifier.h"
+#include "common/lp_buttons.h"
+#include "common/rule_engine.h"
+
+#include "deferred_log.h"
+#include "device_config.h"
 #include "generated_config.h"
+#include "latency_stats.h"
+#include "power_manager.h"
 
 #include <algorithm>
 #include <array>
 #include <cstring>
-#include <cstdio>
 #include <inttypes.h>
 
 #include <esp_err.h>
@@ -15,20 +23,19 @@
 #include <iot_button.h>
 #include <driver/gpio.h>
 #include "button_gpio.h"
+#include <esp_timer.h>
 
 #include <esp_matter.h>
 #include <esp_matter_cluster.h>
 #include <esp_matter_endpoint.h>
 #include <esp_matter_attribute.h>
 #include <esp_matter_core.h>
-#include <esp_matter_client.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
 #include <platform/CHIPDeviceLayer.h>
 #include <lib/core/DataModelTypes.h>
-#include <lib/core/Optional.h>
 #include <app-common/zap-generated/cluster-objects.h>
 
 namespace device_modules::button {
@@ -43,15 +50,19 @@ namespace {
 constexpr const char *TAG = "button_driver";
 
 using ButtonConfig = generated_config::button::config_t;
-constexpr size_t kButtonCount = generated_config::button::count;
-
-struct IdentifyCommandPayload {
-    uint16_t duration_s;
-};
+constexpr size_t kMaxButtons = generated_config::button::max_count;
 
 enum class ButtonMode { Remote, Local, Dual };
-enum class ActionCluster { OnOff, Identify, Unsupported };
-enum class ActionCommand { Toggle, On, Off, Identify, Unsupported };
+enum class ActionCluster { OnOff, LevelControl, Identify, Unsupported };
+enum class ActionCommand { Toggle, On, Off, MoveUp, MoveDown, Move, Identify, Unsupported };
+
+// Local hold-to-dim ramp granularity; remote targets ramp on their own.
+constexpr uint32_t kLocalRampIntervalMs = 50;
+
+struct ButtonAction {
+    ActionCluster cluster = ActionCluster::Unsupported;
+    ActionCommand command = ActionCommand::Unsupported;
+};
 
 struct ButtonRuntime {
     const ButtonConfig *cfg = nullptr;
@@ -59,19 +70,28 @@ struct ButtonRuntime {
     ButtonMode mode = ButtonMode::Remote;
     ActionCluster cluster = ActionCluster::OnOff;
     ActionCommand command = ActionCommand::Toggle;
+    ButtonAction double_action{};
+    ButtonAction triple_action{};
+    GestureClassifier classifier;
+    esp_timer_handle_t gesture_timer = nullptr;
     chip::EndpointId binding_endpoint = chip::kInvalidEndpointId;
     chip::EndpointId target_endpoint = chip::kInvalidEndpointId;
     uint8_t short_press_count = 0;
     TickType_t last_short_press_tick = 0;
-    IdentifyCommandPayload identify_payload{0};
+    bool holding = false;
+    bool pm_hold = false; // keeps the chip awake until the gesture is resolved
+    bool last_move_up = false;
+    esp_timer_handle_t ramp_timer = nullptr;
+    int32_t ramp_residual_milli = 0;
+    bound_client::Command remote_command{};
+    bound_client::Command stop_command{};
 };
 
-static std::array<ButtonRuntime, kButtonCount> s_button_states{};
-static bool s_client_callbacks_registered = false;
+static std::array<ButtonRuntime, kMaxButtons> s_button_states{};
 
 const char *button_name(const ButtonRuntime &btn)
 {
-    return (btn.cfg && btn.cfg->id) ? btn.cfg->id : "button";
+    return (btn.cfg && btn.cfg->id[0] != '\0') ? btn.cfg->id : "button";
 }
 
 ButtonMode parse_mode(const char *mode)
@@ -96,6 +116,9 @@ ActionCluster parse_cluster(const char *cluster)
     if (!cluster || std::strcmp(cluster, "on_off") == 0) {
         return ActionCluster::OnOff;
     }
+    if (std::strcmp(cluster, "level_control") == 0) {
+        return ActionCluster::LevelControl;
+    }
     if (std::strcmp(cluster, "identify") == 0) {
         return ActionCluster::Identify;
     }
@@ -118,6 +141,19 @@ ActionCommand parse_command(ActionCluster cluster, const char *command)
         ESP_LOGW(TAG, "Unsupported on_off command '%s', defaulting to toggle.", command ? command : "<null>");
         return ActionCommand::Toggle;
     }
+    if (cluster == ActionCluster::LevelControl) {
+        if (!command || std::strcmp(command, "move") == 0) {
+            return ActionCommand::Move;
+        }
+        if (std::strcmp(command, "move_up") == 0) {
+            return ActionCommand::MoveUp;
+        }
+        if (std::strcmp(command, "move_down") == 0) {
+            return ActionCommand::MoveDown;
+        }
+        ESP_LOGW(TAG, "Unsupported level_control command '%s', defaulting to move.", command);
+        return ActionCommand::Move;
+    }
     if (cluster == ActionCluster::Identify) {
         return ActionCommand::Identify;
     }
@@ -134,75 +170,12 @@ bool mode_has_local(ButtonMode mode)
     return mode == ButtonMode::Local || mode == ButtonMode::Dual;
 }
 
-chip::EndpointId resolve_default_binding_endpoint()
-{
-    for (size_t idx = 0; idx < generated_config::num_endpoints; ++idx) {
-        const auto &endpoint = generated_config::endpoints[idx];
-        if (endpoint.device_type && std::strcmp(endpoint.device_type, "on_off_switch") == 0) {
-            return static_cast<chip::EndpointId>(endpoint.id);
-        }
-    }
-    return chip::kInvalidEndpointId;
-}
-
-chip::EndpointId resolve_default_local_endpoint()
-{
-    for (size_t idx = 0; idx < generated_config::num_endpoints; ++idx) {
-        const auto &endpoint = generated_config::endpoints[idx];
-        if (!endpoint.device_type) {
-            continue;
-        }
-        if (endpoint.on_off.present && std::strcmp(endpoint.device_type, "on_off_switch") != 0) {
-            return static_cast<chip::EndpointId>(endpoint.id);
-        }
-    }
-    return chip::kInvalidEndpointId;
-}
-
-static void send_command_success_callback(void *, const chip::app::ConcreteCommandPath &,
-                                          const chip::app::StatusIB &, chip::TLV::TLVReader *)
-{
-    ESP_LOGD(TAG, "Command sent successfully.");
-}
-
-static void send_command_failure_callback(void *, CHIP_ERROR error)
-{
-    ESP_LOGE(TAG, "Command send failed: %" CHIP_ERROR_FORMAT, error.Format());
-}
-
-static void button_client_invoke_cb(client::peer_device_t *peer_device,
-                                    client::request_handle_t *req_handle,
-                                    void *);
-static void button_client_group_invoke_cb(uint8_t fabric_index,
-                                          client::request_handle_t *req_handle,
-                                          void *);
-
-esp_err_t ensure_client_callbacks()
-{
-    if (s_client_callbacks_registered) {
-        return ESP_OK;
-    }
-#ifdef CONFIG_ESP_MATTER_ENABLE_MATTER_SERVER
-    esp_matter::client::binding_init();
-#endif
-
-    esp_err_t err = esp_matter::client::set_request_callback(button_client_invoke_cb,
-                                                             button_client_group_invoke_cb,
-                                                             nullptr);
-    if (err == ESP_OK) {
-        s_client_callbacks_registered = true;
-    } else {
-        ESP_LOGE(TAG, "Failed to register client callbacks: %s", esp_err_to_name(err));
-    }
-    return err;
-}
-
 chip::EndpointId binding_endpoint_for(const ButtonRuntime &btn)
 {
     if (btn.binding_endpoint != chip::kInvalidEndpointId) {
         return btn.binding_endpoint;
     }
-    return resolve_default_binding_endpoint();
+    return utils::default_binding_endpoint();
 }
 
 chip::EndpointId target_endpoint_for(const ButtonRuntime &btn)
@@ -210,55 +183,17 @@ chip::EndpointId target_endpoint_for(const ButtonRuntime &btn)
     if (btn.target_endpoint != chip::kInvalidEndpointId) {
         return btn.target_endpoint;
     }
-    return resolve_default_local_endpoint();
-}
-
-esp_err_t dispatch_bound_command(ButtonRuntime &btn, client::request_handle_t &req_handle)
-{
-    chip::EndpointId local_endpoint = binding_endpoint_for(btn);
-    if (local_endpoint == chip::kInvalidEndpointId) {
-        ESP_LOGW(TAG, "%s: no binding endpoint available for remote command.", button_name(btn));
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    endpoint_t *endpoint = endpoint::get(local_endpoint);
-    if (!endpoint) {
-        ESP_LOGW(TAG, "%s: endpoint %u not created yet; retrying later.",
-                 button_name(btn), static_cast<unsigned int>(local_endpoint));
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    auto lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::status::SUCCESS) {
-        ESP_LOGE(TAG, "%s: failed to acquire CHIP stack lock (status=%d).",
-                 button_name(btn), static_cast<int>(lock_status));
-        return ESP_FAIL;
-    }
-
-    esp_err_t err = esp_matter::client::cluster_update(static_cast<uint16_t>(local_endpoint), &req_handle);
-    esp_matter::lock::chip_stack_unlock();
-
-    if (err == ESP_ERR_NOT_FOUND) {
-        ESP_LOGW(TAG, "%s: no bindings configured for endpoint %u.",
-                 button_name(btn), static_cast<unsigned int>(local_endpoint));
-    } else if (err != ESP_OK) {
-        ESP_LOGE(TAG, "%s: cluster_update failed: %s", button_name(btn), esp_err_to_name(err));
-    }
-    return err;
+    return utils::default_light_endpoint();
 }
 
-esp_err_t send_remote_onoff(ButtonRuntime &btn)
+esp_err_t send_remote_onoff(ButtonRuntime &btn, ActionCommand command)
 {
-    if (btn.cluster != ActionCluster::OnOff ||
-        !mode_has_remote(btn.mode)) {
+    if (!mode_has_remote(btn.mode)) {
         return ESP_OK;
     }
-    if (ensure_client_callbacks() != ESP_OK) {
-        return ESP_FAIL;
-    }
 
     chip::CommandId command_id = OnOff::Commands::Toggle::Id;
-    switch (btn.command) {
+    switch (command) {
     case ActionCommand::On:
         command_id = OnOff::Commands::On::Id;
         break;
@@ -273,13 +208,8 @@ esp_err_t send_remote_onoff(ButtonRuntime &btn)
         return ESP_ERR_INVALID_ARG;
     }
 
-    client::request_handle_t req_handle;
-    req_handle.type = client::INVOKE_CMD;
-    req_handle.command_path.mClusterId = OnOff::Id;
-    req_handle.command_path.mCommandId = command_id;
-    req_handle.request_data = nullptr;
-
-    return dispatch_bound_command(btn, req_handle);
+    bound_client::build_on_off(btn.remote_command, command_id);
+    return bound_client::send(binding_endpoint_for(btn), btn.remote_command, button_name(btn));
 }
 
 esp_err_t send_remote_identify(ButtonRuntime &btn, uint16_t duration_s)
@@ -287,25 +217,14 @@ esp_err_t send_remote_identify(ButtonRuntime &btn, uint16_t duration_s)
     if (!mode_has_remote(btn.mode)) {
         return ESP_OK;
     }
-    if (ensure_client_callbacks() != ESP_OK) {
-        return ESP_FAIL;
-    }
-
-    btn.identify_payload.duration_s = duration_s;
-
-    client::request_handle_t req_handle;
-    req_handle.type = client::INVOKE_CMD;
-    req_handle.command_path.mClusterId = Identify::Id;
-    req_handle.command_path.mCommandId = Identify::Commands::Identify::Id;
-    req_handle.request_data = &btn.identify_payload;
 
-    return dispatch_bound_command(btn, req_handle);
+    bound_client::build_identify(btn.remote_command, duration_s);
+    return bound_client::send(binding_endpoint_for(btn), btn.remote_command, button_name(btn));
 }
 
-esp_err_t perform_local_onoff(ButtonRuntime &btn)
+esp_err_t perform_local_onoff(ButtonRuntime &btn, ActionCommand command)
 {
-    if (btn.cluster != ActionCluster::OnOff ||
-        !mode_has_local(btn.mode)) {
+    if (!mode_has_local(btn.mode)) {
         return ESP_OK;
     }
 
@@ -325,7 +244,7 @@ esp_err_t perform_local_onoff(ButtonRuntime &btn)
     }
 
     bool new_state = true;
-    if (btn.command == ActionCommand::Toggle) {
+    if (command == ActionCommand::Toggle) {
         esp_matter_attr_val_t current_val = esp_matter_invalid(nullptr);
         if (attribute::get_val(attr, &current_val) == ESP_OK) {
             new_state = !current_val.val.b;
@@ -333,9 +252,9 @@ esp_err_t perform_local_onoff(ButtonRuntime &btn)
             ESP_LOGW(TAG, "%s: failed to read current OnOff state; defaulting to ON.", button_name(btn));
             new_state = true;
         }
-    } else if (btn.command == ActionCommand::On) {
+    } else if (command == ActionCommand::On) {
         new_state = true;
-    } else if (btn.command == ActionCommand::Off) {
+    } else if (command == ActionCommand::Off) {
         new_state = false;
     } else {
         ESP_LOGW(TAG, "%s: unsupported local on_off command.", button_name(btn));
@@ -378,16 +297,21 @@ esp_err_t perform_local_identify(ButtonRuntime &btn, uint16_t duration_s)
     return err;
 }
 
-void handle_button_action(ButtonRuntime &btn)
+void handle_button_action(ButtonRuntime &btn, ActionCluster cluster, ActionCommand command)
 {
     const auto &cfg = *btn.cfg;
     const uint16_t action_identify_time = static_cast<uint16_t>(
         cfg.action_identify_time_s > 0 ? cfg.action_identify_time_s : cfg.identify_time_s);
 
-    switch (btn.cluster) {
+    switch (cluster) {
     case ActionCluster::OnOff:
-        send_remote_onoff(btn);
-        perform_local_onoff(btn);
+        send_remote_onoff(btn, command);
+        perform_local_onoff(btn, command);
+        break;
+    case ActionCluster::LevelControl:
+        // Dimmer buttons: click toggles, press-and-hold streams Move/Stop.
+        send_remote_onoff(btn, ActionCommand::Toggle);
+        perform_local_onoff(btn, ActionCommand::Toggle);
         break;
     case ActionCluster::Identify:
         send_remote_identify(btn, action_identify_time);
@@ -399,74 +323,147 @@ void handle_button_action(ButtonRuntime &btn)
     }
 }
 
-static void button_client_invoke_cb(client::peer_device_t *peer_device,
-                                    client::request_handle_t *req_handle,
-                                    void *)
+void undo_single_action(ButtonRuntime &btn)
 {
-    if (!req_handle || req_handle->type != client::INVOKE_CMD) {
+    // Only a toggle can be reverted without remembering the previous state.
+    const bool is_toggle = btn.cluster == ActionCluster::LevelControl ||
+                           (btn.cluster == ActionCluster::OnOff && btn.command == ActionCommand::Toggle);
+    if (!is_toggle) {
+        ESP_LOGW(TAG, "%s: single action cannot be undone; use gesture_policy wait.", button_name(btn));
         return;
     }
+    send_remote_onoff(btn, ActionCommand::Toggle);
+    perform_local_onoff(btn, ActionCommand::Toggle);
+}
 
-    char command_data_str[32];
-    if (req_handle->command_path.mClusterId == OnOff::Id) {
-        std::strcpy(command_data_str, "{}");
-    } else if (req_handle->command_path.mClusterId == Identify::Id &&
-               req_handle->command_path.mCommandId == Identify::Commands::Identify::Id) {
-        uint16_t duration = 0;
-        if (req_handle->request_data) {
-            const auto *payload = static_cast<const IdentifyCommandPayload *>(req_handle->request_data);
-            duration = payload->duration_s;
-        }
-        std::snprintf(command_data_str, sizeof(command_data_str), "{\"0:U16\": %u}", duration);
-    } else {
-        ESP_LOGW(TAG, "Unsupported cluster 0x%08" PRIx32 " for invoke callback.",
-                 static_cast<uint32_t>(req_handle->command_path.mClusterId));
-        return;
+bool local_level_is_high(ButtonRuntime &btn)
+{
+    chip::EndpointId endpoint_id = target_endpoint_for(btn);
+    attribute_t *level_attr = attribute::get(endpoint_id, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id);
+    attribute_t *on_off_attr = attribute::get(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id);
+    if (!level_attr) {
+        return false;
+    }
+    esp_matter_attr_val_t val = esp_matter_invalid(nullptr);
+    if (on_off_attr && attribute::get_val(on_off_attr, &val) == ESP_OK && !val.val.b) {
+        return false;
     }
+    return attribute::get_val(level_attr, &val) == ESP_OK && val.val.u8 >= 127;
+}
 
-    esp_matter::client::interaction::invoke::send_request(nullptr,
-                                                          peer_device,
-                                                          req_handle->command_path,
-                                                          command_data_str,
-                                                          send_command_success_callback,
-                                                          send_command_failure_callback,
-                                                          chip::NullOptional);
+bool resolve_move_direction(ButtonRuntime &btn)
+{
+    switch (btn.command) {
+    case ActionCommand::MoveUp:
+        return true;
+    case ActionCommand::MoveDown:
+        return false;
+    default:
+        break;
+    }
+    // Alternating dimmer: follow the local level when there is one, otherwise flip.
+    if (mode_has_local(btn.mode) && target_endpoint_for(btn) != chip::kInvalidEndpointId) {
+        return !local_level_is_high(btn);
+    }
+    return !btn.last_move_up;
+}
+
+uint8_t move_rate(const ButtonRuntime &btn)
+{
+    return static_cast<uint8_t>(std::clamp(btn.cfg->action_move_rate, 1, 254));
 }
 
-static void button_client_group_invoke_cb(uint8_t fabric_index,
-                                          client::request_handle_t *req_handle,
-                                          void *)
+static void local_ramp_cb(void *arg)
 {
-    if (!req_handle || req_handle->type != client::INVOKE_CMD) {
+    auto *btn = static_cast<ButtonRuntime *>(arg);
+    if (!btn || !btn->holding) {
         return;
     }
 
-    char command_data_str[32];
-    if (req_handle->command_path.mClusterId == OnOff::Id) {
-        std::strcpy(command_data_str, "{}");
-    } else if (req_handle->command_path.mClusterId == Identify::Id &&
-               req_handle->command_path.mCommandId == Identify::Commands::Identify::Id) {
-        uint16_t duration = 0;
-        if (req_handle->request_data) {
-            const auto *payload = static_cast<const IdentifyCommandPayload *>(req_handle->request_data);
-            duration = payload->duration_s;
+    btn->ramp_residual_milli += static_cast<int32_t>(move_rate(*btn)) * static_cast<int32_t>(kLocalRampIntervalMs);
+    const int32_t delta = btn->ramp_residual_milli / 1000;
+    if (delta == 0) {
+        return;
+    }
+    btn->ramp_residual_milli -= delta * 1000;
+
+    uint8_t level = 0;
+    chip::EndpointId endpoint_id = target_endpoint_for(*btn);
+    esp_err_t err = utils::apply_level_delta(endpoint_id, btn->last_move_up ? delta : -delta, &level);
+    const bool at_limit = btn->last_move_up ? level >= 254 : level <= 1;
+    if (err != ESP_OK || at_limit) {
+        esp_timer_stop(btn->ramp_timer);
+    }
+}
+
+esp_err_t start_local_ramp(ButtonRuntime &btn)
+{
+    if (!mode_has_local(btn.mode)) {
+        return ESP_OK;
+    }
+    if (target_endpoint_for(btn) == chip::kInvalidEndpointId) {
+        ESP_LOGW(TAG, "%s: no local endpoint available for dimming.", button_name(btn));
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!btn.ramp_timer) {
+        esp_timer_create_args_t timer_args = {
+            .callback = local_ramp_cb,
+            .arg = &btn,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "button_ramp",
+            .skip_unhandled_events = true,
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &btn.ramp_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s: failed to create ramp timer: %s", button_name(btn), esp_err_to_name(err));
+            return err;
         }
-        std::snprintf(command_data_str, sizeof(command_data_str), "{\"0:U16\": %u}", duration);
-    } else {
-        ESP_LOGW(TAG, "Unsupported cluster 0x%08" PRIx32 " for group callback.",
-                 static_cast<uint32_t>(req_handle->command_path.mClusterId));
+    }
+    btn.ramp_residual_milli = 0;
+    esp_timer_stop(btn.ramp_timer);
+    return esp_timer_start_periodic(btn.ramp_timer, kLocalRampIntervalMs * 1000U);
+}
+
+void handle_hold_start(ButtonRuntime *state)
+{
+    if (state->cluster != ActionCluster::LevelControl) {
         return;
     }
 
-    esp_matter::client::interaction::invoke::send_group_request(fabric_index,
-                                                                req_handle->command_path,
-                                                                command_data_str);
+    const bool up = resolve_move_direction(*state);
+    state->last_move_up = up;
+    state->holding = true;
+    DLOGI(BUTTON, TAG, "%s: hold start, dimming %s at %u/s.",
+          button_name(*state), up ? "up" : "down", static_cast<unsigned int>(move_rate(*state)));
+
+    if (mode_has_remote(state->mode)) {
+        bound_client::build_level_move(state->remote_command, up, move_rate(*state));
+        bound_client::send(binding_endpoint_for(*state), state->remote_command, button_name(*state));
+    }
+    start_local_ramp(*state);
 }
 
-static void button_long_press_cb(void *, void *usr_data)
+void handle_hold_end(ButtonRuntime *state)
 {
-    auto *state = static_cast<ButtonRuntime *>(usr_data);
-    const char *name = state ? button_name(*state) : "button";
+    if (!state->holding) {
+        return;
+    }
+
+    state->holding = false;
+    DLOGI(BUTTON, TAG, "%s: hold released, stopping.", button_name(*state));
+
+    if (mode_has_remote(state->mode)) {
+        bound_client::build_level_stop(state->stop_command);
+        bound_client::send(binding_endpoint_for(*state), state->stop_command, button_name(*state));
+    }
+    if (state->ramp_timer) {
+        esp_timer_stop(state->ramp_timer);
+    }
+}
+
+void handle_factory_reset(ButtonRuntime *state)
+{
+    const char *name = button_name(*state);
 
     ESP_LOGI(TAG, "%s: long press detected, erasing NVM...", name);
     esp_err_t ret = nvs_flash_erase();
@@ -482,13 +479,8 @@ static void button_long_press_cb(void *, void *usr_data)
     esp_restart();
 }
 
-static void button_short_press_cb(void *, void *usr_data)
+void count_identify_clicks(ButtonRuntime *state, int clicks)
 {
-    auto *state = static_cast<ButtonRuntime *>(usr_data);
-    if (!state || !state->cfg) {
-        return;
-    }
-
     const ButtonConfig &cfg = *state->cfg;
     TickType_t current_tick = xTaskGetTickCount();
     TickType_t timeout_ticks = pdMS_TO_TICKS(cfg.short_press_timeout_ms > 0 ? cfg.short_press_timeout_ms : 0);
@@ -496,22 +488,19 @@ static void button_short_press_cb(void *, void *usr_data)
     if (state->short_press_count == 0 ||
         timeout_ticks == 0 ||
         (current_tick - state->last_short_press_tick) > timeout_ticks) {
-        state->short_press_count = 1;
-    } else {
-        ++state->short_press_count;
+        state->short_press_count = 0;
     }
+    state->short_press_count = static_cast<uint8_t>(std::max(0, state->short_press_count + clicks));
     state->last_short_press_tick = current_tick;
 
-    ESP_LOGI(TAG, "%s: short press count = %u",
-             button_name(*state), static_cast<unsigned int>(state->short_press_count));
-
-    handle_button_action(*state);
+    DLOGI(BUTTON, TAG, "%s: short press count = %u",
+          button_name(*state), static_cast<unsigned int>(state->short_press_count));
 
     if (cfg.identify_trigger_count > 0 &&
         state->short_press_count >= static_cast<uint8_t>(cfg.identify_trigger_count)) {
-        ESP_LOGI(TAG,
-                 "%s: identify trigger reached (%d presses).",
-                 button_name(*state), cfg.identify_trigger_count);
+        DLOGI(BUTTON, TAG,
+              "%s: identify trigger reached (%d presses).",
+              button_name(*state), cfg.identify_trigger_count);
         if (mode_has_remote(state->mode)) {
             send_remote_identify(*state, static_cast<uint16_t>(cfg.identify_time_s));
         }
@@ -522,21 +511,176 @@ static void button_short_press_cb(void *, void *usr_data)
     }
 }
 
+void handle_gesture(ButtonRuntime *state, const GestureClassifier::Event &event)
+{
+    latency_stats::Scope scope(latency_stats::Probe::ButtonGesture);
+    DLOGI(BUTTON, TAG, "%s: %s gesture (+%" PRIu32 " ms)",
+          button_name(*state), GestureClassifier::name(event.gesture), event.latency_ms);
+
+    // A YAML rule on this gesture replaces the button's own action.
+    const bool by_rule = event.gesture != Gesture::Long && rules::on_button(state->cfg->id, event.gesture);
+    if (by_rule) {
+        if (event.gesture == Gesture::HoldEnd) {
+            handle_hold_end(state); // stops a ramp of the button's own hold, if any
+        } else if (event.gesture != Gesture::HoldStart) {
+            count_identify_clicks(state, event.clicks);
+        }
+        return;
+    }
+
+    switch (event.gesture) {
+    case Gesture::Single:
+        handle_button_action(*state, state->cluster, state->command);
+        count_identify_clicks(state, event.clicks);
+        break;
+    case Gesture::Double:
+        handle_button_action(*state, state->double_action.cluster, state->double_action.command);
+        count_identify_clicks(state, event.clicks);
+        break;
+    case Gesture::Triple:
+        handle_button_action(*state, state->triple_action.cluster, state->triple_action.command);
+        count_identify_clicks(state, event.clicks);
+        break;
+    case Gesture::Undo:
+        // A single click handled by a rule cannot be undone.
+        if (!rules::handles(state->cfg->id, Gesture::Single)) {
+            undo_single_action(*state);
+        }
+        count_identify_clicks(state, -1);
+        break;
+    case Gesture::HoldStart:
+        handle_hold_start(state);
+        break;
+    case Gesture::HoldEnd:
+        handle_hold_end(state);
+        break;
+    case Gesture::Long:
+        handle_factory_reset(state);
+        break;
+    default:
+        break;
+    }
+}
+
+uint32_t now_ms()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+void process_gestures(ButtonRuntime *state)
+{
+    GestureClassifier::Event event{};
+    while (state->classifier.next(event)) {
+        handle_gesture(state, event);
+    }
+
+    if (!state->gesture_timer) {
+        return;
+    }
+    esp_timer_stop(state->gesture_timer);
+    uint32_t deadline_ms = 0;
+    const bool pending = state->classifier.next_deadline_ms(deadline_ms);
+    if (pending) {
+        const int32_t remaining_ms = static_cast<int32_t>(deadline_ms - now_ms());
+        esp_timer_start_once(state->gesture_timer, static_cast<uint64_t>(std::max<int32_t>(remaining_ms, 1)) * 1000U);
+    }
+
+    // Light sleep would stretch the multi-click window and the local ramp, so
+    // stay awake while either runs. A plain press needs nothing: its release
+    // edge wakes the chip over GPIO.
+    const bool busy = pending || state->holding;
+    if (busy != state->pm_hold) {
+        state->pm_hold = busy;
+        if (busy) {
+            power_manager::acquire(power_manager::Hold::Button);
+        } else {
+            power_manager::release(power_manager::Hold::Button);
+        }
+    }
+}
+
+static void gesture_timer_cb(void *arg)
+{
+    auto *state = static_cast<ButtonRuntime *>(arg);
+    state->classifier.poll(now_ms());
+    process_gestures(state);
+}
+
+static void button_press_down_cb(void *, void *usr_data)
+{
+    auto *state = static_cast<ButtonRuntime *>(usr_data);
+    if (!state || !state->cfg) {
+        return;
+    }
+    power_manager::on_user_activity();
+    state->classifier.press(now_ms());
+    process_gestures(state);
+}
+
+static void button_press_up_cb(void *, void *usr_data)
+{
+    auto *state = static_cast<ButtonRuntime *>(usr_data);
+    if (!state || !state->cfg) {
+        return;
+    }
+    state->classifier.release(now_ms());
+    process_gestures(state);
+}
+
+// Edges debounced by the LP core, back-dated to the scan that accepted them.
+static void lp_edge_cb(bool pressed, uint32_t event_ms, void *usr_data)
+{
+    auto *state = static_cast<ButtonRuntime *>(usr_data);
+    if (!state || !state->cfg) {
+        return;
+    }
+    if (pressed) {
+        power_manager::on_user_activity();
+        state->classifier.press(event_ms);
+    } else {
+        state->classifier.release(event_ms);
+    }
+    process_gestures(state);
+}
+
+ButtonAction parse_action(const char *cluster, const char *command)
+{
+    ButtonAction action{};
+    if (!cluster || cluster[0] == '\0') {
+        return action;
+    }
+    action.cluster = parse_cluster(cluster);
+    action.command = parse_command(action.cluster, command);
+    return action;
+}
+
+GesturePolicy parse_policy(const char *policy)
+{
+    if (policy && std::strcmp(policy, "wait") == 0) {
+        return GesturePolicy::Wait;
+    }
+    if (policy && std::strcmp(policy, "immediate") != 0) {
+        ESP_LOGW(TAG, "Unknown gesture policy '%s', defaulting to immediate.", policy);
+    }
+    return GesturePolicy::Immediate;
+}
+
 } // namespace
 
 app_driver_handle_t init()
 {
-    if constexpr (kButtonCount == 0) {
+    const size_t button_count = std::min(device_config::button_count(), kMaxButtons);
+    if (button_count == 0) {
         ESP_LOGI(TAG, "No buttons configured.");
         return nullptr;
     }
 
     app_driver_handle_t primary_handle = nullptr;
-    bool needs_client_callbacks = false;
+    bool needs_bindings = false;
 
-    for (size_t idx = 0; idx < kButtonCount; ++idx) {
+    for (size_t idx = 0; idx < button_count; ++idx) {
         ButtonRuntime &state = s_button_states[idx];
-        const ButtonConfig &cfg = generated_config::button::configs[idx];
+        const ButtonConfig &cfg = device_config::button(idx);
 
         state.cfg = &cfg;
         state.handle = nullptr;
@@ -545,8 +689,32 @@ app_driver_handle_t init()
         state.mode = parse_mode(cfg.mode);
         state.cluster = parse_cluster(cfg.action_cluster);
         state.command = parse_command(state.cluster, cfg.action_command);
-        state.identify_payload.duration_s = static_cast<uint16_t>(
-            cfg.action_identify_time_s > 0 ? cfg.action_identify_time_s : cfg.identify_time_s);
+        state.double_action = parse_action(cfg.double_action_cluster, cfg.double_action_command);
+        state.triple_action = parse_action(cfg.triple_action_cluster, cfg.triple_action_command);
+
+        // Multi-click detection is only paid for when a multi-click action or rule exists.
+        uint8_t max_clicks = 1;
+        if (state.triple_action.cluster != ActionCluster::Unsupported || rules::handles(cfg.id, Gesture::Triple)) {
+            max_clicks = 3;
+        } else if (state.double_action.cluster != ActionCluster::Unsupported ||
+                   rules::handles(cfg.id, Gesture::Double)) {
+            max_clicks = 2;
+        }
+        const bool holds = state.cluster == ActionCluster::LevelControl ||
+                           rules::handles(cfg.id, Gesture::HoldStart) ||
+                           rules::handles(cfg.id, Gesture::HoldEnd);
+        // A hold that runs long would otherwise erase NVS; parse_config.py rejects the combination.
+        const bool factory_reset = cfg.factory_reset && !holds;
+        if (cfg.factory_reset && holds) {
+            ESP_LOGW(TAG, "%s: factory reset disabled, the button reports holds.", button_name(state));
+        }
+        state.classifier = GestureClassifier({
+            .policy = parse_policy(cfg.gesture_policy),
+            .max_clicks = max_clicks,
+            .multi_click_window_ms = static_cast<uint32_t>(std::max(cfg.multi_click_window_ms, 0)),
+            .hold_time_ms = holds ? static_cast<uint32_t>(std::max(cfg.hold_time_ms, 1)) : 0U,
+            .long_press_time_ms = factory_reset ? static_cast<uint32_t>(std::max(cfg.long_press_time_ms, 1)) : 0U,
+        });
 
         state.binding_endpoint = cfg.binding_endpoint > 0
                                      ? static_cast<chip::EndpointId>(cfg.binding_endpoint)
@@ -556,58 +724,120 @@ app_driver_handle_t init()
                                     : chip::kInvalidEndpointId;
 
         if (mode_has_remote(state.mode)) {
-            needs_client_callbacks = true;
+            needs_bindings = true;
             if (state.binding_endpoint == chip::kInvalidEndpointId) {
-                state.binding_endpoint = resolve_default_binding_endpoint();
+                state.binding_endpoint = utils::default_binding_endpoint();
             }
         }
         if (mode_has_local(state.mode) && state.target_endpoint == chip::kInvalidEndpointId) {
-            state.target_endpoint = resolve_default_local_endpoint();
+            state.target_endpoint = utils::default_light_endpoint();
         }
 
-        button_gpio_config_t gpio_cfg = {
-            .gpio_num = static_cast<gpio_num_t>(cfg.gpio),
-            .active_level = static_cast<uint8_t>(cfg.active_level),
-            .enable_power_save = false,
-            .disable_pull = false,
-        };
+        // With power.lp_core.buttons the LP core scans and debounces LP IOs,
+        // so the HP core only wakes for real edges. Other pins stay on iot_button.
+        bool lp_scanned = false;
+        if (lp_buttons::enabled()) {
+            lp_scanned = lp_buttons::supports_gpio(cfg.gpio) &&
+                         lp_buttons::add(cfg.gpio, cfg.active_level == 0, lp_edge_cb, &state) == ESP_OK;
+            if (!lp_scanned) {
+                ESP_LOGW(TAG, "%s: gpio %d is not an LP IO; scanned by the HP core.", button_name(state), cfg.gpio);
+            }
+        }
 
-        button_config_t btn_cfg = {
-            .long_press_time = static_cast<uint16_t>(std::clamp(cfg.long_press_time_ms, 0, 0xFFFF)),
-            .short_press_time = 50,
-        };
+        esp_err_t err = ESP_OK;
+        if (!lp_scanned) {
+            button_gpio_config_t gpio_cfg = {
+                .gpio_num = static_cast<gpio_num_t>(cfg.gpio),
+                .active_level = static_cast<uint8_t>(cfg.active_level),
+                // Light-sleep builds wake on the GPIO edge instead of polling every
+                // 20 ms; the wake-up press goes straight into the classifier.
+                .enable_power_save = power_manager::light_sleep(),
+                .disable_pull = false,
+            };
+
+            // Clicks, holds and long presses are classified from raw press/release
+            // edges; iot_button only debounces.
+            button_config_t btn_cfg = {
+                .long_press_time = static_cast<uint16_t>(std::clamp(cfg.long_press_time_ms, 0, 0xFFFF)),
+                .short_press_time = 50,
+            };
+
+            button_handle_t handle = nullptr;
+            err = iot_button_new_gpio_device(&btn_cfg, &gpio_cfg, &handle);
+            if (err != ESP_OK || handle == nullptr) {
+                ESP_LOGE(TAG, "%s: failed to create button (gpio %d): %s",
+                         button_name(state), cfg.gpio, esp_err_to_name(err));
+                continue;
+            }
 
-        button_handle_t handle = nullptr;
-        esp_err_t err = iot_button_new_gpio_device(&btn_cfg, &gpio_cfg, &handle);
-        if (err != ESP_OK || handle == nullptr) {
-            ESP_LOGE(TAG, "%s: failed to create button (gpio %d): %s",
-                     button_name(state), cfg.gpio, esp_err_to_name(err));
-            continue;
+            state.handle = handle;
+            if (!primary_handle) {
+                primary_handle = handle;
+            }
         }
 
-        state.handle = handle;
-        if (!primary_handle) {
-            primary_handle = handle;
+        esp_timer_create_args_t timer_args = {
+            .callback = gesture_timer_cb,
+            .arg = &state,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "button_gesture",
+            .skip_unhandled_events = true,
+        };
+        err = esp_timer_create(&timer_args, &state.gesture_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s: failed to create gesture timer: %s",
+                     button_name(state), esp_err_to_name(err));
         }
 
-        err = iot_button_register_cb(handle, BUTTON_LONG_PRESS_UP, nullptr, button_long_press_cb, &state);
+        if (!state.handle) {
+            continue;
+        }
+        err = iot_button_register_cb(state.handle, BUTTON_PRESS_DOWN, nullptr, button_press_down_cb, &state);
+        if (err == ESP_OK) {
+            err = iot_button_register_cb(state.handle, BUTTON_PRESS_UP, nullptr, button_press_up_cb, &state);
+        }
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "%s: failed to register long press callback: %s",
+            ESP_LOGE(TAG, "%s: failed to register press callbacks: %s",
                      button_name(state), esp_err_to_name(err));
         }
+    }
 
-        err = iot_button_register_cb(handle, BUTTON_SINGLE_CLICK, nullptr, button_short_press_cb, &state);
+    if (lp_buttons::enabled()) {
+        esp_err_t err = lp_buttons::start();
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "%s: failed to register short press callback: %s",
-                     button_name(state), esp_err_to_name(err));
+            ESP_LOGE(TAG, "LP core button scanning failed to start: %s", esp_err_to_name(err));
         }
     }
 
-    if (needs_client_callbacks) {
-        ensure_client_callbacks();
+    if (needs_bindings) {
+        bound_client::ensure_bindings();
     }
 
     return primary_handle;
 }
 
+void log_gesture_stats()
+{
+    for (const ButtonRuntime &state : s_button_states) {
+        if (!state.cfg) {
+            continue;
+        }
+        for (size_t idx = 0; idx < static_cast<size_t>(Gesture::Count); ++idx) {
+            const auto gesture = static_cast<Gesture>(idx);
+            const GestureClassifier::LatencyStats &stats = state.classifier.stats(gesture);
+            if (stats.count == 0) {
+                continue;
+            }
+            ESP_LOGI(TAG, "%s: %s n=%" PRIu32 " avg=%" PRIu32 " ms max=%" PRIu32 " ms",
+                     button_name(state), GestureClassifier::name(gesture),
+                     stats.count, stats.total_ms / stats.count, stats.max_ms);
+        }
+    }
+}
+
+esp_err_t register_commands()
+{
+    return latency_stats::add_subcommand("gestures", log_gesture_stats);
+}
+
 } // namespace device_modules::button
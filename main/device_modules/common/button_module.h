@@ -6,4 +6,10 @@ namespace device_modules::button {
 
 app_driver_handle_t init();
 
+/** Logs per-gesture classification latency collected since boot. */
+void log_gesture_stats();
+
+/** @brief Registers `matter esp latency gestures`. */
+esp_err_t register_commands();
+
 }
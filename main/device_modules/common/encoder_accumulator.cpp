@@ -0,0 +1,70 @@
+#include "encoder_accumulator.h"
+
+namespace device_modules::encoder {
+
+namespace {
+
+// Acceleration multiplier is kept in 1/16 units to stay in integer math.
+constexpr uint32_t kMultiplierOne = 16;
+constexpr uint32_t kMultiplierMax = 8 * kMultiplierOne;
+
+int32_t abs32(int32_t value)
+{
+    return value < 0 ? -value : value;
+}
+
+} // namespace
+
+EncoderAccumulator::EncoderAccumulator(const Params &params) : m_params(params)
+{
+    if (m_params.counts_per_detent <= 0) {
+        m_params.counts_per_detent = 1;
+    }
+    if (m_params.step_size == 0) {
+        m_params.step_size = 1;
+    }
+    if (m_params.max_step_size < m_params.step_size) {
+        m_params.max_step_size = m_params.step_size;
+    }
+}
+
+void EncoderAccumulator::add_counts(int32_t counts)
+{
+    m_pending_counts += counts;
+}
+
+bool EncoderAccumulator::flush(uint32_t elapsed_ms, Step &out)
+{
+    const int32_t detents = m_pending_counts / m_params.counts_per_detent;
+    if (detents == 0) {
+        return false;
+    }
+    m_pending_counts -= detents * m_params.counts_per_detent;
+
+    const uint32_t magnitude = static_cast<uint32_t>(abs32(detents));
+    uint32_t multiplier = kMultiplierOne;
+    if (m_params.acceleration_threshold_dps > 0 && elapsed_ms > 0) {
+        const uint32_t detents_per_s = (magnitude * 1000U) / elapsed_ms;
+        if (detents_per_s > m_params.acceleration_threshold_dps) {
+            multiplier = (detents_per_s * kMultiplierOne) / m_params.acceleration_threshold_dps;
+            if (multiplier > kMultiplierMax) {
+                multiplier = kMultiplierMax;
+            }
+        }
+    }
+
+    uint32_t size = (magnitude * m_params.step_size * multiplier) / kMultiplierOne;
+    if (size > m_params.max_step_size) {
+        size = m_params.max_step_size;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+
+    out.up = detents > 0;
+    out.size = static_cast<uint8_t>(size);
+    out.detents = detents;
+    return true;
+}
+
+} // namespace device_modules::encoder
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+namespace device_modules::encoder {
+
+/**
+ * @brief Turns raw quadrature counts into coalesced LevelControl steps.
+ *
+ * Counts are accumulated between flushes; each flush emits at most one step
+ * whose size grows with the rotation rate. Partial detents carry over to the
+ * next interval. Plain C++ with no ESP-IDF dependency so it can be driven by
+ * the simulated encoder on a host.
+ */
+class EncoderAccumulator {
+public:
+    struct Params {
+        int32_t counts_per_detent;
+        uint8_t step_size;
+        uint8_t max_step_size;
+        uint32_t acceleration_threshold_dps;
+    };
+
+    struct Step {
+        bool up;
+        uint8_t size;
+        int32_t detents;
+    };
+
+    explicit EncoderAccumulator(const Params &params = Params{1, 1, 1, 0});
+
+    void add_counts(int32_t counts);
+
+    /** Emits the step for the last `elapsed_ms`; false when no full detent was seen. */
+    bool flush(uint32_t elapsed_ms, Step &out);
+
+    int32_t pending_counts() const { return m_pending_counts; }
+
+private:
+    Params m_params;
+    int32_t m_pending_counts = 0;
+};
+
+} // namespace device_modules::encoder
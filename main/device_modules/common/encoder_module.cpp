@@ -0,0 +1,314 @@
+#include "common/encoder_module.h"
+#include "common/bound_client.h"
+#include "common/encoder_accumulator.h"
+#include "common/endpoint_utils.h"
+
+#include "device_config.h"
+#include "generated_config.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <driver/pulse_cnt.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <lib/core/DataModelTypes.h>
+
+namespace device_modules::encoder {
+
+namespace {
+
+constexpr const char *TAG = "encoder_driver";
+
+using EncoderConfig = generated_config::encoder::config_t;
+constexpr size_t kMaxEncoders = generated_config::encoder::max_count;
+
+// PCNT limits; with accum_count the unit keeps counting across overflows.
+constexpr int kPcntHighLimit = 1000;
+constexpr int kPcntLowLimit = -1000;
+
+enum class EncoderMode { Remote, Local, Dual };
+
+struct EncoderRuntime {
+    const EncoderConfig *cfg = nullptr;
+    pcnt_unit_handle_t unit = nullptr;
+    pcnt_channel_handle_t chan_a = nullptr;
+    pcnt_channel_handle_t chan_b = nullptr;
+    esp_timer_handle_t timer = nullptr;
+    EncoderMode mode = EncoderMode::Local;
+    chip::EndpointId binding_endpoint = chip::kInvalidEndpointId;
+    chip::EndpointId target_endpoint = chip::kInvalidEndpointId;
+    EncoderAccumulator accumulator;
+    int last_count = 0;
+    int64_t last_flush_us = 0;
+    bound_client::Command remote_command{};
+};
+
+static std::array<EncoderRuntime, kMaxEncoders> s_encoder_states{};
+
+const char *encoder_name(const EncoderRuntime &enc)
+{
+    return (enc.cfg && enc.cfg->id[0] != '\0') ? enc.cfg->id : "encoder";
+}
+
+EncoderMode parse_mode(const char *mode)
+{
+    if (!mode || std::strcmp(mode, "local") == 0) {
+        return EncoderMode::Local;
+    }
+    if (std::strcmp(mode, "remote") == 0) {
+        return EncoderMode::Remote;
+    }
+    if (std::strcmp(mode, "dual") == 0) {
+        return EncoderMode::Dual;
+    }
+    ESP_LOGW(TAG, "Unknown encoder mode '%s', defaulting to local.", mode);
+    return EncoderMode::Local;
+}
+
+bool mode_has_remote(EncoderMode mode)
+{
+    return mode == EncoderMode::Remote || mode == EncoderMode::Dual;
+}
+
+bool mode_has_local(EncoderMode mode)
+{
+    return mode == EncoderMode::Local || mode == EncoderMode::Dual;
+}
+
+uint16_t transition_time_ds(const EncoderRuntime &enc)
+{
+    // Let the target ramp over one coalescing interval so steps blend together.
+    return static_cast<uint16_t>(enc.cfg->coalesce_interval_ms / 100);
+}
+
+esp_err_t perform_local_step(EncoderRuntime &enc, const EncoderAccumulator::Step &step)
+{
+    const chip::EndpointId endpoint_id = enc.target_endpoint;
+    if (endpoint_id == chip::kInvalidEndpointId) {
+        ESP_LOGW(TAG, "%s: no local endpoint available for level control.", encoder_name(enc));
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const int delta = step.up ? step.size : -static_cast<int>(step.size);
+    return utils::apply_level_delta(endpoint_id, delta, nullptr);
+}
+
+void dispatch_step(EncoderRuntime &enc, const EncoderAccumulator::Step &step)
+{
+    ESP_LOGD(TAG, "%s: %d detents -> step %s %u",
+             encoder_name(enc), static_cast<int>(step.detents), step.up ? "up" : "down",
+             static_cast<unsigned int>(step.size));
+
+    if (mode_has_remote(enc.mode)) {
+        bound_client::build_level_step(enc.remote_command, step.up, step.size, transition_time_ds(enc));
+        bound_client::send(enc.binding_endpoint, enc.remote_command, encoder_name(enc));
+    }
+    if (mode_has_local(enc.mode)) {
+        perform_local_step(enc, step);
+    }
+}
+
+void encoder_poll_cb(void *arg)
+{
+    auto *enc = static_cast<EncoderRuntime *>(arg);
+    if (!enc || !enc->unit) {
+        return;
+    }
+
+    int count = 0;
+    if (pcnt_unit_get_count(enc->unit, &count) != ESP_OK) {
+        return;
+    }
+    const int64_t now_us = esp_timer_get_time();
+    const uint32_t elapsed_ms = static_cast<uint32_t>((now_us - enc->last_flush_us) / 1000);
+    enc->last_flush_us = now_us;
+
+    if (count != enc->last_count) {
+        enc->accumulator.add_counts(count - enc->last_count);
+        enc->last_count = count;
+    }
+
+    EncoderAccumulator::Step step{};
+    if (enc->accumulator.flush(elapsed_ms, step)) {
+        dispatch_step(*enc, step);
+    }
+}
+
+void release_pcnt(EncoderRuntime &enc)
+{
+    if (!enc.unit) {
+        return;
+    }
+    // Both fail with ESP_ERR_INVALID_STATE when setup stopped earlier; that is fine.
+    pcnt_unit_stop(enc.unit);
+    pcnt_unit_disable(enc.unit);
+    if (enc.chan_b) {
+        pcnt_del_channel(enc.chan_b);
+        enc.chan_b = nullptr;
+    }
+    if (enc.chan_a) {
+        pcnt_del_channel(enc.chan_a);
+        enc.chan_a = nullptr;
+    }
+    pcnt_del_unit(enc.unit);
+    enc.unit = nullptr;
+}
+
+esp_err_t configure_pcnt(EncoderRuntime &enc)
+{
+    const EncoderConfig &cfg = *enc.cfg;
+
+    pcnt_unit_config_t unit_config = {};
+    unit_config.low_limit = kPcntLowLimit;
+    unit_config.high_limit = kPcntHighLimit;
+    unit_config.flags.accum_count = true;
+    esp_err_t err = pcnt_new_unit(&unit_config, &enc.unit);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (cfg.glitch_filter_ns > 0) {
+        pcnt_glitch_filter_config_t filter_config = {
+            .max_glitch_ns = static_cast<uint32_t>(cfg.glitch_filter_ns),
+        };
+        err = pcnt_unit_set_glitch_filter(enc.unit, &filter_config);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // Full quadrature decoding: both channels count on both edges.
+    pcnt_chan_config_t chan_a_config = {};
+    chan_a_config.edge_gpio_num = cfg.gpio_a;
+    chan_a_config.level_gpio_num = cfg.gpio_b;
+    err = pcnt_new_channel(enc.unit, &chan_a_config, &enc.chan_a);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    pcnt_chan_config_t chan_b_config = {};
+    chan_b_config.edge_gpio_num = cfg.gpio_b;
+    chan_b_config.level_gpio_num = cfg.gpio_a;
+    err = pcnt_new_channel(enc.unit, &chan_b_config, &enc.chan_b);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    pcnt_channel_set_edge_action(enc.chan_a, PCNT_CHANNEL_EDGE_ACTION_DECREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+    pcnt_channel_set_level_action(enc.chan_a, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+    pcnt_channel_set_edge_action(enc.chan_b, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+    pcnt_channel_set_level_action(enc.chan_b, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+
+    pcnt_unit_add_watch_point(enc.unit, kPcntHighLimit);
+    pcnt_unit_add_watch_point(enc.unit, kPcntLowLimit);
+
+    err = pcnt_unit_enable(enc.unit);
+    if (err == ESP_OK) {
+        err = pcnt_unit_clear_count(enc.unit);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_start(enc.unit);
+    }
+    return err;
+}
+
+esp_err_t setup_pcnt(EncoderRuntime &enc)
+{
+    const esp_err_t err = configure_pcnt(enc);
+    if (err != ESP_OK) {
+        release_pcnt(enc);
+    }
+    return err;
+}
+
+} // namespace
+
+app_driver_handle_t init()
+{
+    const size_t encoder_count = std::min(device_config::encoder_count(), kMaxEncoders);
+    if (encoder_count == 0) {
+        ESP_LOGI(TAG, "No encoders configured.");
+        return nullptr;
+    }
+
+    app_driver_handle_t primary_handle = nullptr;
+    bool needs_bindings = false;
+
+    for (size_t idx = 0; idx < encoder_count; ++idx) {
+        EncoderRuntime &state = s_encoder_states[idx];
+        const EncoderConfig &cfg = device_config::encoder(idx);
+
+        state.cfg = &cfg;
+        state.mode = parse_mode(cfg.mode);
+        state.accumulator = EncoderAccumulator({
+            .counts_per_detent = cfg.counts_per_detent,
+            .step_size = static_cast<uint8_t>(std::clamp(cfg.step_size, 1, 254)),
+            .max_step_size = static_cast<uint8_t>(std::clamp(cfg.max_step_size, 1, 254)),
+            .acceleration_threshold_dps = static_cast<uint32_t>(std::max(cfg.acceleration_threshold_dps, 0)),
+        });
+        state.last_count = 0;
+
+        state.binding_endpoint = cfg.binding_endpoint > 0
+                                     ? static_cast<chip::EndpointId>(cfg.binding_endpoint)
+                                     : chip::kInvalidEndpointId;
+        state.target_endpoint = cfg.target_endpoint > 0
+                                    ? static_cast<chip::EndpointId>(cfg.target_endpoint)
+                                    : chip::kInvalidEndpointId;
+        if (mode_has_remote(state.mode)) {
+            needs_bindings = true;
+            if (state.binding_endpoint == chip::kInvalidEndpointId) {
+                state.binding_endpoint = utils::default_binding_endpoint();
+            }
+        }
+        if (mode_has_local(state.mode) && state.target_endpoint == chip::kInvalidEndpointId) {
+            state.target_endpoint = utils::default_level_endpoint();
+        }
+
+        esp_err_t err = setup_pcnt(state);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s: failed to set up PCNT (gpio %d/%d): %s",
+                     encoder_name(state), cfg.gpio_a, cfg.gpio_b, esp_err_to_name(err));
+            continue;
+        }
+
+        esp_timer_create_args_t timer_args = {
+            .callback = encoder_poll_cb,
+            .arg = &state,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "encoder_poll",
+            .skip_unhandled_events = true,
+        };
+        err = esp_timer_create(&timer_args, &state.timer);
+        if (err == ESP_OK) {
+            state.last_flush_us = esp_timer_get_time();
+            err = esp_timer_start_periodic(state.timer, static_cast<uint64_t>(cfg.coalesce_interval_ms) * 1000U);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s: failed to start poll timer: %s", encoder_name(state), esp_err_to_name(err));
+            if (state.timer) {
+                esp_timer_delete(state.timer);
+                state.timer = nullptr;
+            }
+            release_pcnt(state);
+            continue;
+        }
+
+        ESP_LOGI(TAG, "%s: encoder ready on gpio %d/%d (interval %d ms).",
+                 encoder_name(state), cfg.gpio_a, cfg.gpio_b, cfg.coalesce_interval_ms);
+        if (!primary_handle) {
+            primary_handle = state.unit;
+        }
+    }
+
+    if (needs_bindings) {
+        bound_client::ensure_bindings();
+    }
+
+    return primary_handle;
+}
+
+} // namespace device_modules::encoder
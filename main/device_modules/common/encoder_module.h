@@ -0,0 +1,9 @@
+#pragma once
+
+#include "device_module.h"
+
+namespace device_modules::encoder {
+
+app_driver_handle_t init();
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace device_modules::encoder {
+
+/**
+ * @brief Host-side stand-in for the PCNT unit.
+ *
+ * Produces the same accumulated count the firmware reads with
+ * `pcnt_unit_get_count`, so test/host/encoder_test.cpp can feed scripted rotations
+ * (including partial detents) into EncoderAccumulator at any polling interval.
+ */
+class SimulatedEncoder {
+public:
+    explicit SimulatedEncoder(int32_t counts_per_detent) : m_counts_per_detent(counts_per_detent) {}
+
+    void rotate(int32_t detents) { m_count += detents * m_counts_per_detent; }
+
+    /** Partial movement that does not complete a detent (e.g. contact bounce). */
+    void glitch(int32_t counts) { m_count += counts; }
+
+    int32_t read_count() const { return m_count; }
+
+    /** Counts seen since the previous call, mirroring the firmware poll loop. */
+    int32_t take_delta()
+    {
+        const int32_t delta = m_count - m_last_read;
+        m_last_read = m_count;
+        return delta;
+    }
+
+private:
+    int32_t m_counts_per_detent;
+    int32_t m_count = 0;
+    int32_t m_last_read = 0;
+};
+
+} // namespace device_modules::encoder
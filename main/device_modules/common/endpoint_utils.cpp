@@ -1,14 +1,21 @@
 #include "endpoint_utils.h"
 
+#include "device_config.h"
+#include "generated_config.h"
+
+#include <algorithm>
 #include <cstring>
 #include <esp_log.h>
+#include <esp_matter_attribute.h>
 #include <esp_matter_cluster.h>
 #include <esp_matter_endpoint.h>
+#include <app-common/zap-generated/cluster-objects.h>
 
 namespace device_modules::utils {
 
 using namespace esp_matter;
 using namespace esp_matter::cluster;
+using namespace chip::app::Clusters;
 
 namespace {
 struct DeviceTypeInfo {
@@ -22,9 +29,16 @@ constexpr DeviceTypeInfo kDeviceTypes[] = {
     {"dimmable_light", ESP_MATTER_DIMMABLE_LIGHT_DEVICE_TYPE_ID, ESP_MATTER_DIMMABLE_LIGHT_DEVICE_TYPE_VERSION},
     {"extended_color_light", ESP_MATTER_EXTENDED_COLOR_LIGHT_DEVICE_TYPE_ID, ESP_MATTER_EXTENDED_COLOR_LIGHT_DEVICE_TYPE_VERSION},
     {"on_off_switch", ESP_MATTER_ON_OFF_SWITCH_DEVICE_TYPE_ID, ESP_MATTER_ON_OFF_SWITCH_DEVICE_TYPE_VERSION},
+    {"temperature_sensor", ESP_MATTER_TEMPERATURE_SENSOR_DEVICE_TYPE_ID, ESP_MATTER_TEMPERATURE_SENSOR_DEVICE_TYPE_VERSION},
+    {"humidity_sensor", ESP_MATTER_HUMIDITY_SENSOR_DEVICE_TYPE_ID, ESP_MATTER_HUMIDITY_SENSOR_DEVICE_TYPE_VERSION},
+    {"light_sensor", ESP_MATTER_LIGHT_SENSOR_DEVICE_TYPE_ID, ESP_MATTER_LIGHT_SENSOR_DEVICE_TYPE_VERSION},
+    {"occupancy_sensor", ESP_MATTER_OCCUPANCY_SENSOR_DEVICE_TYPE_ID, ESP_MATTER_OCCUPANCY_SENSOR_DEVICE_TYPE_VERSION},
 };
 
 constexpr const char *TAG = "endpoint_utils";
+
+constexpr int kMinLevel = 1;
+constexpr int kMaxLevel = 254;
 } // namespace
 
 bool lookup_device_type(const char *device_type, uint32_t &type_id, uint8_t &version)
@@ -64,4 +78,94 @@ bool add_descriptor_and_register(esp_matter::endpoint_t *endpoint,
     return true;
 }
 
+chip::EndpointId default_binding_endpoint()
+{
+    for (size_t idx = 0; idx < device_config::endpoint_count(); ++idx) {
+        const auto &endpoint = device_config::endpoint(idx);
+        if (strcmp(endpoint.device_type, "on_off_switch") == 0) {
+            return static_cast<chip::EndpointId>(endpoint.id);
+        }
+    }
+    return chip::kInvalidEndpointId;
+}
+
+chip::EndpointId default_light_endpoint()
+{
+    for (size_t idx = 0; idx < device_config::endpoint_count(); ++idx) {
+        const auto &endpoint = device_config::endpoint(idx);
+        if (endpoint.device_type[0] == '\0') {
+            continue;
+        }
+        if (endpoint.on_off.present && strcmp(endpoint.device_type, "on_off_switch") != 0) {
+            return static_cast<chip::EndpointId>(endpoint.id);
+        }
+    }
+    return chip::kInvalidEndpointId;
+}
+
+chip::EndpointId default_level_endpoint()
+{
+    for (size_t idx = 0; idx < device_config::endpoint_count(); ++idx) {
+        const auto &endpoint = device_config::endpoint(idx);
+        if (endpoint.level_control.present ||
+            strcmp(endpoint.device_type, "dimmable_light") == 0 ||
+            strcmp(endpoint.device_type, "extended_color_light") == 0) {
+            return static_cast<chip::EndpointId>(endpoint.id);
+        }
+    }
+    return chip::kInvalidEndpointId;
+}
+
+esp_err_t apply_level_delta(chip::EndpointId endpoint_id, int delta, uint8_t *out_level)
+{
+    attribute_t *level_attr = attribute::get(endpoint_id, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id);
+    if (!level_attr) {
+        ESP_LOGW(TAG, "CurrentLevel attribute not found on endpoint %u.", static_cast<unsigned int>(endpoint_id));
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_matter_attr_val_t level_val = esp_matter_invalid(nullptr);
+    int current_level = kMinLevel;
+    if (attribute::get_val(level_attr, &level_val) == ESP_OK && level_val.val.u8 <= kMaxLevel) {
+        current_level = level_val.val.u8;
+    }
+
+    bool is_on = true;
+    attribute_t *on_off_attr = attribute::get(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id);
+    if (on_off_attr) {
+        esp_matter_attr_val_t on_off_val = esp_matter_invalid(nullptr);
+        if (attribute::get_val(on_off_attr, &on_off_val) == ESP_OK) {
+            is_on = on_off_val.val.b;
+        }
+    }
+
+    if (!is_on && delta > 0) {
+        current_level = kMinLevel;
+    }
+    const int new_level = std::clamp(current_level + delta, kMinLevel, kMaxLevel);
+    if (out_level) {
+        *out_level = static_cast<uint8_t>(new_level);
+    }
+
+    esp_err_t err = ESP_OK;
+    if (new_level != current_level || !is_on) {
+        esp_matter_attr_val_t new_val = esp_matter_uint8(static_cast<uint8_t>(new_level));
+        err = attribute::update(endpoint_id, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id, &new_val);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to update CurrentLevel on endpoint %u: %s",
+                     static_cast<unsigned int>(endpoint_id), esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    if (on_off_attr) {
+        const bool want_on = delta > 0 || new_level > kMinLevel;
+        if (want_on != is_on) {
+            esp_matter_attr_val_t on_val = esp_matter_bool(want_on);
+            err = attribute::update(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, &on_val);
+        }
+    }
+    return err;
+}
+
 } // namespace device_modules::utils
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <esp_matter.h>
+#include <lib/core/DataModelTypes.h>
 
 namespace device_modules::utils {
 
@@ -10,5 +11,21 @@ bool add_descriptor_and_register(esp_matter::endpoint_t *endpoint,
                                  esp_matter::cluster::descriptor::config_t &descriptor_config,
                                  const char *device_type);
 
+/** First on_off_switch endpoint; the default client side for bindings. */
+chip::EndpointId default_binding_endpoint();
+
+/** First endpoint with OnOff that is not a switch; the default local target of buttons and rules. */
+chip::EndpointId default_light_endpoint();
+
+/** First endpoint carrying a LevelControl server; the default local dimming target. */
+chip::EndpointId default_level_endpoint();
+
+/**
+ * Moves CurrentLevel by `delta` with StepWithOnOff semantics: raising from off
+ * starts at the minimum level and turns the endpoint on, reaching the minimum
+ * while lowering turns it off. `out_level` (optional) receives the new level.
+ */
+esp_err_t apply_level_delta(chip::EndpointId endpoint_id, int delta, uint8_t *out_level);
+
 } // namespace device_modules::utils
 
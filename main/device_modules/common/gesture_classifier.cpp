@@ -0,0 +1,171 @@
+#include "gesture_classifier.h"
+
+namespace device_modules::button {
+
+GestureClassifier::GestureClassifier(const Params &params) : m_params(params)
+{
+    if (m_params.max_clicks == 0) {
+        m_params.max_clicks = 1;
+    }
+    if (m_params.max_clicks > 3) {
+        m_params.max_clicks = 3;
+    }
+}
+
+void GestureClassifier::press(uint32_t now_ms)
+{
+    if (m_state == State::Released) {
+        poll(now_ms);
+    }
+    if (m_state == State::Idle) {
+        m_clicks = 0;
+        m_single_reported = false;
+    }
+    m_state = State::Pressed;
+    m_press_ms = now_ms;
+}
+
+void GestureClassifier::release(uint32_t now_ms)
+{
+    if (m_state != State::Pressed) {
+        return;
+    }
+
+    // A hold already reported this press; Long would act on it a second time.
+    if (m_holding) {
+        emit(Gesture::HoldEnd, m_clicks, 0);
+        reset();
+        return;
+    }
+    if (m_params.long_press_time_ms > 0 && now_ms - m_press_ms >= m_params.long_press_time_ms) {
+        emit(Gesture::Long, m_clicks, 0);
+        reset();
+        return;
+    }
+
+    ++m_clicks;
+    m_release_ms = now_ms;
+    m_state = State::Released;
+
+    if (m_clicks == 2 && m_single_reported) {
+        emit(Gesture::Undo, 1, 0);
+    }
+    if (m_clicks >= m_params.max_clicks) {
+        emit_clicks(m_clicks, 0);
+        reset();
+        return;
+    }
+    if (m_params.policy == GesturePolicy::Immediate && m_clicks == 1) {
+        emit(Gesture::Single, 1, 0);
+        m_single_reported = true;
+    }
+}
+
+void GestureClassifier::poll(uint32_t now_ms)
+{
+    if (m_state == State::Pressed) {
+        if (!m_holding && m_clicks == 0 && m_params.hold_time_ms > 0 &&
+            now_ms - m_press_ms >= m_params.hold_time_ms) {
+            m_holding = true;
+            emit(Gesture::HoldStart, 0, now_ms - m_press_ms - m_params.hold_time_ms);
+        }
+        return;
+    }
+    if (m_state == State::Released && now_ms - m_release_ms >= m_params.multi_click_window_ms) {
+        const uint32_t latency_ms = now_ms - m_release_ms;
+        if (m_clicks > 1 || !m_single_reported) {
+            emit_clicks(m_clicks, latency_ms);
+        }
+        reset();
+    }
+}
+
+bool GestureClassifier::next(Event &out)
+{
+    if (m_queue_len == 0) {
+        return false;
+    }
+    out = m_queue[m_queue_head];
+    m_queue_head = (m_queue_head + 1) % kQueueSize;
+    --m_queue_len;
+    return true;
+}
+
+bool GestureClassifier::next_deadline_ms(uint32_t &deadline_ms) const
+{
+    if (m_state == State::Pressed && !m_holding && m_clicks == 0 && m_params.hold_time_ms > 0) {
+        deadline_ms = m_press_ms + m_params.hold_time_ms;
+        return true;
+    }
+    if (m_state == State::Released) {
+        deadline_ms = m_release_ms + m_params.multi_click_window_ms;
+        return true;
+    }
+    return false;
+}
+
+const char *GestureClassifier::name(Gesture gesture)
+{
+    switch (gesture) {
+    case Gesture::Single:
+        return "single";
+    case Gesture::Double:
+        return "double";
+    case Gesture::Triple:
+        return "triple";
+    case Gesture::Long:
+        return "long";
+    case Gesture::HoldStart:
+        return "hold_start";
+    case Gesture::HoldEnd:
+        return "hold_end";
+    case Gesture::Undo:
+        return "undo";
+    default:
+        return "unknown";
+    }
+}
+
+void GestureClassifier::emit(Gesture gesture, uint8_t clicks, uint32_t latency_ms)
+{
+    LatencyStats &stats = m_stats[static_cast<size_t>(gesture)];
+    ++stats.count;
+    stats.total_ms += latency_ms;
+    if (latency_ms > stats.max_ms) {
+        stats.max_ms = latency_ms;
+    }
+
+    if (m_queue_len == kQueueSize) {
+        // Oldest event is dropped; callers drain after every input so this only
+        // happens if next() is never called.
+        m_queue_head = (m_queue_head + 1) % kQueueSize;
+        --m_queue_len;
+    }
+    m_queue[(m_queue_head + m_queue_len) % kQueueSize] = Event{gesture, clicks, latency_ms};
+    ++m_queue_len;
+}
+
+void GestureClassifier::emit_clicks(uint8_t clicks, uint32_t latency_ms)
+{
+    switch (clicks) {
+    case 1:
+        emit(Gesture::Single, clicks, latency_ms);
+        break;
+    case 2:
+        emit(Gesture::Double, clicks, latency_ms);
+        break;
+    default:
+        emit(Gesture::Triple, clicks, latency_ms);
+        break;
+    }
+}
+
+void GestureClassifier::reset()
+{
+    m_state = State::Idle;
+    m_clicks = 0;
+    m_holding = false;
+    m_single_reported = false;
+}
+
+} // namespace device_modules::button
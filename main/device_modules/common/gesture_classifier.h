@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace device_modules::button {
+
+enum class Gesture : uint8_t { Single, Double, Triple, Long, HoldStart, HoldEnd, Undo, Count };
+
+/**
+ * @brief How clicks are reported when multi-click gestures are enabled.
+ *
+ * `Immediate` reports the first click as Single right away and emits Undo
+ * followed by the multi-click gesture if more clicks arrive in the window.
+ * `Wait` reports nothing until the window closes, trading latency for a
+ * single unambiguous gesture.
+ */
+enum class GesturePolicy : uint8_t { Immediate, Wait };
+
+/**
+ * @brief Turns debounced press/release edges into button gestures.
+ *
+ * Time is passed in by the caller (milliseconds, wrapping is fine), so the
+ * classifier has no ESP-IDF dependency and can be driven from a host harness.
+ * After every press(), release() or poll() the caller drains next() and
+ * re-arms its timer for next_deadline_ms().
+ */
+class GestureClassifier {
+public:
+    struct Params {
+        GesturePolicy policy;
+        uint8_t max_clicks;             // 1 disables multi-click detection
+        uint32_t multi_click_window_ms; // gap allowed between releases and the next press
+        uint32_t hold_time_ms;          // 0 disables HoldStart/HoldEnd
+        uint32_t long_press_time_ms;    // 0 disables Long; never reported after HoldStart
+    };
+
+    struct Event {
+        Gesture gesture;
+        uint8_t clicks;
+        uint32_t latency_ms; // time between the deciding edge and the report
+    };
+
+    struct LatencyStats {
+        uint32_t count;
+        uint32_t total_ms;
+        uint32_t max_ms;
+    };
+
+    explicit GestureClassifier(const Params &params = Params{GesturePolicy::Immediate, 1, 0, 0, 0});
+
+    void press(uint32_t now_ms);
+    void release(uint32_t now_ms);
+    void poll(uint32_t now_ms);
+
+    bool next(Event &out);
+
+    /** True with the absolute time of the next poll() that can emit a gesture. */
+    bool next_deadline_ms(uint32_t &deadline_ms) const;
+
+    const LatencyStats &stats(Gesture gesture) const { return m_stats[static_cast<size_t>(gesture)]; }
+
+    static const char *name(Gesture gesture);
+
+private:
+    enum class State : uint8_t { Idle, Pressed, Released };
+
+    static constexpr size_t kQueueSize = 4;
+
+    void emit(Gesture gesture, uint8_t clicks, uint32_t latency_ms);
+    void emit_clicks(uint8_t clicks, uint32_t latency_ms);
+    void reset();
+
+    Params m_params;
+    State m_state = State::Idle;
+    uint8_t m_clicks = 0;
+    bool m_holding = false;
+    bool m_single_reported = false;
+    uint32_t m_press_ms = 0;
+    uint32_t m_release_ms = 0;
+
+    Event m_queue[kQueueSize] = {};
+    size_t m_queue_head = 0;
+    size_t m_queue_len = 0;
+
+    LatencyStats m_stats[static_cast<size_t>(Gesture::Count)] = {};
+};
+
+} // namespace device_modules::button
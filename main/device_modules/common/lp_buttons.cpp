@@ -0,0 +1,248 @@
+#include "common/lp_buttons.h"
+
+#include "generated_config.h"
+#include "ulp/button_scan.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include <esp_log.h>
+#include <sdkconfig.h>
+#if APP_LP_BUTTON_SCAN
+#include <atomic>
+#include <driver/rtc_io.h>
+#include <esp_freertos_hooks.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <ulp_lp_core.h>
+
+#include "ulp_buttons.h"
+#endif
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#if APP_LP_BUTTON_SCAN
+extern "C" const uint8_t ulp_buttons_bin_start[] asm("_binary_ulp_buttons_bin_start");
+extern "C" const uint8_t ulp_buttons_bin_end[] asm("_binary_ulp_buttons_bin_end");
+#endif
+
+namespace device_modules::lp_buttons {
+
+namespace {
+
+constexpr const char *TAG = "lp_buttons";
+
+#if APP_LP_BUTTON_SCAN
+struct Binding {
+    int gpio;
+    bool active_low;
+    EdgeCallback callback;
+    void *arg;
+};
+
+Binding s_bindings[BUTTON_SCAN_MAX_GPIO] = {};
+size_t s_binding_count = 0;
+bool s_started = false;
+esp_timer_handle_t s_drain_timer = nullptr;
+std::atomic<bool> s_drain_armed{false};
+uint32_t s_edges = 0;
+
+// The LP core program's `scan`, in LP SRAM.
+button_scan_t *shared()
+{
+    return reinterpret_cast<button_scan_t *>(&ulp_scan);
+}
+
+uint32_t now_ms()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+void drain(void *)
+{
+    s_drain_armed.store(false);
+    button_scan_event_t event;
+    while (button_scan_pop(shared(), &event)) {
+        // Back-date the edge to the scan that accepted it.
+        const uint32_t age_ms = (shared()->ticks - event.tick) * generated_config::lp_core::scan_period_ms;
+        const uint32_t event_ms = now_ms() - age_ms;
+        for (size_t idx = 0; idx < s_binding_count; ++idx) {
+            if (s_bindings[idx].gpio == event.gpio) {
+                ++s_edges;
+                s_bindings[idx].callback(event.pressed != 0, event_ms, s_bindings[idx].arg);
+                break;
+            }
+        }
+    }
+}
+
+// Runs before every idle/sleep of the HP core, including right after the LP
+// core woke it. Edges are handed to the esp_timer task, where the gesture
+// timers of iot_button buttons also run.
+bool idle_hook()
+{
+    if (button_scan_pending(shared()) && !s_drain_armed.exchange(true)) {
+        if (esp_timer_start_once(s_drain_timer, 0) != ESP_OK) {
+            s_drain_armed.store(false);
+        }
+    }
+    return true;
+}
+#endif
+
+} // namespace
+
+bool enabled()
+{
+    return APP_LP_BUTTON_SCAN != 0;
+}
+
+bool supports_gpio(int gpio)
+{
+#if APP_LP_BUTTON_SCAN
+    return gpio >= 0 && gpio < BUTTON_SCAN_MAX_GPIO && rtc_gpio_is_valid_gpio(static_cast<gpio_num_t>(gpio));
+#else
+    (void) gpio;
+    return false;
+#endif
+}
+
+esp_err_t add(int gpio, bool active_low, EdgeCallback callback, void *arg)
+{
+#if APP_LP_BUTTON_SCAN
+    if (s_started || !callback || !supports_gpio(gpio) || s_binding_count == BUTTON_SCAN_MAX_GPIO) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const gpio_num_t pin = static_cast<gpio_num_t>(gpio);
+    esp_err_t err = rtc_gpio_init(pin);
+    if (err == ESP_OK) {
+        err = rtc_gpio_set_direction(pin, RTC_GPIO_MODE_INPUT_ONLY);
+    }
+    if (err == ESP_OK) {
+        err = active_low ? rtc_gpio_pullup_en(pin) : rtc_gpio_pulldown_en(pin);
+    }
+    if (err == ESP_OK) {
+        err = active_low ? rtc_gpio_pulldown_dis(pin) : rtc_gpio_pullup_dis(pin);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure LP IO %d: %s", gpio, esp_err_to_name(err));
+        return err;
+    }
+    s_bindings[s_binding_count++] = {gpio, active_low, callback, arg};
+    return ESP_OK;
+#else
+    (void) gpio;
+    (void) active_low;
+    (void) callback;
+    (void) arg;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t start()
+{
+#if APP_LP_BUTTON_SCAN
+    if (s_started || s_binding_count == 0) {
+        return ESP_OK;
+    }
+    uint32_t gpio_mask = 0;
+    uint32_t active_low_mask = 0;
+    for (size_t idx = 0; idx < s_binding_count; ++idx) {
+        gpio_mask |= 1u << s_bindings[idx].gpio;
+        if (s_bindings[idx].active_low) {
+            active_low_mask |= 1u << s_bindings[idx].gpio;
+        }
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = drain,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "lp_buttons",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_drain_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create drain timer: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = ulp_lp_core_load_binary(ulp_buttons_bin_start, ulp_buttons_bin_end - ulp_buttons_bin_start);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to load the LP core program: %s", esp_err_to_name(err));
+        return err;
+    }
+    button_scan_init(shared(), gpio_mask, active_low_mask, generated_config::lp_core::debounce_samples);
+
+    ulp_lp_core_cfg_t cfg = {};
+    cfg.wakeup_source = ULP_LP_CORE_WAKEUP_SOURCE_LP_TIMER;
+    cfg.lp_timer_sleep_duration_us = generated_config::lp_core::scan_period_ms * 1000;
+    err = ulp_lp_core_run(&cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the LP core: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = esp_sleep_enable_ulp_wakeup();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "LP core cannot wake the chip from light sleep: %s", esp_err_to_name(err));
+    }
+    err = esp_register_freertos_idle_hook(idle_hook);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register the idle hook: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_started = true;
+    ESP_LOGI(TAG, "LP core scans %u button(s) every %" PRIu32 " ms (mask 0x%02" PRIx32 ").",
+             static_cast<unsigned>(s_binding_count), generated_config::lp_core::scan_period_ms, gpio_mask);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+Stats stats()
+{
+    Stats stats{};
+#if APP_LP_BUTTON_SCAN
+    if (s_started) {
+        stats.scans = shared()->ticks;
+        stats.wakeups = shared()->wakeups;
+        stats.dropped = shared()->dropped;
+        stats.edges = s_edges;
+    }
+#endif
+    return stats;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL && APP_LP_BUTTON_SCAN
+namespace {
+
+esp_err_t lpcore_command(int, char **)
+{
+    const Stats current = stats();
+    printf("LP core: %s, %" PRIu32 " scans, %" PRIu32 " HP wake-ups, %" PRIu32 " edges, %" PRIu32 " dropped\n",
+           s_started ? "scanning" : "stopped", current.scans, current.wakeups, current.edges, current.dropped);
+    return ESP_OK;
+}
+
+} // namespace
+#endif
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL && APP_LP_BUTTON_SCAN
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "lpcore",
+            .description = "LP core button scanner counters. Usage: matter esp lpcore",
+            .handler = lpcore_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace device_modules::lp_buttons
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <esp_err.h>
+
+#include <cstdint>
+
+namespace device_modules::lp_buttons {
+
+/** Called in the esp_timer task with the time the edge was debounced, in esp_timer milliseconds. */
+using EdgeCallback = void (*)(bool pressed, uint32_t event_ms, void *arg);
+
+struct Stats {
+    uint32_t scans;   // LP core runs since start()
+    uint32_t wakeups; // times the LP core woke the HP core
+    uint32_t edges;   // edges delivered to callbacks
+    uint32_t dropped; // edges lost to a full queue
+};
+
+/** True when `power.lp_core.buttons` moved button scanning to the LP core. */
+bool enabled();
+
+/** True when the LP core can read @p gpio (LP IOs 0..7 on the ESP32-C6). */
+bool supports_gpio(int gpio);
+
+/** Registers a button before start(); its pin is configured as an LP IO with the matching pull. */
+esp_err_t add(int gpio, bool active_low, EdgeCallback callback, void *arg);
+
+/**
+ * @brief Loads the LP core program and starts scanning.
+ *
+ * The LP core samples every added button once per `scan_period_ms` and
+ * debounces on its own; the HP core is woken only when an edge is queued
+ * and drains the queue from its idle hook, so bounces and idle scans never
+ * cost HP wake-ups.
+ */
+esp_err_t start();
+
+Stats stats();
+
+/** @brief Registers `matter esp lpcore`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace device_modules::lp_buttons
@@ -0,0 +1,479 @@
+#include "common/rule_engine.h"
+#include "common/bound_client.h"
+#include "common/endpoint_utils.h"
+#include "light/light_module.h"
+
+#include "deferred_log.h"
+#include "generated_config.h"
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_matter_core.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <app-common/zap-generated/cluster-objects.h>
+#include <platform/CHIPDeviceLayer.h>
+
+namespace device_modules::rules {
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+namespace {
+
+constexpr const char *TAG = "rules";
+
+using Rule = generated_config::rules::rule_t;
+using RuleAction = generated_config::rules::action_t;
+constexpr size_t kRuleCount = generated_config::rules::count;
+static_assert(kRuleCount <= 32, "pending rules are a 32-bit mask");
+
+// Rules triggered by the actions of other rules run in further rounds of the
+// same pass; a cycle between rules is cut after this many rounds.
+constexpr int kMaxChain = 4;
+
+struct RuleState {
+    bool matched; // attribute value inside the condition
+    bool armed;   // deadline_ms is pending
+    uint32_t deadline_ms;
+};
+
+// Attribute and timer triggers; touched with the CHIP stack lock held.
+std::array<RuleState, kRuleCount> s_state{};
+
+// Set from any context; the runner drains them on the esp_timer task.
+std::atomic<bool> s_started{false};
+std::atomic<uint32_t> s_pending{0};
+std::atomic<uint32_t> s_chained{0};
+std::atomic<TaskHandle_t> s_runner_task{nullptr};
+std::array<std::atomic<uint32_t>, kRuleCount> s_triggered_us{};
+esp_timer_handle_t s_run_timer = nullptr;
+
+// Runner only.
+std::array<uint32_t, kRuleCount> s_fired{};
+bound_client::Command s_command{};
+Stats s_stats{};
+
+const Rule &rule_at(size_t idx)
+{
+    return generated_config::rules::rules[idx];
+}
+
+uint32_t now_ms()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+void fire(size_t idx)
+{
+    const uint32_t bit = 1U << idx;
+    s_triggered_us[idx].store(static_cast<uint32_t>(esp_timer_get_time()), std::memory_order_relaxed);
+    // An action of a running rule changed an attribute: next round of this pass.
+    if (s_runner_task.load() == xTaskGetCurrentTaskHandle()) {
+        s_chained.fetch_or(bit);
+        return;
+    }
+    s_pending.fetch_or(bit);
+    // Fails with ESP_ERR_INVALID_STATE while already armed; that run drains this bit too.
+    esp_timer_start_once(s_run_timer, 0);
+}
+
+chip::EndpointId local_endpoint(const RuleAction &action)
+{
+    if (action.endpoint != 0) {
+        return static_cast<chip::EndpointId>(action.endpoint);
+    }
+    return static_cast<Action>(action.kind) == Action::LevelStep ? utils::default_level_endpoint()
+                                                                 : utils::default_light_endpoint();
+}
+
+esp_err_t update(chip::EndpointId endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t val)
+{
+    if (endpoint_id == chip::kInvalidEndpointId || !attribute::get(endpoint_id, cluster_id, attribute_id)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return attribute::update(endpoint_id, cluster_id, attribute_id, &val);
+}
+
+esp_err_t run_local(const RuleAction &action)
+{
+    const chip::EndpointId endpoint_id = local_endpoint(action);
+    switch (static_cast<Action>(action.kind)) {
+    case Action::OnOff: {
+        bool on = action.value == 1;
+        if (action.value == 2) {
+            attribute_t *attr = attribute::get(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id);
+            esp_matter_attr_val_t current = esp_matter_invalid(nullptr);
+            on = !(attr && attribute::get_val(attr, &current) == ESP_OK && current.val.b);
+        }
+        return update(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, esp_matter_bool(on));
+    }
+    case Action::Level: {
+        // MoveToLevelWithOnOff semantics: 0 turns the light off and keeps its level.
+        if (action.value == 0) {
+            return update(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, esp_matter_bool(false));
+        }
+        esp_err_t err = update(endpoint_id, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id,
+                               esp_matter_uint8(static_cast<uint8_t>(action.value)));
+        if (err == ESP_OK && attribute::get(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id)) {
+            err = update(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, esp_matter_bool(true));
+        }
+        return err;
+    }
+    case Action::LevelStep:
+        return utils::apply_level_delta(endpoint_id, action.value, nullptr);
+    case Action::Identify:
+        return update(endpoint_id, Identify::Id, Identify::Attributes::IdentifyTime::Id,
+                      esp_matter_uint16(static_cast<uint16_t>(action.value)));
+    case Action::Scene:
+        return light::recall_scene(action.group_id, static_cast<uint8_t>(action.value));
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t run_bound(const RuleAction &action, const char *name)
+{
+    switch (static_cast<Action>(action.kind)) {
+    case Action::OnOff: {
+        constexpr chip::CommandId kCommands[] = {OnOff::Commands::Off::Id, OnOff::Commands::On::Id,
+                                                 OnOff::Commands::Toggle::Id};
+        bound_client::build_on_off(s_command, kCommands[action.value]);
+        break;
+    }
+    case Action::Level:
+        bound_client::build_level_move_to(s_command, static_cast<uint8_t>(action.value), 0);
+        break;
+    case Action::LevelStep:
+        bound_client::build_level_step(s_command, action.value > 0, static_cast<uint8_t>(std::abs(action.value)), 0);
+        break;
+    case Action::Identify:
+        bound_client::build_identify(s_command, static_cast<uint16_t>(action.value));
+        break;
+    case Action::Scene:
+        bound_client::build_recall_scene(s_command, action.group_id, static_cast<uint8_t>(action.value));
+        break;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+    const chip::EndpointId binding_endpoint =
+        action.endpoint != 0 ? static_cast<chip::EndpointId>(action.endpoint) : utils::default_binding_endpoint();
+    return bound_client::send(binding_endpoint, s_command, name);
+}
+
+void run_rule(size_t idx)
+{
+    const Rule &rule = rule_at(idx);
+    for (size_t pos = 0; pos < rule.action_count; ++pos) {
+        const RuleAction &action = generated_config::rules::actions[rule.first_action + pos];
+        const esp_err_t err = action.bound ? run_bound(action, rule.name) : run_local(action);
+        if (err == ESP_OK) {
+            ++s_stats.actions;
+        } else {
+            ++s_stats.failed;
+            DLOGW(RULES, TAG, "%s: action %u failed: %s", rule.name, static_cast<unsigned int>(pos),
+                  esp_err_to_name(err));
+        }
+    }
+    const uint32_t latency_us =
+        static_cast<uint32_t>(esp_timer_get_time()) - s_triggered_us[idx].load(std::memory_order_relaxed);
+    if (latency_us > s_stats.max_latency_us) {
+        s_stats.max_latency_us = latency_us;
+    }
+    ++s_stats.fired;
+    ++s_fired[idx];
+    DLOGI(RULES, TAG, "%s: %u actions in %" PRIu32 " us", rule.name, static_cast<unsigned int>(rule.action_count),
+          latency_us);
+}
+
+void run_pending(void *)
+{
+    s_runner_task.store(xTaskGetCurrentTaskHandle());
+    uint32_t pending = s_pending.exchange(0);
+    for (int round = 0; pending != 0; ++round) {
+        if (round == kMaxChain) {
+            s_stats.loops_cut += static_cast<uint32_t>(__builtin_popcount(pending));
+            DLOGW(RULES, TAG, "Rules keep triggering each other; dropped 0x%08" PRIx32 ".", pending);
+            break;
+        }
+        for (size_t idx = 0; idx < kRuleCount; ++idx) {
+            if (pending & (1U << idx)) {
+                run_rule(idx);
+            }
+        }
+        pending = s_chained.exchange(0);
+    }
+    s_runner_task.store(nullptr);
+}
+
+bool to_int(const esp_matter_attr_val_t &val, int64_t &out)
+{
+    switch (static_cast<esp_matter_val_type_t>(val.type & ~ESP_MATTER_VAL_NULLABLE_BASE)) {
+    case ESP_MATTER_VAL_TYPE_BOOLEAN:
+        out = val.val.b;
+        return true;
+    case ESP_MATTER_VAL_TYPE_UINT8:
+    case ESP_MATTER_VAL_TYPE_ENUM8:
+    case ESP_MATTER_VAL_TYPE_BITMAP8:
+        out = val.val.u8;
+        return true;
+    case ESP_MATTER_VAL_TYPE_UINT16:
+    case ESP_MATTER_VAL_TYPE_ENUM16:
+        out = val.val.u16;
+        return true;
+    case ESP_MATTER_VAL_TYPE_INT16:
+        out = val.val.i16;
+        return true;
+    case ESP_MATTER_VAL_TYPE_UINT32:
+        out = val.val.u32;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool inside(const Rule &rule, int64_t value)
+{
+    switch (static_cast<Compare>(rule.compare)) {
+    case Compare::Equal:
+        return value == rule.value;
+    case Compare::Above:
+        return value > rule.value;
+    case Compare::Below:
+        return value < rule.value;
+    case Compare::Changed:
+        break;
+    }
+    return true;
+}
+
+void deadline_cb(chip::System::Layer *, void *);
+
+void arm_deadline_timer(uint32_t now)
+{
+    bool any = false;
+    uint32_t earliest_ms = 0;
+    for (const RuleState &state : s_state) {
+        if (state.armed && (!any || static_cast<int32_t>(state.deadline_ms - earliest_ms) < 0)) {
+            earliest_ms = state.deadline_ms;
+            any = true;
+        }
+    }
+    if (!any) {
+        chip::DeviceLayer::SystemLayer().CancelTimer(deadline_cb, nullptr);
+        return;
+    }
+    const int32_t delay_ms = static_cast<int32_t>(earliest_ms - now);
+    chip::DeviceLayer::SystemLayer().StartTimer(
+        chip::System::Clock::Milliseconds32(delay_ms > 0 ? static_cast<uint32_t>(delay_ms) : 0), deadline_cb,
+        nullptr);
+}
+
+// Runs on the CHIP task.
+void deadline_cb(chip::System::Layer *, void *)
+{
+    const uint32_t now = now_ms();
+    for (size_t idx = 0; idx < kRuleCount; ++idx) {
+        RuleState &state = s_state[idx];
+        if (!state.armed || static_cast<int32_t>(now - state.deadline_ms) < 0) {
+            continue;
+        }
+        fire(idx);
+        const Rule &rule = rule_at(idx);
+        if (static_cast<Trigger>(rule.trigger) == Trigger::Timer) {
+            state.deadline_ms += rule.period_ms;
+            if (static_cast<int32_t>(now - state.deadline_ms) >= 0) {
+                state.deadline_ms = now + rule.period_ms; // fell behind, e.g. after a long CHIP stall
+            }
+        } else {
+            state.armed = false;
+        }
+    }
+    arm_deadline_timer(now);
+}
+
+bool read_attribute(const Rule &rule, int64_t &out)
+{
+    attribute_t *attr = attribute::get(rule.endpoint, rule.cluster_id, rule.attribute_id);
+    esp_matter_attr_val_t val = esp_matter_invalid(nullptr);
+    return attr && attribute::get_val(attr, &val) == ESP_OK && to_int(val, out);
+}
+
+const char *trigger_name(const Rule &rule)
+{
+    switch (static_cast<Trigger>(rule.trigger)) {
+    case Trigger::Button:
+        return button::GestureClassifier::name(static_cast<button::Gesture>(rule.gesture));
+    case Trigger::Attribute:
+        return "attribute";
+    case Trigger::Timer:
+        return "timer";
+    }
+    return "?";
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t rules_command(int, char **)
+{
+    printf("%u rules, fired %" PRIu32 ", actions %" PRIu32 " (failed %" PRIu32 "), loops cut %" PRIu32
+           ", max latency %" PRIu32 " us\n",
+           static_cast<unsigned int>(kRuleCount), s_stats.fired, s_stats.actions, s_stats.failed, s_stats.loops_cut,
+           s_stats.max_latency_us);
+    for (size_t idx = 0; idx < kRuleCount; ++idx) {
+        const Rule &rule = rule_at(idx);
+        printf("  %s: %s%s%s, %u actions, fired %" PRIu32 "%s\n", rule.name, trigger_name(rule),
+               rule.button ? " of " : "", rule.button ? rule.button : "", static_cast<unsigned int>(rule.action_count),
+               s_fired[idx], s_state[idx].armed ? ", armed" : "");
+    }
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+esp_err_t start()
+{
+    if (kRuleCount == 0 || s_started.load()) {
+        return ESP_OK;
+    }
+    esp_timer_create_args_t timer_args = {
+        .callback = run_pending,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "rules",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_run_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create rule timer: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    if (esp_matter::lock::chip_stack_lock(portMAX_DELAY) != esp_matter::lock::status::SUCCESS) {
+        return ESP_FAIL;
+    }
+    // A condition that already holds at boot counts from now, so `for_s`
+    // rules catch a light restored on; it does not fire edge rules.
+    const uint32_t now = now_ms();
+    for (size_t idx = 0; idx < kRuleCount; ++idx) {
+        const Rule &rule = rule_at(idx);
+        RuleState &state = s_state[idx];
+        int64_t value = 0;
+        if (static_cast<Trigger>(rule.trigger) == Trigger::Timer) {
+            state.armed = true;
+            state.deadline_ms = now + rule.period_ms;
+        } else if (static_cast<Trigger>(rule.trigger) == Trigger::Attribute && read_attribute(rule, value)) {
+            state.matched = inside(rule, value);
+            state.armed = state.matched && rule.period_ms > 0;
+            state.deadline_ms = now + rule.period_ms;
+        }
+    }
+    arm_deadline_timer(now);
+    s_started.store(true);
+    esp_matter::lock::chip_stack_unlock();
+    ESP_LOGI(TAG, "%u rules loaded.", static_cast<unsigned int>(kRuleCount));
+    return ESP_OK;
+}
+
+bool handles(const char *button_id, button::Gesture gesture)
+{
+    for (size_t idx = 0; idx < kRuleCount; ++idx) {
+        const Rule &rule = rule_at(idx);
+        if (static_cast<Trigger>(rule.trigger) == Trigger::Button && rule.gesture == static_cast<uint8_t>(gesture) &&
+            button_id && std::strcmp(rule.button, button_id) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool on_button(const char *button_id, button::Gesture gesture)
+{
+    if (!s_started.load()) {
+        return false;
+    }
+    bool matched = false;
+    for (size_t idx = 0; idx < kRuleCount; ++idx) {
+        const Rule &rule = rule_at(idx);
+        if (static_cast<Trigger>(rule.trigger) == Trigger::Button && rule.gesture == static_cast<uint8_t>(gesture) &&
+            std::strcmp(rule.button, button_id) == 0) {
+            fire(idx);
+            matched = true;
+        }
+    }
+    return matched;
+}
+
+void on_attribute_changed(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                          const esp_matter_attr_val_t &val)
+{
+    if (!s_started.load()) {
+        return;
+    }
+    bool rearm = false;
+    int64_t value = 0;
+    for (size_t idx = 0; idx < kRuleCount; ++idx) {
+        const Rule &rule = rule_at(idx);
+        if (static_cast<Trigger>(rule.trigger) != Trigger::Attribute || rule.endpoint != endpoint_id ||
+            rule.cluster_id != cluster_id || rule.attribute_id != attribute_id || !to_int(val, value)) {
+            continue;
+        }
+        if (static_cast<Compare>(rule.compare) == Compare::Changed) {
+            fire(idx);
+            continue;
+        }
+        RuleState &state = s_state[idx];
+        const bool now_inside = inside(rule, value);
+        const bool entered = now_inside && !state.matched;
+        state.matched = now_inside;
+        if (!now_inside && state.armed) {
+            state.armed = false;
+            rearm = true;
+        } else if (entered && rule.period_ms == 0) {
+            fire(idx);
+        } else if (entered) {
+            state.armed = true;
+            state.deadline_ms = now_ms() + rule.period_ms;
+            rearm = true;
+        }
+    }
+    if (rearm) {
+        arm_deadline_timer(now_ms());
+    }
+}
+
+Stats stats()
+{
+    return s_stats;
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "rules",
+            .description = "Local automation rules and their counters. Usage: matter esp rules",
+            .handler = rules_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace device_modules::rules
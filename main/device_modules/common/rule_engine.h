@@ -0,0 +1,62 @@
+#pragma once
+
+#include "common/gesture_classifier.h"
+
+#include <esp_err.h>
+#include <esp_matter_attribute_utils.h>
+
+#include <cstdint>
+
+namespace device_modules::rules {
+
+// Values of generated_config::rules, kept in step with tools/render_config.py.
+enum class Trigger : uint8_t { Button, Attribute, Timer };
+enum class Compare : uint8_t { Changed, Equal, Above, Below };
+enum class Action : uint8_t { OnOff, Level, LevelStep, Identify, Scene };
+
+struct Stats {
+    uint32_t fired;          // rules whose actions ran
+    uint32_t actions;        // actions that returned ESP_OK
+    uint32_t failed;         // actions that did not
+    uint32_t loops_cut;      // rules dropped after four rounds of rules triggering rules
+    uint32_t max_latency_us; // trigger to last action done
+};
+
+/**
+ * @brief Enables the YAML `rules` and arms their timers. Call once the
+ * Matter stack runs; triggers before that are ignored.
+ *
+ * Rules are compiled into a constexpr table. A trigger only marks its rule
+ * pending; the actions run in order on the esp_timer task, the same context
+ * the button actions use, with no allocation and no round trip through a
+ * controller. Local actions write attributes of this node; bound actions go
+ * to the peers bound to an endpoint, groupcast first, as button commands do.
+ */
+esp_err_t start();
+
+/**
+ * @brief Runs the rules for @p gesture of the button with @p button_id.
+ *
+ * Returns true when a rule matched, in which case the button's own action
+ * for that gesture is skipped.
+ */
+bool on_button(const char *button_id, button::Gesture gesture);
+
+/** True when a rule listens for @p gesture of @p button_id; enables multi-click and hold detection. */
+bool handles(const char *button_id, button::Gesture gesture);
+
+/**
+ * @brief Feeds an attribute change (esp_matter POST_UPDATE), with the CHIP
+ * stack lock held. A rule fires when the value enters its condition, or on
+ * every change without one; with `for_s` the value must stay in the
+ * condition that long.
+ */
+void on_attribute_changed(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                          const esp_matter_attr_val_t &val);
+
+Stats stats();
+
+/** @brief Registers `matter esp rules`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace device_modules::rules
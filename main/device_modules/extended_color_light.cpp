@@ -2,6 +2,7 @@
 
 #include "device_modules/common/endpoint_utils.h"
 #include "generated_config.h"
+#include "mac_credentials.h"
 
 #include <app-common/zap-generated/cluster-objects.h>
 #include <esp_mac.h>
@@ -178,7 +179,7 @@ uint8_t clamp_uint8(int value, uint8_t min_value, uint8_t max_value)
 
 uint8_t parse_color_mode(const generated_config::optional_string &value, uint8_t fallback)
 {
-    if (!value.has_value || !value.value) {
+    if (!value.has_value || value.value[0] == '\0') {
         return fallback;
     }
     if (strings_equal(value.value, "kColorTemperature") || strings_equal(value.value, "kColorTemperatureMireds")) {
@@ -195,7 +196,7 @@ uint8_t parse_color_mode(const generated_config::optional_string &value, uint8_t
 
 uint8_t parse_enhanced_mode(const generated_config::optional_string &value, uint8_t fallback)
 {
-    if (!value.has_value || !value.value) {
+    if (!value.has_value || value.value[0] == '\0') {
         return fallback;
     }
     if (strings_equal(value.value, "kColorTemperature") || strings_equal(value.value, "kColorTemperatureMireds")) {
@@ -265,20 +266,13 @@ void register_provider()
     }
     chip::DeviceLayer::CommissionableDataProvider *base = chip::DeviceLayer::GetCommissionableDataProvider();
     g_provider.SetBase(base);
-    uint16_t discriminator = 3840;
-    uint32_t passcode = 20202021;
+    mac_credentials::Credentials credentials = {mac_credentials::kFallbackPasscode,
+                                                mac_credentials::kFallbackDiscriminator};
     uint8_t mac[6] = {0};
     if (read_mac(mac)) {
-        uint64_t mac_value = 0;
-        for (int i = 0; i < 6; ++i) {
-            mac_value = (mac_value << 8) | mac[i];
-        }
-        uint64_t mix = mac_value ^ (mac_value >> 12) ^ 0x5A5A5A5A5A5AULL;
-        uint32_t pin_raw = static_cast<uint32_t>(mix % 99999999ULL);
-        passcode = 10000000U + (pin_raw % 89999999U);
-        discriminator = static_cast<uint16_t>((mac_value ^ (mac_value >> 24)) & 0x0FFFU);
+        credentials = mac_credentials::derive(mac);
     }
-    g_provider.SetCredentials(discriminator, passcode);
+    g_provider.SetCredentials(credentials.discriminator, credentials.passcode);
     chip::DeviceLayer::SetCommissionableDataProvider(&g_provider);
     g_provider_registered = true;
 }
@@ -0,0 +1,116 @@
+#include "effect_player.h"
+
+namespace device_modules::light {
+
+namespace {
+
+enum class Shape : uint8_t { Square, Triangle, Flash };
+
+struct EffectSpec {
+    Effect effect;
+    uint32_t period_ms;
+    uint16_t cycles; // 0 runs until stopped
+    Shape shape;
+    bool coloured;
+    uint8_t hue; // Matter units, 0..254
+};
+
+constexpr uint8_t kFullLevel = 254;
+constexpr uint8_t kMinLevel = 1;
+constexpr uint32_t kFlashMs = 500;
+
+// Timings follow the TriggerEffect descriptions: blink once, breathe 15
+// times over a second each, a green "okay" double blink, and an orange
+// channel-change flash that stays at minimum for the rest of 8 s.
+constexpr EffectSpec kSpecs[] = {
+    {Effect::Blink, 1000, 1, Shape::Square, false, 0},
+    {Effect::Breathe, 1000, 15, Shape::Triangle, false, 0},
+    {Effect::Okay, 500, 2, Shape::Square, true, 85},
+    {Effect::ChannelChange, 8000, 1, Shape::Flash, true, 21},
+    {Effect::Identify, 1000, 0, Shape::Square, false, 0},
+};
+
+const EffectSpec &spec_for(Effect effect)
+{
+    for (const auto &spec : kSpecs) {
+        if (spec.effect == effect) {
+            return spec;
+        }
+    }
+    return kSpecs[0];
+}
+
+uint8_t level_at(const EffectSpec &spec, uint64_t phase_us, uint64_t period_us)
+{
+    switch (spec.shape) {
+    case Shape::Square:
+        return phase_us < period_us / 2 ? kFullLevel : 0;
+    case Shape::Triangle: {
+        const uint64_t half = period_us / 2;
+        const uint64_t ramp = phase_us < half ? phase_us : period_us - phase_us;
+        return static_cast<uint8_t>(ramp * kFullLevel / half);
+    }
+    case Shape::Flash:
+        return phase_us < static_cast<uint64_t>(kFlashMs) * 1000 ? kFullLevel : kMinLevel;
+    }
+    return 0;
+}
+
+} // namespace
+
+uint64_t EffectPlayer::period_us() const
+{
+    return static_cast<uint64_t>(spec_for(m_effect).period_ms) * 1000;
+}
+
+void EffectPlayer::start(Effect effect, const LightState &base, uint64_t now_us)
+{
+    m_effect = effect;
+    m_base = base;
+    m_active = true;
+    const EffectSpec &spec = spec_for(effect);
+    if (spec.cycles == 0) {
+        m_end_us = 0;
+        return;
+    }
+    // The cycle in progress counts as the first one unless less than half of
+    // it is left.
+    const uint64_t period = period_us();
+    const uint64_t phase = now_us % period;
+    m_end_us = now_us - phase + period * spec.cycles + (phase > period / 2 ? period : 0);
+}
+
+void EffectPlayer::finish(uint64_t now_us)
+{
+    if (!m_active) {
+        return;
+    }
+    const uint64_t period = period_us();
+    const uint64_t cycle_end = now_us - now_us % period + period;
+    if (m_end_us == 0 || cycle_end < m_end_us) {
+        m_end_us = cycle_end;
+    }
+}
+
+bool EffectPlayer::render(uint64_t now_us, LightState &out)
+{
+    if (m_active && m_end_us != 0 && now_us >= m_end_us) {
+        m_active = false;
+    }
+    if (!m_active) {
+        return false;
+    }
+    const EffectSpec &spec = spec_for(m_effect);
+    const uint64_t period = period_us();
+    out = m_base;
+    out.level = level_at(spec, now_us % period, period);
+    out.on = out.level > 0;
+    if (spec.coloured) {
+        out.mode = ColorMode::HueSaturation;
+        out.hue = spec.hue;
+        out.saturation = kFullLevel;
+    }
+    return true;
+}
+
+} // namespace device_modules::light
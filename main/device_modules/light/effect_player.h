@@ -0,0 +1,54 @@
+#pragma once
+
+#include "light_state.h"
+
+#include <cstdint>
+
+namespace device_modules::light {
+
+/** Identify cluster effects, by their TriggerEffect ids; Identify is the IdentifyTime blink. */
+enum class Effect : uint8_t {
+    Blink = 0x00,
+    Breathe = 0x01,
+    Okay = 0x02,
+    ChannelChange = 0x0b,
+    Identify = 0xf0,
+};
+
+constexpr uint8_t kEffectFinish = 0xfe;
+constexpr uint8_t kEffectStop = 0xff;
+
+/**
+ * @brief Renders effects as a function of group time.
+ *
+ * The frame at time t depends only on t modulo the effect period, never on
+ * when the command arrived, so lights sharing a GroupClock show the same
+ * phase however far apart a groupcast reached them. A light that starts
+ * late joins the cycle in progress; the effect ends on a period boundary,
+ * which is the same one for every light unless they started on either side
+ * of it. No ESP-IDF dependency.
+ */
+class EffectPlayer {
+public:
+    /** Starts @p effect at group time @p now_us; @p base supplies the colour and is what finishes on. */
+    void start(Effect effect, const LightState &base, uint64_t now_us);
+
+    /** FinishEffect: ends at the end of the cycle in progress. */
+    void finish(uint64_t now_us);
+    void stop() { m_active = false; }
+    bool active() const { return m_active; }
+    Effect effect() const { return m_effect; }
+
+    /** Frame at group time @p now_us; false once the effect is over. */
+    bool render(uint64_t now_us, LightState &out);
+
+private:
+    uint64_t period_us() const;
+
+    Effect m_effect = Effect::Blink;
+    LightState m_base{};
+    uint64_t m_end_us = 0; // 0 runs until stopped
+    bool m_active = false;
+};
+
+} // namespace device_modules::light
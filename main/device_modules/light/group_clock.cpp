@@ -0,0 +1,255 @@
+#include "group_clock.h"
+
+namespace device_modules::light {
+
+namespace {
+
+constexpr uint8_t kSyncMagic[4] = {'L', 'S', 'Y', 'N'};
+constexpr uint8_t kSyncVersion = 1;
+
+void put_be(uint8_t *out, uint64_t value, size_t bytes)
+{
+    for (size_t idx = 0; idx < bytes; ++idx) {
+        out[idx] = static_cast<uint8_t>(value >> (8 * (bytes - 1 - idx)));
+    }
+}
+
+uint64_t get_be(const uint8_t *data, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t idx = 0; idx < bytes; ++idx) {
+        value = value << 8 | data[idx];
+    }
+    return value;
+}
+
+} // namespace
+
+void encode_sync(const SyncMessage &message, uint8_t *out)
+{
+    for (size_t idx = 0; idx < sizeof(kSyncMagic); ++idx) {
+        out[idx] = kSyncMagic[idx];
+    }
+    out[4] = kSyncVersion;
+    out[5] = static_cast<uint8_t>(message.type);
+    put_be(out + 6, message.domain, 2);
+    put_be(out + 8, message.node_id, 8);
+    put_be(out + 16, message.peer_id, 8);
+    put_be(out + 24, message.t1, 8);
+    put_be(out + 32, message.t2, 8);
+    put_be(out + 40, message.t3, 8);
+}
+
+bool decode_sync(const uint8_t *data, size_t len, SyncMessage &out)
+{
+    if (len != kSyncMessageSize || data[4] != kSyncVersion) {
+        return false;
+    }
+    for (size_t idx = 0; idx < sizeof(kSyncMagic); ++idx) {
+        if (data[idx] != kSyncMagic[idx]) {
+            return false;
+        }
+    }
+    if (data[5] < static_cast<uint8_t>(SyncType::Beacon) || data[5] > static_cast<uint8_t>(SyncType::DelayResponse)) {
+        return false;
+    }
+    out.type = static_cast<SyncType>(data[5]);
+    out.domain = static_cast<uint16_t>(get_be(data + 6, 2));
+    out.node_id = get_be(data + 8, 8);
+    out.peer_id = get_be(data + 16, 8);
+    out.t1 = get_be(data + 24, 8);
+    out.t2 = get_be(data + 32, 8);
+    out.t3 = get_be(data + 40, 8);
+    return true;
+}
+
+void GroupClock::configure(const Config &config, uint64_t local_us)
+{
+    *this = GroupClock{};
+    m_config = config;
+    m_started_us = local_us;
+}
+
+uint64_t GroupClock::leader_timeout_us() const
+{
+    // Three missed beacons and a half before anyone takes over.
+    return interval_us() * 7 / 2;
+}
+
+bool GroupClock::leader(uint64_t local_us) const
+{
+    if (!m_synced) {
+        // Listen first, so a node joining an existing group adopts its time.
+        return local_us - m_started_us >= leader_timeout_us();
+    }
+    if (!m_has_leader || local_us - m_leader_seen_us >= leader_timeout_us()) {
+        return true;
+    }
+    // A lower id takes over a running group only once its offset is refined,
+    // or the whole group would inherit its one-way latency.
+    return m_leader_id > m_config.node_id && m_exchange_count >= kWindow / 2;
+}
+
+void GroupClock::follow(uint64_t leader_id)
+{
+    // A new leader of the same group shares its time base, so exchanges with
+    // the old one stay valid and age out of the window; only a node without
+    // a time base starts over.
+    m_leader_id = leader_id;
+    m_has_leader = true;
+    m_request_armed = false;
+    m_request_pending = false;
+    if (!m_synced) {
+        m_coarse = false;
+        m_exchange_count = 0;
+        m_exchange_next = 0;
+        m_rtt_us = 0;
+    }
+    ++m_stats.leader_changes;
+}
+
+bool GroupClock::on_message(const SyncMessage &message, uint64_t rx_local_us, SyncMessage &reply)
+{
+    if (message.domain != m_config.domain || message.node_id == m_config.node_id) {
+        ++m_stats.ignored;
+        return false;
+    }
+    switch (message.type) {
+    case SyncType::Beacon:
+        on_beacon(message, rx_local_us);
+        return false;
+    case SyncType::DelayRequest:
+        if (!leader(rx_local_us)) {
+            ++m_stats.ignored;
+            return false;
+        }
+        reply = {SyncType::DelayResponse, m_config.domain, m_config.node_id, message.node_id,
+                 message.t1,              group_us(rx_local_us), group_us(rx_local_us)};
+        ++m_stats.answered;
+        return true;
+    case SyncType::DelayResponse:
+        on_response(message, rx_local_us);
+        return false;
+    }
+    return false;
+}
+
+void GroupClock::on_beacon(const SyncMessage &message, uint64_t rx_local_us)
+{
+    const bool leader_alive = m_has_leader && rx_local_us - m_leader_seen_us < leader_timeout_us();
+    if (!m_has_leader || message.node_id != m_leader_id) {
+        // A higher id only gets through while this node has no time base
+        // yet; it then takes over with the offset it learnt.
+        const bool lower_than_leader = !leader_alive || message.node_id < m_leader_id;
+        const bool usable = message.node_id < m_config.node_id || !m_synced;
+        if (!lower_than_leader || !usable) {
+            ++m_stats.ignored;
+            return;
+        }
+        follow(message.node_id);
+    }
+
+    ++m_stats.beacons_received;
+    m_leader_seen_us = rx_local_us;
+    if (m_exchange_count == 0) {
+        // Least-delayed beacon so far; latency is only removed by an exchange.
+        const int64_t sample = static_cast<int64_t>(message.t1 - rx_local_us);
+        if (!m_coarse || sample > m_offset_us) {
+            m_offset_us = sample;
+        }
+        m_coarse = true;
+    }
+    m_synced = true;
+
+    // Followers answer at different points of the interval, not all at once.
+    m_request_due_us = rx_local_us + (m_config.node_id % 8 + 1) * interval_us() / 20;
+    m_request_armed = true;
+    m_request_pending = false;
+}
+
+void GroupClock::on_response(const SyncMessage &message, uint64_t rx_local_us)
+{
+    if (!m_request_pending || message.peer_id != m_config.node_id || message.node_id != m_leader_id ||
+        message.t1 != m_request_sent_us) {
+        ++m_stats.ignored;
+        return;
+    }
+    m_request_pending = false;
+
+    const int64_t out_us = static_cast<int64_t>(message.t2 - message.t1);
+    const int64_t back_us = static_cast<int64_t>(message.t3 - rx_local_us);
+    const int64_t rtt_us = static_cast<int64_t>(rx_local_us - message.t1) - static_cast<int64_t>(message.t3 - message.t2);
+    m_exchanges[m_exchange_next] = {(out_us + back_us) / 2, static_cast<uint32_t>(rtt_us > 0 ? rtt_us : 0)};
+    m_exchange_next = (m_exchange_next + 1) % kWindow;
+    if (m_exchange_count < kWindow) {
+        ++m_exchange_count;
+    }
+    ++m_stats.exchanges;
+
+    const Exchange *best = &m_exchanges[0];
+    for (size_t idx = 1; idx < m_exchange_count; ++idx) {
+        if (m_exchanges[idx].rtt_us < best->rtt_us) {
+            best = &m_exchanges[idx];
+        }
+    }
+    m_offset_us = best->offset_us;
+    m_rtt_us = best->rtt_us;
+}
+
+bool GroupClock::poll(uint64_t local_us, SyncMessage &out)
+{
+    if (leader(local_us)) {
+        if (!m_was_leader) {
+            m_was_leader = true;
+            m_synced = true;
+            m_request_armed = false;
+            m_request_pending = false;
+            m_next_beacon_us = local_us;
+            ++m_stats.leader_changes;
+        }
+        if (local_us < m_next_beacon_us) {
+            return false;
+        }
+        out = {SyncType::Beacon, m_config.domain, m_config.node_id, 0, group_us(local_us), 0, 0};
+        m_next_beacon_us = local_us + interval_us();
+        ++m_stats.beacons_sent;
+        return true;
+    }
+
+    m_was_leader = false;
+    if (!m_request_armed || local_us < m_request_due_us) {
+        return false;
+    }
+    out = {SyncType::DelayRequest, m_config.domain, m_config.node_id, m_leader_id, local_us, 0, 0};
+    m_request_armed = false;
+    m_request_pending = true;
+    m_request_sent_us = local_us;
+    return true;
+}
+
+uint64_t GroupClock::next_wakeup_us(uint64_t local_us) const
+{
+    uint64_t next;
+    if (leader(local_us)) {
+        next = m_was_leader ? m_next_beacon_us : local_us;
+    } else {
+        next = (m_synced ? m_leader_seen_us : m_started_us) + leader_timeout_us();
+        if (m_request_armed && m_request_due_us < next) {
+            next = m_request_due_us;
+        }
+    }
+    return next > local_us ? next : local_us;
+}
+
+GroupClock::Stats GroupClock::stats(uint64_t local_us) const
+{
+    Stats stats = m_stats;
+    stats.leader = leader(local_us);
+    stats.leader_id = stats.leader ? m_config.node_id : m_leader_id;
+    stats.synced = m_synced;
+    stats.offset_us = m_offset_us;
+    stats.rtt_us = m_rtt_us;
+    return stats;
+}
+
+} // namespace device_modules::light
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace device_modules::light {
+
+enum class SyncType : uint8_t { Beacon = 1, DelayRequest = 2, DelayResponse = 3 };
+
+/**
+ * @brief One sync datagram.
+ *
+ * Beacons are multicast by the leader with its group time in t1. A follower
+ * unicasts a DelayRequest with its local send time in t1; the leader echoes
+ * it with the group times the request arrived (t2) and the reply left (t3).
+ */
+struct SyncMessage {
+    SyncType type;
+    uint16_t domain;
+    uint64_t node_id; // sender
+    uint64_t peer_id; // DelayResponse: the requester
+    uint64_t t1;
+    uint64_t t2;
+    uint64_t t3;
+};
+
+constexpr size_t kSyncMessageSize = 48;
+
+/** Writes @p message to @p out (kSyncMessageSize bytes, big-endian). */
+void encode_sync(const SyncMessage &message, uint8_t *out);
+bool decode_sync(const uint8_t *data, size_t len, SyncMessage &out);
+
+/**
+ * @brief Shared time base for the lights of one sync domain.
+ *
+ * The node with the lowest id heard recently is the leader and multicasts
+ * a beacon every `beacon_interval_ms`. Each follower answers a beacon with
+ * a delay request, so its offset comes from a two-way exchange and the
+ * link latency cancels out; of the last few exchanges the one with the
+ * shortest round trip wins, which drops queueing and scheduling jitter.
+ * Until the first exchange completes the beacon alone gives a coarse offset.
+ *
+ * A node joining a running group adopts its time before it may lead, and
+ * followers keep their offset and exchange window across a change of
+ * leader, so group time does not jump when the leader goes away. Times are
+ * local microseconds (esp_timer on the device). Not thread-safe; no ESP-IDF
+ * dependency.
+ */
+class GroupClock {
+public:
+    struct Config {
+        uint64_t node_id;
+        uint16_t domain;
+        uint32_t beacon_interval_ms;
+    };
+
+    struct Stats {
+        uint64_t leader_id;
+        bool leader;
+        bool synced;         // a leader was heard or this node took over
+        int64_t offset_us;   // group time - local time
+        uint32_t rtt_us;     // round trip of the exchange in use, 0 before one
+        uint32_t beacons_sent;
+        uint32_t beacons_received;
+        uint32_t exchanges;  // delay responses used
+        uint32_t answered;   // delay requests answered as leader
+        uint32_t ignored;    // other domains, stale leaders, late responses
+        uint32_t leader_changes;
+    };
+
+    static constexpr size_t kWindow = 8;
+
+    void configure(const Config &config, uint64_t local_us);
+
+    uint64_t group_us(uint64_t local_us) const { return local_us + static_cast<uint64_t>(m_offset_us); }
+    bool synced() const { return m_synced; }
+    bool leader(uint64_t local_us) const;
+
+    /** Leading, or at least one exchange done: group time is within the link jitter, not its latency. */
+    bool locked(uint64_t local_us) const { return leader(local_us) || (m_synced && m_exchange_count > 0); }
+
+    /**
+     * @brief Feeds a received message, timestamped as close to the socket as possible.
+     *
+     * Returns true when @p reply must go back to the sender; restamp its t3
+     * with group_us() right before sending.
+     */
+    bool on_message(const SyncMessage &message, uint64_t rx_local_us, SyncMessage &reply);
+
+    /**
+     * @brief Beacon (multicast) or delay request (unicast to the sender of
+     * the last beacon) due at @p local_us. Counts it as sent.
+     */
+    bool poll(uint64_t local_us, SyncMessage &out);
+
+    /** Local time of the next poll() worth making. */
+    uint64_t next_wakeup_us(uint64_t local_us) const;
+
+    void on_malformed() { ++m_stats.ignored; }
+    Stats stats(uint64_t local_us) const;
+
+private:
+    struct Exchange {
+        int64_t offset_us;
+        uint32_t rtt_us;
+    };
+
+    uint64_t interval_us() const { return static_cast<uint64_t>(m_config.beacon_interval_ms) * 1000; }
+    uint64_t leader_timeout_us() const;
+    void follow(uint64_t leader_id);
+    void on_beacon(const SyncMessage &message, uint64_t rx_local_us);
+    void on_response(const SyncMessage &message, uint64_t rx_local_us);
+
+    Config m_config{};
+    uint64_t m_started_us = 0;
+    uint64_t m_leader_id = 0;
+    uint64_t m_leader_seen_us = 0;
+    bool m_has_leader = false;
+    bool m_synced = false;
+    bool m_was_leader = false;
+    uint64_t m_next_beacon_us = 0;
+    int64_t m_offset_us = 0;
+    bool m_coarse = false; // offset taken from a beacon, before any exchange
+
+    // Follower side: one request in flight, answered or dropped by the next beacon.
+    uint64_t m_request_due_us = 0;
+    bool m_request_armed = false;
+    uint64_t m_request_sent_us = 0;
+    bool m_request_pending = false;
+
+    Exchange m_exchanges[kWindow] = {};
+    size_t m_exchange_count = 0;
+    size_t m_exchange_next = 0;
+    uint32_t m_rtt_us = 0;
+
+    Stats m_stats{};
+};
+
+} // namespace device_modules::light
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "group_clock.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace device_modules::light {
+
+/**
+ * @brief Host-side group of lights sharing a GroupClock over a simulated link.
+ *
+ * Every node has its own crystal error and boot time; every datagram
+ * (beacons, delay requests and responses) arrives after a base latency plus
+ * random jitter, with an occasional long-delayed packet.
+ * test/host/group_clock_test.cpp runs the group and samples the phase
+ * error: the largest difference in group time between locked nodes, which
+ * is how far apart their effect frames land.
+ */
+class SimulatedSyncGroup {
+public:
+    struct ErrorStats {
+        uint64_t max_us;
+        uint64_t avg_us;
+        uint32_t samples;
+    };
+
+    SimulatedSyncGroup(uint16_t domain, uint32_t beacon_interval_ms, uint32_t base_delay_us, uint32_t jitter_us,
+                       uint32_t seed = 1)
+        : m_domain(domain), m_interval_ms(beacon_interval_ms), m_base_delay_us(base_delay_us),
+          m_jitter_us(jitter_us), m_rng(seed ? seed : 1)
+    {
+    }
+
+    /** Adds a node that boots now; returns its index. */
+    size_t add_node(uint64_t node_id, int32_t skew_ppm, uint64_t boot_local_us)
+    {
+        Node node{};
+        node.node_id = node_id;
+        node.skew_ppm = skew_ppm;
+        node.local_base_us = boot_local_us;
+        node.true_base_us = m_now_us;
+        node.online = true;
+        node.clock.configure({node_id, m_domain, m_interval_ms}, boot_local_us);
+        m_nodes.push_back(node);
+        return m_nodes.size() - 1;
+    }
+
+    /** Powers a node off, or back on with a fresh clock (a reboot). */
+    void set_online(size_t index, bool online)
+    {
+        Node &node = m_nodes[index];
+        if (online && !node.online) {
+            node.local_base_us = local_us(node);
+            node.true_base_us = m_now_us;
+            node.clock.configure({node.node_id, m_domain, m_interval_ms}, node.local_base_us);
+        }
+        node.online = online;
+    }
+
+    void run_until(uint64_t until_us, uint64_t step_us = 100)
+    {
+        while (m_now_us < until_us) {
+            m_now_us += step_us;
+            deliver();
+            for (size_t idx = 0; idx < m_nodes.size(); ++idx) {
+                Node &node = m_nodes[idx];
+                SyncMessage message;
+                if (node.online && node.clock.poll(local_us(node), message)) {
+                    send(idx, message);
+                }
+            }
+        }
+    }
+
+    /** Runs until @p until_us and samples the phase error every @p sample_us. */
+    ErrorStats measure(uint64_t until_us, uint64_t sample_us)
+    {
+        ErrorStats stats{};
+        uint64_t total = 0;
+        while (m_now_us < until_us) {
+            run_until(m_now_us + sample_us);
+            const uint64_t error = phase_error_us();
+            stats.max_us = error > stats.max_us ? error : stats.max_us;
+            total += error;
+            ++stats.samples;
+        }
+        stats.avg_us = stats.samples ? total / stats.samples : 0;
+        return stats;
+    }
+
+    /** Spread of group time across online, locked nodes right now. */
+    uint64_t phase_error_us() const
+    {
+        bool first = true;
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+        for (const Node &node : m_nodes) {
+            const uint64_t local = local_us(node);
+            if (!node.online || !node.clock.locked(local)) {
+                continue;
+            }
+            const uint64_t group = node.clock.group_us(local);
+            lo = first || group < lo ? group : lo;
+            hi = first || group > hi ? group : hi;
+            first = false;
+        }
+        return hi - lo;
+    }
+
+    const GroupClock &clock(size_t index) const { return m_nodes[index].clock; }
+    uint64_t local_now_us(size_t index) const { return local_us(m_nodes[index]); }
+    uint64_t now_us() const { return m_now_us; }
+
+private:
+    struct Node {
+        GroupClock clock;
+        uint64_t node_id;
+        int32_t skew_ppm;
+        uint64_t local_base_us;
+        uint64_t true_base_us;
+        bool online;
+    };
+
+    struct InFlight {
+        uint64_t deliver_us;
+        size_t target;
+        SyncMessage message;
+    };
+
+    uint64_t local_us(const Node &node) const
+    {
+        const int64_t elapsed = static_cast<int64_t>(m_now_us - node.true_base_us);
+        return node.local_base_us + static_cast<uint64_t>(elapsed + elapsed * node.skew_ppm / 1'000'000);
+    }
+
+    uint32_t next_random()
+    {
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 17;
+        m_rng ^= m_rng << 5;
+        return m_rng;
+    }
+
+    uint64_t link_delay_us()
+    {
+        uint64_t delay = m_base_delay_us + (m_jitter_us ? next_random() % m_jitter_us : 0);
+        if (next_random() % 8 == 0) {
+            delay += 4ull * m_jitter_us; // a retry or a busy receiver
+        }
+        return delay;
+    }
+
+    // Beacons go to everyone, requests to the leader they name, responses
+    // back to the requester.
+    void send(size_t from, const SyncMessage &message)
+    {
+        for (size_t idx = 0; idx < m_nodes.size(); ++idx) {
+            if (idx == from || !m_nodes[idx].online) {
+                continue;
+            }
+            if (message.type != SyncType::Beacon && m_nodes[idx].node_id != message.peer_id) {
+                continue;
+            }
+            m_in_flight.push_back({m_now_us + link_delay_us(), idx, message});
+        }
+    }
+
+    void deliver()
+    {
+        for (size_t idx = 0; idx < m_in_flight.size();) {
+            const InFlight &packet = m_in_flight[idx];
+            if (packet.deliver_us > m_now_us) {
+                ++idx;
+                continue;
+            }
+            const size_t target = packet.target;
+            const SyncMessage message = packet.message;
+            m_in_flight[idx] = m_in_flight.back();
+            m_in_flight.pop_back();
+            Node &node = m_nodes[target];
+            SyncMessage reply;
+            if (node.online && node.clock.on_message(message, local_us(node), reply)) {
+                reply.t3 = node.clock.group_us(local_us(node));
+                send(target, reply);
+            }
+        }
+    }
+
+    uint16_t m_domain;
+    uint32_t m_interval_ms;
+    uint32_t m_base_delay_us;
+    uint32_t m_jitter_us;
+    uint32_t m_rng;
+    uint64_t m_now_us = 0;
+    std::vector<Node> m_nodes;
+    std::vector<InFlight> m_in_flight;
+};
+
+} // namespace device_modules::light
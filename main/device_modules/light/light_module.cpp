@@ -1,10 +1,24 @@
 #include "light_module.h"
+#include "effect_player.h"
+#include "light_pwm.h"
+#include "light_scenes.h"
+#include "light_state.h"
+#include "light_stream.h"
+#include "light_sync.h"
+#include "pixel_stream.h"
+#include "power_limit.h"
 
 #include "common/endpoint_utils.h"
+#include "deferred_log.h"
+#include "device_config.h"
 #include "generated_config.h"
+#include "power_manager.h"
+#include "report_throttle.h"
 
 #include "common_macros.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <inttypes.h>
 #include <esp_err.h>
@@ -13,7 +27,12 @@
 #include <esp_matter_cluster.h>
 #include <esp_matter_endpoint.h>
 #include <led_indicator.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
 #include <lib/core/DataModelTypes.h>
+#include <platform/CHIPDeviceLayer.h>
 #include <app-common/zap-generated/cluster-objects.h>
 
 namespace device_modules::light {
@@ -87,9 +106,6 @@ struct endpoint_config_resolved {
 };
 
 constexpr int kStandardBrightness = 255;
-constexpr int kStandardHue = 360;
-constexpr int kStandardSaturation = 255;
-constexpr uint32_t kStandardTemperatureFactor = 1'000'000;
 
 constexpr int kMatterBrightness = 254;
 constexpr int kMatterHue = 254;
@@ -98,7 +114,20 @@ constexpr int kMatterSaturation = 254;
 app_driver_handle_t s_driver_handle = nullptr;
 static bool s_is_identifying = false;
 
-#if LED_STRIP_LED_COUNT > 0
+// Attribute writes land in s_target and are committed to the strip once per
+// CHIP event. All of it is touched with the CHIP stack lock held.
+static LightState s_target = {false, 0, ColorMode::Temperature, 0, 0, 250};
+static bool s_stack_started = false;
+static bool s_commit_pending = false;
+static scenes::FrameCounters s_counters = {};
+
+#if APP_LED_POWER_LIMIT
+// Caps strip brightness to led_strip.power_limit. Streaming builds hand it
+// to the pixel stream, which serialises it with its own frames.
+static PowerLimiter s_power_limiter;
+#endif
+
+#if LED_STRIP_LED_COUNT > 0 && !APP_LED_STREAMING
 static bool s_previous_on_off_state = false;
 static led_indicator_ihsv_t s_previous_hsv_state = {0, 0, 0};
 #endif
@@ -106,10 +135,7 @@ static led_indicator_ihsv_t s_previous_hsv_state = {0, 0, 0};
 #if LED_STRIP_LED_COUNT > 0
 static led_model_t resolve_led_model_from_config()
 {
-    const char *type = generated_config::led_strip::type;
-    if (!type) {
-        return LED_MODEL_WS2812;
-    }
+    const char *type = device_config::device().led_type;
 
     if (strcmp(type, "sk6812") == 0 || strcmp(type, "sk6812_rgbw") == 0 || strcmp(type, "sk6812w") == 0) {
         return LED_MODEL_SK6812;
@@ -120,72 +146,180 @@ static led_model_t resolve_led_model_from_config()
 
 static led_pixel_format_t resolve_pixel_format_from_config()
 {
-    const char *type = generated_config::led_strip::type;
-    if (type && (strcmp(type, "sk6812w") == 0 || strcmp(type, "sk6812_rgbw") == 0 || strcmp(type, "rgbw") == 0)) {
+    const char *type = device_config::device().led_type;
+    if ((strcmp(type, "sk6812w") == 0 || strcmp(type, "sk6812_rgbw") == 0 || strcmp(type, "rgbw") == 0)) {
         return LED_PIXEL_FORMAT_GRBW;
     }
     return LED_PIXEL_FORMAT_GRB;
 }
 #endif
 
-static esp_err_t set_power(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+#if APP_LED_POWER_LIMIT && !APP_LED_STREAMING
+// Value of a solid colour on the whole strip that stays within the budget.
+static uint8_t limit_solid(const Hsv &colour)
 {
-#if LED_STRIP_LED_COUNT > 0
-    return led_indicator_set_on_off(handle, val->val.b);
+    Hsv full = colour;
+    full.v = 255;
+    const Rgb rgb = to_rgb(full);
+    const uint32_t per_pixel = static_cast<uint32_t>(rgb.r) + rgb.g + rgb.b;
+    const uint32_t pixels = static_cast<uint32_t>(device_config::device().led_count);
+    return s_power_limiter.limit(per_pixel * pixels, colour.v);
+}
+#endif
+
+static esp_err_t commit_frame(led_indicator_handle_t handle)
+{
+#if APP_LIGHT_SYNC
+    // s_target is still updated; the effect finishes on it.
+    if (sync::effect_running()) {
+        return ESP_OK;
+    }
+#endif
+    ++s_counters.frames;
+#if APP_LIGHT_PWM
+    (void) handle;
+    return pwm::fade_to(s_target);
+#elif APP_LED_STREAMING
+    (void) handle;
+    return stream::show(s_target);
+#elif LED_STRIP_LED_COUNT > 0
+    if (!handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!s_target.on) {
+        return led_indicator_set_on_off(handle, false);
+    }
+    // Colour and brightness in one write, so the strip is refreshed once.
+    Hsv target = to_hsv(s_target);
+#if APP_LED_POWER_LIMIT
+    target.v = limit_solid(target);
+#endif
+    led_indicator_ihsv_t hsv;
+    hsv.value = led_indicator_get_hsv(handle);
+    hsv.h = target.h;
+    hsv.s = target.s;
+    hsv.v = target.v;
+    return led_indicator_set_hsv(handle, hsv.value);
 #else
-    ESP_LOGI(TAG, "LED set power: %d (LED count is 0, visual update skipped)", val->val.b);
+    DLOGI(LIGHT, TAG, "LED frame: on=%d level=%u (LED count is 0, visual update skipped)", s_target.on, s_target.level);
     return ESP_OK;
 #endif
 }
 
-static esp_err_t set_brightness(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+static void commit_frame_work(intptr_t arg)
 {
-    int value = remap_to_range(val->val.u8, kMatterBrightness, kStandardBrightness);
-#if LED_STRIP_LED_COUNT > 0
-    return led_indicator_set_brightness(handle, value);
-#else
-    ESP_LOGI(TAG, "LED set brightness: %d (LED count is 0, visual update skipped)", value);
+    s_commit_pending = false;
+    esp_err_t err = commit_frame(reinterpret_cast<led_indicator_handle_t>(arg));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to refresh LED strip: %s", esp_err_to_name(err));
+    }
+    power_manager::release(power_manager::Hold::Render);
+}
+
+// Queued behind the event being handled, so every attribute a command writes
+// (a scene recall touches OnOff, Level and Color) is in the same frame.
+static esp_err_t schedule_commit(led_indicator_handle_t handle)
+{
+    ++s_counters.writes;
+    if (!s_stack_started) {
+        return commit_frame(handle);
+    }
+    if (s_commit_pending) {
+        return ESP_OK;
+    }
+    power_manager::acquire(power_manager::Hold::Render);
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(commit_frame_work, reinterpret_cast<intptr_t>(handle)) !=
+        CHIP_NO_ERROR) {
+        power_manager::release(power_manager::Hold::Render);
+        return commit_frame(handle);
+    }
+    s_commit_pending = true;
     return ESP_OK;
-#endif
 }
 
-static esp_err_t set_hue(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+#if APP_LIGHT_SYNC
+// One effect frame, straight to the output: no fade, so the edges land on
+// the frame grid.
+static esp_err_t show_effect_frame(const LightState &state)
 {
-    int value = remap_to_range(val->val.u8, kMatterHue, kStandardHue);
-#if LED_STRIP_LED_COUNT > 0
+#if APP_LIGHT_PWM
+    return pwm::show(state);
+#elif APP_LED_STREAMING
+    return stream::show(state);
+#elif LED_STRIP_LED_COUNT > 0
+    led_indicator_handle_t handle = static_cast<led_indicator_handle_t>(s_driver_handle);
+    if (!handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    Hsv target = to_hsv(state);
+#if APP_LED_POWER_LIMIT
+    target.v = limit_solid(target);
+#endif
     led_indicator_ihsv_t hsv;
     hsv.value = led_indicator_get_hsv(handle);
-    led_indicator_ihsv_t new_hsv = {(uint32_t) value, hsv.s, hsv.v};
-    return led_indicator_set_hsv(handle, new_hsv.value);
+    hsv.h = target.h;
+    hsv.s = target.s;
+    hsv.v = state.on ? target.v : 0;
+    return led_indicator_set_hsv(handle, hsv.value);
 #else
-    ESP_LOGI(TAG, "LED set hue: %d (LED count is 0, visual update skipped)", value);
+    (void) state;
     return ESP_OK;
 #endif
 }
 
-static esp_err_t set_saturation(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+static void effect_done()
 {
-    int value = remap_to_range(val->val.u8, kMatterSaturation, kStandardSaturation);
-#if LED_STRIP_LED_COUNT > 0
-    led_indicator_ihsv_t hsv;
-    hsv.value = led_indicator_get_hsv(handle);
-    led_indicator_ihsv_t new_hsv = {hsv.h, (uint8_t) value, hsv.v};
-    return led_indicator_set_hsv(handle, new_hsv.value);
-#else
-    ESP_LOGI(TAG, "LED set saturation: %d (LED count is 0, visual update skipped)", value);
-    return ESP_OK;
+    commit_frame(static_cast<led_indicator_handle_t>(s_driver_handle));
+}
 #endif
+
+static esp_err_t set_power(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    // Light sleep is only allowed in standby, with every output off.
+    power_manager::set_output_on(val->val.b);
+    s_target.on = val->val.b;
+    return schedule_commit(handle);
+}
+
+static esp_err_t set_brightness(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    s_target.level = static_cast<uint8_t>(CLAMPI(val->val.u8, 0, kMatterBrightness));
+    return schedule_commit(handle);
+}
+
+static esp_err_t set_hue(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    s_target.hue = static_cast<uint8_t>(CLAMPI(val->val.u8, 0, kMatterHue));
+    s_target.mode = ColorMode::HueSaturation;
+    return schedule_commit(handle);
+}
+
+static esp_err_t set_saturation(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    s_target.saturation = static_cast<uint8_t>(CLAMPI(val->val.u8, 0, kMatterSaturation));
+    s_target.mode = ColorMode::HueSaturation;
+    return schedule_commit(handle);
 }
 
 static esp_err_t set_temperature(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
 {
-    uint32_t value = remap_to_range_inverse(val->val.u16, kStandardTemperatureFactor);
-#if LED_STRIP_LED_COUNT > 0
-    return led_indicator_set_color_temperature(handle, value);
-#else
-    ESP_LOGI(TAG, "LED set temperature: %ld (LED count is 0, visual update skipped)", value);
-    return ESP_OK;
-#endif
+    s_target.mireds = val->val.u16;
+    s_target.mode = ColorMode::Temperature;
+    return schedule_commit(handle);
+}
+
+static esp_err_t set_x(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    s_target.x = val->val.u16;
+    s_target.mode = ColorMode::XY;
+    return schedule_commit(handle);
+}
+
+static esp_err_t set_y(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    s_target.y = val->val.u16;
+    s_target.mode = ColorMode::XY;
+    return schedule_commit(handle);
 }
 
 static esp_err_t set_default_brightness(uint16_t endpoint_id, led_indicator_handle_t handle)
@@ -261,6 +395,27 @@ static esp_err_t set_default_color(uint16_t endpoint_id, led_indicator_handle_t
         return err;
     }
 
+    if (mode.val.u8 == static_cast<uint8_t>(ColorControl::ColorModeEnum::kCurrentXAndCurrentY)) {
+        attribute_t *x_attr = attribute::get(endpoint_id, ColorControl::Id, ColorControl::Attributes::CurrentX::Id);
+        attribute_t *y_attr = attribute::get(endpoint_id, ColorControl::Id, ColorControl::Attributes::CurrentY::Id);
+        if (!x_attr || !y_attr) {
+            ESP_LOGE(TAG, "Missing CurrentX/CurrentY attributes at endpoint %u", endpoint_id);
+            return ESP_FAIL;
+        }
+        esp_matter_attr_val_t x = esp_matter_invalid(nullptr);
+        esp_matter_attr_val_t y = esp_matter_invalid(nullptr);
+        err = attribute::get_val(x_attr, &x);
+        if (err == ESP_OK) {
+            err = attribute::get_val(y_attr, &y);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read CurrentX/CurrentY: %s", esp_err_to_name(err));
+            return err;
+        }
+        set_x(handle, &x);
+        return set_y(handle, &y);
+    }
+
     ESP_LOGW(TAG, "Color mode 0x%02X not handled for defaults", mode.val.u8);
     return ESP_OK;
 }
@@ -289,7 +444,7 @@ static esp_err_t apply_light_defaults(uint16_t endpoint_id)
         handle = (led_indicator_handle_t) s_driver_handle;
     }
 
-#if LED_STRIP_LED_COUNT == 0
+#if LED_STRIP_LED_COUNT == 0 && !APP_LIGHT_PWM
     ESP_LOGW(TAG, "apply_light_defaults: LED strip disabled. Proceeding without LED operations.");
 #endif
 
@@ -322,7 +477,7 @@ bool is_light_type(const char *device_type)
 
 bool list_contains(const generated_config::string_list &list, const char *value)
 {
-    if (!value || list.count == 0 || list.items == nullptr) {
+    if (!value || list.count == 0) {
         return false;
     }
     for (size_t idx = 0; idx < list.count; ++idx) {
@@ -467,15 +622,12 @@ chip::app::Clusters::ColorControl::ColorModeEnum map_color_mode_key(const char *
 }
 
 chip::app::Clusters::ColorControl::ColorModeEnum resolve_color_mode(const generated_config::optional_string &primary,
-                                                                    const generated_config::optional_string &fallback)
+                                                                    const char *fallback)
 {
     if (primary.has_value) {
         return map_color_mode_key(primary.value);
     }
-    if (fallback.has_value) {
-        return map_color_mode_key(fallback.value);
-    }
-    return chip::app::Clusters::ColorControl::ColorModeEnum::kColorTemperatureMireds;
+    return map_color_mode_key(fallback);
 }
 
 endpoint_config_resolved resolve_light_config(const generated_config::endpoint_raw &raw)
@@ -536,10 +688,10 @@ endpoint_config_resolved resolve_light_config(const generated_config::endpoint_r
         default_color_mode_value = "kCurrentHueAndCurrentSaturation";
     }
 
-    generated_config::optional_string default_color_mode{true, default_color_mode_value};
-    auto base_mode = resolve_color_mode(raw.color_control.color_mode, default_color_mode);
+    auto base_mode = resolve_color_mode(raw.color_control.color_mode, default_color_mode_value);
     auto enhanced_mode = resolve_color_mode(raw.color_control.enhanced_color_mode,
-                                            raw.color_control.color_mode.has_value ? raw.color_control.color_mode : default_color_mode);
+                                            raw.color_control.color_mode.has_value ? raw.color_control.color_mode.value
+                                                                                   : default_color_mode_value);
     resolved.color_control.color_mode = static_cast<uint8_t>(base_mode);
     resolved.color_control.enhanced_color_mode = static_cast<uint8_t>(enhanced_mode);
 
@@ -563,11 +715,36 @@ endpoint_config_resolved resolve_light_config(const generated_config::endpoint_r
 
 app_driver_handle_t init_drivers()
 {
-#if LED_STRIP_LED_COUNT > 0
+#if APP_LIGHT_PWM
+    ESP_LOGI(TAG, "Initializing PWM light driver...");
+    pwm::init();
+    // Every write goes through light_pwm; there is no led_indicator handle.
+    s_driver_handle = nullptr;
+#elif APP_LED_STREAMING
+    ESP_LOGI(TAG, "Initializing LED strip for streaming...");
+    led_strip_config_t strip_config = {};
+    strip_config.strip_gpio_num = device_config::device().led_rmt_gpio;
+    strip_config.max_leds = static_cast<uint32_t>(device_config::device().led_count);
+    strip_config.led_pixel_format = resolve_pixel_format_from_config();
+    strip_config.led_model = resolve_led_model_from_config();
+    strip_config.flags.invert_out = 0;
+
+#if APP_LED_POWER_LIMIT
+    s_power_limiter.configure({generated_config::led_power::budget_ma, generated_config::led_power::channel_ma,
+                               generated_config::led_power::idle_ua, strip_config.max_leds});
+    stream::init(strip_config, &s_power_limiter);
+#else
+    stream::init(strip_config, nullptr);
+#endif
+    // Every write goes through the pixel stream; there is no led_indicator handle.
+    s_driver_handle = nullptr;
+#elif LED_STRIP_LED_COUNT > 0
     ESP_LOGI(TAG, "Initializing LED strip light driver...");
     static led_indicator_strips_config_t strips_config = {};
-    strips_config.led_strip_cfg.strip_gpio_num = generated_config::led_strip::rmt_gpio;
-    strips_config.led_strip_cfg.max_leds = LED_STRIP_LED_COUNT;
+    // LED_STRIP_LED_COUNT only decides whether the strip driver is built in;
+    // the actual strip comes from the (possibly partition-provided) config.
+    strips_config.led_strip_cfg.strip_gpio_num = device_config::device().led_rmt_gpio;
+    strips_config.led_strip_cfg.max_leds = static_cast<uint32_t>(device_config::device().led_count);
     strips_config.led_strip_cfg.led_pixel_format = resolve_pixel_format_from_config();
     strips_config.led_strip_cfg.led_model = resolve_led_model_from_config();
     strips_config.led_strip_cfg.flags.invert_out = 0;
@@ -585,6 +762,11 @@ app_driver_handle_t init_drivers()
         .blink_list_num = 0,
     };
 
+#if APP_LED_POWER_LIMIT
+    s_power_limiter.configure({generated_config::led_power::budget_ma, generated_config::led_power::channel_ma,
+                               generated_config::led_power::idle_ua, strips_config.led_strip_cfg.max_leds});
+#endif
+
     led_indicator_handle_t handle = led_indicator_create(&indicator_config);
     if (!handle) {
         ESP_LOGE(TAG, "Failed to create LED indicator for strip light.");
@@ -855,11 +1037,11 @@ esp_err_t attribute_update(app_driver_handle_t driver_handle,
                            uint32_t attribute_id,
                            esp_matter_attr_val_t *val)
 {
-    ESP_LOGI(TAG,
-             "Updating attribute - Cluster: 0x%" PRIx32 ", Attribute: 0x%" PRIx32 ", Value: %d",
-             cluster_id,
-             attribute_id,
-             val->val.u8);
+    DLOGI(LIGHT, TAG,
+          "Updating attribute - Cluster: 0x%" PRIx32 ", Attribute: 0x%" PRIx32 ", Value: %d",
+          cluster_id,
+          attribute_id,
+          val->val.u8);
 
     if (endpoint_id != light_endpoint_id) {
         return ESP_OK;
@@ -885,6 +1067,12 @@ esp_err_t attribute_update(app_driver_handle_t driver_handle,
         if (attribute_id == ColorControl::Attributes::ColorTemperatureMireds::Id) {
             return set_temperature(handle, val);
         }
+        if (attribute_id == ColorControl::Attributes::CurrentX::Id) {
+            return set_x(handle, val);
+        }
+        if (attribute_id == ColorControl::Attributes::CurrentY::Id) {
+            return set_y(handle, val);
+        }
     }
     return ESP_OK;
 }
@@ -896,11 +1084,12 @@ void after_endpoint_created(const generated_config::endpoint_raw &config, endpoi
     }
 
     const uint16_t endpoint_id = endpoint::get_id(endpoint);
+    report_throttle::track_endpoint(endpoint_id);
+    endpoint_config_resolved resolved = resolve_light_config(config);
     if (light_endpoint_id == chip::kInvalidEndpointId) {
         light_endpoint_id = endpoint_id;
+        scenes::configure(resolved.scenes_management.enabled ? resolved.scenes_management.scene_table_size : 0);
     }
-
-    endpoint_config_resolved resolved = resolve_light_config(config);
     if (resolved.color_control.enabled) {
         esp_matter_attr_val_t val;
         if (resolved.color_control.has_color_temperature) {
@@ -947,25 +1136,71 @@ void perform_identification(app_driver_handle_t driver_handle,
                             esp_matter::identification::callback_type_t type,
                             uint8_t effect_id)
 {
-    ESP_LOGI(TAG, "Identify action: Type=%d, EffectID=0x%02x", static_cast<int>(type), effect_id);
+    DLOGI(LIGHT, TAG, "Identify action: Type=%d, EffectID=0x%02x", static_cast<int>(type), effect_id);
+
+#if APP_LIGHT_SYNC
+    // Identify and TriggerEffect are rendered from group time, so a group of
+    // lights blinks and breathes in phase.
+    (void) driver_handle;
+    if (type == esp_matter::identification::START) {
+        s_is_identifying = true;
+        sync::start_effect(Effect::Identify, s_target);
+    } else if (type == esp_matter::identification::STOP) {
+        s_is_identifying = false;
+        sync::end_effect(false);
+    } else if (effect_id == kEffectFinish || effect_id == kEffectStop) {
+        sync::end_effect(effect_id == kEffectFinish);
+    } else if (effect_id == static_cast<uint8_t>(Effect::Blink) || effect_id == static_cast<uint8_t>(Effect::Breathe) ||
+               effect_id == static_cast<uint8_t>(Effect::Okay) ||
+               effect_id == static_cast<uint8_t>(Effect::ChannelChange)) {
+        sync::start_effect(static_cast<Effect>(effect_id), s_target);
+    }
+    return;
+#endif
 
     if (type == esp_matter::identification::START) {
         if (s_is_identifying) {
-            ESP_LOGI(TAG, "Identify: Already identifying. Ignoring new START.");
+            DLOGI(LIGHT, TAG, "Identify: Already identifying. Ignoring new START.");
             return;
         }
         s_is_identifying = true;
+        power_manager::acquire(power_manager::Hold::Render);
     }
 
-#if LED_STRIP_LED_COUNT > 0
+#if APP_LIGHT_PWM
+    (void) driver_handle;
+    if (type == esp_matter::identification::START && pwm::ready()) {
+        LightState identify = s_target;
+        identify.on = true;
+        identify.level = kMatterBrightness;
+        pwm::show(identify);
+    } else if (type == esp_matter::identification::STOP && s_is_identifying) {
+        s_is_identifying = false;
+        commit_frame(nullptr);
+        power_manager::release(power_manager::Hold::Render);
+    }
+#elif APP_LED_STREAMING
+    (void) driver_handle;
+    if (type == esp_matter::identification::START && stream::get()) {
+        stream::get()->set_matter_state(true, kMatterBrightness, 255, 255, 255);
+    } else if (type == esp_matter::identification::STOP && s_is_identifying) {
+        s_is_identifying = false;
+        commit_frame(nullptr);
+        power_manager::release(power_manager::Hold::Render);
+    }
+#elif LED_STRIP_LED_COUNT > 0
     led_indicator_handle_t handle = static_cast<led_indicator_handle_t>(driver_handle);
     if (!handle) {
         ESP_LOGE(TAG, "Identify: Invalid LED strip driver handle.");
+        if (type == esp_matter::identification::STOP && s_is_identifying) {
+            s_is_identifying = false;
+            power_manager::release(power_manager::Hold::Render);
+        }
         return;
     }
 
     if (type == esp_matter::identification::START) {
-        ESP_LOGI(TAG, "Identify: Saving current LED state before starting identification.");
+        DLOGI(LIGHT, TAG, "Identify: Saving current LED state before starting identification.");
         uint8_t current_brightness = led_indicator_get_brightness(handle);
         s_previous_on_off_state = (current_brightness > 0);
         s_previous_hsv_state.value = led_indicator_get_hsv(handle);
@@ -978,14 +1213,19 @@ void perform_identification(app_driver_handle_t driver_handle,
                  s_previous_hsv_state.v,
                  current_brightness);
 
-        ESP_LOGI(TAG, "Identify: Setting LED to full brightness for identification (no blink support).");
-        esp_err_t err_set = led_indicator_set_brightness(handle, kStandardBrightness);
+        DLOGI(LIGHT, TAG, "Identify: Setting LED to full brightness for identification (no blink support).");
+        uint8_t identify_brightness = kStandardBrightness;
+#if APP_LED_POWER_LIMIT
+        identify_brightness = limit_solid({static_cast<uint16_t>(s_previous_hsv_state.h),
+                                           static_cast<uint8_t>(s_previous_hsv_state.s), identify_brightness});
+#endif
+        esp_err_t err_set = led_indicator_set_brightness(handle, identify_brightness);
         if (err_set != ESP_OK) {
             ESP_LOGE(TAG, "Identify: Failed to set LED brightness for identification: %s", esp_err_to_name(err_set));
         }
     } else if (type == esp_matter::identification::STOP) {
         if (s_is_identifying) {
-            ESP_LOGI(TAG, "Identify: Stopping identification and restoring previous LED state.");
+            DLOGI(LIGHT, TAG, "Identify: Stopping identification and restoring previous LED state.");
 
             esp_err_t err_hsv = led_indicator_set_hsv(handle, s_previous_hsv_state.value);
             if (err_hsv != ESP_OK) {
@@ -996,22 +1236,35 @@ void perform_identification(app_driver_handle_t driver_handle,
             if (err_on_off != ESP_OK) {
                 ESP_LOGE(TAG, "Identify: Failed to restore on/off state: %s", esp_err_to_name(err_on_off));
             }
-            ESP_LOGI(TAG, "Identify: Previous LED state restoration attempted.");
+            DLOGI(LIGHT, TAG, "Identify: Previous LED state restoration attempted.");
             s_is_identifying = false;
+            power_manager::release(power_manager::Hold::Render);
         } else {
-            ESP_LOGI(TAG, "Identify STOP received, but was not actively identifying with LEDs.");
+            DLOGI(LIGHT, TAG, "Identify STOP received, but was not actively identifying with LEDs.");
         }
     }
 #else
-    ESP_LOGI(TAG, "LED strip disabled. Visual identification skipped.");
-    if (type == esp_matter::identification::STOP) {
+    DLOGI(LIGHT, TAG, "LED strip disabled. Visual identification skipped.");
+    if (type == esp_matter::identification::STOP && s_is_identifying) {
         s_is_identifying = false;
+        power_manager::release(power_manager::Hold::Render);
     }
 #endif
 }
 
 void apply_post_stack_start()
 {
+#if APP_LED_STREAMING
+    stream::start();
+#endif
+#if APP_LIGHT_SYNC
+    sync::start(show_effect_frame, effect_done);
+#endif
+    if (esp_matter::lock::chip_stack_lock(portMAX_DELAY) != esp_matter::lock::status::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to lock the CHIP stack; driver defaults not applied.");
+        return;
+    }
+    s_stack_started = true;
     if (light_endpoint_id != chip::kInvalidEndpointId) {
         esp_err_t err = apply_light_defaults(light_endpoint_id);
         if (err == ESP_OK) {
@@ -1022,12 +1275,73 @@ void apply_post_stack_start()
                      esp_err_to_name(err));
         }
     }
+    esp_matter::lock::chip_stack_unlock();
 }
 
+#if CONFIG_ENABLE_CHIP_SHELL && APP_LED_POWER_LIMIT
+esp_err_t strip_power_command(int argc, char **argv)
+{
+    const bool reset = argc >= 1 && std::strcmp(argv[0], "reset") == 0;
+    PowerLimiter::Stats stats{};
+#if APP_LED_STREAMING
+    PixelStream *pixel_stream = stream::get();
+    if (!pixel_stream) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (reset) {
+        pixel_stream->reset_stats();
+        return ESP_OK;
+    }
+    stats = pixel_stream->power_stats();
+#else
+    if (esp_matter::lock::chip_stack_lock(portMAX_DELAY) != esp_matter::lock::status::SUCCESS) {
+        return ESP_FAIL;
+    }
+    if (reset) {
+        s_power_limiter.reset_stats();
+    }
+    stats = s_power_limiter.stats();
+    esp_matter::lock::chip_stack_unlock();
+    if (reset) {
+        return ESP_OK;
+    }
+#endif
+    printf("budget %" PRIu32 " mA, last frame %" PRIu32 " mA, peak %" PRIu32 " mA (requested %" PRIu32
+           " mA), limited %" PRIu32 "/%" PRIu32 " frames\n",
+           s_power_limiter.budget_ma(), stats.last_ma, stats.peak_ma, stats.requested_peak_ma, stats.limited,
+           stats.frames);
+    return ESP_OK;
+}
+#endif
+
 } // namespace
 
 uint16_t light_endpoint_id = chip::kInvalidEndpointId;
 
+esp_err_t register_commands()
+{
+    esp_err_t err = scenes::register_commands(s_counters);
+#if CONFIG_ENABLE_CHIP_SHELL && APP_LED_POWER_LIMIT
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "strip_power",
+            .description = "Estimated strip current against led_strip.power_limit. Usage: matter esp strip_power [reset]",
+            .handler = strip_power_command,
+        },
+    };
+    if (err == ESP_OK) {
+        err = esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+    }
+#endif
+    if (err == ESP_OK) {
+        err = stream::register_commands();
+    }
+    if (err == ESP_OK) {
+        err = sync::register_commands();
+    }
+    return err;
+}
+
 const DeviceModule kModule = {
     .name = "light",
     .init_drivers = init_drivers,
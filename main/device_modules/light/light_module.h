@@ -9,5 +9,30 @@ namespace device_modules::light {
 extern const DeviceModule kModule;
 extern uint16_t light_endpoint_id;
 
+/**
+ * @brief Stores the current state of the light as scene @p scene_id of @p group_id.
+ *
+ * Goes through CHIP's scenes server like a StoreScene command, once per
+ * commissioned fabric. Returns ESP_ERR_NO_MEM when a fabric's table is full
+ * or the fabric has not joined the group.
+ */
+esp_err_t store_scene(uint16_t group_id, uint8_t scene_id);
+
+/**
+ * @brief Recalls a scene from the scenes server, as a RecallScene command would.
+ *
+ * Uses the first fabric that holds the scene; ESP_ERR_NOT_FOUND when none
+ * does. All of its attributes reach the strip in one refresh.
+ */
+esp_err_t recall_scene(uint16_t group_id, uint8_t scene_id);
+
+/**
+ * @brief Registers `matter esp scene`, plus `matter esp stream` with
+ * `led_strip.streaming`, `matter esp strip_power` with
+ * `led_strip.power_limit` and `matter esp sync` with `light_sync`. No-op
+ * without the CHIP shell.
+ */
+esp_err_t register_commands();
+
 } // namespace device_modules::light
 
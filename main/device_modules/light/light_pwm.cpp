@@ -0,0 +1,131 @@
+#include "light_pwm.h"
+#include "pwm_output.h"
+
+#include "generated_config.h"
+#include "power_manager.h"
+
+#include <esp_log.h>
+#if APP_LIGHT_PWM
+#include <atomic>
+#include <esp_timer.h>
+#endif
+
+namespace device_modules::light::pwm {
+
+#if APP_LIGHT_PWM
+namespace {
+
+constexpr const char *TAG = "light_pwm";
+
+PwmOutput s_pwm;
+PwmLayout s_layout = {};
+bool s_ready = false;
+uint64_t s_last_frame_us = 0;
+esp_timer_handle_t s_fade_timer = nullptr;
+std::atomic<bool> s_fade_hold{false};
+
+void fade_done(void *)
+{
+    if (s_fade_hold.exchange(false)) {
+        power_manager::release(power_manager::Hold::Render);
+    }
+}
+
+// Keeps the chip out of light sleep until a fade (down to off, say) is over.
+void hold_for_fade(uint32_t fade_ms)
+{
+    if (!s_fade_timer || fade_ms == 0) {
+        return;
+    }
+    esp_timer_stop(s_fade_timer);
+    if (!s_fade_hold.exchange(true)) {
+        power_manager::acquire(power_manager::Hold::Render);
+    }
+    esp_timer_start_once(s_fade_timer, static_cast<uint64_t>(fade_ms) * 1000);
+}
+
+uint32_t next_fade_ms()
+{
+    const uint64_t now_us = static_cast<uint64_t>(esp_timer_get_time());
+    const uint64_t gap_ms = (now_us - s_last_frame_us) / 1000;
+    s_last_frame_us = now_us;
+    return gap_ms < generated_config::pwm_light::fade_ms ? static_cast<uint32_t>(gap_ms)
+                                                         : generated_config::pwm_light::fade_ms;
+}
+
+PwmLayout layout_from_config()
+{
+    PwmLayout layout = {};
+    for (const auto &channel : generated_config::pwm_light::channels) {
+        switch (static_cast<PwmChannel>(channel.role)) {
+        case PwmChannel::Red:
+        case PwmChannel::Green:
+        case PwmChannel::Blue:
+            layout.rgb = true;
+            break;
+        case PwmChannel::White:
+            layout.white = true;
+            break;
+        case PwmChannel::Cool:
+        case PwmChannel::Warm:
+            layout.cct = true;
+            break;
+        }
+    }
+    layout.cool_mireds = generated_config::pwm_light::cool_mireds;
+    layout.warm_mireds = generated_config::pwm_light::warm_mireds;
+    return layout;
+}
+
+} // namespace
+
+esp_err_t init()
+{
+    PwmOutput::Channel channels[generated_config::pwm_light::channel_count] = {};
+    for (size_t idx = 0; idx < generated_config::pwm_light::channel_count; ++idx) {
+        channels[idx].role = static_cast<PwmChannel>(generated_config::pwm_light::channels[idx].role);
+        channels[idx].gpio = generated_config::pwm_light::channels[idx].gpio;
+    }
+    esp_err_t err = s_pwm.init(channels, generated_config::pwm_light::channel_count,
+                               generated_config::pwm_light::frequency_hz, generated_config::pwm_light::resolution_bits);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize PWM outputs: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_layout = layout_from_config();
+    s_ready = true;
+    const esp_timer_create_args_t timer_args = {
+        .callback = fade_done,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "pwm_fade",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&timer_args, &s_fade_timer) != ESP_OK) {
+        ESP_LOGW(TAG, "No fade timer; light sleep may cut fades short.");
+    }
+    return ESP_OK;
+}
+
+bool ready()
+{
+    return s_ready;
+}
+
+esp_err_t fade_to(const LightState &state)
+{
+    if (!s_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const uint32_t fade_ms = next_fade_ms();
+    hold_for_fade(fade_ms);
+    return s_pwm.apply(to_pwm_levels(state, s_layout), fade_ms);
+}
+
+esp_err_t show(const LightState &state)
+{
+    return s_ready ? s_pwm.apply(to_pwm_levels(state, s_layout), 0) : ESP_ERR_INVALID_STATE;
+}
+#endif
+
+} // namespace device_modules::light::pwm
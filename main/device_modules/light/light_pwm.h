@@ -0,0 +1,32 @@
+#pragma once
+
+#include "light_state.h"
+
+#include <esp_err.h>
+
+namespace device_modules::light::pwm {
+
+/*
+ * `pwm_light` (APP_LIGHT_PWM): analog fixtures on LEDC instead of a strip.
+ * Only built in with APP_LIGHT_PWM.
+ */
+
+/** @brief Sets up the configured channels and the timer that ends fade holds. */
+esp_err_t init();
+
+/** True once init() succeeded. */
+bool ready();
+
+/**
+ * @brief Fades to @p state.
+ *
+ * The fade lasts as long as the gap since the previous frame, capped at
+ * `fade_ms`, so the steps of a Matter transition join into one continuous
+ * ramp. Light sleep is held off until the fade is over.
+ */
+esp_err_t fade_to(const LightState &state);
+
+/** @brief Jumps to @p state with no fade, for effect frames and identify. */
+esp_err_t show(const LightState &state);
+
+} // namespace device_modules::light::pwm
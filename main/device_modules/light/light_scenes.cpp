@@ -0,0 +1,171 @@
+#include "light_scenes.h"
+#include "light_module.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <esp_log.h>
+#include <esp_matter_core.h>
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+#include <app/clusters/scenes-server/SceneTableImpl.h>
+#include <app/clusters/scenes-server/scenes-server.h>
+#include <app/server/Server.h>
+
+namespace device_modules::light {
+
+using chip::app::Clusters::ScenesManagement::ScenesServer;
+
+namespace {
+
+constexpr const char *TAG = "light_scenes";
+
+using SceneTableEntry = chip::scenes::DefaultSceneTableImpl::SceneTableEntry;
+using SceneStorageId = chip::scenes::DefaultSceneTableImpl::SceneStorageId;
+
+uint16_t s_table_size = 0;
+const scenes::FrameCounters *s_counters = nullptr;
+
+// Scenes are fabric-scoped in the scenes server; call with the CHIP stack lock held.
+bool scene_exists(chip::FabricIndex fabric_index, uint16_t group_id, uint8_t scene_id)
+{
+    chip::scenes::DefaultSceneTableImpl *table = chip::scenes::GetSceneTableImpl(light_endpoint_id, s_table_size);
+    SceneTableEntry entry;
+    return table && table->GetSceneTableEntry(fabric_index, SceneStorageId(scene_id, group_id), entry) == CHIP_NO_ERROR;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+bool parse_scene_key(int argc, char **argv, uint16_t &group_id, uint8_t &scene_id)
+{
+    if (argc < 3) {
+        return false;
+    }
+    char *end = nullptr;
+    const unsigned long group = std::strtoul(argv[1], &end, 0);
+    if (*end != '\0' || group > UINT16_MAX) {
+        return false;
+    }
+    const unsigned long scene = std::strtoul(argv[2], &end, 0);
+    if (*end != '\0' || scene > UINT8_MAX) {
+        return false;
+    }
+    group_id = static_cast<uint16_t>(group);
+    scene_id = static_cast<uint8_t>(scene);
+    return true;
+}
+
+esp_err_t scene_command(int argc, char **argv)
+{
+    uint16_t group_id = 0;
+    uint8_t scene_id = 0;
+    if (argc >= 1 && std::strcmp(argv[0], "store") == 0 && parse_scene_key(argc, argv, group_id, scene_id)) {
+        return store_scene(group_id, scene_id);
+    }
+    if (argc >= 1 && std::strcmp(argv[0], "recall") == 0 && parse_scene_key(argc, argv, group_id, scene_id)) {
+        return recall_scene(group_id, scene_id);
+    }
+    if (argc > 0) {
+        printf("Usage: matter esp scene [store|recall <group> <scene>]\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (esp_matter::lock::chip_stack_lock(portMAX_DELAY) != esp_matter::lock::status::SUCCESS) {
+        return ESP_FAIL;
+    }
+    printf("scene table %u per fabric, attribute writes %" PRIu32 ", frames %" PRIu32 "\n",
+           static_cast<unsigned>(s_table_size), s_counters->writes, s_counters->frames);
+    esp_matter::lock::chip_stack_unlock();
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+esp_err_t store_scene(uint16_t group_id, uint8_t scene_id)
+{
+    if (light_endpoint_id == chip::kInvalidEndpointId || s_table_size == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const auto lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+    if (lock_status == esp_matter::lock::status::FAILED) {
+        return ESP_FAIL;
+    }
+    // Stored in every fabric, so a local recall finds it whichever fabric has it.
+    size_t fabrics = 0;
+    size_t stored = 0;
+    for (const chip::FabricInfo &fabric : chip::Server::GetInstance().GetFabricTable()) {
+        const chip::FabricIndex fabric_index = fabric.GetFabricIndex();
+        ScenesServer::Instance().StoreCurrentScene(fabric_index, light_endpoint_id, group_id, scene_id);
+        ++fabrics;
+        if (scene_exists(fabric_index, group_id, scene_id)) {
+            ++stored;
+        } else {
+            ESP_LOGW(TAG, "Fabric %u did not take scene %u/%u: table full or group not joined.", fabric_index,
+                     group_id, scene_id);
+        }
+    }
+    if (lock_status == esp_matter::lock::status::SUCCESS) {
+        esp_matter::lock::chip_stack_unlock();
+    }
+    if (fabrics == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return stored == fabrics ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t recall_scene(uint16_t group_id, uint8_t scene_id)
+{
+    if (light_endpoint_id == chip::kInvalidEndpointId || s_table_size == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const auto lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+    if (lock_status == esp_matter::lock::status::FAILED) {
+        return ESP_FAIL;
+    }
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    for (const chip::FabricInfo &fabric : chip::Server::GetInstance().GetFabricTable()) {
+        if (scene_exists(fabric.GetFabricIndex(), group_id, scene_id)) {
+            ScenesServer::Instance().RecallScene(fabric.GetFabricIndex(), light_endpoint_id, group_id, scene_id);
+            err = ESP_OK;
+            break;
+        }
+    }
+    if (lock_status == esp_matter::lock::status::SUCCESS) {
+        esp_matter::lock::chip_stack_unlock();
+    }
+    return err;
+}
+
+namespace scenes {
+
+void configure(uint16_t table_size)
+{
+    s_table_size = table_size;
+}
+
+esp_err_t register_commands(const FrameCounters &counters)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    s_counters = &counters;
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "scene",
+            .description = "Light scenes and frame counters. Usage: matter esp scene [store|recall <group> <scene>]",
+            .handler = scene_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    (void) counters;
+    return ESP_OK;
+#endif
+}
+
+} // namespace scenes
+
+} // namespace device_modules::light
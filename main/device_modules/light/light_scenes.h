@@ -0,0 +1,30 @@
+#pragma once
+
+#include <esp_err.h>
+
+#include <cstdint>
+
+namespace device_modules::light::scenes {
+
+/*
+ * Scenes of light_endpoint_id go through CHIP's scenes server, so local
+ * store/recall (store_scene(), recall_scene() and `matter esp scene`) and
+ * the Scenes Management cluster share one table per fabric.
+ */
+
+/** Attribute writes against the strip frames they were committed in. */
+struct FrameCounters {
+    uint32_t writes;
+    uint32_t frames;
+};
+
+/** @brief Sets the per-fabric table size of light_endpoint_id; 0 without a scenes cluster. */
+void configure(uint16_t table_size);
+
+/**
+ * @brief Registers `matter esp scene`, which also prints @p counters (read
+ * with the CHIP stack lock held). No-op without the CHIP shell.
+ */
+esp_err_t register_commands(const FrameCounters &counters);
+
+} // namespace device_modules::light::scenes
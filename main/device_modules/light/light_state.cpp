@@ -0,0 +1,184 @@
+#include "light_state.h"
+
+namespace device_modules::light {
+
+namespace {
+
+constexpr uint16_t kMiredsFirst = 100;
+constexpr uint16_t kMiredsStep = 25;
+
+// Blackbody colour every 25 mireds from 100 (10000 K) to 500 (2000 K).
+constexpr Rgb kBlackbody[] = {
+    {202, 218, 255}, {221, 230, 255}, {255, 250, 255}, {255, 241, 229}, {255, 228, 206}, {255, 216, 185},
+    {255, 206, 166}, {255, 196, 148}, {255, 188, 131}, {255, 180, 115}, {255, 172, 100}, {255, 165, 85},
+    {255, 159, 70},  {255, 153, 56},  {255, 147, 42},  {255, 142, 28},  {255, 137, 14},
+};
+constexpr size_t kBlackbodyCount = sizeof(kBlackbody) / sizeof(kBlackbody[0]);
+
+uint8_t remap(uint8_t value, uint32_t from_max, uint32_t to_max)
+{
+    const uint32_t scaled = (static_cast<uint32_t>(value) * to_max + from_max / 2) / from_max;
+    return static_cast<uint8_t>(scaled > to_max ? to_max : scaled);
+}
+
+Rgb blackbody(uint16_t mireds)
+{
+    if (mireds <= kMiredsFirst) {
+        return kBlackbody[0];
+    }
+    const uint32_t offset = mireds - kMiredsFirst;
+    const size_t idx = offset / kMiredsStep;
+    if (idx + 1 >= kBlackbodyCount) {
+        return kBlackbody[kBlackbodyCount - 1];
+    }
+    const int32_t frac = static_cast<int32_t>(offset % kMiredsStep);
+    const Rgb &lo = kBlackbody[idx];
+    const Rgb &hi = kBlackbody[idx + 1];
+    auto lerp = [frac](uint8_t a, uint8_t b) {
+        return static_cast<uint8_t>(a + ((static_cast<int32_t>(b) - a) * frac) / static_cast<int32_t>(kMiredsStep));
+    };
+    return {lerp(lo.r, hi.r), lerp(lo.g, hi.g), lerp(lo.b, hi.b)};
+}
+
+void rgb_to_hs(const Rgb &rgb, uint16_t &h, uint8_t &s)
+{
+    const int32_t max = rgb.r > rgb.g ? (rgb.r > rgb.b ? rgb.r : rgb.b) : (rgb.g > rgb.b ? rgb.g : rgb.b);
+    const int32_t min = rgb.r < rgb.g ? (rgb.r < rgb.b ? rgb.r : rgb.b) : (rgb.g < rgb.b ? rgb.g : rgb.b);
+    const int32_t delta = max - min;
+    s = max == 0 ? 0 : static_cast<uint8_t>((delta * 255 + max / 2) / max);
+    if (delta == 0) {
+        h = 0;
+        return;
+    }
+    int32_t hue;
+    if (max == rgb.r) {
+        hue = 60 * (rgb.g - rgb.b) / delta;
+    } else if (max == rgb.g) {
+        hue = 120 + 60 * (rgb.b - rgb.r) / delta;
+    } else {
+        hue = 240 + 60 * (rgb.r - rgb.g) / delta;
+    }
+    h = static_cast<uint16_t>(hue < 0 ? hue + 360 : hue);
+}
+
+// CIE xy at full luminance to linear sRGB, scaled so the largest channel is
+// 255. Colours outside the sRGB gamut are clipped to its edge; level sets
+// the brightness afterwards, so luminance does not matter here.
+Rgb xy_to_rgb(uint16_t x, uint16_t y)
+{
+    if (y == 0) {
+        return {255, 255, 255};
+    }
+    // X, Y and Z with Y = 65536; the matrix is scaled by 10000.
+    const int64_t big_x = (static_cast<int64_t>(x) << 16) / y;
+    const int64_t big_y = 1 << 16;
+    const int64_t big_z = (static_cast<int64_t>(65536 - x - y) << 16) / y;
+    int64_t channels[3] = {
+        32406 * big_x - 15372 * big_y - 4986 * big_z,
+        -9689 * big_x + 18758 * big_y + 415 * big_z,
+        557 * big_x - 2040 * big_y + 10570 * big_z,
+    };
+    int64_t max = 0;
+    for (int64_t &channel : channels) {
+        channel = channel < 0 ? 0 : channel;
+        max = channel > max ? channel : max;
+    }
+    if (max == 0) {
+        return {255, 255, 255};
+    }
+    auto scale = [max](int64_t channel) { return static_cast<uint8_t>((channel * 255 + max / 2) / max); };
+    return {scale(channels[0]), scale(channels[1]), scale(channels[2])};
+}
+
+} // namespace
+
+Hsv to_hsv(const LightState &state)
+{
+    Hsv hsv{};
+    hsv.v = remap(state.level, 254, 255);
+    if (state.mode == ColorMode::Temperature) {
+        rgb_to_hs(blackbody(state.mireds), hsv.h, hsv.s);
+    } else if (state.mode == ColorMode::XY) {
+        rgb_to_hs(xy_to_rgb(state.x, state.y), hsv.h, hsv.s);
+    } else {
+        const uint16_t hue = static_cast<uint16_t>((static_cast<uint32_t>(state.hue) * 360 + 127) / 254);
+        hsv.h = hue >= 360 ? 0 : hue;
+        hsv.s = remap(state.saturation, 254, 255);
+    }
+    return hsv;
+}
+
+Rgb to_rgb(const Hsv &hsv)
+{
+    const uint32_t sector = (hsv.h % 360) / 60;
+    const uint32_t frac = (hsv.h % 60) * 255 / 60;
+    const uint32_t v = hsv.v;
+    const uint8_t p = static_cast<uint8_t>(v * (255 - hsv.s) / 255);
+    const uint8_t q = static_cast<uint8_t>(v * (255 - hsv.s * frac / 255) / 255);
+    const uint8_t t = static_cast<uint8_t>(v * (255 - hsv.s * (255 - frac) / 255) / 255);
+    const uint8_t value = hsv.v;
+    switch (sector) {
+    case 0:
+        return {value, t, p};
+    case 1:
+        return {q, value, p};
+    case 2:
+        return {p, value, t};
+    case 3:
+        return {p, q, value};
+    case 4:
+        return {t, p, value};
+    default:
+        return {value, p, q};
+    }
+}
+
+PwmLevels to_pwm_levels(const LightState &state, const PwmLayout &layout)
+{
+    PwmLevels levels{};
+    if (!state.on || state.level == 0) {
+        return levels;
+    }
+    const uint32_t level = state.level > 254 ? 254 : state.level;
+    const uint32_t brightness = (level * level * 65535u + 254u * 254u / 2) / (254u * 254u);
+    auto scale = [brightness](uint32_t component) {
+        return static_cast<uint16_t>((component * brightness + 127) / 255);
+    };
+
+    if (state.mode == ColorMode::Temperature && layout.cct) {
+        const uint16_t cool = layout.cool_mireds;
+        const uint16_t warm = layout.warm_mireds > cool ? layout.warm_mireds : cool + 1;
+        const uint16_t mireds = state.mireds < cool ? cool : (state.mireds > warm ? warm : state.mireds);
+        const uint32_t warm_share = (static_cast<uint32_t>(mireds - cool) * 255 + (warm - cool) / 2) / (warm - cool);
+        levels.duty[static_cast<size_t>(PwmChannel::Warm)] = scale(warm_share);
+        levels.duty[static_cast<size_t>(PwmChannel::Cool)] = scale(255 - warm_share);
+        return levels;
+    }
+    if (!layout.rgb) {
+        // White-only fixtures keep their white point and only dim.
+        if (layout.cct) {
+            LightState white = state;
+            white.mode = ColorMode::Temperature;
+            return to_pwm_levels(white, layout);
+        }
+        levels.duty[static_cast<size_t>(PwmChannel::White)] = static_cast<uint16_t>(brightness);
+        return levels;
+    }
+
+    Hsv colour = to_hsv(state);
+    colour.v = 255;
+    Rgb rgb = to_rgb(colour);
+    if (layout.white) {
+        const uint8_t common = rgb.r < rgb.g ? (rgb.r < rgb.b ? rgb.r : rgb.b) : (rgb.g < rgb.b ? rgb.g : rgb.b);
+        rgb.r = static_cast<uint8_t>(rgb.r - common);
+        rgb.g = static_cast<uint8_t>(rgb.g - common);
+        rgb.b = static_cast<uint8_t>(rgb.b - common);
+        levels.duty[static_cast<size_t>(PwmChannel::White)] = scale(common);
+    }
+    levels.duty[static_cast<size_t>(PwmChannel::Red)] = scale(rgb.r);
+    levels.duty[static_cast<size_t>(PwmChannel::Green)] = scale(rgb.g);
+    levels.duty[static_cast<size_t>(PwmChannel::Blue)] = scale(rgb.b);
+    return levels;
+}
+
+} // namespace device_modules::light
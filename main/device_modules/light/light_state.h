@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace device_modules::light {
+
+enum class ColorMode : uint8_t { HueSaturation, Temperature, XY };
+
+/**
+ * @brief Target state of the strip in Matter units.
+ *
+ * Attribute writes only update this state; the light module commits it to
+ * the strip once per CHIP event, so a scene recall that writes OnOff, Level
+ * and Color attributes in one command lands in a single refresh. `mode`
+ * follows the ColorMode attribute: the colour fields of the other modes keep
+ * their last value but are not rendered.
+ */
+struct LightState {
+    bool on;
+    uint8_t level;      // 0..254
+    ColorMode mode;
+    uint8_t hue;        // 0..254
+    uint8_t saturation; // 0..254
+    uint16_t mireds;
+    uint16_t x;         // CIE 1931 x, 0..65279 for 0..0.996
+    uint16_t y;         // CIE 1931 y, same scale
+};
+
+struct Hsv {
+    uint16_t h; // 0..359
+    uint8_t s;  // 0..255
+    uint8_t v;  // 0..255
+};
+
+struct Rgb {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+/**
+ * Colour and brightness of @p state as one HSV value. Temperatures go through
+ * an integer blackbody table and xy through the sRGB matrix.
+ */
+Hsv to_hsv(const LightState &state);
+Rgb to_rgb(const Hsv &hsv);
+
+/** Channels of an analog (PWM) fixture; the values index PwmLevels::duty. */
+enum class PwmChannel : uint8_t { Red, Green, Blue, White, Cool, Warm };
+constexpr size_t kPwmChannelCount = 6;
+
+/** Which channels a fixture has and the white points of its CW/WW pair. */
+struct PwmLayout {
+    bool rgb;   // red, green and blue
+    bool white; // single white channel
+    bool cct;   // cool and warm white pair
+    uint16_t cool_mireds;
+    uint16_t warm_mireds;
+};
+
+/** Linear duty of every channel, 0..65535, before it is scaled to the timer resolution. */
+struct PwmLevels {
+    uint16_t duty[kPwmChannelCount];
+};
+
+/**
+ * @brief Mixes @p state into the channels of @p layout.
+ *
+ * Colour goes through to_hsv()/to_rgb() like the strip; temperatures are
+ * blended between the CW/WW white points at constant total output when the
+ * fixture has them, and RGBW moves the common part of R, G and B to white.
+ * Level is squared, so the low end of the dimming curve gets the extra
+ * resolution of the timer.
+ */
+PwmLevels to_pwm_levels(const LightState &state, const PwmLayout &layout);
+
+} // namespace device_modules::light
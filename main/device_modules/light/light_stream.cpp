@@ -0,0 +1,195 @@
+#include "light_stream.h"
+
+#include "generated_config.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <esp_log.h>
+#include <sdkconfig.h>
+#if APP_LED_STREAMING
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <platform/CHIPDeviceLayer.h>
+#endif
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+namespace device_modules::light::stream {
+
+#if APP_LED_STREAMING
+namespace {
+
+constexpr const char *TAG = "light_stream";
+
+constexpr uint32_t kStreamTaskStackSize = 4096;
+constexpr UBaseType_t kStreamTaskPriority = 5;
+constexpr uint32_t kStreamPollMs = 100;
+
+class LedStripOutput : public PixelOutput {
+public:
+    LedStripOutput(led_strip_handle_t strip, size_t pixel_count, uint8_t bytes_per_pixel)
+        : m_strip(strip), m_pixel_count(pixel_count), m_bytes_per_pixel(bytes_per_pixel)
+    {
+    }
+
+    size_t pixel_count() const override { return m_pixel_count; }
+    uint8_t bytes_per_pixel() const override { return m_bytes_per_pixel; }
+
+    bool show(const uint8_t *framebuffer, uint8_t brightness) override
+    {
+        const uint32_t scale = brightness + 1u;
+        for (size_t idx = 0; idx < m_pixel_count; ++idx) {
+            const uint8_t *px = framebuffer + idx * m_bytes_per_pixel;
+            const uint32_t r = (px[0] * scale) >> 8;
+            const uint32_t g = (px[1] * scale) >> 8;
+            const uint32_t b = (px[2] * scale) >> 8;
+            if (m_bytes_per_pixel == 4) {
+                led_strip_set_pixel_rgbw(m_strip, idx, r, g, b, (px[3] * scale) >> 8);
+            } else {
+                led_strip_set_pixel(m_strip, idx, r, g, b);
+            }
+        }
+        return led_strip_refresh(m_strip) == ESP_OK;
+    }
+
+private:
+    led_strip_handle_t m_strip;
+    size_t m_pixel_count;
+    uint8_t m_bytes_per_pixel;
+};
+
+PixelStream *s_stream = nullptr;
+
+uint64_t stream_now_us()
+{
+    return static_cast<uint64_t>(esp_timer_get_time());
+}
+
+void stream_task(void *)
+{
+    while (s_stream->poll(kStreamPollMs)) {
+    }
+    ESP_LOGE(TAG, "Pixel stream socket closed.");
+    vTaskDelete(nullptr);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t stream_command(int argc, char **argv)
+{
+    if (!s_stream) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (argc >= 1 && std::strcmp(argv[0], "reset") == 0) {
+        s_stream->reset_stats();
+        return ESP_OK;
+    }
+    const PixelStream::Stats stats = s_stream->stats();
+    printf("%s, %" PRIu32 ".%" PRIu32 " fps, frames %" PRIu32 " (coalesced %" PRIu32 "), packets %" PRIu32
+           " (dropped %" PRIu32 ", sequence gaps %" PRIu32 ")\n",
+           s_stream->streaming() ? "streaming" : "idle", stats.fps_x10 / 10, stats.fps_x10 % 10, stats.frames,
+           stats.coalesced, stats.packets, stats.dropped, stats.sequence_gaps);
+    printf("packet-to-frame latency avg %" PRIu32 " us, max %" PRIu32 " us\n", stats.latency_avg_us,
+           stats.latency_max_us);
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+esp_err_t init(const led_strip_config_t &strip_config, PowerLimiter *limiter)
+{
+    led_strip_rmt_config_t rmt_config = {};
+    rmt_config.clk_src = RMT_CLK_SRC_DEFAULT;
+    rmt_config.resolution_hz = 10 * 1000 * 1000;
+    rmt_config.mem_block_symbols = 64;
+    rmt_config.flags.with_dma = false;
+
+    led_strip_handle_t strip = nullptr;
+    esp_err_t err = led_strip_new_rmt_device(&strip_config, &rmt_config, &strip);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create LED strip: %s", esp_err_to_name(err));
+        return err;
+    }
+    const uint8_t bytes_per_pixel = strip_config.led_pixel_format == LED_PIXEL_FORMAT_GRBW ? 4 : 3;
+    static LedStripOutput output(strip, strip_config.max_leds, bytes_per_pixel);
+    static PixelStream stream(output);
+    stream.set_power_limiter(limiter);
+    s_stream = &stream;
+    return ESP_OK;
+}
+
+void start()
+{
+    if (!s_stream) {
+        return;
+    }
+    const PixelStream::Config config = {
+        .protocol = generated_config::led_stream::e131 ? StreamProtocol::E131 : StreamProtocol::Ddp,
+        .port = generated_config::led_stream::port,
+        .universe = generated_config::led_stream::universe,
+        .max_fps = generated_config::led_stream::max_fps,
+        .timeout_ms = generated_config::led_stream::timeout_ms,
+        .now_us = stream_now_us,
+    };
+    if (!s_stream->open(config)) {
+        ESP_LOGE(TAG, "Failed to open pixel stream on UDP port %u.", config.port);
+        return;
+    }
+#if CHIP_DEVICE_CONFIG_ENABLE_WIFI_STATION
+    // Modem sleep holds packets until the next DTIM beacon, far longer than a frame.
+    esp_err_t err = esp_wifi_set_ps(WIFI_PS_NONE);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to disable Wi-Fi power save: %s", esp_err_to_name(err));
+    }
+#endif
+    if (xTaskCreate(stream_task, "pixel_stream", kStreamTaskStackSize, nullptr, kStreamTaskPriority, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create pixel stream task.");
+        s_stream->close();
+        return;
+    }
+    ESP_LOGI(TAG, "Listening for %s pixel data on UDP port %u.", generated_config::led_stream::e131 ? "E1.31" : "DDP",
+             config.port);
+}
+
+esp_err_t show(const LightState &state)
+{
+    if (!s_stream) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Level is the master brightness of streamed frames, so the colour is
+    // handed over at full value.
+    Hsv colour = to_hsv(state);
+    colour.v = 255;
+    const Rgb rgb = to_rgb(colour);
+    s_stream->set_matter_state(state.on, state.level, rgb.r, rgb.g, rgb.b);
+    return ESP_OK;
+}
+
+PixelStream *get()
+{
+    return s_stream;
+}
+#endif
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL && APP_LED_STREAMING
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "stream",
+            .description = "DDP/E1.31 receiver statistics. Usage: matter esp stream [reset]",
+            .handler = stream_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace device_modules::light::stream
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "light_state.h"
+#include "pixel_stream.h"
+#include "power_limit.h"
+
+#include <esp_err.h>
+#include <led_strip.h>
+
+namespace device_modules::light::stream {
+
+/*
+ * `led_strip.streaming` (APP_LED_STREAMING): the strip is driven directly
+ * instead of through led_indicator, so streamed frames and Matter colours
+ * share one RMT channel. Only built in with APP_LED_STREAMING.
+ */
+
+/**
+ * @brief Creates the strip and its PixelStream. @p limiter, if set, caps
+ * every frame and is serialised with the stream's own frames.
+ */
+esp_err_t init(const led_strip_config_t &strip_config, PowerLimiter *limiter);
+
+/** @brief Opens the DDP/E1.31 receiver and starts the pixel_stream task; call once the stack is up. */
+void start();
+
+/** @brief Hands @p state over as the fallback colour and master brightness of streamed frames. */
+esp_err_t show(const LightState &state);
+
+/** The strip's PixelStream; nullptr until init() succeeded. */
+PixelStream *get();
+
+/** @brief Registers `matter esp stream`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace device_modules::light::stream
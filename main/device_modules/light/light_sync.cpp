@@ -0,0 +1,319 @@
+#include "light_sync.h"
+#include "group_clock.h"
+
+#include "generated_config.h"
+#include "power_manager.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include <esp_log.h>
+#include <sdkconfig.h>
+#if APP_LIGHT_SYNC
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <esp_mac.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+namespace device_modules::light::sync {
+
+#if APP_LIGHT_SYNC
+namespace {
+
+constexpr const char *TAG = "light_sync";
+
+constexpr uint32_t kSyncTaskStackSize = 4096;
+constexpr UBaseType_t kSyncTaskPriority = 6;
+constexpr uint32_t kSyncPollMs = 1000;
+
+// s_mutex guards s_clock and s_effect.
+GroupClock s_clock;
+EffectPlayer s_effect;
+std::mutex s_mutex;
+std::atomic<bool> s_effect_running{false};
+esp_timer_handle_t s_effect_timer = nullptr;
+uint32_t s_effect_frames = 0;
+ShowFrame s_show = nullptr;
+EffectDone s_done = nullptr;
+int s_socket = -1;
+sockaddr_in6 s_group = {};
+sockaddr_in6 s_leader = {};
+bool s_leader_known = false;
+
+void effect_done_work(intptr_t)
+{
+    if (!s_effect_running.load()) {
+        s_done();
+    }
+    power_manager::release(power_manager::Hold::Render);
+}
+
+void effect_frame(void *)
+{
+    LightState frame{};
+    uint64_t now_us = 0;
+    bool active = false;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        now_us = s_clock.group_us(static_cast<uint64_t>(esp_timer_get_time()));
+        active = s_effect.render(now_us, frame);
+        if (!active) {
+            s_effect_running.store(false);
+        }
+    }
+    if (!active) {
+        // Back to the attribute state in the CHIP context, where attribute writes land.
+        if (chip::DeviceLayer::PlatformMgr().ScheduleWork(effect_done_work) != CHIP_NO_ERROR) {
+            ESP_LOGE(TAG, "Failed to schedule the end of an effect.");
+            power_manager::release(power_manager::Hold::Render);
+        }
+        return;
+    }
+    s_show(frame);
+    ++s_effect_frames;
+    const uint64_t frame_us = static_cast<uint64_t>(generated_config::light_sync::frame_ms) * 1000;
+    esp_timer_start_once(s_effect_timer, frame_us - now_us % frame_us);
+}
+
+void send_sync(const SyncMessage &message, const sockaddr_in6 &to)
+{
+    uint8_t buffer[kSyncMessageSize];
+    encode_sync(message, buffer);
+    sendto(s_socket, buffer, sizeof(buffer), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+}
+
+void receive_sync()
+{
+    uint8_t buffer[kSyncMessageSize + 1];
+    sockaddr_in6 from = {};
+    socklen_t from_len = sizeof(from);
+    const ssize_t len = recvfrom(s_socket, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr *>(&from),
+                                 &from_len);
+    // Stamped before anything else, so the exchange sees as little of this task as possible.
+    const uint64_t rx_us = static_cast<uint64_t>(esp_timer_get_time());
+    if (len <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    SyncMessage message{};
+    if (!decode_sync(buffer, static_cast<size_t>(len), message)) {
+        s_clock.on_malformed();
+        return;
+    }
+    SyncMessage reply{};
+    const bool answer = s_clock.on_message(message, rx_us, reply);
+    if (message.type == SyncType::Beacon && !s_clock.leader(rx_us) &&
+        s_clock.stats(rx_us).leader_id == message.node_id) {
+        // Delay requests go back to wherever the leader's beacons come from.
+        s_leader = from;
+        s_leader_known = true;
+    }
+    if (answer) {
+        reply.t3 = s_clock.group_us(static_cast<uint64_t>(esp_timer_get_time()));
+        send_sync(reply, from);
+    }
+}
+
+void sync_task(void *)
+{
+    while (true) {
+        uint64_t now_us = static_cast<uint64_t>(esp_timer_get_time());
+        uint64_t wake_us = 0;
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            SyncMessage message{};
+            if (s_clock.poll(now_us, message)) {
+                if (message.type == SyncType::Beacon) {
+                    send_sync(message, s_group);
+                } else if (s_leader_known) {
+                    send_sync(message, s_leader);
+                }
+            }
+            wake_us = s_clock.next_wakeup_us(now_us);
+        }
+
+        uint64_t wait_ms = (wake_us - now_us) / 1000 + 1;
+        wait_ms = wait_ms < kSyncPollMs ? wait_ms : kSyncPollMs;
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(s_socket, &readable);
+        timeval timeout = {
+            .tv_sec = static_cast<time_t>(wait_ms / 1000),
+            .tv_usec = static_cast<suseconds_t>((wait_ms % 1000) * 1000),
+        };
+        if (select(s_socket + 1, &readable, nullptr, nullptr, &timeout) > 0) {
+            receive_sync();
+        }
+    }
+}
+
+uint64_t sync_node_id()
+{
+    uint8_t mac[6] = {};
+    esp_efuse_mac_get_default(mac);
+    uint64_t node_id = 0;
+    for (uint8_t byte : mac) {
+        node_id = node_id << 8 | byte;
+    }
+    return node_id;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t sync_command(int, char **)
+{
+    GroupClock::Stats stats{};
+    bool locked = false;
+    bool effect = false;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        const uint64_t now_us = static_cast<uint64_t>(esp_timer_get_time());
+        stats = s_clock.stats(now_us);
+        locked = s_clock.locked(now_us);
+        effect = s_effect.active();
+    }
+    printf("%s, leader %016" PRIx64 ", %s, offset %" PRId64 " us, rtt %" PRIu32 " us\n",
+           stats.leader ? "leading" : "following", stats.leader_id,
+           locked ? "locked" : (stats.synced ? "coarse" : "listening"), stats.offset_us, stats.rtt_us);
+    printf("beacons sent %" PRIu32 " received %" PRIu32 ", exchanges %" PRIu32 ", answered %" PRIu32
+           ", ignored %" PRIu32 ", leader changes %" PRIu32 "\n",
+           stats.beacons_sent, stats.beacons_received, stats.exchanges, stats.answered, stats.ignored,
+           stats.leader_changes);
+    printf("effect %s, %" PRIu32 " effect frames\n", effect ? "running" : "idle", s_effect_frames);
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+void start(ShowFrame show, EffectDone done)
+{
+    s_show = show;
+    s_done = done;
+    const esp_timer_create_args_t timer_args = {
+        .callback = effect_frame,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "light_effect",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&timer_args, &s_effect_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create the effect timer.");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_clock.configure({sync_node_id(), generated_config::light_sync::domain,
+                           generated_config::light_sync::beacon_interval_ms},
+                          static_cast<uint64_t>(esp_timer_get_time()));
+    }
+
+    s_group.sin6_family = AF_INET6;
+    s_group.sin6_port = htons(generated_config::light_sync::port);
+    if (inet_pton(AF_INET6, generated_config::light_sync::address, &s_group.sin6_addr) != 1) {
+        ESP_LOGE(TAG, "Invalid light_sync address %s.", generated_config::light_sync::address);
+        return;
+    }
+    s_socket = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_socket < 0) {
+        ESP_LOGE(TAG, "Failed to create the sync socket: errno %d", errno);
+        return;
+    }
+    sockaddr_in6 local = {};
+    local.sin6_family = AF_INET6;
+    local.sin6_port = htons(generated_config::light_sync::port);
+    local.sin6_addr = in6addr_any;
+    ipv6_mreq group = {};
+    group.ipv6mr_multiaddr = s_group.sin6_addr;
+    group.ipv6mr_interface = 0;
+    if (bind(s_socket, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0) {
+        ESP_LOGE(TAG, "Failed to bind the sync socket to port %u: errno %d", generated_config::light_sync::port, errno);
+        close(s_socket);
+        s_socket = -1;
+        return;
+    }
+    if (setsockopt(s_socket, IPPROTO_IPV6, IPV6_JOIN_GROUP, &group, sizeof(group)) != 0) {
+        ESP_LOGW(TAG, "Failed to join %s: errno %d", generated_config::light_sync::address, errno);
+    }
+#if CHIP_DEVICE_CONFIG_ENABLE_WIFI_STATION
+    // Modem sleep holds beacons and replies until the next DTIM beacon.
+    esp_err_t err = esp_wifi_set_ps(WIFI_PS_NONE);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to disable Wi-Fi power save: %s", esp_err_to_name(err));
+    }
+#endif
+    if (xTaskCreate(sync_task, "light_sync", kSyncTaskStackSize, nullptr, kSyncTaskPriority, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the light sync task.");
+        close(s_socket);
+        s_socket = -1;
+        return;
+    }
+    ESP_LOGI(TAG, "Light sync domain %u on [%s]:%u.", generated_config::light_sync::domain,
+             generated_config::light_sync::address, generated_config::light_sync::port);
+}
+
+void start_effect(Effect effect, const LightState &from)
+{
+    if (!s_effect_timer) {
+        ESP_LOGW(TAG, "Effect timer missing; effect 0x%02x skipped.", static_cast<unsigned>(effect));
+        return;
+    }
+    bool first_frame = false;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_effect.start(effect, from, s_clock.group_us(static_cast<uint64_t>(esp_timer_get_time())));
+        first_frame = !s_effect_running.exchange(true);
+    }
+    if (first_frame) {
+        power_manager::acquire(power_manager::Hold::Render);
+        esp_timer_start_once(s_effect_timer, 0);
+    }
+}
+
+void end_effect(bool finish_cycle)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (finish_cycle) {
+        s_effect.finish(s_clock.group_us(static_cast<uint64_t>(esp_timer_get_time())));
+    } else {
+        s_effect.stop();
+    }
+}
+
+bool effect_running()
+{
+    return s_effect_running.load();
+}
+#endif
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL && APP_LIGHT_SYNC
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "sync",
+            .description = "Group clock and effect state for light_sync. Usage: matter esp sync",
+            .handler = sync_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace device_modules::light::sync
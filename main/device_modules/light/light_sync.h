@@ -0,0 +1,42 @@
+#pragma once
+
+#include "effect_player.h"
+#include "light_state.h"
+
+#include <esp_err.h>
+
+namespace device_modules::light::sync {
+
+/*
+ * `light_sync` (APP_LIGHT_SYNC): lights of one domain share a GroupClock
+ * over UDP multicast, and effects are rendered from group time on the
+ * frame_ms grid of group time, so every light of the group refreshes at the
+ * same instant. Only built in with APP_LIGHT_SYNC.
+ */
+
+/** Puts one effect frame on the output with no fade; called in the esp_timer task. */
+using ShowFrame = esp_err_t (*)(const LightState &state);
+
+/** Called in the CHIP context once an effect is over, to go back to the attribute state. */
+using EffectDone = void (*)();
+
+/**
+ * @brief Creates the effect timer, joins the sync group and starts the
+ * light_sync task; call once the stack is up. Effects run on the local clock
+ * until the group is heard.
+ */
+void start(ShowFrame show, EffectDone done);
+
+/** @brief Starts @p effect from @p from. Call with the CHIP stack lock held. */
+void start_effect(Effect effect, const LightState &from);
+
+/** @brief Stops the running effect, or lets it finish its cycle with @p finish_cycle. */
+void end_effect(bool finish_cycle);
+
+/** True while an effect owns the output; attribute writes are committed once it is over. */
+bool effect_running();
+
+/** @brief Registers `matter esp sync`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace device_modules::light::sync
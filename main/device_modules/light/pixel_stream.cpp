@@ -0,0 +1,368 @@
+#include "pixel_stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace device_modules::light {
+
+namespace {
+
+constexpr size_t kDdpHeaderLen = 10;
+constexpr size_t kDdpTimecodeHeaderLen = 14;
+constexpr uint8_t kDdpVersionMask = 0xC0;
+constexpr uint8_t kDdpVersion1 = 0x40;
+constexpr uint8_t kDdpFlagTimecode = 0x10;
+constexpr uint8_t kDdpFlagReply = 0x04;
+constexpr uint8_t kDdpFlagQuery = 0x02;
+constexpr uint8_t kDdpFlagPush = 0x01;
+constexpr uint8_t kDdpIdDisplay = 1;
+
+constexpr size_t kE131HeaderLen = 126;
+constexpr uint8_t kE131PacketId[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+constexpr uint32_t kE131RootVectorData = 0x00000004;
+constexpr uint32_t kE131FramingVectorData = 0x00000002;
+constexpr uint8_t kE131DmpVectorSetProperty = 0x02;
+constexpr uint8_t kE131OptionPreview = 0x80;
+constexpr uint16_t kDmxSlots = 512;
+
+constexpr size_t kMaxHeaderLen = kE131HeaderLen;
+constexpr uint64_t kFpsWindowUs = 1'000'000;
+
+uint16_t be16(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+uint32_t be32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 |
+           p[3];
+}
+
+} // namespace
+
+PixelStream::PixelStream(PixelOutput &output) : m_output(output) {}
+
+PixelStream::~PixelStream()
+{
+    close();
+}
+
+bool PixelStream::open(const Config &config)
+{
+    close();
+    m_config = config;
+    if (m_config.max_fps == 0) {
+        m_config.max_fps = 60;
+    }
+
+    const uint8_t bytes_per_pixel = m_output.bytes_per_pixel();
+    m_framebuffer_size = m_output.pixel_count() * bytes_per_pixel;
+    // Pixels never straddle a universe: 170 RGB or 128 RGBW pixels each.
+    m_universe_bytes = bytes_per_pixel ? (kDmxSlots / bytes_per_pixel) * bytes_per_pixel : 0;
+    m_receive.reset(new (std::nothrow) uint8_t[m_framebuffer_size]());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_framebuffer.reset(new (std::nothrow) uint8_t[m_framebuffer_size]());
+    }
+    if (!m_receive || !m_framebuffer || m_framebuffer_size == 0 || !m_config.now_us) {
+        return false;
+    }
+
+    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_socket < 0) {
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_config.port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(m_socket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void PixelStream::close()
+{
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+}
+
+bool PixelStream::poll(uint32_t timeout_ms)
+{
+    if (m_socket < 0) {
+        return false;
+    }
+
+    // An eighth of slack so a sender running exactly at max_fps is not held
+    // back a whole frame by jitter.
+    const uint64_t frame_interval_us = 1'000'000 / m_config.max_fps * 7 / 8;
+    uint64_t wait_us = static_cast<uint64_t>(timeout_ms) * 1000;
+    if (m_frame_pending) {
+        const uint64_t since_show = m_config.now_us() - m_last_show_us;
+        wait_us = since_show >= frame_interval_us ? 0 : std::min(wait_us, frame_interval_us - since_show);
+    }
+
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(m_socket, &read_fds);
+    timeval tv = {static_cast<decltype(tv.tv_sec)>(wait_us / 1'000'000),
+                  static_cast<decltype(tv.tv_usec)>(wait_us % 1'000'000)};
+    const int ready = select(m_socket + 1, &read_fds, nullptr, nullptr, &tv);
+    if (ready < 0 && errno != EINTR) {
+        return false;
+    }
+
+    // Drain everything queued before showing, so a burst collapses into the
+    // newest complete frame. Counters are added to m_stats under the lock
+    // once the socket is drained.
+    Stats counted{};
+    while (ready > 0) {
+        uint8_t header[kMaxHeaderLen];
+        const ssize_t peeked = recv(m_socket, header, sizeof(header), MSG_PEEK | MSG_DONTWAIT);
+        if (peeked < 0) {
+            break;
+        }
+        const uint64_t now = m_config.now_us();
+        Placement placement{};
+        if (!locate(header, static_cast<size_t>(peeked), placement)) {
+            drop_datagram();
+            ++counted.dropped;
+            continue;
+        }
+
+        iovec iov[2] = {
+            {header, placement.header_len},
+            {m_receive.get() + placement.offset, placement.length},
+        };
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = placement.length ? 2 : 1;
+        if (recvmsg(m_socket, &msg, MSG_DONTWAIT) < 0) {
+            break;
+        }
+
+        ++counted.packets;
+        counted.sequence_gaps += placement.sequence_gap ? 1 : 0;
+        if (!m_frame_pending && m_frame_first_us == 0) {
+            m_frame_first_us = now;
+        }
+        m_last_packet_us.store(now, std::memory_order_relaxed);
+        m_was_streaming = true;
+        if (placement.frame_end) {
+            if (m_frame_pending) {
+                ++counted.coalesced;
+            }
+            m_frame_pending = true;
+        }
+    }
+    if (counted.packets != 0 || counted.dropped != 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.packets += counted.packets;
+        m_stats.dropped += counted.dropped;
+        m_stats.coalesced += counted.coalesced;
+        m_stats.sequence_gaps += counted.sequence_gaps;
+    }
+
+    const uint64_t now = m_config.now_us();
+    if (m_frame_pending && now - m_last_show_us >= frame_interval_us) {
+        show_frame(now);
+    }
+    if (m_was_streaming && !streaming()) {
+        // The sender went quiet: hand the strip back to Matter.
+        m_was_streaming = false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        show_solid_locked();
+    }
+    return true;
+}
+
+bool PixelStream::locate(const uint8_t *header, size_t len, Placement &out)
+{
+    out.sequence_gap = false;
+    if (m_config.protocol == StreamProtocol::Ddp) {
+        if (len < kDdpHeaderLen || (header[0] & kDdpVersionMask) != kDdpVersion1 ||
+            (header[0] & (kDdpFlagReply | kDdpFlagQuery)) || header[3] != kDdpIdDisplay) {
+            return false;
+        }
+        out.header_len = (header[0] & kDdpFlagTimecode) ? kDdpTimecodeHeaderLen : kDdpHeaderLen;
+        if (len < out.header_len) {
+            return false;
+        }
+        out.offset = be32(header + 4);
+        out.length = be16(header + 8);
+        out.frame_end = (header[0] & kDdpFlagPush) != 0;
+
+        // Sequence numbers run 1..15; 0 means the sender does not use them.
+        const uint8_t sequence = header[1] & 0x0F;
+        if (sequence != 0) {
+            out.sequence_gap = m_has_sequence && sequence != (m_sequence % 15) + 1;
+            m_sequence = sequence;
+            m_has_sequence = true;
+        }
+    } else {
+        if (len < kE131HeaderLen || std::memcmp(header + 4, kE131PacketId, sizeof(kE131PacketId)) != 0 ||
+            be32(header + 18) != kE131RootVectorData || be32(header + 40) != kE131FramingVectorData ||
+            header[117] != kE131DmpVectorSetProperty || header[125] != 0 || (header[112] & kE131OptionPreview)) {
+            return false;
+        }
+        const uint16_t universe = be16(header + 113);
+        if (universe < m_config.universe) {
+            return false;
+        }
+        const uint16_t slots = be16(header + 123);
+        out.header_len = kE131HeaderLen;
+        out.offset = static_cast<size_t>(universe - m_config.universe) * m_universe_bytes;
+        out.length = slots > 0 ? std::min<size_t>(slots - 1, m_universe_bytes) : 0;
+        out.frame_end = out.offset + m_universe_bytes >= m_framebuffer_size;
+
+        // sACN sequences are per universe; the first one stands for the stream.
+        if (universe == m_config.universe) {
+            const uint8_t sequence = header[111];
+            out.sequence_gap = m_has_sequence && sequence != static_cast<uint8_t>(m_sequence + 1);
+            m_sequence = sequence;
+            m_has_sequence = true;
+        }
+    }
+
+    if (out.offset >= m_framebuffer_size) {
+        return false;
+    }
+    out.length = std::min(out.length, m_framebuffer_size - out.offset);
+    return true;
+}
+
+void PixelStream::drop_datagram()
+{
+    uint8_t scratch;
+    recv(m_socket, &scratch, sizeof(scratch), MSG_DONTWAIT);
+}
+
+void PixelStream::show_frame(uint64_t now_us)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // The receive buffer keeps its pixels, so DDP senders that only update
+    // part of the strip still build on the previous frame.
+    std::memcpy(m_framebuffer.get(), m_receive.get(), m_framebuffer_size);
+    m_output.show(m_framebuffer.get(), frame_brightness());
+    const uint64_t shown_us = m_config.now_us();
+
+    const uint64_t latency_us = m_frame_first_us ? shown_us - m_frame_first_us : 0;
+    ++m_stats.frames;
+    m_latency_total_us += latency_us;
+    m_stats.latency_avg_us = static_cast<uint32_t>(m_latency_total_us / m_stats.frames);
+    if (latency_us > m_stats.latency_max_us) {
+        m_stats.latency_max_us = static_cast<uint32_t>(latency_us);
+    }
+
+    ++m_fps_window_frames;
+    if (m_fps_window_us == 0) {
+        m_fps_window_us = now_us;
+    } else if (now_us - m_fps_window_us >= kFpsWindowUs) {
+        m_stats.fps_x10 = static_cast<uint32_t>(m_fps_window_frames * 10'000'000ULL / (now_us - m_fps_window_us));
+        m_fps_window_us = now_us;
+        m_fps_window_frames = 0;
+    }
+
+    m_frame_pending = false;
+    m_frame_first_us = 0;
+    m_last_show_us = now_us;
+}
+
+void PixelStream::show_solid_locked()
+{
+    if (!m_framebuffer) {
+        return;
+    }
+    const uint8_t bytes_per_pixel = m_output.bytes_per_pixel();
+    for (size_t idx = 0; idx + bytes_per_pixel <= m_framebuffer_size; idx += bytes_per_pixel) {
+        std::memcpy(m_framebuffer.get() + idx, m_solid, sizeof(m_solid));
+        if (bytes_per_pixel > sizeof(m_solid)) {
+            std::memset(m_framebuffer.get() + idx + sizeof(m_solid), 0, bytes_per_pixel - sizeof(m_solid));
+        }
+    }
+    m_output.show(m_framebuffer.get(), frame_brightness());
+}
+
+uint8_t PixelStream::brightness() const
+{
+    if (!m_on.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    const uint32_t level = m_level.load(std::memory_order_relaxed);
+    return static_cast<uint8_t>((level * 255 + 127) / 254);
+}
+
+// Brightness the current framebuffer is latched with, within the power budget.
+uint8_t PixelStream::frame_brightness()
+{
+    const uint8_t requested = brightness();
+    if (!m_limiter || !m_limiter->enabled()) {
+        return requested;
+    }
+    return m_limiter->limit(sum_channels(m_framebuffer.get(), m_framebuffer_size), requested);
+}
+
+void PixelStream::set_matter_state(bool on, uint8_t level, uint8_t r, uint8_t g, uint8_t b)
+{
+    m_on.store(on, std::memory_order_relaxed);
+    m_level.store(level > 254 ? 254 : level, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_solid[0] = r;
+    m_solid[1] = g;
+    m_solid[2] = b;
+    if (!m_framebuffer) {
+        return;
+    }
+    if (streaming()) {
+        // Re-latch the current frame so the switch does not wait for the sender.
+        m_output.show(m_framebuffer.get(), frame_brightness());
+    } else {
+        show_solid_locked();
+    }
+}
+
+bool PixelStream::streaming() const
+{
+    const uint64_t last = m_last_packet_us.load(std::memory_order_relaxed);
+    return last != 0 && m_config.now_us && m_config.now_us() - last < static_cast<uint64_t>(m_config.timeout_ms) * 1000;
+}
+
+PixelStream::Stats PixelStream::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+PowerLimiter::Stats PixelStream::power_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_limiter ? m_limiter->stats() : PowerLimiter::Stats{};
+}
+
+void PixelStream::reset_stats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_limiter) {
+        m_limiter->reset_stats();
+    }
+    m_stats = {};
+    m_latency_total_us = 0;
+    m_fps_window_us = 0;
+    m_fps_window_frames = 0;
+}
+
+} // namespace device_modules::light
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "power_limit.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace device_modules::light {
+
+enum class StreamProtocol : uint8_t { Ddp, E131 };
+
+/**
+ * @brief Where decoded frames go: the RMT strip on the device, a simulated
+ * strip on a host.
+ *
+ * `show()` gets the framebuffer in wire order (RGB or RGBW per pixel) and the
+ * master brightness to scale it by; it returns once the frame is latched.
+ */
+class PixelOutput {
+public:
+    virtual ~PixelOutput() = default;
+    virtual size_t pixel_count() const = 0;
+    virtual uint8_t bytes_per_pixel() const = 0;
+    virtual bool show(const uint8_t *framebuffer, uint8_t brightness) = 0;
+};
+
+/**
+ * @brief UDP receiver for DDP and E1.31 (sACN) pixel data.
+ *
+ * Each datagram is peeked for its header and then received with a scatter
+ * read into a receive buffer at the pixel offset it carries, so pixel data
+ * is not staged in a packet buffer. A DDP packet with PUSH set, or the E1.31
+ * universe holding the last pixel, completes a frame, which is copied to the
+ * framebuffer under the lock and shown at most `max_fps` times per second.
+ * Only the receiver touches the receive buffer, so set_matter_state() never
+ * sees a half-written frame.
+ *
+ * Matter keeps control through set_matter_state(): OnOff/Level are the
+ * master switch and brightness of streamed frames, and the colour is what
+ * the strip shows when no stream arrived for `timeout_ms`.
+ *
+ * Only POSIX sockets are used, so the same code runs against lwIP on the
+ * device and on a Linux host with SimulatedPixelOutput.
+ */
+class PixelStream {
+public:
+    struct Config {
+        StreamProtocol protocol;
+        uint16_t port;
+        uint16_t universe;   // first E1.31 universe
+        uint16_t max_fps;
+        uint32_t timeout_ms; // falls back to the solid colour after this much silence
+        uint64_t (*now_us)();
+    };
+
+    struct Stats {
+        uint32_t packets;
+        uint32_t frames;          // frames shown
+        uint32_t coalesced;       // frames replaced before they were shown (max_fps)
+        uint32_t dropped;         // malformed, foreign or out-of-range packets
+        uint32_t sequence_gaps;
+        uint32_t fps_x10;         // over the last second
+        uint32_t latency_avg_us;  // first packet of a frame to show() returning
+        uint32_t latency_max_us;
+    };
+
+    explicit PixelStream(PixelOutput &output);
+    ~PixelStream();
+    PixelStream(const PixelStream &) = delete;
+    PixelStream &operator=(const PixelStream &) = delete;
+
+    /** Allocates the framebuffer and binds the UDP port. */
+    bool open(const Config &config);
+    void close();
+
+    /**
+     * @brief Waits up to @p timeout_ms for packets and shows completed frames.
+     *
+     * Called in a loop by the receiver task (or a host harness); returns
+     * false once the socket is closed.
+     */
+    bool poll(uint32_t timeout_ms);
+
+    /** Safe from any task; the strip is updated at once with a single show(). */
+    void set_matter_state(bool on, uint8_t level, uint8_t r, uint8_t g, uint8_t b);
+
+    /** Caps every show() to the budget of @p limiter; set before open(). */
+    void set_power_limiter(PowerLimiter *limiter) { m_limiter = limiter; }
+
+    bool streaming() const;
+    Stats stats() const;
+    PowerLimiter::Stats power_stats() const;
+    void reset_stats();
+
+private:
+    struct Placement {
+        size_t header_len;
+        size_t offset;
+        size_t length;
+        bool frame_end;
+        bool sequence_gap;
+    };
+
+    bool locate(const uint8_t *header, size_t len, Placement &out);
+    void drop_datagram();
+    void show_frame(uint64_t now_us);
+    void show_solid_locked();
+    uint8_t brightness() const;
+    uint8_t frame_brightness();
+
+    PixelOutput &m_output;
+    PowerLimiter *m_limiter = nullptr;
+    Config m_config{};
+    int m_socket = -1;
+    std::unique_ptr<uint8_t[]> m_receive;     // receiver task only
+    std::unique_ptr<uint8_t[]> m_framebuffer; // guarded by m_mutex
+    size_t m_framebuffer_size = 0;
+    size_t m_universe_bytes = 0;
+
+    // Serialises show() between the receiver task and Matter updates, and
+    // guards the framebuffer and the statistics.
+    mutable std::mutex m_mutex;
+    std::atomic<bool> m_on{true};
+    std::atomic<uint8_t> m_level{254};
+    uint8_t m_solid[3] = {255, 255, 255};
+
+    uint8_t m_sequence = 0;
+    bool m_has_sequence = false;
+    bool m_frame_pending = false;
+    uint64_t m_frame_first_us = 0;
+    uint64_t m_last_show_us = 0;
+    std::atomic<uint64_t> m_last_packet_us{0};
+    bool m_was_streaming = false;
+
+    Stats m_stats{};
+    uint64_t m_latency_total_us = 0;
+    uint64_t m_fps_window_us = 0;
+    uint32_t m_fps_window_frames = 0;
+};
+
+} // namespace device_modules::light
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "pixel_stream.h"
+
+#include <chrono>
+#include <vector>
+
+namespace device_modules::light {
+
+/**
+ * @brief Host-side stand-in for the RMT strip.
+ *
+ * Keeps the last frame as it would be latched (brightness applied) and
+ * counts show() calls, so test/host/pixel_stream_test.cpp can run
+ * PixelStream over loopback and compare what a sender pushed with what
+ * reached the strip.
+ */
+class SimulatedPixelOutput : public PixelOutput {
+public:
+    SimulatedPixelOutput(size_t pixel_count, uint8_t bytes_per_pixel)
+        : m_pixel_count(pixel_count), m_bytes_per_pixel(bytes_per_pixel), m_latched(pixel_count * bytes_per_pixel)
+    {
+    }
+
+    size_t pixel_count() const override { return m_pixel_count; }
+    uint8_t bytes_per_pixel() const override { return m_bytes_per_pixel; }
+
+    bool show(const uint8_t *framebuffer, uint8_t brightness) override
+    {
+        for (size_t idx = 0; idx < m_latched.size(); ++idx) {
+            m_latched[idx] = static_cast<uint8_t>((framebuffer[idx] * (brightness + 1)) >> 8);
+        }
+        ++m_shows;
+        return true;
+    }
+
+    const std::vector<uint8_t> &latched() const { return m_latched; }
+    uint32_t shows() const { return m_shows; }
+
+    static uint64_t steady_now_us()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+private:
+    size_t m_pixel_count;
+    uint8_t m_bytes_per_pixel;
+    std::vector<uint8_t> m_latched;
+    uint32_t m_shows = 0;
+};
+
+} // namespace device_modules::light
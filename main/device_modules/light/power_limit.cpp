@@ -0,0 +1,88 @@
+#include "power_limit.h"
+
+#include <cstring>
+
+namespace device_modules::light {
+
+namespace {
+
+constexpr uint32_t kEvenBytes = 0x00FF00FFu;
+// Each 16-bit lane gains at most 255 per word; 257 words fill it exactly.
+constexpr size_t kWordsPerFlush = 256;
+// Strips latch (byte * (brightness + 1)) >> 8, which never exceeds
+// byte * (brightness + 1) / 256; estimating with that keeps the budget safe.
+constexpr uint64_t kFullScale = 255u * 256u;
+
+uint64_t brightness_scale(uint8_t brightness)
+{
+    return brightness ? brightness + 1u : 0u;
+}
+
+uint32_t fold(uint32_t lanes)
+{
+    return (lanes & 0xFFFFu) + (lanes >> 16);
+}
+
+} // namespace
+
+uint32_t sum_channels(const uint8_t *data, size_t len)
+{
+    uint32_t total = 0;
+    size_t idx = 0;
+    while (len - idx >= sizeof(uint32_t)) {
+        uint32_t even = 0;
+        uint32_t odd = 0;
+        const size_t words = (len - idx) / sizeof(uint32_t);
+        const size_t batch = words < kWordsPerFlush ? words : kWordsPerFlush;
+        for (size_t word_idx = 0; word_idx < batch; ++word_idx, idx += sizeof(uint32_t)) {
+            uint32_t word;
+            std::memcpy(&word, data + idx, sizeof(word));
+            even += word & kEvenBytes;
+            odd += (word >> 8) & kEvenBytes;
+        }
+        total += fold(even) + fold(odd);
+    }
+    for (; idx < len; ++idx) {
+        total += data[idx];
+    }
+    return total;
+}
+
+uint64_t PowerLimiter::idle_ua() const
+{
+    return static_cast<uint64_t>(m_config.pixel_count) * m_config.idle_ua;
+}
+
+uint32_t PowerLimiter::estimate_ma(uint32_t channel_sum, uint8_t brightness) const
+{
+    const uint64_t active_ua =
+        static_cast<uint64_t>(channel_sum) * brightness_scale(brightness) * m_config.channel_ma * 1000u / kFullScale;
+    return static_cast<uint32_t>((idle_ua() + active_ua + 500) / 1000);
+}
+
+uint8_t PowerLimiter::limit(uint32_t channel_sum, uint8_t brightness)
+{
+    const uint32_t requested_ma = estimate_ma(channel_sum, brightness);
+    uint8_t shown = brightness;
+    if (enabled() && requested_ma > m_config.budget_ma) {
+        const uint64_t budget_ua = static_cast<uint64_t>(m_config.budget_ma) * 1000u;
+        const uint64_t available_ua = budget_ua > idle_ua() ? budget_ua - idle_ua() : 0;
+        const uint64_t full_ua = static_cast<uint64_t>(channel_sum) * m_config.channel_ma * 1000u;
+        const uint64_t scale = full_ua ? available_ua * kFullScale / full_ua : brightness_scale(brightness);
+        const uint64_t allowed = scale > 0 ? scale - 1 : 0;
+        shown = static_cast<uint8_t>(allowed < brightness ? allowed : brightness);
+        ++m_stats.limited;
+    }
+
+    ++m_stats.frames;
+    m_stats.last_ma = shown == brightness ? requested_ma : estimate_ma(channel_sum, shown);
+    if (m_stats.last_ma > m_stats.peak_ma) {
+        m_stats.peak_ma = m_stats.last_ma;
+    }
+    if (requested_ma > m_stats.requested_peak_ma) {
+        m_stats.requested_peak_ma = requested_ma;
+    }
+    return shown;
+}
+
+} // namespace device_modules::light
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace device_modules::light {
+
+/**
+ * @brief Sum of every byte in @p data, i.e. the total duty of a framebuffer.
+ *
+ * Bytes are added four at a time as two 16-bit lanes per 32-bit word, so a
+ * frame of a few hundred pixels costs about one add per pixel.
+ */
+uint32_t sum_channels(const uint8_t *data, size_t len);
+
+/**
+ * @brief Estimates strip current and caps brightness to a milliamp budget.
+ *
+ * The model is linear: every channel draws `channel_ma` at full duty and
+ * every pixel `idle_ua` when black, which is how WS2812/SK6812 behave to
+ * within a few percent. Not thread-safe; the caller serialises frames and
+ * stats reads. No ESP-IDF dependency.
+ */
+class PowerLimiter {
+public:
+    struct Config {
+        uint32_t budget_ma;
+        uint16_t channel_ma; // one channel at full duty
+        uint16_t idle_ua;    // one pixel showing black
+        size_t pixel_count;
+    };
+
+    struct Stats {
+        uint32_t frames;
+        uint32_t limited;           // frames shown dimmer than requested
+        uint32_t last_ma;           // last frame as shown
+        uint32_t peak_ma;           // highest frame as shown
+        uint32_t requested_peak_ma; // highest frame as requested
+    };
+
+    void configure(const Config &config) { m_config = config; }
+    bool enabled() const { return m_config.budget_ma > 0; }
+    uint32_t budget_ma() const { return m_config.budget_ma; }
+
+    /** Current of a frame whose bytes add up to @p channel_sum, latched at @p brightness (0..255). */
+    uint32_t estimate_ma(uint32_t channel_sum, uint8_t brightness) const;
+
+    /**
+     * @brief Brightness to latch the frame with: @p brightness, or less when
+     * that would exceed the budget. Updates the stats.
+     */
+    uint8_t limit(uint32_t channel_sum, uint8_t brightness);
+
+    Stats stats() const { return m_stats; }
+    void reset_stats() { m_stats = {}; }
+
+private:
+    uint64_t idle_ua() const;
+
+    Config m_config{};
+    Stats m_stats{};
+};
+
+} // namespace device_modules::light
@@ -0,0 +1,112 @@
+#include "pwm_output.h"
+
+#include <driver/ledc.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <soc/soc_caps.h>
+
+namespace device_modules::light {
+
+namespace {
+
+constexpr const char *TAG = "pwm_output";
+constexpr ledc_mode_t kSpeedMode = LEDC_LOW_SPEED_MODE;
+constexpr ledc_timer_t kTimer = LEDC_TIMER_0;
+
+ledc_channel_t channel_id(size_t idx)
+{
+    return static_cast<ledc_channel_t>(LEDC_CHANNEL_0 + idx);
+}
+
+} // namespace
+
+esp_err_t PwmOutput::init(const Channel *channels, size_t count, uint32_t frequency_hz, uint8_t resolution_bits)
+{
+    if (count == 0 || count > kMaxChannels || count > SOC_LEDC_CHANNEL_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ledc_timer_config_t timer_config = {};
+    timer_config.speed_mode = kSpeedMode;
+    timer_config.duty_resolution = static_cast<ledc_timer_bit_t>(resolution_bits);
+    timer_config.timer_num = kTimer;
+    timer_config.freq_hz = frequency_hz;
+    timer_config.clk_cfg = LEDC_AUTO_CLK;
+    esp_err_t err = ledc_timer_config(&timer_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "%" PRIu32 " Hz at %u bits is not reachable: %s", frequency_hz,
+                 static_cast<unsigned>(resolution_bits), esp_err_to_name(err));
+        return err;
+    }
+    m_max_duty = 1u << resolution_bits;
+
+    for (size_t idx = 0; idx < count; ++idx) {
+        ledc_channel_config_t channel_config = {};
+        channel_config.gpio_num = channels[idx].gpio;
+        channel_config.speed_mode = kSpeedMode;
+        channel_config.channel = channel_id(idx);
+        channel_config.intr_type = LEDC_INTR_DISABLE;
+        channel_config.timer_sel = kTimer;
+        channel_config.duty = 0;
+        channel_config.hpoint = 0;
+        err = ledc_channel_config(&channel_config);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure LEDC channel on GPIO %d: %s", channels[idx].gpio, esp_err_to_name(err));
+            return err;
+        }
+        m_channels[idx] = channels[idx];
+        m_duty[idx] = 0;
+    }
+    m_count = count;
+
+    err = ledc_fade_func_install(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install the LEDC fade service: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "%u PWM channels at %" PRIu32 " Hz, %u-bit duty.", static_cast<unsigned>(count), frequency_hz,
+             static_cast<unsigned>(resolution_bits));
+    return ESP_OK;
+}
+
+esp_err_t PwmOutput::apply(const PwmLevels &levels, uint32_t fade_ms)
+{
+    esp_err_t result = ESP_OK;
+    for (size_t idx = 0; idx < m_count; ++idx) {
+        const uint32_t duty = duty_for(levels.duty[static_cast<size_t>(m_channels[idx].role)]);
+        if (duty == m_duty[idx]) {
+            continue;
+        }
+#if SOC_LEDC_SUPPORT_FADE_STOP
+        // A fade still running would block the next one until it ends.
+        ledc_fade_stop(kSpeedMode, channel_id(idx));
+#else
+        fade_ms = 0;
+#endif
+        esp_err_t err;
+        if (fade_ms == 0) {
+            err = ledc_set_duty_and_update(kSpeedMode, channel_id(idx), duty, 0);
+        } else {
+            err = ledc_set_fade_time_and_start(kSpeedMode, channel_id(idx), duty, fade_ms, LEDC_FADE_NO_WAIT);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set duty on GPIO %d: %s", m_channels[idx].gpio, esp_err_to_name(err));
+            result = err;
+            continue;
+        }
+        m_duty[idx] = duty;
+    }
+    return result;
+}
+
+uint32_t PwmOutput::duty_for(uint16_t level) const
+{
+    if (level == 0) {
+        return 0;
+    }
+    const uint32_t duty = static_cast<uint32_t>((static_cast<uint64_t>(level) * m_max_duty + 32767) / 65535);
+    // The lowest level still lights the fixture.
+    return duty == 0 ? 1 : duty;
+}
+
+} // namespace device_modules::light
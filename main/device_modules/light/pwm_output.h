@@ -0,0 +1,46 @@
+#pragma once
+
+#include "light_state.h"
+
+#include <esp_err.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace device_modules::light {
+
+/**
+ * @brief LEDC backend for analog CW/WW and RGB(W) fixtures.
+ *
+ * All channels share one low-speed timer. Level changes are handed to the
+ * LEDC hardware fade, so a transition needs no CPU between two attribute
+ * steps; a new target stops the running fade where it is and continues
+ * from there.
+ */
+class PwmOutput {
+public:
+    struct Channel {
+        PwmChannel role;
+        int gpio;
+    };
+
+    /** Configures the timer, one LEDC channel per entry and the fade service. */
+    esp_err_t init(const Channel *channels, size_t count, uint32_t frequency_hz, uint8_t resolution_bits);
+
+    /** Fades every channel to @p levels over @p fade_ms; 0 switches at once. */
+    esp_err_t apply(const PwmLevels &levels, uint32_t fade_ms);
+
+    uint32_t max_duty() const { return m_max_duty; }
+
+private:
+    static constexpr size_t kMaxChannels = kPwmChannelCount;
+
+    uint32_t duty_for(uint16_t level) const;
+
+    Channel m_channels[kMaxChannels] = {};
+    uint32_t m_duty[kMaxChannels] = {};
+    size_t m_count = 0;
+    uint32_t m_max_duty = 0;
+};
+
+} // namespace device_modules::light
@@ -0,0 +1,545 @@
+#include "sensor_module.h"
+#include "sensor_pipeline.h"
+
+#include "generated_config.h"
+#include "report_throttle.h"
+#if APP_SENSOR_SIM
+#include "sensor_sim.h"
+#endif
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <driver/gpio.h>
+#include <driver/temperature_sensor.h>
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_adc/adc_oneshot.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_matter_attribute_utils.h>
+#include <esp_matter_cluster.h>
+#include <esp_matter_endpoint.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <app-common/zap-generated/cluster-objects.h>
+
+namespace device_modules::sensor {
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+namespace {
+
+constexpr const char *TAG = "sensor_module";
+
+constexpr uint32_t kTaskStackSize = 3072;
+constexpr UBaseType_t kTaskPriority = 4;
+
+using SensorConfig = generated_config::sensor::sensor_t;
+constexpr size_t kSensorCount = generated_config::sensor::count;
+
+struct KindInfo {
+    const char *device_type;
+    Kind kind;
+    const char *name;
+};
+
+constexpr KindInfo kKinds[] = {
+    {"temperature_sensor", Kind::Temperature, "temperature"},
+    {"humidity_sensor", Kind::Humidity, "humidity"},
+    {"light_sensor", Kind::Illuminance, "illuminance"},
+    {"occupancy_sensor", Kind::Occupancy, "occupancy"},
+};
+
+constexpr const char *kSourceNames[] = {"internal", "adc", "gpio", "sim"};
+
+struct SensorState {
+    const SensorConfig *config;
+    bool ready;
+    SensorPipeline pipeline;
+#if APP_SENSOR_SIM
+    SimulatedSensor simulated{{0, 0, 0, 0, 0, 0}};
+    SimulatedPresence presence{{0, 0, 0}};
+#endif
+    adc_channel_t adc_channel;
+    adc_cali_handle_t adc_cali;
+    uint64_t next_sample_ms;
+    std::atomic<bool> edge{false}; // set by the GPIO interrupt
+    uint32_t read_errors;
+};
+
+std::array<SensorState, kSensorCount> s_sensors;
+TaskHandle_t s_task = nullptr;
+temperature_sensor_handle_t s_tsens = nullptr;
+adc_oneshot_unit_handle_t s_adc = nullptr;
+
+uint64_t now_ms()
+{
+    return static_cast<uint64_t>(esp_timer_get_time()) / 1000;
+}
+
+Kind kind_of(const SensorConfig &config)
+{
+    return static_cast<Kind>(config.kind);
+}
+
+const char *kind_name(Kind kind)
+{
+    for (const KindInfo &info : kKinds) {
+        if (info.kind == kind) {
+            return info.name;
+        }
+    }
+    return "?";
+}
+
+const KindInfo *find_kind(const char *device_type)
+{
+    for (const KindInfo &info : kKinds) {
+        if (device_type && std::strcmp(device_type, info.device_type) == 0) {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+// MeasuredValue of IlluminanceMeasurement: 10000 * log10(lux) + 1, 0 when too dark.
+int32_t illuminance_value(int32_t lux)
+{
+    if (lux <= 0) {
+        return 0;
+    }
+    const long value = std::lround(10000.0 * std::log10(static_cast<double>(lux))) + 1;
+    return static_cast<int32_t>(value < 0xFFFE ? value : 0xFFFE);
+}
+
+#if APP_SENSOR_SIM
+// `source: sim` readings, in attribute units, so the pipeline has noise and spikes to work on.
+SimulatedSensor::Profile simulated_profile(Kind kind)
+{
+    constexpr uint32_t kDayMs = 24 * 3600 * 1000;
+    switch (kind) {
+    case Kind::Humidity:
+        return {4500, 1000, kDayMs, 60, 5, 800};
+    case Kind::Illuminance:
+        return {24772, 3000, kDayMs, 200, 5, 2000}; // around 300 lx
+    default:
+        return {2150, 150, kDayMs, 15, 5, 300};
+    }
+}
+#endif
+
+void IRAM_ATTR gpio_edge_isr(void *arg)
+{
+    static_cast<SensorState *>(arg)->edge.store(true);
+    BaseType_t woken = pdFALSE;
+    if (s_task) {
+        vTaskNotifyGiveFromISR(s_task, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+esp_err_t setup_adc(SensorState &state)
+{
+    const SensorConfig &cfg = *state.config;
+    esp_err_t err = ESP_OK;
+    if (!s_adc) {
+        adc_oneshot_unit_init_cfg_t unit_cfg = {};
+        unit_cfg.unit_id = ADC_UNIT_1;
+        err = adc_oneshot_new_unit(&unit_cfg, &s_adc);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    adc_unit_t unit;
+    err = adc_oneshot_io_to_channel(cfg.gpio, &unit, &state.adc_channel);
+    if (err != ESP_OK || unit != ADC_UNIT_1) {
+        return err != ESP_OK ? err : ESP_ERR_NOT_SUPPORTED;
+    }
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    err = adc_oneshot_config_channel(s_adc, state.adc_channel, &chan_cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_cfg = {
+        .unit_id = ADC_UNIT_1,
+        .chan = state.adc_channel,
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    if (adc_cali_create_scheme_curve_fitting(&cali_cfg, &state.adc_cali) != ESP_OK) {
+        state.adc_cali = nullptr;
+    }
+#endif
+    if (!state.adc_cali) {
+        ESP_LOGW(TAG, "Endpoint %u: no ADC calibration, millivolts are approximate.", cfg.endpoint);
+    }
+    return ESP_OK;
+}
+
+esp_err_t setup_source(SensorState &state)
+{
+    const SensorConfig &cfg = *state.config;
+    switch (static_cast<Source>(cfg.source)) {
+    case Source::Internal: {
+        if (s_tsens) {
+            return ESP_OK;
+        }
+        // Die temperature: runs a few degrees above the air around the chip.
+        temperature_sensor_config_t tsens_cfg = TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
+        esp_err_t err = temperature_sensor_install(&tsens_cfg, &s_tsens);
+        return err == ESP_OK ? temperature_sensor_enable(s_tsens) : err;
+    }
+    case Source::Adc:
+        return setup_adc(state);
+    case Source::Gpio: {
+        gpio_config_t io_cfg = {
+            .pin_bit_mask = 1ULL << cfg.gpio,
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = cfg.active_low ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+            .pull_down_en = cfg.active_low ? GPIO_PULLDOWN_DISABLE : GPIO_PULLDOWN_ENABLE,
+            .intr_type = GPIO_INTR_ANYEDGE,
+        };
+        esp_err_t err = gpio_config(&io_cfg);
+        if (err != ESP_OK) {
+            return err;
+        }
+        // Already installed when another driver uses GPIO interrupts.
+        err = gpio_install_isr_service(0);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            return err;
+        }
+        // The first pass of the task reads the level the pin starts at.
+        state.edge.store(true);
+        return gpio_isr_handler_add(static_cast<gpio_num_t>(cfg.gpio), gpio_edge_isr, &state);
+    }
+    case Source::Sim:
+#if APP_SENSOR_SIM
+        if (kind_of(cfg) == Kind::Occupancy) {
+            state.presence = SimulatedPresence({10 * 60 * 1000, 3 * 60 * 1000, 300}, cfg.endpoint);
+        } else {
+            state.simulated = SimulatedSensor(simulated_profile(kind_of(cfg)), cfg.endpoint);
+        }
+        return ESP_OK;
+#else
+        break;
+#endif
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t read_adc(SensorState &state, int32_t &out)
+{
+    const SensorConfig &cfg = *state.config;
+    int raw = 0;
+    esp_err_t err = adc_oneshot_read(s_adc, state.adc_channel, &raw);
+    if (err != ESP_OK) {
+        return err;
+    }
+    int mv = raw * 3300 / 4095;
+    if (state.adc_cali) {
+        err = adc_cali_raw_to_voltage(state.adc_cali, raw, &mv);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    const int32_t clamped = mv < cfg.adc_mv_min ? cfg.adc_mv_min : (mv > cfg.adc_mv_max ? cfg.adc_mv_max : mv);
+    const int32_t value = cfg.adc_min + static_cast<int32_t>(static_cast<int64_t>(clamped - cfg.adc_mv_min) *
+                                                             (cfg.adc_max - cfg.adc_min) /
+                                                             (cfg.adc_mv_max - cfg.adc_mv_min));
+    out = kind_of(cfg) == Kind::Illuminance ? illuminance_value(value) : value;
+    return ESP_OK;
+}
+
+esp_err_t read_sample(SensorState &state, uint64_t now, int32_t &out)
+{
+    const SensorConfig &cfg = *state.config;
+    switch (static_cast<Source>(cfg.source)) {
+    case Source::Internal: {
+        float celsius = 0;
+        esp_err_t err = temperature_sensor_get_celsius(s_tsens, &celsius);
+        out = static_cast<int32_t>(std::lround(celsius * 100));
+        return err;
+    }
+    case Source::Adc:
+        return read_adc(state, out);
+    case Source::Gpio:
+        out = (gpio_get_level(static_cast<gpio_num_t>(cfg.gpio)) != 0) != cfg.active_low ? 1 : 0;
+        return ESP_OK;
+    case Source::Sim:
+#if APP_SENSOR_SIM
+        out = kind_of(cfg) == Kind::Occupancy ? state.presence.read(now) : state.simulated.read(now);
+        return ESP_OK;
+#else
+        (void)now;
+        break;
+#endif
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+int32_t clamp(int32_t value, int32_t low, int32_t high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+void write_value(const SensorState &state, int32_t value)
+{
+    const SensorConfig &cfg = *state.config;
+    uint32_t cluster_id = 0;
+    uint32_t attribute_id = 0;
+    esp_matter_attr_val_t val = esp_matter_invalid(nullptr);
+    switch (kind_of(cfg)) {
+    case Kind::Temperature:
+        cluster_id = TemperatureMeasurement::Id;
+        attribute_id = TemperatureMeasurement::Attributes::MeasuredValue::Id;
+        val = esp_matter_nullable_int16(nullable<int16_t>(static_cast<int16_t>(clamp(value, -27315, 32767))));
+        break;
+    case Kind::Humidity:
+        cluster_id = RelativeHumidityMeasurement::Id;
+        attribute_id = RelativeHumidityMeasurement::Attributes::MeasuredValue::Id;
+        val = esp_matter_nullable_uint16(nullable<uint16_t>(static_cast<uint16_t>(clamp(value, 0, 10000))));
+        break;
+    case Kind::Illuminance:
+        cluster_id = IlluminanceMeasurement::Id;
+        attribute_id = IlluminanceMeasurement::Attributes::MeasuredValue::Id;
+        val = esp_matter_nullable_uint16(nullable<uint16_t>(static_cast<uint16_t>(clamp(value, 0, 0xFFFE))));
+        break;
+    case Kind::Occupancy:
+        cluster_id = OccupancySensing::Id;
+        attribute_id = OccupancySensing::Attributes::Occupancy::Id;
+        val = esp_matter_bitmap8(value ? 1 : 0);
+        break;
+    }
+    esp_err_t err = attribute::update(cfg.endpoint, cluster_id, attribute_id, &val);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Endpoint %u: failed to write %s: %s", cfg.endpoint, kind_name(kind_of(cfg)), esp_err_to_name(err));
+    }
+}
+
+void sample(SensorState &state, uint64_t now)
+{
+    int32_t raw = 0;
+    if (read_sample(state, now, raw) != ESP_OK) {
+        ++state.read_errors;
+        return;
+    }
+    int32_t value = 0;
+    if (state.pipeline.on_sample(raw, now, value)) {
+        write_value(state, value);
+    }
+}
+
+// Sleeps until the next sample or pipeline deadline, or until a GPIO edge.
+void sensor_task(void *)
+{
+    for (;;) {
+        const uint64_t now = now_ms();
+        uint64_t wake_ms = SensorPipeline::kNever;
+        for (SensorState &state : s_sensors) {
+            if (!state.ready) {
+                continue;
+            }
+            const uint32_t period_ms = state.config->period_ms;
+            const bool due = period_ms != 0 && now >= state.next_sample_ms;
+            if (state.edge.exchange(false) || due) {
+                sample(state, now);
+            }
+            if (due) {
+                state.next_sample_ms += period_ms;
+                if (state.next_sample_ms <= now) {
+                    state.next_sample_ms = now + period_ms;
+                }
+            }
+            int32_t value = 0;
+            if (state.pipeline.poll(now, value)) {
+                write_value(state, value);
+            }
+            const uint64_t pipeline_ms = state.pipeline.next_due_ms();
+            wake_ms = pipeline_ms < wake_ms ? pipeline_ms : wake_ms;
+            if (period_ms != 0 && state.next_sample_ms < wake_ms) {
+                wake_ms = state.next_sample_ms;
+            }
+        }
+        TickType_t ticks = portMAX_DELAY;
+        if (wake_ms != SensorPipeline::kNever) {
+            ticks = wake_ms > now ? static_cast<TickType_t>((wake_ms - now + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS)
+                                  : 0;
+        }
+        if (ticks > 0) {
+            ulTaskNotifyTake(pdTRUE, ticks);
+        }
+    }
+}
+
+bool supports_endpoint(const generated_config::endpoint_raw &config)
+{
+    return find_kind(config.device_type) != nullptr;
+}
+
+app_driver_handle_t init_drivers()
+{
+    for (size_t idx = 0; idx < kSensorCount; ++idx) {
+        SensorState &state = s_sensors[idx];
+        const SensorConfig &cfg = generated_config::sensor::sensors[idx];
+        state.config = &cfg;
+        state.pipeline.configure({
+            .binary = kind_of(cfg) == Kind::Occupancy,
+            .median = cfg.median,
+            .smoothing = cfg.smoothing,
+            .threshold = cfg.threshold,
+            .hysteresis = cfg.hysteresis,
+            .min_interval_ms = cfg.min_interval_ms,
+            .max_interval_ms = cfg.max_interval_ms,
+            .hold_ms = cfg.hold_ms,
+        });
+        esp_err_t err = setup_source(state);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Endpoint %u: failed to set up the %s source: %s", cfg.endpoint, kSourceNames[cfg.source],
+                     esp_err_to_name(err));
+            continue;
+        }
+        state.ready = true;
+        ESP_LOGI(TAG, "Endpoint %u: %s from %s.", cfg.endpoint, kind_name(kind_of(cfg)), kSourceNames[cfg.source]);
+    }
+    // Sensors have no driver handle for identify or attribute writes.
+    return nullptr;
+}
+
+template <typename Config>
+void apply_identify(Config &cfg, const generated_config::endpoint_raw &config)
+{
+    if (config.identify.identify_time.has_value) {
+        cfg.identify.identify_time = static_cast<uint16_t>(config.identify.identify_time.value);
+    }
+    if (config.identify.identify_type.has_value) {
+        cfg.identify.identify_type = static_cast<uint8_t>(config.identify.identify_type.value);
+    }
+}
+
+endpoint_t *create_endpoint(const generated_config::endpoint_raw &config, node_t *node)
+{
+    const KindInfo *info = find_kind(config.device_type);
+    if (!info) {
+        return nullptr;
+    }
+
+    endpoint_t *endpoint = nullptr;
+    switch (info->kind) {
+    case Kind::Temperature: {
+        endpoint::temperature_sensor::config_t cfg;
+        apply_identify(cfg, config);
+        endpoint = endpoint::temperature_sensor::create(node, &cfg, ENDPOINT_FLAG_NONE, nullptr);
+        break;
+    }
+    case Kind::Humidity: {
+        endpoint::humidity_sensor::config_t cfg;
+        apply_identify(cfg, config);
+        endpoint = endpoint::humidity_sensor::create(node, &cfg, ENDPOINT_FLAG_NONE, nullptr);
+        break;
+    }
+    case Kind::Illuminance: {
+        endpoint::light_sensor::config_t cfg;
+        apply_identify(cfg, config);
+        endpoint = endpoint::light_sensor::create(node, &cfg, ENDPOINT_FLAG_NONE, nullptr);
+        break;
+    }
+    case Kind::Occupancy: {
+        endpoint::occupancy_sensor::config_t cfg;
+        apply_identify(cfg, config);
+        endpoint = endpoint::occupancy_sensor::create(node, &cfg, ENDPOINT_FLAG_NONE, nullptr);
+        break;
+    }
+    }
+    if (!endpoint) {
+        ESP_LOGE(TAG, "Failed to create endpoint for device type %s", config.device_type);
+    }
+    return endpoint;
+}
+
+void after_endpoint_created(const generated_config::endpoint_raw &, endpoint_t *endpoint)
+{
+    if (endpoint) {
+        report_throttle::track_endpoint(endpoint::get_id(endpoint));
+    }
+}
+
+void apply_post_stack_start()
+{
+    if (s_task) {
+        return;
+    }
+    const uint64_t now = now_ms();
+    for (SensorState &state : s_sensors) {
+        state.next_sample_ms = now;
+    }
+    if (xTaskCreate(sensor_task, "sensors", kTaskStackSize, nullptr, kTaskPriority, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the sensor task.");
+    }
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t sensors_command(int, char **)
+{
+    printf("%u sensors\n", static_cast<unsigned int>(kSensorCount));
+    for (const SensorState &state : s_sensors) {
+        const SensorConfig &cfg = *state.config;
+        const SensorPipeline::Stats stats = state.pipeline.stats();
+        const uint32_t saved = stats.raw_changes ? 100 - stats.writes * 100 / stats.raw_changes : 0;
+        printf("  endpoint %u %s from %s%s: value %" PRId32 " (filtered %" PRId32 "), samples %" PRIu32
+               ", raw changes %" PRIu32 ", writes %" PRIu32 " (%" PRIu32 "%% saved), deferred %" PRIu32
+               ", held %" PRIu32 ", read errors %" PRIu32 "\n",
+               cfg.endpoint, kind_name(kind_of(cfg)), kSourceNames[cfg.source], state.ready ? "" : " (failed)",
+               state.pipeline.value(), state.pipeline.filtered(), stats.samples, stats.raw_changes, stats.writes, saved,
+               stats.deferred, stats.held, state.read_errors);
+    }
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+const DeviceModule kModule = {
+    .name = "sensor",
+    .init_drivers = init_drivers,
+    .supports_endpoint = supports_endpoint,
+    .create_endpoint = create_endpoint,
+    .after_endpoint_created = after_endpoint_created,
+    .apply_post_stack_start = apply_post_stack_start,
+    .attribute_update = nullptr,
+    .perform_identification = nullptr,
+};
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "sensors",
+            .description = "Sensor readings and how many writes the filters saved. Usage: matter esp sensors",
+            .handler = sensors_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace device_modules::sensor
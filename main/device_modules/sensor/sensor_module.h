@@ -0,0 +1,26 @@
+#pragma once
+
+#include "device_module.h"
+
+#include <esp_err.h>
+
+#include <cstdint>
+
+namespace device_modules::sensor {
+
+// Values of generated_config::sensor, kept in step with tools/render_config.py.
+enum class Kind : uint8_t { Temperature, Humidity, Illuminance, Occupancy };
+enum class Source : uint8_t { Internal, Adc, Gpio, Sim };
+
+/**
+ * Temperature, humidity, light and occupancy sensor endpoints fed from the
+ * YAML `sensors`. One task samples every sensor on its period, or on GPIO
+ * edges, passes the readings through a SensorPipeline and writes the
+ * attribute only when the pipeline says the change is worth a report.
+ */
+extern const DeviceModule kModule;
+
+/** @brief Registers `matter esp sensors`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace device_modules::sensor
@@ -0,0 +1,164 @@
+#include "sensor_pipeline.h"
+
+namespace device_modules::sensor {
+
+namespace {
+
+int8_t sign(int64_t value)
+{
+    return value > 0 ? 1 : (value < 0 ? -1 : 0);
+}
+
+} // namespace
+
+void SensorPipeline::configure(const Config &config)
+{
+    *this = SensorPipeline{};
+    m_config = config;
+    if (m_config.median < 1 || m_config.median > kMaxMedian) {
+        m_config.median = 1;
+    }
+    if (m_config.smoothing > 6) {
+        m_config.smoothing = 6;
+    }
+}
+
+int32_t SensorPipeline::filter(int32_t raw)
+{
+    m_window[m_window_next] = raw;
+    m_window_next = (m_window_next + 1) % m_config.median;
+    if (m_window_count < m_config.median) {
+        ++m_window_count;
+    }
+    int32_t sorted[kMaxMedian];
+    for (size_t idx = 0; idx < m_window_count; ++idx) {
+        size_t pos = idx;
+        for (; pos > 0 && sorted[pos - 1] > m_window[idx]; --pos) {
+            sorted[pos] = sorted[pos - 1];
+        }
+        sorted[pos] = m_window[idx];
+    }
+    const int32_t median = sorted[m_window_count / 2];
+    if (m_config.smoothing == 0) {
+        return median;
+    }
+
+    const int64_t target = static_cast<int64_t>(median) * 256;
+    m_average = m_has_sample ? m_average + (target - m_average) / (int64_t{1} << m_config.smoothing) : target;
+    return static_cast<int32_t>((m_average + (m_average >= 0 ? 128 : -128)) / 256);
+}
+
+bool SensorPipeline::write(int32_t value, uint64_t now_ms, int32_t &out)
+{
+    if (m_written && value != m_value) {
+        m_direction = sign(static_cast<int64_t>(value) - m_value);
+    }
+    m_value = value;
+    m_written = true;
+    m_written_ms = now_ms;
+    m_deferred = false;
+    ++m_stats.writes;
+    out = value;
+    return true;
+}
+
+bool SensorPipeline::evaluate(uint64_t now_ms, int32_t &out)
+{
+    const int64_t delta = static_cast<int64_t>(m_current) - m_value;
+    const int8_t direction = sign(delta);
+    const int64_t magnitude = delta < 0 ? -delta : delta;
+    const bool reversal = m_direction != 0 && direction == -m_direction;
+    int64_t needed = m_config.threshold + (reversal ? m_config.hysteresis : 0);
+    needed = needed > 0 ? needed : 1;
+
+    const uint64_t since_ms = now_ms - m_written_ms;
+    if (direction != 0 && magnitude >= needed) {
+        if (since_ms >= m_config.min_interval_ms) {
+            return write(m_current, now_ms, out);
+        }
+        if (!m_deferred) {
+            m_deferred = true;
+            ++m_stats.deferred;
+        }
+        return false;
+    }
+    // Back inside the band before the interval ended: nothing to report.
+    m_deferred = false;
+    if (direction != 0 && m_config.max_interval_ms != 0 && since_ms >= m_config.max_interval_ms) {
+        return write(m_current, now_ms, out);
+    }
+    return false;
+}
+
+bool SensorPipeline::on_sample(int32_t raw, uint64_t now_ms, int32_t &out)
+{
+    if (m_config.binary) {
+        raw = raw != 0 ? 1 : 0;
+    }
+    ++m_stats.samples;
+    if (!m_has_sample || raw != m_last_raw) {
+        ++m_stats.raw_changes;
+    }
+    m_last_raw = raw;
+
+    if (m_config.binary) {
+        m_current = raw;
+        m_has_sample = true;
+        if (raw != 0) {
+            m_clearing = false;
+            return m_written && m_value != 0 ? false : write(1, now_ms, out);
+        }
+        if (!m_written) {
+            return write(0, now_ms, out);
+        }
+        if (m_value != 0 && !m_clearing) {
+            m_clearing = true;
+            m_clear_ms = now_ms + m_config.hold_ms;
+        }
+        return poll(now_ms, out);
+    }
+
+    m_current = filter(raw);
+    m_has_sample = true;
+    if (!m_written) {
+        return write(m_current, now_ms, out);
+    }
+    const int64_t delta = static_cast<int64_t>(m_current) - m_value;
+    const int64_t magnitude = delta < 0 ? -delta : delta;
+    if (m_direction != 0 && sign(delta) == -m_direction && magnitude >= m_config.threshold &&
+        magnitude < static_cast<int64_t>(m_config.threshold) + m_config.hysteresis) {
+        ++m_stats.held;
+    }
+    return evaluate(now_ms, out);
+}
+
+bool SensorPipeline::poll(uint64_t now_ms, int32_t &out)
+{
+    if (m_config.binary) {
+        if (!m_clearing || now_ms < m_clear_ms) {
+            return false;
+        }
+        m_clearing = false;
+        return m_value != 0 ? write(0, now_ms, out) : false;
+    }
+    return m_written ? evaluate(now_ms, out) : false;
+}
+
+uint64_t SensorPipeline::next_due_ms() const
+{
+    if (m_config.binary) {
+        return m_clearing ? m_clear_ms : kNever;
+    }
+    if (!m_written) {
+        return kNever;
+    }
+    if (m_deferred) {
+        return m_written_ms + m_config.min_interval_ms;
+    }
+    if (m_config.max_interval_ms != 0 && m_current != m_value) {
+        return m_written_ms + m_config.max_interval_ms;
+    }
+    return kNever;
+}
+
+} // namespace device_modules::sensor
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace device_modules::sensor {
+
+/**
+ * @brief Turns raw samples into the attribute writes worth a report.
+ *
+ * A sample passes a median window, which drops single spikes, and an
+ * exponential moving average that moves 1/2^smoothing of the way per
+ * sample and keeps 8 fraction bits, all in integers. The result is only
+ * written when it has moved `threshold` away from the last written value;
+ * turning back the other way takes `threshold + hysteresis`, so noise
+ * around a level does not make the value bounce. Writes are at least
+ * `min_interval_ms` apart, a change seen earlier going out when the
+ * interval ends, and after `max_interval_ms` any difference is written.
+ *
+ * Binary (occupancy) sensors skip the filters: detection is written at once
+ * and clearing waits until nothing was detected for `hold_ms`.
+ *
+ * Values are in the units of the Matter attribute. Not thread-safe; no
+ * ESP-IDF dependency.
+ */
+class SensorPipeline {
+public:
+    struct Config {
+        bool binary;
+        uint8_t median;    // window of 1 (off), 3 or 5 samples
+        uint8_t smoothing; // 0 (off) to 6
+        int32_t threshold;
+        int32_t hysteresis;
+        uint32_t min_interval_ms;
+        uint32_t max_interval_ms; // 0: small differences are never written
+        uint32_t hold_ms;
+    };
+
+    struct Stats {
+        uint32_t samples;
+        uint32_t raw_changes; // samples unlike the one before: the writes without this pipeline
+        uint32_t writes;
+        uint32_t deferred;    // changes that waited for min_interval_ms
+        uint32_t held;        // reversals kept back by the hysteresis
+    };
+
+    static constexpr size_t kMaxMedian = 5;
+    static constexpr uint64_t kNever = UINT64_MAX;
+
+    void configure(const Config &config);
+
+    /** Feeds a sample taken at @p now_ms; true when @p out must be written. */
+    bool on_sample(int32_t raw, uint64_t now_ms, int32_t &out);
+
+    /** Writes that fall due without a new sample: deferred changes, `max_interval_ms`, `hold_ms`. */
+    bool poll(uint64_t now_ms, int32_t &out);
+
+    /** Time of the next poll() that may write, kNever when none. */
+    uint64_t next_due_ms() const;
+
+    bool written() const { return m_written; }
+    int32_t value() const { return m_value; }
+    int32_t filtered() const { return m_current; }
+    Stats stats() const { return m_stats; }
+
+private:
+    int32_t filter(int32_t raw);
+    bool evaluate(uint64_t now_ms, int32_t &out);
+    bool write(int32_t value, uint64_t now_ms, int32_t &out);
+
+    Config m_config{false, 1, 0, 0, 0, 0, 0, 0};
+
+    int32_t m_window[kMaxMedian] = {};
+    size_t m_window_count = 0;
+    size_t m_window_next = 0;
+    int64_t m_average = 0; // 8 fraction bits
+    bool m_has_sample = false;
+    int32_t m_last_raw = 0;
+    int32_t m_current = 0;
+
+    bool m_written = false;
+    int32_t m_value = 0;
+    int8_t m_direction = 0; // sign of the last written change
+    uint64_t m_written_ms = 0;
+    bool m_deferred = false;
+
+    bool m_clearing = false;
+    uint64_t m_clear_ms = 0;
+
+    Stats m_stats{};
+};
+
+} // namespace device_modules::sensor
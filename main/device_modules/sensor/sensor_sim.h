@@ -0,0 +1,149 @@
+#pragma once
+
+#include "sensor_pipeline.h"
+
+#include <cstdint>
+
+namespace device_modules::sensor {
+
+/**
+ * @brief Simulated analog sensor, in the units of its Matter attribute.
+ *
+ * The true value is a triangle wave of +-swing around base; each reading
+ * adds triangular noise of up to +-noise and, on a few readings per
+ * thousand, a spike. Backs `source: sim` on the device and
+ * test/host/sensor_test.cpp, which measures how many writes SensorPipeline
+ * saves.
+ */
+class SimulatedSensor {
+public:
+    struct Profile {
+        int32_t base;
+        int32_t swing;
+        uint32_t period_ms;
+        int32_t noise;
+        uint16_t spikes_per_mille;
+        int32_t spike;
+    };
+
+    explicit SimulatedSensor(const Profile &profile, uint32_t seed = 1) : m_profile(profile), m_rng(seed ? seed : 1) {}
+
+    int32_t truth(uint64_t now_ms) const
+    {
+        if (m_profile.period_ms == 0 || m_profile.swing == 0) {
+            return m_profile.base;
+        }
+        const int64_t period = m_profile.period_ms;
+        const int64_t phase = static_cast<int64_t>(now_ms % m_profile.period_ms);
+        const int64_t ramp = phase < period / 2 ? phase : period - phase; // 0 .. period/2
+        return m_profile.base - m_profile.swing + static_cast<int32_t>(ramp * 4 * m_profile.swing / period);
+    }
+
+    int32_t read(uint64_t now_ms)
+    {
+        int32_t value = truth(now_ms);
+        if (m_profile.noise > 0) {
+            const uint32_t span = static_cast<uint32_t>(m_profile.noise) + 1;
+            value += static_cast<int32_t>(next_random() % span) - static_cast<int32_t>(next_random() % span);
+        }
+        if (m_profile.spikes_per_mille && next_random() % 1000 < m_profile.spikes_per_mille) {
+            value += next_random() % 2 ? m_profile.spike : -m_profile.spike;
+        }
+        return value;
+    }
+
+private:
+    uint32_t next_random()
+    {
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 17;
+        m_rng ^= m_rng << 5;
+        return m_rng;
+    }
+
+    Profile m_profile;
+    uint32_t m_rng;
+};
+
+/**
+ * @brief Simulated PIR: people come and go at random, and while someone is
+ * there a reading sees motion with probability `motion_per_mille`.
+ * Times are drawn between half and one and a half times their mean.
+ */
+class SimulatedPresence {
+public:
+    struct Profile {
+        uint32_t mean_gap_ms;
+        uint32_t mean_visit_ms;
+        uint16_t motion_per_mille;
+    };
+
+    explicit SimulatedPresence(const Profile &profile, uint32_t seed = 1) : m_profile(profile), m_rng(seed ? seed : 1)
+    {
+        m_next_change_ms = draw(m_profile.mean_gap_ms);
+    }
+
+    int32_t truth(uint64_t now_ms)
+    {
+        while (now_ms >= m_next_change_ms) {
+            m_present = !m_present;
+            m_next_change_ms += draw(m_present ? m_profile.mean_visit_ms : m_profile.mean_gap_ms);
+        }
+        return m_present ? 1 : 0;
+    }
+
+    int32_t read(uint64_t now_ms) { return truth(now_ms) && next_random() % 1000 < m_profile.motion_per_mille ? 1 : 0; }
+
+private:
+    uint32_t next_random()
+    {
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 17;
+        m_rng ^= m_rng << 5;
+        return m_rng;
+    }
+
+    uint64_t draw(uint32_t mean_ms) { return mean_ms / 2 + (mean_ms ? next_random() % (mean_ms + 1) : 0) + 1; }
+
+    Profile m_profile;
+    uint32_t m_rng;
+    bool m_present = false;
+    uint64_t m_next_change_ms = 0;
+};
+
+struct SimulationResult {
+    SensorPipeline::Stats stats;
+    uint32_t max_error;       // largest |written value - true value| at a sample
+    uint32_t mean_error_x1000;
+};
+
+/**
+ * @brief Runs @p pipeline on readings of @p source every @p period_ms for
+ * @p duration_ms, with deferred writes polled when due as on the device.
+ */
+template <typename Source>
+SimulationResult simulate(SensorPipeline &pipeline, Source &source, uint64_t duration_ms, uint32_t period_ms)
+{
+    SimulationResult result{};
+    uint64_t error_sum = 0;
+    uint64_t next_sample_ms = 0;
+    int32_t out = 0;
+    while (next_sample_ms < duration_ms) {
+        const uint64_t due_ms = pipeline.next_due_ms();
+        if (due_ms < next_sample_ms) {
+            pipeline.poll(due_ms, out);
+            continue;
+        }
+        pipeline.on_sample(source.read(next_sample_ms), next_sample_ms, out);
+        const int64_t error = static_cast<int64_t>(pipeline.value()) - source.truth(next_sample_ms);
+        const uint32_t magnitude = static_cast<uint32_t>(error < 0 ? -error : error);
+        result.max_error = magnitude > result.max_error ? magnitude : result.max_error;
+        error_sum += magnitude;
+        next_sample_ms += period_ms;
+    }
+    result.stats = pipeline.stats();
+    result.mean_error_x1000 = result.stats.samples ? static_cast<uint32_t>(error_sum * 1000 / result.stats.samples) : 0;
+    return result;
+}
+
+} // namespace device_modules::sensor
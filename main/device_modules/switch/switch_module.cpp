@@ -1,6 +1,7 @@
 #include "switch_module.h"
 
 #include "generated_config.h"
+#include "report_throttle.h"
 
 #include <cstring>
 #include <esp_log.h>
@@ -111,9 +112,11 @@ endpoint_t *create_endpoint(const generated_config::endpoint_raw &config, node_t
     return endpoint;
 }
 
-void after_endpoint_created(const generated_config::endpoint_raw &, endpoint_t *)
+void after_endpoint_created(const generated_config::endpoint_raw &, endpoint_t *endpoint)
 {
-    // No additional bookkeeping required for the switch module.
+    if (endpoint) {
+        report_throttle::track_endpoint(endpoint::get_id(endpoint));
+    }
 }
 
 void apply_post_stack_start()
@@ -0,0 +1,212 @@
+#include "event_loop_monitor.h"
+
+#include "latency_stats.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <platform/CHIPDeviceLayer.h>
+
+namespace event_loop_monitor {
+
+namespace {
+
+constexpr const char *TAG = "event_loop";
+constexpr const char *kNoActivity = "unknown";
+// Tasks that can be inside an Activity at once: CHIP, esp_timer, main, a few app tasks.
+constexpr size_t kMaxActivityTasks = 8;
+
+struct TaskActivity {
+    TaskHandle_t task;
+    const char *label;  // innermost open section of the task
+    uint32_t entered;   // order of entry across tasks, to find the latest
+};
+
+portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+Stats s_stats = {0, 0, 0, 0, 0, 0, kNoActivity, kNoActivity, 0};
+
+TaskActivity s_activities[kMaxActivityTasks] = {};
+uint32_t s_activity_entries = 0;
+TaskHandle_t s_chip_task = nullptr;
+std::atomic<bool> s_probe_pending{false};
+std::atomic<uint32_t> s_probe_sent_ms{0};
+std::atomic<const char *> s_stall_activity{nullptr};
+
+uint32_t now_ms()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+// Called with s_lock held.
+TaskActivity *activity_slot(TaskHandle_t task, bool claim)
+{
+    TaskActivity *free_slot = nullptr;
+    for (TaskActivity &slot : s_activities) {
+        if (slot.task == task) {
+            return &slot;
+        }
+        if (!slot.task && !free_slot) {
+            free_slot = &slot;
+        }
+    }
+    if (claim && free_slot) {
+        free_slot->task = task;
+        free_slot->label = nullptr;
+    }
+    return claim ? free_slot : nullptr;
+}
+
+// The CHIP task's section is what blocks the loop; otherwise the section
+// entered last, on whichever task holds the stack lock.
+const char *blocking_activity()
+{
+    if (!s_chip_task) {
+        s_chip_task = xTaskGetHandle(CHIP_DEVICE_CONFIG_CHIP_TASK_NAME);
+    }
+    const char *latest = nullptr;
+    uint32_t latest_entered = 0;
+    const char *chip_label = nullptr;
+    portENTER_CRITICAL(&s_lock);
+    for (const TaskActivity &slot : s_activities) {
+        if (!slot.task || !slot.label) {
+            continue;
+        }
+        if (slot.task == s_chip_task) {
+            chip_label = slot.label;
+        }
+        if (!latest || static_cast<int32_t>(slot.entered - latest_entered) > 0) {
+            latest = slot.label;
+            latest_entered = slot.entered;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return chip_label ? chip_label : latest;
+}
+
+void probe_work(intptr_t)
+{
+    const uint32_t delay_ms = now_ms() - s_probe_sent_ms.load(std::memory_order_relaxed);
+    latency_stats::record(latency_stats::Probe::EventLoop, delay_ms * 1000);
+
+    const char *activity = s_stall_activity.exchange(nullptr);
+    portENTER_CRITICAL(&s_lock);
+    ++s_stats.probes;
+    if (delay_ms > s_stats.max_delay_ms) {
+        s_stats.max_delay_ms = delay_ms;
+    }
+    if (delay_ms >= kStallThresholdMs) {
+        ++s_stats.stalls;
+        if (delay_ms > s_stats.longest_stall_ms) {
+            s_stats.longest_stall_ms = delay_ms;
+        }
+        s_stats.last_stall_at_ms = now_ms();
+        s_stats.last_stall_activity = activity ? activity : kNoActivity;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    s_probe_pending.store(false, std::memory_order_release);
+    if (delay_ms >= kStallThresholdMs) {
+        ESP_LOGW(TAG, "CHIP event loop stalled for %" PRIu32 " ms (activity: %s).",
+                 delay_ms, activity ? activity : kNoActivity);
+    }
+}
+
+} // namespace
+
+void run()
+{
+    uint32_t next_warning_ms = kStallThresholdMs;
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(kProbePeriodMs));
+
+        if (s_probe_pending.load(std::memory_order_acquire)) {
+            // The previous probe is still queued: the loop is blocked right now,
+            // so this is the moment to see who is running.
+            const uint32_t waiting_ms = now_ms() - s_probe_sent_ms.load(std::memory_order_relaxed);
+            const char *activity = blocking_activity();
+            const char *expected = nullptr;
+            if (activity) {
+                s_stall_activity.compare_exchange_strong(expected, activity);
+            }
+            if (waiting_ms >= next_warning_ms) {
+                ESP_LOGW(TAG, "CHIP event loop unresponsive for %" PRIu32 " ms (activity: %s).",
+                         waiting_ms, activity ? activity : kNoActivity);
+                next_warning_ms = waiting_ms * 2;
+            }
+            continue;
+        }
+
+        next_warning_ms = kStallThresholdMs;
+        s_probe_sent_ms.store(now_ms(), std::memory_order_relaxed);
+        s_probe_pending.store(true, std::memory_order_release);
+        if (chip::DeviceLayer::PlatformMgr().ScheduleWork(probe_work, 0) != CHIP_NO_ERROR) {
+            s_probe_pending.store(false, std::memory_order_release);
+            portENTER_CRITICAL(&s_lock);
+            ++s_stats.schedule_failures;
+            portEXIT_CRITICAL(&s_lock);
+        }
+    }
+}
+
+Stats stats()
+{
+    portENTER_CRITICAL(&s_lock);
+    const Stats copy = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+    return copy;
+}
+
+void print()
+{
+    const Stats s = stats();
+    printf("event loop: probes=%" PRIu32 " failures=%" PRIu32 " max_delay=%" PRIu32 " ms\n",
+           s.probes, s.schedule_failures, s.max_delay_ms);
+    printf("stalls>=%" PRIu32 "ms: %" PRIu32 ", longest=%" PRIu32 " ms, last at %" PRIu32 " ms during '%s'\n",
+           kStallThresholdMs, s.stalls, s.longest_stall_ms, s.last_stall_at_ms, s.last_stall_activity);
+    printf("last long activity: '%s' (%" PRIu32 " ms)\n", s.last_long_activity, s.last_long_activity_ms);
+}
+
+esp_err_t register_commands()
+{
+    return latency_stats::add_subcommand("loop", print);
+}
+
+Activity::Activity(const char *label) : m_label(label), m_previous(nullptr), m_start_ms(now_ms())
+{
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&s_lock);
+    TaskActivity *slot = activity_slot(task, true);
+    if (slot) {
+        m_previous = slot->label;
+        slot->label = label;
+        slot->entered = ++s_activity_entries;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+Activity::~Activity()
+{
+    const uint32_t elapsed_ms = now_ms() - m_start_ms;
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&s_lock);
+    TaskActivity *slot = activity_slot(task, false);
+    if (slot) {
+        slot->label = m_previous;
+        if (!m_previous) {
+            slot->task = nullptr;
+        }
+    }
+    if (elapsed_ms >= kLongActivityMs) {
+        s_stats.last_long_activity = m_label;
+        s_stats.last_long_activity_ms = elapsed_ms;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+} // namespace event_loop_monitor
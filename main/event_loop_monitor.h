@@ -0,0 +1,69 @@
+#pragma once
+
+#include "generated_config.h"
+
+#include <esp_err.h>
+
+#include <cstdint>
+
+namespace event_loop_monitor {
+
+struct Stats {
+    uint32_t probes;
+    uint32_t schedule_failures;
+    uint32_t max_delay_ms;
+    uint32_t stalls;                  // probes delayed by at least kStallThresholdMs
+    uint32_t longest_stall_ms;
+    uint32_t last_stall_at_ms;        // uptime when the last stall ended
+    const char *last_stall_activity;  // activity running when the stall was noticed
+    const char *last_long_activity;   // last Activity that ran for kLongActivityMs or more
+    uint32_t last_long_activity_ms;
+};
+
+// Light-sleep builds probe rarely so the monitor does not keep the chip awake.
+constexpr uint32_t kProbePeriodMs = generated_config::power::light_sleep ? 30000 : 1000;
+constexpr uint32_t kStallThresholdMs = 100;
+constexpr uint32_t kLongActivityMs = 50;
+
+/**
+ * @brief Runs the responsiveness monitor on the calling task; never returns.
+ *
+ * Every kProbePeriodMs a no-op work item is queued with
+ * PlatformMgr().ScheduleWork() and its round trip through the CHIP event loop
+ * is recorded (also into latency_stats). While a probe is outstanding for
+ * longer than kStallThresholdMs the monitor logs which Activity is running,
+ * so blocking LED refreshes, NVS writes or lock holders show up by name.
+ */
+[[noreturn]] void run();
+
+Stats stats();
+void print();
+
+/** @brief Registers `matter esp latency loop`. */
+esp_err_t register_commands();
+
+/**
+ * @brief Labels a section that runs on, or holds the lock of, the CHIP stack.
+ *
+ * Labels must be string literals. Each task keeps its own innermost label,
+ * so sections on different tasks do not overwrite each other and a nested
+ * section restores the outer one when it ends. A stall is blamed on the CHIP
+ * task's section, or else on the section entered last on any task. Sections
+ * lasting kLongActivityMs or more are remembered as the last long-running
+ * work item.
+ */
+class Activity {
+public:
+    explicit Activity(const char *label);
+    ~Activity();
+
+    Activity(const Activity &) = delete;
+    Activity &operator=(const Activity &) = delete;
+
+private:
+    const char *m_label;
+    const char *m_previous;
+    uint32_t m_start_ms;
+};
+
+} // namespace event_loop_monitor
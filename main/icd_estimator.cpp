@@ -0,0 +1,88 @@
+#include "icd_estimator.h"
+
+namespace icd {
+
+namespace {
+
+bool reached(uint32_t now_ms, uint32_t deadline_ms)
+{
+    return static_cast<int32_t>(now_ms - deadline_ms) >= 0;
+}
+
+} // namespace
+
+Estimator::Estimator(const Params &params, uint32_t now_ms)
+    : m_params(params), m_last_ms(now_ms), m_transition_ms(now_ms + params.idle_interval_ms)
+{
+}
+
+void Estimator::user_event(uint32_t now_ms)
+{
+    advance(now_ms);
+    ++m_totals.user_events;
+    if (m_mode == Mode::Idle) {
+        enter(Mode::Active, now_ms);
+        return;
+    }
+    const uint32_t extended_ms = now_ms + m_params.active_threshold_ms;
+    if (static_cast<int32_t>(extended_ms - m_transition_ms) > 0) {
+        m_transition_ms = extended_ms;
+    }
+}
+
+void Estimator::advance(uint32_t now_ms)
+{
+    // A long gap (e.g. after a simulation skips an hour) walks through
+    // every check-in window it contains.
+    while (reached(now_ms, m_transition_ms)) {
+        account(m_transition_ms - m_last_ms);
+        m_last_ms = m_transition_ms;
+        if (m_mode == Mode::Active) {
+            enter(Mode::Idle, m_transition_ms);
+        } else {
+            ++m_totals.check_ins;
+            enter(Mode::Active, m_transition_ms);
+        }
+    }
+    account(now_ms - m_last_ms);
+    m_last_ms = now_ms;
+}
+
+uint32_t Estimator::poll_period_ms() const
+{
+    return m_mode == Mode::Active ? m_params.fast_poll_ms : m_params.slow_poll_ms;
+}
+
+const char *Estimator::name(Mode mode)
+{
+    return mode == Mode::Active ? "active" : "idle";
+}
+
+void Estimator::account(uint32_t elapsed_ms)
+{
+    if (m_mode == Mode::Active) {
+        m_totals.active_ms += elapsed_ms;
+    } else {
+        m_totals.idle_ms += elapsed_ms;
+    }
+    const uint32_t period_ms = poll_period_ms();
+    if (period_ms == 0) {
+        return;
+    }
+    const uint64_t since_poll_ms = static_cast<uint64_t>(m_poll_residual_ms) + elapsed_ms;
+    m_totals.polls += static_cast<uint32_t>(since_poll_ms / period_ms);
+    m_poll_residual_ms = static_cast<uint32_t>(since_poll_ms % period_ms);
+}
+
+void Estimator::enter(Mode mode, uint32_t at_ms)
+{
+    m_mode = mode;
+    m_transition_ms = at_ms + (mode == Mode::Active ? m_params.active_interval_ms : m_params.idle_interval_ms);
+    // Entering active mode polls right away so queued messages arrive quickly.
+    if (mode == Mode::Active) {
+        ++m_totals.polls;
+        m_poll_residual_ms = 0;
+    }
+}
+
+} // namespace icd
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+namespace icd {
+
+enum class Mode : uint8_t { Idle, Active };
+
+/**
+ * @brief Model of the idle/active timeline of a Matter ICD, for estimates only.
+ *
+ * CHIP's ICDManager runs the real timeline, from the same YAML values
+ * rendered into sdkconfig (CONFIG_ICD_*). This class follows the same ICD
+ * Management cluster rules so the firmware and test/host/icd_test.cpp can
+ * count idle time, active time, polls and check-ins and turn them into an
+ * average current (estimate() below). Nothing here changes a poll interval.
+ *
+ * The rules: the device idles for the idle interval, then stays active for
+ * the active interval (check-in window). User activity enters active mode
+ * for the active interval, or extends an ongoing one to at least the active
+ * threshold. Time is passed in by the caller (milliseconds, wrapping is fine).
+ */
+class Estimator {
+public:
+    struct Params {
+        uint32_t idle_interval_ms;
+        uint32_t active_interval_ms;
+        uint32_t active_threshold_ms;
+        uint32_t slow_poll_ms; // Thread data-poll period while idle
+        uint32_t fast_poll_ms; // Thread data-poll period while active
+    };
+
+    struct Totals {
+        uint64_t idle_ms;
+        uint64_t active_ms;
+        uint32_t polls;       // data polls implied by the poll periods
+        uint32_t check_ins;   // idle intervals that expired into a check-in window
+        uint32_t user_events;
+    };
+
+    Estimator(const Params &params, uint32_t now_ms);
+
+    /** A button press or other local activity that must reach the network. */
+    void user_event(uint32_t now_ms);
+
+    /** Applies every transition up to @p now_ms; cheap to call lazily. */
+    void advance(uint32_t now_ms);
+
+    Mode mode() const { return m_mode; }
+    uint32_t poll_period_ms() const;
+
+    /** Absolute time of the next idle/active transition. */
+    uint32_t next_transition_ms() const { return m_transition_ms; }
+
+    const Totals &totals() const { return m_totals; }
+    const Params &params() const { return m_params; }
+
+    static const char *name(Mode mode);
+
+private:
+    void account(uint32_t elapsed_ms);
+    void enter(Mode mode, uint32_t at_ms);
+
+    Params m_params;
+    Mode m_mode = Mode::Idle;
+    uint32_t m_last_ms;
+    uint32_t m_transition_ms;
+    uint32_t m_poll_residual_ms = 0; // time since the last data poll
+    Totals m_totals = {};
+};
+
+/**
+ * @brief Charge model of a sleepy end device.
+ *
+ * The defaults are typical ESP32-C6/H2 figures for a switch with the radio
+ * off between polls; replace them with values measured on the real board.
+ * Charge is in microcoulombs, so charge per second reads directly as µA.
+ */
+struct CurrentProfile {
+    uint32_t sleep_ua = 35;            // light sleep with RTC timer and GPIO wake-up
+    uint32_t active_extra_ua = 300;    // CPU woken more often while in active mode
+    uint32_t poll_uc = 60;             // one data poll: wake, TX request, RX ack
+    uint32_t check_in_uc = 600;        // check-in message exchange
+    uint32_t user_event_uc = 1500;     // wake-up, command to the bound target, ack
+};
+
+struct Estimate {
+    uint32_t average_ua;
+    uint32_t active_permille;  // share of time spent in active mode
+    Estimator::Totals totals;
+};
+
+/** Average current of the timeline accumulated by @p estimator. */
+inline Estimate estimate(const Estimator &estimator, const CurrentProfile &profile)
+{
+    const Estimator::Totals &t = estimator.totals();
+    const uint64_t total_ms = t.idle_ms + t.active_ms;
+    Estimate out = {0, 0, t};
+    if (total_ms == 0) {
+        return out;
+    }
+    const uint64_t charge_uc_ms = static_cast<uint64_t>(profile.sleep_ua) * total_ms +
+                                  static_cast<uint64_t>(profile.active_extra_ua) * t.active_ms +
+                                  (static_cast<uint64_t>(profile.poll_uc) * t.polls +
+                                   static_cast<uint64_t>(profile.check_in_uc) * t.check_ins +
+                                   static_cast<uint64_t>(profile.user_event_uc) * t.user_events) * 1000;
+    out.average_ua = static_cast<uint32_t>(charge_uc_ms / total_ms);
+    out.active_permille = static_cast<uint32_t>(t.active_ms * 1000 / total_ms);
+    return out;
+}
+
+/** Battery life in hours for a cell of @p capacity_mah at @p average_ua. */
+inline uint32_t battery_life_hours(uint32_t capacity_mah, uint32_t average_ua)
+{
+    return average_ua ? static_cast<uint32_t>(static_cast<uint64_t>(capacity_mah) * 1000 / average_ua) : 0;
+}
+
+} // namespace icd
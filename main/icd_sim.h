@@ -0,0 +1,33 @@
+#pragma once
+
+#include "icd_estimator.h"
+
+#include <cstdint>
+
+namespace icd {
+
+/**
+ * @brief Runs an Estimator over @p hours of simulated time with evenly spaced presses.
+ *
+ * Used by host harnesses and by `matter esp power estimate` to size the ICD
+ * intervals before a board is on the bench.
+ */
+inline Estimate simulate(const Estimator::Params &params, const CurrentProfile &profile,
+                         uint32_t presses_per_hour, uint32_t hours)
+{
+    constexpr uint32_t kHourMs = 3600U * 1000U;
+    Estimator estimator(params, 0);
+    uint32_t now_ms = 0;
+    for (uint32_t hour = 0; hour < hours; ++hour) {
+        const uint32_t gap_ms = presses_per_hour ? kHourMs / presses_per_hour : kHourMs;
+        for (uint32_t press = 0; press < presses_per_hour; ++press) {
+            now_ms += gap_ms;
+            estimator.user_event(now_ms);
+        }
+        now_ms += kHourMs - gap_ms * presses_per_hour;
+        estimator.advance(now_ms);
+    }
+    return estimate(estimator, profile);
+}
+
+} // namespace icd
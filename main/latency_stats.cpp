@@ -0,0 +1,203 @@
+#include "latency_stats.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <esp_log.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+namespace latency_stats {
+
+namespace {
+
+constexpr const char *TAG = "latency_stats";
+constexpr size_t kProbeCount = static_cast<size_t>(Probe::Count);
+constexpr size_t kMaxSubcommands = 6;
+
+struct Histogram {
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> max_us;
+    std::atomic<uint32_t> buckets[kBucketCount];
+};
+
+Histogram s_histograms[kProbeCount];
+
+struct Subcommand {
+    const char *name;
+    SubcommandHandler handler;
+};
+
+Subcommand s_subcommands[kMaxSubcommands] = {};
+size_t s_subcommand_count = 0;
+
+size_t bucket_for(uint32_t elapsed_us)
+{
+    if (elapsed_us == 0) {
+        return 0;
+    }
+    const size_t bucket = 31 - static_cast<size_t>(__builtin_clz(elapsed_us));
+    return bucket < kBucketCount ? bucket : kBucketCount - 1;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t latency_command(int argc, char **argv)
+{
+    if (argc == 0) {
+        print();
+        return ESP_OK;
+    }
+    if (strcmp(argv[0], "reset") == 0) {
+        reset();
+        printf("Latency histograms cleared.\n");
+        return ESP_OK;
+    }
+    for (size_t idx = 0; idx < s_subcommand_count; ++idx) {
+        if (strcmp(argv[0], s_subcommands[idx].name) == 0) {
+            s_subcommands[idx].handler();
+            return ESP_OK;
+        }
+    }
+    printf("Usage: matter esp latency [reset");
+    for (size_t idx = 0; idx < s_subcommand_count; ++idx) {
+        printf("|%s", s_subcommands[idx].name);
+    }
+    printf("]\n");
+    return ESP_ERR_INVALID_ARG;
+}
+#endif
+
+} // namespace
+
+void record(Probe probe, uint32_t elapsed_us)
+{
+    Histogram &histogram = s_histograms[static_cast<size_t>(probe)];
+    histogram.buckets[bucket_for(elapsed_us)].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t current = histogram.max_us.load(std::memory_order_relaxed);
+    while (elapsed_us > current &&
+           !histogram.max_us.compare_exchange_weak(current, elapsed_us, std::memory_order_relaxed)) {
+    }
+}
+
+Snapshot snapshot(Probe probe)
+{
+    const Histogram &histogram = s_histograms[static_cast<size_t>(probe)];
+    Snapshot out = {};
+    out.count = histogram.count.load(std::memory_order_relaxed);
+    out.max_us = histogram.max_us.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        out.buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+    }
+    return out;
+}
+
+void reset()
+{
+    for (Histogram &histogram : s_histograms) {
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.max_us.store(0, std::memory_order_relaxed);
+        for (auto &bucket : histogram.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+const char *name(Probe probe)
+{
+    switch (probe) {
+    case Probe::AttributeUpdateCb:
+        return "attribute_update_cb";
+    case Probe::ModuleAttributeUpdate:
+        return "module_attribute_update";
+    case Probe::Identification:
+        return "identification";
+    case Probe::BoundSend:
+        return "bound_send";
+    case Probe::ButtonGesture:
+        return "button_gesture";
+    case Probe::EventLoop:
+        return "event_loop";
+    default:
+        return "unknown";
+    }
+}
+
+uint32_t percentile_us(const Snapshot &snapshot, uint32_t percentile)
+{
+    uint32_t total = 0;
+    for (uint32_t bucket : snapshot.buckets) {
+        total += bucket;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // Rank of the sample at the percentile, rounded up so p99 of 50 samples
+    // still lands on the slowest one.
+    const uint64_t rank = (static_cast<uint64_t>(total) * percentile + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += snapshot.buckets[i];
+        if (seen >= rank && snapshot.buckets[i] > 0) {
+            const uint32_t upper = (i + 1 < kBucketCount) ? (1U << (i + 1)) : snapshot.max_us;
+            return upper < snapshot.max_us ? upper : snapshot.max_us;
+        }
+    }
+    return snapshot.max_us;
+}
+
+void print()
+{
+    printf("%-24s %8s %9s %9s %9s %9s\n", "probe", "count", "p50_us", "p90_us", "p99_us", "max_us");
+    for (size_t idx = 0; idx < kProbeCount; ++idx) {
+        const auto probe = static_cast<Probe>(idx);
+        const Snapshot snap = snapshot(probe);
+        if (snap.count == 0) {
+            continue;
+        }
+        printf("%-24s %8" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 "\n",
+               name(probe), snap.count, percentile_us(snap, 50), percentile_us(snap, 90),
+               percentile_us(snap, 99), snap.max_us);
+    }
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "latency",
+            .description = "Callback latency histograms. Usage: matter esp latency [reset|<view>]",
+            .handler = latency_command,
+        },
+    };
+    esp_err_t err = esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to register latency command: %s", esp_err_to_name(err));
+    }
+    return err;
+#else
+    return ESP_OK;
+#endif
+}
+
+esp_err_t add_subcommand(const char *name, SubcommandHandler handler)
+{
+    if (!name || !handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_subcommand_count == kMaxSubcommands) {
+        ESP_LOGW(TAG, "No room for latency subcommand %s", name);
+        return ESP_ERR_NO_MEM;
+    }
+    s_subcommands[s_subcommand_count++] = {name, handler};
+    return ESP_OK;
+}
+
+} // namespace latency_stats
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <esp_err.h>
+#include <esp_timer.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace latency_stats {
+
+enum class Probe : uint8_t {
+    AttributeUpdateCb,      // app_attribute_update_cb as a whole
+    ModuleAttributeUpdate,  // DeviceModule::attribute_update
+    Identification,         // DeviceModule::perform_identification
+    BoundSend,              // bound_client::send
+    ButtonGesture,          // button gesture dispatch
+    EventLoop,              // ScheduleWork round trip through the CHIP event loop
+    Count,
+};
+
+/**
+ * Bucket 0 counts samples in [0, 2) µs and bucket `i` > 0 those in
+ * [2^i, 2^(i+1)) µs; the last one is open-ended.
+ */
+constexpr size_t kBucketCount = 20;
+
+struct Snapshot {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t buckets[kBucketCount];
+};
+
+/**
+ * @brief Adds one sample to the probe's histogram.
+ *
+ * Lock-free and allocation-free, so it is safe from any task or timer
+ * callback. Counts are relaxed atomics: a snapshot taken concurrently may be
+ * off by the samples in flight.
+ */
+void record(Probe probe, uint32_t elapsed_us);
+
+Snapshot snapshot(Probe probe);
+void reset();
+
+const char *name(Probe probe);
+
+/** Upper bound in µs of the bucket holding the given percentile (0-100). */
+uint32_t percentile_us(const Snapshot &snapshot, uint32_t percentile);
+
+/** Prints every non-empty histogram with p50/p90/p99 to the console. */
+void print();
+
+/**
+ * @brief Registers `matter esp latency [reset|<subcommand>]`.
+ *
+ * No-op when the CHIP shell is disabled in sdkconfig.
+ */
+esp_err_t register_commands();
+
+using SubcommandHandler = void (*)();
+
+/**
+ * @brief Adds `matter esp latency <name>`, which runs @p handler.
+ *
+ * Modules with their own timing records (gestures, bound peers, the event
+ * loop) register a view here from their register_commands(). @p name must be
+ * a string literal.
+ */
+esp_err_t add_subcommand(const char *name, SubcommandHandler handler);
+
+/** @brief Times the enclosing scope into `probe`. */
+class Scope {
+public:
+    explicit Scope(Probe probe) : m_probe(probe), m_start_us(esp_timer_get_time()) {}
+    ~Scope() { record(m_probe, static_cast<uint32_t>(esp_timer_get_time() - m_start_us)); }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    Probe m_probe;
+    int64_t m_start_us;
+};
+
+} // namespace latency_stats
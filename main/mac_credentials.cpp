@@ -0,0 +1,42 @@
+#include "mac_credentials.h"
+
+namespace mac_credentials {
+
+namespace {
+
+// Trivial passcodes the Matter specification forbids.
+constexpr uint32_t kInvalidPasscodes[] = {
+    0, 11111111, 22222222, 33333333, 44444444, 55555555,
+    66666666, 77777777, 88888888, 99999999, 12345678, 87654321,
+};
+
+bool invalid(uint32_t passcode)
+{
+    for (uint32_t code : kInvalidPasscodes) {
+        if (passcode == code) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+Credentials derive(const uint8_t (&mac)[6])
+{
+    uint64_t mac_value = 0;
+    for (uint8_t byte : mac) {
+        mac_value = (mac_value << 8) | byte;
+    }
+    const uint64_t mix = mac_value ^ (mac_value >> 12) ^ 0x5A5A5A5A5A5AULL;
+    const uint32_t pin_raw = static_cast<uint32_t>(mix % 99999999ULL);
+    uint32_t passcode = 10000000U + (pin_raw % 89999999U);
+    // The range still contains trivial codes; step past them so every MAC
+    // keeps a passcode of its own.
+    while (invalid(passcode)) {
+        ++passcode;
+    }
+    return {passcode, static_cast<uint16_t>((mac_value ^ (mac_value >> 24)) & 0x0FFFU)};
+}
+
+} // namespace mac_credentials
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mac_credentials {
+
+/** Used when the MAC cannot be read. */
+constexpr uint32_t kFallbackPasscode = 20202021;
+constexpr uint16_t kFallbackDiscriminator = 3840;
+
+struct Credentials {
+    uint32_t passcode;
+    uint16_t discriminator;
+};
+
+/**
+ * @brief Setup passcode and discriminator for a 6-byte MAC.
+ *
+ * The algorithm of docs/codegen_guardrails.md, the same as
+ * tools/matter_credentials.py, so the firmware and the provisioning tools
+ * agree on every MAC. test/host/mac_credentials_test.cpp pins both.
+ */
+Credentials derive(const uint8_t (&mac)[6]);
+
+} // namespace mac_credentials
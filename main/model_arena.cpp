@@ -0,0 +1,121 @@
+#include "model_arena.h"
+
+#include "generated_config.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// esp_matter_mem_calloc/free are wrapped at link time (see main/CMakeLists.txt).
+extern "C" void *__real_esp_matter_mem_calloc(size_t n, size_t size);
+extern "C" void __real_esp_matter_mem_free(void *ptr);
+
+namespace model_arena {
+
+namespace {
+
+constexpr const char *TAG = "model_arena";
+constexpr size_t kAlignment = 8;
+
+alignas(kAlignment) uint8_t s_arena[generated_config::model_arena_size];
+size_t s_offset = 0;
+size_t s_last_offset = SIZE_MAX;
+TaskHandle_t s_owner = nullptr;
+Stats s_stats = {sizeof(s_arena), 0, 0, 0, 0};
+
+bool in_arena(const void *ptr)
+{
+    const auto *p = static_cast<const uint8_t *>(ptr);
+    return p >= s_arena && p < s_arena + sizeof(s_arena);
+}
+
+bool active()
+{
+    return s_owner != nullptr && s_owner == xTaskGetCurrentTaskHandle();
+}
+
+void *arena_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > SIZE_MAX / size) {
+        return nullptr;
+    }
+    const size_t bytes = (n * size + kAlignment - 1) & ~(kAlignment - 1);
+    if (bytes == 0 || bytes > sizeof(s_arena) - s_offset) {
+        return nullptr;
+    }
+    // The arena is zeroed once at boot, but a rolled-back block may be reused.
+    void *ptr = s_arena + s_offset;
+    memset(ptr, 0, bytes);
+    s_last_offset = s_offset;
+    s_offset += bytes;
+    if (s_offset > s_stats.used) {
+        s_stats.used = s_offset;
+    }
+    ++s_stats.allocations;
+    return ptr;
+}
+
+} // namespace
+
+void begin()
+{
+    s_owner = xTaskGetCurrentTaskHandle();
+}
+
+void end()
+{
+    s_owner = nullptr;
+    s_last_offset = SIZE_MAX;
+}
+
+Stats stats()
+{
+    return s_stats;
+}
+
+void log_stats()
+{
+    ESP_LOGI(TAG, "Data model arena: %u/%u bytes in %u allocations (high-water), %u spilled to heap (%u bytes).",
+             static_cast<unsigned int>(s_stats.used), static_cast<unsigned int>(s_stats.capacity),
+             static_cast<unsigned int>(s_stats.allocations), static_cast<unsigned int>(s_stats.overflow_allocations),
+             static_cast<unsigned int>(s_stats.overflow_bytes));
+    ESP_LOGI(TAG, "Largest free internal block: %u bytes.",
+             static_cast<unsigned int>(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL)));
+    if (s_stats.overflow_allocations > 0) {
+        ESP_LOGW(TAG, "Arena too small for this configuration; raise the estimate in tools/render_config.py.");
+    }
+}
+
+} // namespace model_arena
+
+extern "C" void *__wrap_esp_matter_mem_calloc(size_t n, size_t size)
+{
+    using namespace model_arena;
+    if (active()) {
+        if (void *ptr = arena_calloc(n, size)) {
+            return ptr;
+        }
+        ++s_stats.overflow_allocations;
+        s_stats.overflow_bytes += n * size;
+    }
+    return __real_esp_matter_mem_calloc(n, size);
+}
+
+extern "C" void __wrap_esp_matter_mem_free(void *ptr)
+{
+    using namespace model_arena;
+    if (!in_arena(ptr)) {
+        __real_esp_matter_mem_free(ptr);
+        return;
+    }
+    // Temporary buffers freed right after allocation are reclaimed; anything
+    // else stays reserved until reboot, like the rest of the model.
+    if (active() && static_cast<uint8_t *>(ptr) == s_arena + s_last_offset) {
+        s_offset = s_last_offset;
+        s_last_offset = SIZE_MAX;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+namespace model_arena {
+
+/**
+ * @brief Routes esp_matter data-model allocations into one static block.
+ *
+ * Between begin() and end(), every esp_matter_mem_calloc() made by the
+ * calling task is served from a bump arena sized by render_config.py from the
+ * endpoint list, so the node, endpoints, clusters and attributes that live for
+ * the whole uptime end up contiguous instead of scattered across the heap.
+ * Requests that do not fit fall back to the heap. Frees of arena memory are
+ * ignored, except for the most recent allocation which is rolled back.
+ */
+void begin();
+void end();
+
+struct Stats {
+    size_t capacity;
+    size_t used;             // high-water mark of the bump pointer
+    size_t allocations;
+    size_t overflow_allocations;
+    size_t overflow_bytes;
+};
+
+Stats stats();
+
+/** @brief Logs the arena high-water mark and the largest free heap block. */
+void log_stats();
+
+} // namespace model_arena
@@ -0,0 +1,429 @@
+#include "ota_stream.h"
+
+#include <cstring>
+#include <new>
+
+namespace ota_stream {
+
+namespace {
+
+constexpr uint32_t kMinMatch = 4;
+constexpr uint8_t kOpCopy = 0;
+constexpr uint8_t kOpAdd = 1;
+constexpr uint8_t kOpData = 2;
+
+uint32_t read_le32(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+           static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+} // namespace
+
+bool Decoder::is_payload(const uint8_t *data, size_t len)
+{
+    return len >= sizeof(kMagic) && memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+const char *Decoder::name(Error error)
+{
+    switch (error) {
+    case Error::None:
+        return "none";
+    case Error::BadHeader:
+        return "bad header";
+    case Error::Rejected:
+        return "rejected";
+    case Error::NoMemory:
+        return "no memory";
+    case Error::Corrupt:
+        return "corrupt";
+    case Error::BaseRange:
+        return "base out of range";
+    case Error::BaseRead:
+        return "base read failed";
+    case Error::Write:
+        return "write failed";
+    case Error::Overrun:
+        return "overrun";
+    case Error::Truncated:
+        return "truncated";
+    }
+    return "?";
+}
+
+void Decoder::reset()
+{
+    m_window.reset();
+    m_error = Error::None;
+    m_header_len = 0;
+    m_header = Header{};
+    m_consumed = 0;
+    m_produced = 0;
+    m_window_mask = 0;
+    m_window_pos = 0;
+    m_flushed_pos = 0;
+    m_unflushed = 0;
+    m_stream_out = 0;
+    m_lz_state = LzState::Token;
+    m_literals = 0;
+    m_match = 0;
+    m_offset = 0;
+    m_op_state = OpState::Opcode;
+    m_opcode = 0;
+    m_varint = 0;
+    m_varint_shift = 0;
+    m_op_len = 0;
+    m_base_pos = 0;
+}
+
+bool Decoder::fail(Error error)
+{
+    if (m_error == Error::None) {
+        m_error = error;
+    }
+    m_window.reset();
+    return false;
+}
+
+bool Decoder::feed(const uint8_t *data, size_t len)
+{
+    if (m_error != Error::None) {
+        return false;
+    }
+    m_consumed += static_cast<uint32_t>(len);
+    if (m_header_len < kHeaderSize) {
+        const size_t take = len < kHeaderSize - m_header_len ? len : kHeaderSize - m_header_len;
+        memcpy(m_header_bytes + m_header_len, data, take);
+        m_header_len += take;
+        data += take;
+        len -= take;
+        if (m_header_len < kHeaderSize) {
+            return true;
+        }
+        if (!parse_header()) {
+            return false;
+        }
+    }
+    if (len == 0) {
+        return true;
+    }
+    return lz_input(data, len) && flush_window();
+}
+
+bool Decoder::finish()
+{
+    if (m_error != Error::None) {
+        return false;
+    }
+    if (!has_header() || m_lz_state != LzState::Done || m_op_state != OpState::Opcode ||
+        m_produced != m_header.target_size) {
+        return fail(Error::Truncated);
+    }
+    m_window.reset();
+    return true;
+}
+
+bool Decoder::parse_header()
+{
+    const uint8_t *raw = m_header_bytes;
+    if (memcmp(raw, kMagic, sizeof(kMagic)) != 0 || raw[4] != kVersion) {
+        return fail(Error::BadHeader);
+    }
+    m_header.kind = static_cast<Kind>(raw[5]);
+    m_header.window_bits = raw[6];
+    m_header.target_size = read_le32(raw + 8);
+    m_header.stream_size = read_le32(raw + 12);
+    m_header.base_size = read_le32(raw + 16);
+    memcpy(m_header.base_sha256, raw + 20, sizeof(m_header.base_sha256));
+    memcpy(m_header.target_sha256, raw + 52, sizeof(m_header.target_sha256));
+
+    const bool compressed = m_header.kind == Kind::Compressed;
+    if ((!compressed && m_header.kind != Kind::Delta) || m_header.window_bits < kMinWindowBits ||
+        m_header.window_bits > kMaxWindowBits || (compressed && m_header.base_size != 0) ||
+        (compressed && m_header.stream_size != m_header.target_size)) {
+        return fail(Error::BadHeader);
+    }
+    if (!m_io.begin(m_header)) {
+        return fail(Error::Rejected);
+    }
+    const uint32_t window = uint32_t{1} << m_header.window_bits;
+    m_window.reset(new (std::nothrow) uint8_t[window]);
+    if (!m_window) {
+        return fail(Error::NoMemory);
+    }
+    m_window_mask = window - 1;
+    if (m_header.stream_size == 0) {
+        m_lz_state = LzState::Done;
+    }
+    return true;
+}
+
+bool Decoder::lz_input(const uint8_t *data, size_t len)
+{
+    size_t idx = 0;
+    while (idx < len) {
+        const uint8_t byte = data[idx];
+        switch (m_lz_state) {
+        case LzState::Token:
+            ++idx;
+            m_literals = byte >> 4;
+            m_match = (byte & 0x0F) + kMinMatch;
+            if (m_literals == 15) {
+                m_lz_state = LzState::LiteralLength;
+            } else if (m_literals > 0) {
+                m_lz_state = LzState::Literals;
+            } else if (!lz_after_literals()) {
+                return false;
+            }
+            break;
+        case LzState::LiteralLength:
+            ++idx;
+            m_literals += byte;
+            if (m_literals > m_header.stream_size - m_stream_out) {
+                return fail(Error::Corrupt);
+            }
+            if (byte != 255) {
+                m_lz_state = LzState::Literals;
+            }
+            break;
+        case LzState::Literals: {
+            const size_t available = len - idx;
+            const size_t take = m_literals < available ? m_literals : available;
+            for (size_t n = 0; n < take; ++n) {
+                if (!lz_put(data[idx + n])) {
+                    return false;
+                }
+            }
+            idx += take;
+            m_literals -= static_cast<uint32_t>(take);
+            if (m_literals == 0 && !lz_after_literals()) {
+                return false;
+            }
+            break;
+        }
+        case LzState::OffsetLow:
+            ++idx;
+            m_offset = byte;
+            m_lz_state = LzState::OffsetHigh;
+            break;
+        case LzState::OffsetHigh:
+            ++idx;
+            m_offset |= static_cast<uint32_t>(byte) << 8;
+            if (m_offset == 0 || m_offset > m_window_mask + 1 || m_offset > m_stream_out) {
+                return fail(Error::Corrupt);
+            }
+            if (m_match == 15 + kMinMatch) {
+                m_lz_state = LzState::MatchLength;
+            } else if (!lz_match()) {
+                return false;
+            }
+            break;
+        case LzState::MatchLength:
+            ++idx;
+            m_match += byte;
+            if (m_match > m_header.stream_size - m_stream_out) {
+                return fail(Error::Overrun);
+            }
+            if (byte != 255 && !lz_match()) {
+                return false;
+            }
+            break;
+        case LzState::Done:
+            return fail(Error::Overrun);
+        }
+    }
+    return true;
+}
+
+bool Decoder::lz_after_literals()
+{
+    m_lz_state = m_stream_out == m_header.stream_size ? LzState::Done : LzState::OffsetLow;
+    return true;
+}
+
+bool Decoder::lz_match()
+{
+    if (m_match > m_header.stream_size - m_stream_out) {
+        return fail(Error::Overrun);
+    }
+    for (uint32_t n = 0; n < m_match; ++n) {
+        if (!lz_put(m_window[(m_window_pos - m_offset) & m_window_mask])) {
+            return false;
+        }
+    }
+    m_lz_state = m_stream_out == m_header.stream_size ? LzState::Done : LzState::Token;
+    return true;
+}
+
+bool Decoder::lz_put(uint8_t byte)
+{
+    if (m_stream_out == m_header.stream_size) {
+        return fail(Error::Overrun);
+    }
+    m_window[m_window_pos] = byte;
+    m_window_pos = (m_window_pos + 1) & m_window_mask;
+    ++m_unflushed;
+    ++m_stream_out;
+    // Hand the window over before it wraps onto bytes not yet passed on.
+    return m_window_pos != 0 || flush_window();
+}
+
+bool Decoder::flush_window()
+{
+    if (m_unflushed == 0) {
+        return true;
+    }
+    const uint32_t start = m_flushed_pos;
+    const uint32_t len = m_unflushed;
+    m_flushed_pos = m_window_pos;
+    m_unflushed = 0;
+    return stream_output(m_window.get() + start, len);
+}
+
+bool Decoder::stream_output(const uint8_t *data, size_t len)
+{
+    if (m_header.kind == Kind::Compressed) {
+        return write(data, len);
+    }
+    return op_input(data, len);
+}
+
+bool Decoder::op_varint(uint8_t byte, bool &complete)
+{
+    if (m_varint_shift == 28 && (byte & 0xF0) != 0) {
+        return fail(Error::Corrupt);
+    }
+    m_varint |= static_cast<uint32_t>(byte & 0x7F) << m_varint_shift;
+    complete = (byte & 0x80) == 0;
+    m_varint_shift = complete ? 0 : m_varint_shift + 7;
+    return true;
+}
+
+bool Decoder::op_start()
+{
+    // m_varint holds the zigzag base delta; m_op_len the operation length.
+    const int64_t delta = static_cast<int64_t>(m_varint >> 1) ^ -static_cast<int64_t>(m_varint & 1);
+    const int64_t offset = static_cast<int64_t>(m_base_pos) + delta;
+    if (offset < 0 || offset + m_op_len > m_header.base_size) {
+        return fail(Error::BaseRange);
+    }
+    m_base_pos = static_cast<uint32_t>(offset);
+    if (m_opcode == kOpCopy) {
+        m_op_state = OpState::Opcode;
+        return copy_base(m_op_len);
+    }
+    m_op_state = m_op_len ? OpState::Add : OpState::Opcode;
+    return true;
+}
+
+bool Decoder::op_input(const uint8_t *data, size_t len)
+{
+    size_t idx = 0;
+    while (idx < len) {
+        bool complete = false;
+        switch (m_op_state) {
+        case OpState::Opcode:
+            m_opcode = data[idx++];
+            if (m_opcode > kOpData) {
+                return fail(Error::Corrupt);
+            }
+            m_varint = 0;
+            m_varint_shift = 0;
+            m_op_state = OpState::Length;
+            break;
+        case OpState::Length:
+            if (!op_varint(data[idx++], complete)) {
+                return false;
+            }
+            if (!complete) {
+                break;
+            }
+            m_op_len = m_varint;
+            m_varint = 0;
+            if (m_op_len > m_header.target_size - m_produced) {
+                return fail(Error::Overrun);
+            }
+            if (m_opcode == kOpData) {
+                m_op_state = m_op_len ? OpState::Data : OpState::Opcode;
+            } else {
+                m_op_state = OpState::BaseDelta;
+            }
+            break;
+        case OpState::BaseDelta:
+            if (!op_varint(data[idx++], complete)) {
+                return false;
+            }
+            if (complete && !op_start()) {
+                return false;
+            }
+            break;
+        case OpState::Add:
+        case OpState::Data: {
+            const size_t available = len - idx;
+            const size_t take = m_op_len < available ? m_op_len : available;
+            const bool ok = m_op_state == OpState::Add ? add_base(data + idx, take) : write(data + idx, take);
+            if (!ok) {
+                return false;
+            }
+            idx += take;
+            m_op_len -= static_cast<uint32_t>(take);
+            if (m_op_len == 0) {
+                m_op_state = OpState::Opcode;
+            }
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+bool Decoder::copy_base(uint32_t len)
+{
+    while (len > 0) {
+        const size_t chunk = len < kBaseChunk ? len : kBaseChunk;
+        if (!m_io.read_base(m_base_pos, m_base, chunk)) {
+            return fail(Error::BaseRead);
+        }
+        if (!write(m_base, chunk)) {
+            return false;
+        }
+        m_base_pos += static_cast<uint32_t>(chunk);
+        len -= static_cast<uint32_t>(chunk);
+    }
+    return true;
+}
+
+bool Decoder::add_base(const uint8_t *diff, size_t len)
+{
+    while (len > 0) {
+        const size_t chunk = len < kBaseChunk ? len : kBaseChunk;
+        if (!m_io.read_base(m_base_pos, m_base, chunk)) {
+            return fail(Error::BaseRead);
+        }
+        for (size_t idx = 0; idx < chunk; ++idx) {
+            m_base[idx] = static_cast<uint8_t>(m_base[idx] + diff[idx]);
+        }
+        if (!write(m_base, chunk)) {
+            return false;
+        }
+        m_base_pos += static_cast<uint32_t>(chunk);
+        diff += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+bool Decoder::write(const uint8_t *data, size_t len)
+{
+    if (len > m_header.target_size - m_produced) {
+        return fail(Error::Overrun);
+    }
+    if (!m_io.write(data, len)) {
+        return fail(Error::Write);
+    }
+    m_produced += static_cast<uint32_t>(len);
+    return true;
+}
+
+} // namespace ota_stream
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ota_stream {
+
+/*
+ * Payload of a Matter OTA image, as built by tools/ota_pack.py:
+ *
+ *   offset  size  field
+ *        0     4  magic "OTAZ"
+ *        4     1  version (1)
+ *        5     1  kind: 1 compressed, 2 delta against the running image
+ *        6     1  window_bits: LZ window of 2^bits bytes (8..15)
+ *        7     1  reserved (0)
+ *        8     4  target_size: bytes of the app image it expands to
+ *       12     4  stream_size: bytes the LZ body decodes to
+ *       16     4  base_size: bytes of the running image a delta reads (0 when compressed)
+ *       20    32  SHA-256 of those base bytes
+ *       52    32  SHA-256 of the target image
+ *       84        LZ body
+ *
+ * All integers are little-endian. The LZ body is a series of sequences:
+ * a token (literal count in the high nibble, match length - 4 in the low
+ * one, 15 meaning "add the following bytes until one is not 255"), the
+ * literals, a 16-bit offset back into the window and the extra match
+ * length. The last sequence ends after its literals.
+ *
+ * A compressed payload decodes to the image itself. A delta decodes to
+ * operations, each an opcode followed by LEB128 fields:
+ *
+ *   0 COPY  len, base_delta          len bytes of the base
+ *   1 ADD   len, base_delta, bytes   base bytes plus these, modulo 256
+ *   2 DATA  len, bytes               literal bytes
+ *
+ * base_delta is zigzag-encoded and relative to the end of the previous
+ * COPY or ADD, so runs of code that only moved stay cheap.
+ */
+
+constexpr uint8_t kMagic[4] = {'O', 'T', 'A', 'Z'};
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 84;
+constexpr uint8_t kMinWindowBits = 8;
+constexpr uint8_t kMaxWindowBits = 15;
+constexpr size_t kBaseChunk = 512;
+
+enum class Kind : uint8_t { Compressed = 1, Delta = 2 };
+
+struct Header {
+    Kind kind;
+    uint8_t window_bits;
+    uint32_t target_size;
+    uint32_t stream_size;
+    uint32_t base_size;
+    uint8_t base_sha256[32];
+    uint8_t target_sha256[32];
+};
+
+enum class Error : uint8_t {
+    None,
+    BadHeader,  // not a payload of this version, or inconsistent sizes
+    Rejected,   // ImageIo::begin() refused it, e.g. the delta is for another image
+    NoMemory,
+    Corrupt,    // malformed LZ body or delta operation
+    BaseRange,  // an operation reads past base_size
+    BaseRead,
+    Write,
+    Overrun,    // more data than the header announced
+    Truncated,  // finish() before the image was complete
+};
+
+/**
+ * @brief The slots a Decoder works on: the OTA partition on the device,
+ * buffers on a host.
+ */
+class ImageIo {
+public:
+    virtual ~ImageIo() = default;
+    /** Called once the header is in; returning false stops with Error::Rejected. */
+    virtual bool begin(const Header &header) = 0;
+    virtual bool read_base(uint32_t offset, uint8_t *data, size_t len) = 0;
+    virtual bool write(const uint8_t *data, size_t len) = 0;
+};
+
+/**
+ * @brief Streaming decoder for compressed and delta OTA payloads.
+ *
+ * Bytes can arrive in blocks of any size. Output is written as soon as it
+ * is decoded, so RAM is bounded by the LZ window (at most 32 KB) and a
+ * kBaseChunk buffer for base reads, whatever the image size.
+ */
+class Decoder {
+public:
+    explicit Decoder(ImageIo &io) : m_io(io) {}
+    Decoder(const Decoder &) = delete;
+    Decoder &operator=(const Decoder &) = delete;
+
+    /**
+     * True when @p data starts with the whole of kMagic. Blocks can split
+     * anywhere, so callers hold the first bytes until sizeof(kMagic) are in.
+     */
+    static bool is_payload(const uint8_t *data, size_t len);
+
+    /** Returns false once an error was hit; error() tells which. */
+    bool feed(const uint8_t *data, size_t len);
+
+    /** True when the payload was complete and every byte was written. */
+    bool finish();
+
+    /** Frees the window and forgets the payload. */
+    void reset();
+
+    bool has_header() const { return m_header_len == kHeaderSize; }
+    const Header &header() const { return m_header; }
+    Error error() const { return m_error; }
+    uint32_t consumed() const { return m_consumed; }
+    uint32_t produced() const { return m_produced; }
+    size_t window_size() const { return m_window ? m_window_mask + 1 : 0; }
+
+    static const char *name(Error error);
+
+private:
+    enum class LzState : uint8_t { Token, LiteralLength, Literals, OffsetLow, OffsetHigh, MatchLength, Done };
+    enum class OpState : uint8_t { Opcode, Length, BaseDelta, Add, Data };
+
+    bool fail(Error error);
+    bool parse_header();
+    bool lz_input(const uint8_t *data, size_t len);
+    bool lz_put(uint8_t byte);
+    bool lz_match();
+    bool lz_after_literals();
+    bool flush_window();
+    bool stream_output(const uint8_t *data, size_t len);
+    bool op_input(const uint8_t *data, size_t len);
+    bool op_varint(uint8_t byte, bool &complete);
+    bool op_start();
+    bool copy_base(uint32_t len);
+    bool add_base(const uint8_t *diff, size_t len);
+    bool write(const uint8_t *data, size_t len);
+
+    ImageIo &m_io;
+    Error m_error = Error::None;
+    uint8_t m_header_bytes[kHeaderSize] = {};
+    size_t m_header_len = 0;
+    Header m_header{};
+    uint32_t m_consumed = 0;
+    uint32_t m_produced = 0;
+
+    std::unique_ptr<uint8_t[]> m_window;
+    uint32_t m_window_mask = 0;
+    uint32_t m_window_pos = 0;
+    uint32_t m_flushed_pos = 0;
+    uint32_t m_unflushed = 0;
+    uint32_t m_stream_out = 0;
+    LzState m_lz_state = LzState::Token;
+    uint32_t m_literals = 0;
+    uint32_t m_match = 0;
+    uint32_t m_offset = 0;
+
+    OpState m_op_state = OpState::Opcode;
+    uint8_t m_opcode = 0;
+    uint32_t m_varint = 0;
+    uint8_t m_varint_shift = 0;
+    uint32_t m_op_len = 0;
+    uint32_t m_base_pos = 0;
+    uint8_t m_base[kBaseChunk] = {};
+};
+
+} // namespace ota_stream
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ota_stream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ota_stream {
+
+/**
+ * @brief ImageIo over buffers: the base is the "running" image and the
+ * output collects what the device would write to the inactive slot.
+ *
+ * Lets test/host/ota_stream_test.cpp check that a payload decodes to the
+ * exact target image, for any BDX block size.
+ */
+class MemoryImageIo : public ImageIo {
+public:
+    explicit MemoryImageIo(const std::vector<uint8_t> &base) : m_base(base) {}
+
+    bool begin(const Header &header) override
+    {
+        m_output.clear();
+        m_output.reserve(header.target_size);
+        return header.base_size <= m_base.size();
+    }
+
+    bool read_base(uint32_t offset, uint8_t *data, size_t len) override
+    {
+        if (offset > m_base.size() || len > m_base.size() - offset) {
+            return false;
+        }
+        memcpy(data, m_base.data() + offset, len);
+        ++m_base_reads;
+        return true;
+    }
+
+    bool write(const uint8_t *data, size_t len) override
+    {
+        m_output.insert(m_output.end(), data, data + len);
+        ++m_writes;
+        return true;
+    }
+
+    const std::vector<uint8_t> &output() const { return m_output; }
+    uint32_t base_reads() const { return m_base_reads; }
+    uint32_t writes() const { return m_writes; }
+
+private:
+    const std::vector<uint8_t> &m_base;
+    std::vector<uint8_t> m_output;
+    uint32_t m_base_reads = 0;
+    uint32_t m_writes = 0;
+};
+
+struct ApplyResult {
+    bool ok;
+    Error error;
+    size_t window;   // decoder RAM besides its fixed members
+    std::vector<uint8_t> image;
+};
+
+/**
+ * @brief Feeds @p payload to a Decoder in blocks of @p block bytes, as the
+ * OTA requestor would, and returns the decoded image.
+ */
+inline ApplyResult apply(const std::vector<uint8_t> &payload, const std::vector<uint8_t> &base, size_t block)
+{
+    MemoryImageIo io(base);
+    Decoder decoder(io);
+    ApplyResult result{false, Error::None, 0, {}};
+    block = block ? block : payload.size();
+    bool ok = true;
+    for (size_t offset = 0; ok && offset < payload.size(); offset += block) {
+        const size_t len = payload.size() - offset < block ? payload.size() - offset : block;
+        ok = decoder.feed(payload.data() + offset, len);
+        if (decoder.window_size() > result.window) {
+            result.window = decoder.window_size();
+        }
+    }
+    result.ok = ok && decoder.finish();
+    result.error = decoder.error();
+    result.image = io.output();
+    return result;
+}
+
+} // namespace ota_stream
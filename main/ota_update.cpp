@@ -0,0 +1,631 @@
+#include "ota_update.h"
+
+#include "ota_stream.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <mbedtls/sha256.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#include <app/clusters/ota-requestor/BDXDownloader.h>
+#include <app/clusters/ota-requestor/DefaultOTARequestor.h>
+#include <app/clusters/ota-requestor/DefaultOTARequestorStorage.h>
+#include <app/clusters/ota-requestor/ExtendedOTARequestorDriver.h>
+#include <app/server/Server.h>
+#include <lib/core/OTAImageHeader.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <platform/OTAImageProcessor.h>
+
+namespace ota_update {
+
+namespace {
+
+constexpr const char *TAG = "ota_update";
+constexpr uint32_t kTaskStackSize = 4096;
+constexpr UBaseType_t kTaskPriority = tskIDLE_PRIORITY + 2;
+constexpr UBaseType_t kQueueLength = 4;
+constexpr uint32_t kRestartDelayS = 2;
+
+enum class Job : uint8_t { Prepare, Block, Finalize, Abort, Apply };
+
+class SlotIo : public ota_stream::ImageIo {
+public:
+    void start(const esp_partition_t *slot)
+    {
+        m_slot = slot;
+        m_running = esp_ota_get_running_partition();
+        m_write_err = ESP_OK;
+    }
+
+    void stop()
+    {
+        if (m_hashing) {
+            mbedtls_sha256_free(&m_sha);
+            m_hashing = false;
+        }
+    }
+
+    const esp_partition_t *slot() const { return m_slot; }
+
+    /** Erases the slot for @p image_size bytes, or all of it when the size is 0. */
+    esp_err_t open(size_t image_size)
+    {
+        m_write_err = esp_ota_begin(m_slot, image_size ? image_size : OTA_SIZE_UNKNOWN, &m_handle);
+        m_open = m_write_err == ESP_OK;
+        return m_write_err;
+    }
+
+    esp_err_t write_raw(const uint8_t *data, size_t len)
+    {
+        m_write_err = esp_ota_write(m_handle, data, len);
+        return m_write_err;
+    }
+
+    esp_err_t end()
+    {
+        if (!m_open) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        m_open = false;
+        return esp_ota_end(m_handle);
+    }
+
+    void abort()
+    {
+        if (m_open) {
+            esp_ota_abort(m_handle);
+            m_open = false;
+        }
+    }
+
+    bool target_matches(const uint8_t (&expected)[32])
+    {
+        uint8_t digest[32];
+        const bool ok = m_hashing && mbedtls_sha256_finish(&m_sha, digest) == 0 &&
+                        memcmp(digest, expected, sizeof(digest)) == 0;
+        stop();
+        return ok;
+    }
+
+    esp_err_t write_err() const { return m_write_err; }
+
+    bool begin(const ota_stream::Header &header) override
+    {
+        if (header.kind == ota_stream::Kind::Delta && !base_matches(header)) {
+            return false;
+        }
+        mbedtls_sha256_init(&m_sha);
+        m_hashing = mbedtls_sha256_starts(&m_sha, 0) == 0;
+        return m_hashing && open(header.target_size) == ESP_OK;
+    }
+
+    bool read_base(uint32_t offset, uint8_t *data, size_t len) override
+    {
+        return esp_partition_read(m_running, offset, data, len) == ESP_OK;
+    }
+
+    bool write(const uint8_t *data, size_t len) override
+    {
+        return write_raw(data, len) == ESP_OK && mbedtls_sha256_update(&m_sha, data, len) == 0;
+    }
+
+private:
+    // Patching another build would write garbage; check before the slot is erased.
+    bool base_matches(const ota_stream::Header &header)
+    {
+        if (m_running == nullptr || header.base_size > m_running->size) {
+            ESP_LOGE(TAG, "Delta needs %" PRIu32 " bytes of base image; the running slot is smaller", header.base_size);
+            return false;
+        }
+        mbedtls_sha256_context sha;
+        mbedtls_sha256_init(&sha);
+        bool ok = mbedtls_sha256_starts(&sha, 0) == 0;
+        for (uint32_t offset = 0; ok && offset < header.base_size; offset += sizeof(m_chunk)) {
+            const size_t len = header.base_size - offset < sizeof(m_chunk) ? header.base_size - offset : sizeof(m_chunk);
+            ok = esp_partition_read(m_running, offset, m_chunk, len) == ESP_OK &&
+                 mbedtls_sha256_update(&sha, m_chunk, len) == 0;
+        }
+        uint8_t digest[32];
+        ok = ok && mbedtls_sha256_finish(&sha, digest) == 0;
+        mbedtls_sha256_free(&sha);
+        if (!ok || memcmp(digest, header.base_sha256, sizeof(digest)) != 0) {
+            ESP_LOGE(TAG, "Delta was built against another image than the one running (%s)", m_running->label);
+            return false;
+        }
+        return true;
+    }
+
+    const esp_partition_t *m_slot = nullptr;
+    const esp_partition_t *m_running = nullptr;
+    esp_ota_handle_t m_handle = 0;
+    bool m_open = false;
+    esp_err_t m_write_err = ESP_OK;
+    mbedtls_sha256_context m_sha{};
+    bool m_hashing = false;
+    uint8_t m_chunk[1024] = {};
+};
+
+// The BDXDownloader calls in on the CHIP task; every job goes to the ota
+// task, which reports back through ScheduleWork() with the esp_err_t as arg.
+class ImageProcessor : public chip::OTAImageProcessorInterface {
+public:
+    void SetOTADownloader(chip::OTADownloader *downloader) { m_downloader = downloader; }
+
+    CHIP_ERROR PrepareDownload() override
+    {
+        mParams.downloadedBytes = 0;
+        mParams.totalFileBytes = 0;
+        return post(Job::Prepare);
+    }
+
+    CHIP_ERROR Finalize() override { return post(Job::Finalize); }
+    CHIP_ERROR Apply() override { return post(Job::Apply); }
+    CHIP_ERROR Abort() override { return post(Job::Abort); }
+
+    CHIP_ERROR ProcessBlock(chip::ByteSpan &block) override
+    {
+        // The downloader sends the next block only after FetchNextData(), so one buffer is enough.
+        if (block.size() > m_capacity) {
+            m_block.reset(new (std::nothrow) uint8_t[block.size()]);
+            m_capacity = m_block ? block.size() : 0;
+            if (!m_block) {
+                return CHIP_ERROR_NO_MEMORY;
+            }
+        }
+        memcpy(m_block.get(), block.data(), block.size());
+        m_block_len = block.size();
+        return post(Job::Block);
+    }
+
+    bool IsFirstImageRun() override
+    {
+        chip::OTARequestorInterface *requestor = chip::GetRequestorInstance();
+        return requestor != nullptr &&
+               requestor->GetCurrentUpdateState() == chip::OTARequestorInterface::OTAUpdateStateEnum::kApplying;
+    }
+
+    CHIP_ERROR ConfirmCurrentImage() override
+    {
+        chip::OTARequestorInterface *requestor = chip::GetRequestorInstance();
+        if (requestor == nullptr) {
+            return CHIP_ERROR_INTERNAL;
+        }
+        uint32_t version = 0;
+        ReturnErrorOnFailure(chip::DeviceLayer::ConfigurationMgr().GetSoftwareVersion(version));
+        return version == requestor->GetTargetVersion() ? CHIP_NO_ERROR : CHIP_ERROR_INCORRECT_STATE;
+    }
+
+    chip::ByteSpan block() const { return chip::ByteSpan(m_block.get(), m_block_len); }
+
+    void on_prepared(esp_err_t err);
+    void on_block_done(esp_err_t err, uint64_t image_size);
+
+private:
+    CHIP_ERROR post(Job job);
+
+    chip::OTADownloader *m_downloader = nullptr;
+    std::unique_ptr<uint8_t[]> m_block;
+    size_t m_capacity = 0;
+    size_t m_block_len = 0;
+};
+
+QueueHandle_t s_jobs = nullptr;
+ImageProcessor s_processor;
+chip::DefaultOTARequestor s_requestor;
+chip::DefaultOTARequestorStorage s_storage;
+chip::DeviceLayer::ExtendedOTARequestorDriver s_driver;
+chip::BDXDownloader s_downloader;
+bool s_requestor_started = false;
+
+// Owned by the ota task.
+SlotIo s_io;
+ota_stream::Decoder s_decoder(s_io);
+chip::OTAImageHeaderParser s_header_parser;
+uint8_t s_lead[sizeof(ota_stream::kMagic)] = {};
+size_t s_lead_len = 0;
+uint64_t s_image_size = 0;
+bool s_active = false;
+int64_t s_started_us = 0;
+
+portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+Stats s_stats = {Format::None, 0, 0, 0, 0, ESP_ERR_NOT_FINISHED};
+bool s_downloading = false;
+
+CHIP_ERROR to_chip(esp_err_t err)
+{
+    switch (err) {
+    case ESP_OK:
+        return CHIP_NO_ERROR;
+    case ESP_ERR_NO_MEM:
+        return CHIP_ERROR_NO_MEMORY;
+    case ESP_ERR_NOT_FOUND:
+        return CHIP_ERROR_NOT_FOUND;
+    case ESP_ERR_OTA_VALIDATE_FAILED:
+        return CHIP_ERROR_INTEGRITY_CHECK_FAILED;
+    default:
+        return CHIP_ERROR_WRITE_FAILED;
+    }
+}
+
+Format format()
+{
+    portENTER_CRITICAL(&s_lock);
+    const Format current = s_stats.format;
+    portEXIT_CRITICAL(&s_lock);
+    return current;
+}
+
+void release()
+{
+    s_decoder.reset();
+    s_io.stop();
+    s_header_parser.Clear();
+    s_active = false;
+}
+
+void finish_stats(esp_err_t result)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_stats.result = result;
+    s_downloading = false;
+    s_stats.elapsed_ms = static_cast<uint32_t>((esp_timer_get_time() - s_started_us) / 1000);
+    if (s_stats.format == Format::Compressed || s_stats.format == Format::Delta) {
+        s_stats.written = s_decoder.produced();
+    }
+    const Stats stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "%s image: %" PRIu32 " bytes received, %" PRIu32 " written in %" PRIu32 " ms: %s", name(stats.format),
+             stats.received, stats.written, stats.elapsed_ms, esp_err_to_name(result));
+}
+
+esp_err_t decoder_error()
+{
+    const ota_stream::Error error = s_decoder.error();
+    ESP_LOGE(TAG, "OTA payload: %s after %" PRIu32 " bytes", ota_stream::Decoder::name(error), s_decoder.consumed());
+    switch (error) {
+    case ota_stream::Error::NoMemory:
+        return ESP_ERR_NO_MEM;
+    case ota_stream::Error::Write:
+        return s_io.write_err() != ESP_OK ? s_io.write_err() : ESP_FAIL;
+    default:
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+}
+
+esp_err_t prepare()
+{
+    if (s_active) {
+        ESP_LOGW(TAG, "New OTA started before the previous one ended; dropping its state.");
+        s_io.abort();
+        release();
+    }
+    const esp_partition_t *slot = esp_ota_get_next_update_partition(nullptr);
+    if (slot == nullptr) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_io.start(slot);
+    s_header_parser.Init();
+    s_lead_len = 0;
+    s_image_size = 0;
+    s_active = true;
+    s_started_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    s_stats = {Format::None, 0, 0, 0, 0, ESP_ERR_NOT_FINISHED};
+    s_downloading = true;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t write_payload(const uint8_t *data, size_t len)
+{
+    if (format() == Format::Raw) {
+        const esp_err_t err = s_io.write_raw(data, len);
+        if (err == ESP_OK) {
+            portENTER_CRITICAL(&s_lock);
+            s_stats.written += static_cast<uint32_t>(len);
+            portEXIT_CRITICAL(&s_lock);
+        }
+        return err;
+    }
+    const bool ok = s_decoder.feed(data, len);
+    if (s_decoder.has_header()) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.format = s_decoder.header().kind == ota_stream::Kind::Delta ? Format::Delta : Format::Compressed;
+        if (s_decoder.window_size() > s_stats.window) {
+            s_stats.window = s_decoder.window_size();
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return ok ? ESP_OK : decoder_error();
+}
+
+esp_err_t on_payload(const uint8_t *data, size_t len)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_stats.received += static_cast<uint32_t>(len);
+    portEXIT_CRITICAL(&s_lock);
+    if (format() == Format::None) {
+        // Blocks can split the magic; hold the first bytes until it is all in.
+        const size_t take = len < sizeof(s_lead) - s_lead_len ? len : sizeof(s_lead) - s_lead_len;
+        memcpy(s_lead + s_lead_len, data, take);
+        s_lead_len += take;
+        data += take;
+        len -= take;
+        if (s_lead_len < sizeof(s_lead)) {
+            return ESP_OK;
+        }
+        const bool payload = ota_stream::Decoder::is_payload(s_lead, s_lead_len);
+        portENTER_CRITICAL(&s_lock);
+        s_stats.format = payload ? Format::Compressed : Format::Raw;
+        portEXIT_CRITICAL(&s_lock);
+        if (!payload) {
+            // Raw app images keep the stock path; esp_ota_end() rejects anything else.
+            const esp_err_t err = s_io.open(static_cast<size_t>(s_image_size));
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        const esp_err_t err = write_payload(s_lead, s_lead_len);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return len ? write_payload(data, len) : ESP_OK;
+}
+
+esp_err_t on_block(chip::ByteSpan block)
+{
+    if (s_header_parser.IsInitialized()) {
+        chip::OTAImageHeader header;
+        const CHIP_ERROR err = s_header_parser.AccumulateAndDecode(block, header);
+        if (err == CHIP_ERROR_BUFFER_TOO_SMALL) {
+            return ESP_OK;
+        }
+        if (err != CHIP_NO_ERROR) {
+            ESP_LOGE(TAG, "Bad Matter OTA header: %" CHIP_ERROR_FORMAT, err.Format());
+            return ESP_ERR_OTA_VALIDATE_FAILED;
+        }
+        s_image_size = header.mPayloadSize;
+        s_header_parser.Clear();
+    }
+    return block.empty() ? ESP_OK : on_payload(block.data(), block.size());
+}
+
+esp_err_t finalize()
+{
+    esp_err_t err = ESP_OK;
+    const Format current = format();
+    if (current == Format::None) {
+        ESP_LOGE(TAG, "Image ended before its first bytes were in");
+        err = ESP_ERR_OTA_VALIDATE_FAILED;
+    } else if (current != Format::Raw) {
+        if (!s_decoder.finish()) {
+            err = decoder_error();
+        } else if (!s_io.target_matches(s_decoder.header().target_sha256)) {
+            ESP_LOGE(TAG, "Written image does not match the payload's SHA-256");
+            err = ESP_ERR_OTA_VALIDATE_FAILED;
+        }
+    }
+    if (err == ESP_OK) {
+        err = s_io.end();
+    } else {
+        // esp_ota_end() would free the handle; abort does the same without validating.
+        s_io.abort();
+    }
+    finish_stats(err);
+    release();
+    return err;
+}
+
+void restart_timer(chip::System::Layer *, void *)
+{
+    esp_restart();
+}
+
+void restart_work(intptr_t)
+{
+    // Give the requestor time to persist its state and report Applying.
+    chip::DeviceLayer::SystemLayer().StartTimer(chip::System::Clock::Seconds32(kRestartDelayS), restart_timer, nullptr);
+}
+
+esp_err_t apply()
+{
+    const Stats stats = last();
+    if (stats.result != ESP_OK) {
+        ESP_LOGE(TAG, "Not applying: the last image failed (%s)", esp_err_to_name(stats.result));
+        return stats.result;
+    }
+    const esp_err_t err = esp_ota_set_boot_partition(s_io.slot());
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to boot from %s: %s", s_io.slot()->label, esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Applying the image in %s; restarting in %" PRIu32 " s", s_io.slot()->label, kRestartDelayS);
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(restart_work, 0);
+    return ESP_OK;
+}
+
+void prepared_work(intptr_t err)
+{
+    s_processor.on_prepared(static_cast<esp_err_t>(err));
+}
+
+void block_done_work(intptr_t err)
+{
+    s_processor.on_block_done(static_cast<esp_err_t>(err), s_image_size);
+}
+
+void ota_task(void *)
+{
+    Job job;
+    for (;;) {
+        if (xQueueReceive(s_jobs, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        switch (job) {
+        case Job::Prepare:
+            chip::DeviceLayer::PlatformMgr().ScheduleWork(prepared_work, static_cast<intptr_t>(prepare()));
+            break;
+        case Job::Block: {
+            esp_err_t err = s_active ? on_block(s_processor.block()) : ESP_ERR_INVALID_STATE;
+            if (err != ESP_OK) {
+                s_io.abort();
+                finish_stats(err);
+                release();
+            }
+            chip::DeviceLayer::PlatformMgr().ScheduleWork(block_done_work, static_cast<intptr_t>(err));
+            break;
+        }
+        case Job::Finalize:
+            if (s_active) {
+                finalize();
+            }
+            break;
+        case Job::Abort:
+            if (s_active) {
+                s_io.abort();
+                finish_stats(ESP_FAIL);
+                release();
+            }
+            break;
+        case Job::Apply:
+            apply();
+            break;
+        }
+    }
+}
+
+void ImageProcessor::on_prepared(esp_err_t err)
+{
+    if (m_downloader != nullptr) {
+        m_downloader->OnPreparedForDownload(to_chip(err));
+    }
+}
+
+void ImageProcessor::on_block_done(esp_err_t err, uint64_t image_size)
+{
+    if (m_downloader == nullptr) {
+        return;
+    }
+    if (err != ESP_OK) {
+        m_downloader->EndDownload(to_chip(err));
+        return;
+    }
+    mParams.downloadedBytes += m_block_len;
+    mParams.totalFileBytes = image_size;
+    m_downloader->FetchNextData();
+}
+
+CHIP_ERROR ImageProcessor::post(Job job)
+{
+    if (s_jobs == nullptr || xQueueSend(s_jobs, &job, 0) != pdTRUE) {
+        ESP_LOGE(TAG, "OTA task unavailable");
+        return CHIP_ERROR_INCORRECT_STATE;
+    }
+    return CHIP_NO_ERROR;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t ota_command(int, char **)
+{
+    print();
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+void init()
+{
+    s_jobs = xQueueCreate(kQueueLength, sizeof(Job));
+    if (s_jobs == nullptr ||
+        xTaskCreate(ota_task, "ota", kTaskStackSize, nullptr, kTaskPriority, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the OTA task; OTA updates are disabled.");
+        return;
+    }
+    // esp_matter_ota_requestor_start() leaves an instance already set alone.
+    chip::SetRequestorInstance(&s_requestor);
+}
+
+void on_device_event(const chip::DeviceLayer::ChipDeviceEvent &event)
+{
+    if (event.Type != chip::DeviceLayer::DeviceEventType::kServerReady || s_requestor_started || s_jobs == nullptr) {
+        return;
+    }
+    s_requestor_started = true;
+    chip::Server &server = chip::Server::GetInstance();
+    s_storage.Init(server.GetPersistentStorage());
+    s_requestor.Init(server, s_storage, s_driver, s_downloader);
+    s_processor.SetOTADownloader(&s_downloader);
+    s_downloader.SetImageProcessorDelegate(&s_processor);
+    s_driver.Init(&s_requestor, &s_processor);
+}
+
+Stats last()
+{
+    portENTER_CRITICAL(&s_lock);
+    const Stats copy = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+    return copy;
+}
+
+const char *name(Format format)
+{
+    switch (format) {
+    case Format::None:
+        return "none";
+    case Format::Raw:
+        return "raw";
+    case Format::Compressed:
+        return "compressed";
+    case Format::Delta:
+        return "delta";
+    }
+    return "?";
+}
+
+void print()
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    portENTER_CRITICAL(&s_lock);
+    const Stats stats = s_stats;
+    const bool downloading = s_downloading;
+    portEXIT_CRITICAL(&s_lock);
+    printf("running=%s format=%s received=%" PRIu32 " written=%" PRIu32 " elapsed_ms=%" PRIu32 " window=%u result=%s\n",
+           running ? running->label : "?", name(stats.format), stats.received, stats.written, stats.elapsed_ms,
+           static_cast<unsigned>(stats.window),
+           downloading ? "in progress" : esp_err_to_name(stats.result));
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "ota",
+            .description = "Last OTA image: format, bytes received and written. Usage: matter esp ota",
+            .handler = ota_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace ota_update
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <esp_err.h>
+#include <platform/CHIPDeviceEvent.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ota_update {
+
+enum class Format : uint8_t { None, Raw, Compressed, Delta };
+
+struct Stats {
+    Format format;        // of the last image downloaded
+    uint32_t received;    // image bytes after the Matter OTA header
+    uint32_t written;     // bytes written to the inactive slot
+    uint32_t elapsed_ms;  // PrepareDownload() to Finalize()
+    size_t window;        // decoder window, freed once the image is complete
+    esp_err_t result;     // of esp_ota_end(); ESP_ERR_NOT_FINISHED while downloading
+};
+
+/*
+ * The OTA requestor's image processor. Besides raw app images it accepts
+ * the payloads of tools/ota_pack.py: a compressed image, or a delta against
+ * the running slot, expanded into the inactive slot through
+ * ota_stream::Decoder as blocks arrive. A delta is refused before anything
+ * is written unless the running slot hashes to the image it was built
+ * against, and the written image must match the SHA-256 in the payload
+ * header before esp_ota_end() is called.
+ *
+ * Blocks are handled on the "ota" task, so erasing, writing and hashing
+ * flash never hold up the CHIP task; the BDX transfer asks for the next
+ * block once the previous one is in the slot.
+ */
+
+/**
+ * @brief Creates the ota task and claims the requestor instance. Call
+ * before esp_matter::start(), so esp-matter's stock requestor stays unused.
+ */
+void init();
+
+/**
+ * @brief Feeds CHIP device events; call from app_event_cb. The requestor
+ * is started once the server is ready.
+ */
+void on_device_event(const chip::DeviceLayer::ChipDeviceEvent &event);
+
+Stats last();
+const char *name(Format format);
+void print();
+
+/** @brief Registers `matter esp ota`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace ota_update
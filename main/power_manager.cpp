@@ -0,0 +1,395 @@
+#include "power_manager.h"
+
+#include "generated_config.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+#if CONFIG_ENABLE_CHIP_SHELL
+#include "icd_sim.h" // `power estimate` runs the simulation on the device
+
+#include <esp_matter_console.h>
+#endif
+
+#include <platform/CHIPDeviceLayer.h>
+#if CHIP_CONFIG_ENABLE_ICD_SERVER
+#include <app/icd/server/ICDNotifier.h>
+#endif
+#if CHIP_DEVICE_CONFIG_ENABLE_WIFI_STATION
+#include <esp_wifi.h>
+#endif
+
+namespace power_manager {
+
+namespace {
+
+constexpr const char *TAG = "power";
+constexpr uint32_t kReferenceCapacityMah = 1000;
+constexpr size_t kHoldCount = static_cast<size_t>(Hold::Count);
+constexpr uint64_t kReportPeriodUs = 3600ULL * 1000 * 1000;
+
+// Average draw of an ESP32-C6 module at 3.3 V with the radio connected,
+// excluding the power supply and LED driver quiescent current. Awake is the
+// CPU idling without sleep; asleep is light sleep with periodic radio wakes.
+constexpr uint32_t kAwakeMw = 90;
+constexpr uint32_t kSleepMw = 6;
+
+constexpr icd::Estimator::Params kParams = {
+    .idle_interval_ms = generated_config::power::idle_interval_ms,
+    .active_interval_ms = generated_config::power::active_interval_ms,
+    .active_threshold_ms = generated_config::power::active_threshold_ms,
+    .slow_poll_ms = generated_config::power::slow_poll_ms,
+    .fast_poll_ms = generated_config::power::fast_poll_ms,
+};
+
+struct HoldState {
+    uint32_t count;
+    uint32_t acquisitions;
+    uint64_t held_us;
+    uint64_t since_us;
+};
+
+portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+icd::Estimator s_estimator(kParams, 0);
+HoldState s_holds[kHoldCount] = {};
+uint32_t s_active_holds = 0;
+bool s_output_on = false;
+uint64_t s_accounted_us = 0;
+uint64_t s_standby_us = 0;
+uint64_t s_sleep_eligible_us = 0;
+esp_timer_handle_t s_report_timer = nullptr;
+
+#if CONFIG_PM_ENABLE
+esp_pm_lock_handle_t s_pm_locks[kHoldCount] = {};
+#endif
+
+uint32_t now_ms()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+// Caller holds s_lock.
+void account(uint64_t now_us)
+{
+    const uint64_t elapsed_us = now_us - s_accounted_us;
+    s_accounted_us = now_us;
+    if (s_holds[static_cast<size_t>(Hold::Output)].count == 0) {
+        s_standby_us += elapsed_us;
+        if (s_active_holds == 0) {
+            s_sleep_eligible_us += elapsed_us;
+        }
+    }
+}
+
+#if CHIP_CONFIG_ENABLE_ICD_SERVER
+// Runs on the CHIP task.
+void notify_activity(intptr_t)
+{
+    chip::app::ICDNotifier::GetInstance().NotifyNetworkActivityNotification();
+}
+#endif
+
+void report_cb(void *)
+{
+    const StandbyReport r = standby_report();
+    const uint32_t eligible_pct = r.standby_us ? static_cast<uint32_t>(r.sleep_eligible_us * 100 / r.standby_us) : 0;
+    ESP_LOGI(TAG, "standby %" PRIu64 " of %" PRIu64 " s, %" PRIu32 "%% sleep-eligible, ~%" PRIu32 " mW (budget %" PRIu32 " mW)",
+             r.standby_us / 1000000, r.uptime_us / 1000000, eligible_pct, r.estimated_mw, r.budget_mw);
+}
+
+void print_estimate(const char *label, const icd::Estimate &e)
+{
+    const uint32_t hours = icd::battery_life_hours(kReferenceCapacityMah, e.average_ua);
+    printf("%s: avg %" PRIu32 " uA, active %" PRIu32 ".%" PRIu32 "%%, %" PRIu32 " days per %" PRIu32 " mAh\n",
+           label, e.average_ua, e.active_permille / 10, e.active_permille % 10, hours / 24, kReferenceCapacityMah);
+    printf("  polls=%" PRIu32 " check_ins=%" PRIu32 " user_events=%" PRIu32 "\n",
+           e.totals.polls, e.totals.check_ins, e.totals.user_events);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t power_command(int argc, char **argv)
+{
+    if (argc > 0 && strcmp(argv[0], "estimate") == 0) {
+        if (argc < 2) {
+            printf("Usage: matter esp power estimate <presses_per_hour> [hours]\n");
+            return ESP_ERR_INVALID_ARG;
+        }
+        const uint32_t presses = static_cast<uint32_t>(strtoul(argv[1], nullptr, 10));
+        const uint32_t hours = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 24;
+        print_estimate("simulated", icd::simulate(kParams, icd::CurrentProfile{}, presses, hours ? hours : 1));
+        return ESP_OK;
+    }
+    print();
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+esp_err_t init()
+{
+    portENTER_CRITICAL(&s_lock);
+    s_estimator = icd::Estimator(kParams, now_ms());
+    s_accounted_us = static_cast<uint64_t>(esp_timer_get_time());
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!light_sleep()) {
+        return ESP_OK;
+    }
+#if CONFIG_PM_ENABLE
+    // Rendering runs at full clock; the other holds only block light sleep
+    // and let the CPU scale down while the light is on.
+    static constexpr esp_pm_lock_type_t kLockTypes[kHoldCount] = {
+        ESP_PM_NO_LIGHT_SLEEP,
+        ESP_PM_CPU_FREQ_MAX,
+        ESP_PM_NO_LIGHT_SLEEP,
+    };
+    for (size_t idx = 0; idx < kHoldCount; ++idx) {
+        esp_err_t err = esp_pm_lock_create(kLockTypes[idx], 0, name(static_cast<Hold>(idx)), &s_pm_locks[idx]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create PM lock %s: %s", name(static_cast<Hold>(idx)), esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    const esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true,
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable light sleep: %s", esp_err_to_name(err));
+        return err;
+    }
+    if (battery()) {
+        ESP_LOGI(TAG, "Battery profile: light sleep on, idle %" PRIu32 " s, slow poll %" PRIu32 " ms.",
+                 kParams.idle_interval_ms / 1000, kParams.slow_poll_ms);
+    } else {
+        ESP_LOGI(TAG, "Light sleep enabled while all outputs are off.");
+    }
+    return ESP_OK;
+#else
+    ESP_LOGW(TAG, "Light sleep requested without CONFIG_PM_ENABLE; the chip will not sleep.");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t start()
+{
+    if (!light_sleep()) {
+        return ESP_OK;
+    }
+#if CHIP_DEVICE_CONFIG_ENABLE_WIFI_STATION
+    // Light sleep needs the station to sleep between DTIM beacons.
+    esp_err_t err = esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to enable Wi-Fi modem sleep: %s", esp_err_to_name(err));
+    }
+#endif
+    if (s_report_timer) {
+        return ESP_OK;
+    }
+    const esp_timer_create_args_t args = {
+        .callback = report_cb,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "standby_report",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t timer_err = esp_timer_create(&args, &s_report_timer);
+    if (timer_err == ESP_OK) {
+        timer_err = esp_timer_start_periodic(s_report_timer, kReportPeriodUs);
+    }
+    return timer_err;
+}
+
+bool battery()
+{
+    return generated_config::power::battery;
+}
+
+bool light_sleep()
+{
+    return generated_config::power::light_sleep;
+}
+
+void acquire(Hold hold)
+{
+    const size_t idx = static_cast<size_t>(hold);
+    const uint64_t now_us = static_cast<uint64_t>(esp_timer_get_time());
+    portENTER_CRITICAL(&s_lock);
+    account(now_us);
+    HoldState &state = s_holds[idx];
+    if (state.count++ == 0) {
+        state.since_us = now_us;
+        ++state.acquisitions;
+        ++s_active_holds;
+    }
+    portEXIT_CRITICAL(&s_lock);
+#if CONFIG_PM_ENABLE
+    if (s_pm_locks[idx]) {
+        esp_pm_lock_acquire(s_pm_locks[idx]);
+    }
+#endif
+}
+
+void release(Hold hold)
+{
+    const size_t idx = static_cast<size_t>(hold);
+    const uint64_t now_us = static_cast<uint64_t>(esp_timer_get_time());
+    bool held = false;
+    portENTER_CRITICAL(&s_lock);
+    account(now_us);
+    HoldState &state = s_holds[idx];
+    if (state.count > 0) {
+        held = true;
+        if (--state.count == 0) {
+            state.held_us += now_us - state.since_us;
+            --s_active_holds;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+#if CONFIG_PM_ENABLE
+    if (held && s_pm_locks[idx]) {
+        esp_pm_lock_release(s_pm_locks[idx]);
+    }
+#else
+    (void)held;
+#endif
+}
+
+void set_output_on(bool on)
+{
+    portENTER_CRITICAL(&s_lock);
+    const bool changed = s_output_on != on;
+    s_output_on = on;
+    portEXIT_CRITICAL(&s_lock);
+    if (!changed) {
+        return;
+    }
+    if (on) {
+        acquire(Hold::Output);
+    } else {
+        release(Hold::Output);
+    }
+}
+
+void on_user_activity()
+{
+    if (!battery()) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_estimator.user_event(now_ms());
+    portEXIT_CRITICAL(&s_lock);
+#if CHIP_CONFIG_ENABLE_ICD_SERVER
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(notify_activity, 0);
+#endif
+}
+
+HoldStats hold_stats(Hold hold)
+{
+    const uint64_t now_us = static_cast<uint64_t>(esp_timer_get_time());
+    portENTER_CRITICAL(&s_lock);
+    const HoldState state = s_holds[static_cast<size_t>(hold)];
+    portEXIT_CRITICAL(&s_lock);
+    return {state.acquisitions, state.held_us + (state.count ? now_us - state.since_us : 0)};
+}
+
+StandbyReport standby_report()
+{
+    const uint64_t now_us = static_cast<uint64_t>(esp_timer_get_time());
+    portENTER_CRITICAL(&s_lock);
+    account(now_us);
+    StandbyReport r = {now_us, s_standby_us, light_sleep() ? s_sleep_eligible_us : 0, 0,
+                       generated_config::power::standby_budget_mw};
+    portEXIT_CRITICAL(&s_lock);
+    if (r.standby_us) {
+        const uint64_t awake_us = r.standby_us - r.sleep_eligible_us;
+        r.estimated_mw = static_cast<uint32_t>((r.sleep_eligible_us * kSleepMw + awake_us * kAwakeMw) / r.standby_us);
+    }
+    return r;
+}
+
+const char *name(Hold hold)
+{
+    switch (hold) {
+    case Hold::Output:
+        return "output";
+    case Hold::Render:
+        return "render";
+    case Hold::Button:
+        return "button";
+    default:
+        return "unknown";
+    }
+}
+
+icd::Estimate estimate()
+{
+    portENTER_CRITICAL(&s_lock);
+    s_estimator.advance(now_ms());
+    const icd::Estimator copy = s_estimator;
+    portEXIT_CRITICAL(&s_lock);
+    return icd::estimate(copy, icd::CurrentProfile{});
+}
+
+void print()
+{
+    const StandbyReport r = standby_report();
+    printf("light sleep %s; standby %" PRIu64 " of %" PRIu64 " s, sleep-eligible %" PRIu64 " s\n",
+           light_sleep() ? "enabled" : "disabled", r.standby_us / 1000000, r.uptime_us / 1000000,
+           r.sleep_eligible_us / 1000000);
+    printf("standby estimate ~%" PRIu32 " mW, budget %" PRIu32 " mW%s\n", r.estimated_mw, r.budget_mw,
+           r.estimated_mw > r.budget_mw ? " (over budget)" : "");
+    for (size_t idx = 0; idx < kHoldCount; ++idx) {
+        const HoldStats s = hold_stats(static_cast<Hold>(idx));
+        printf("  hold %-7s taken=%" PRIu32 " held=%" PRIu64 " ms\n", name(static_cast<Hold>(idx)), s.acquisitions,
+               s.held_us / 1000);
+    }
+#if CONFIG_PM_PROFILING
+    esp_pm_dump_locks(stdout);
+#endif
+
+    if (!battery()) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_estimator.advance(now_ms());
+    const icd::Mode mode = s_estimator.mode();
+    const uint32_t poll_ms = s_estimator.poll_period_ms();
+    portEXIT_CRITICAL(&s_lock);
+
+    printf("ICD model %s, poll every %" PRIu32 " ms (idle %" PRIu32 " s, active %" PRIu32 " ms, threshold %" PRIu32 " ms)\n",
+           icd::Estimator::name(mode), poll_ms, kParams.idle_interval_ms / 1000, kParams.active_interval_ms,
+           kParams.active_threshold_ms);
+    print_estimate("since boot", estimate());
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "power",
+            .description = "Standby budget, PM holds and ICD estimate. Usage: matter esp power [estimate <presses/h> [hours]]",
+            .handler = power_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace power_manager
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "icd_estimator.h"
+
+#include <esp_err.h>
+
+#include <cstdint>
+
+namespace power_manager {
+
+/**
+ * @brief Reasons the firmware keeps the chip out of light sleep.
+ *
+ * Output is held while any LED output is on, so light sleep only happens in
+ * standby. Render covers driver updates and animations; Button covers a
+ * gesture that is still being classified.
+ */
+enum class Hold : uint8_t { Output, Render, Button, Count };
+
+struct HoldStats {
+    uint32_t acquisitions;
+    uint64_t held_us;
+};
+
+struct StandbyReport {
+    uint64_t uptime_us;
+    uint64_t standby_us;         // time with every output off
+    uint64_t sleep_eligible_us;  // standby time with no hold taken
+    uint32_t estimated_mw;       // average standby draw of the module
+    uint32_t budget_mw;
+};
+
+/**
+ * @brief Enables automatic light sleep when the YAML asks for it.
+ *
+ * Call before the drivers are initialised. `power.light_sleep: true` (implied
+ * by `power.source: battery`) turns on tickless idle and automatic light
+ * sleep; without it every hold below is a no-op apart from its statistics.
+ * The battery profile additionally runs the node as a Thread sleepy end
+ * device with ICD check-in.
+ */
+esp_err_t init();
+
+/** @brief Enables Wi-Fi modem sleep and the hourly standby report. Call after esp_matter::start(). */
+esp_err_t start();
+
+/** True when the YAML selected the battery profile. */
+bool battery();
+
+/** True when automatic light sleep is configured. */
+bool light_sleep();
+
+/** Counted: every acquire() needs a matching release(). Safe from any task. */
+void acquire(Hold hold);
+void release(Hold hold);
+
+/** Holds or drops Output when the light turns on or off; repeated calls are ignored. */
+void set_output_on(bool on);
+
+class Scope {
+public:
+    explicit Scope(Hold hold) : m_hold(hold) { acquire(hold); }
+    ~Scope() { release(m_hold); }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    Hold m_hold;
+};
+
+/**
+ * @brief Reports a button press; safe from any task.
+ *
+ * Puts the ICD in active mode so the resulting command and its ack are
+ * exchanged at the fast poll rate instead of waiting for the next slow poll.
+ */
+void on_user_activity();
+
+HoldStats hold_stats(Hold hold);
+StandbyReport standby_report();
+const char *name(Hold hold);
+
+/** Live ICD timeline and the average current it implies with the default profile. */
+icd::Estimate estimate();
+void print();
+
+/** @brief Registers `matter esp power [estimate <presses/h> [hours]]`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace power_manager
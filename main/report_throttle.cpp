@@ -0,0 +1,317 @@
+#include "report_throttle.h"
+
+#include "generated_config.h"
+
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <type_traits>
+
+#include <esp_log.h>
+#include <esp_matter_attribute_utils.h>
+#include <esp_matter_core.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#include <app/ConcreteAttributePath.h>
+#include <app/reporting/reporting.h>
+#include <lib/core/DataModelTypes.h>
+#include <platform/CHIPDeviceLayer.h>
+
+// Every attribute change, whether from attribute::update() or from a CHIP
+// cluster server such as a LevelControl transition, ends in one of these two
+// overloads. CMakeLists.txt wraps both mangled names (EndpointId, ClusterId,
+// AttributeId with ESP-IDF's uint32_t being unsigned long), since --wrap does
+// not see the path overload calling the other one inside reporting.cpp.
+// tools/check_wraps.py fails the build if anything else still calls them.
+static_assert(std::is_same_v<chip::EndpointId, unsigned short> && std::is_same_v<chip::ClusterId, unsigned long> &&
+                  std::is_same_v<chip::AttributeId, unsigned long>,
+              "update the --wrap symbols in main/CMakeLists.txt");
+static_assert(std::is_same_v<decltype(static_cast<void (*)(chip::EndpointId, chip::ClusterId, chip::AttributeId)>(
+                                 &MatterReportingAttributeChangeCallback)),
+                             void (*)(chip::EndpointId, chip::ClusterId, chip::AttributeId)>);
+static_assert(std::is_same_v<decltype(static_cast<void (*)(const chip::app::ConcreteAttributePath &)>(
+                                 &MatterReportingAttributeChangeCallback)),
+                             void (*)(const chip::app::ConcreteAttributePath &)>);
+
+void real_report_change(chip::EndpointId, chip::ClusterId, chip::AttributeId) __asm__(
+    "__real__Z38MatterReportingAttributeChangeCallbacktmm");
+
+namespace report_throttle {
+
+namespace {
+
+constexpr const char *TAG = "report_throttle";
+constexpr size_t kMaxEndpoints = 8;
+constexpr size_t kMaxTracked = 24;
+
+using Policy = generated_config::reporting::policy_t;
+
+struct Tracked {
+    uint16_t endpoint_id;
+    uint8_t policy;
+    bool used;
+    bool pending;
+    int64_t reported_value;
+    uint32_t reported_ms;
+    uint32_t flush_at_ms;
+};
+
+// Only touched on the CHIP task (or with the CHIP lock held).
+std::array<uint16_t, kMaxEndpoints> s_endpoints = {};
+size_t s_endpoint_count = 0;
+std::array<Tracked, kMaxTracked> s_tracked = {};
+Stats s_stats = {};
+
+uint32_t now_ms()
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+bool is_tracked_endpoint(uint16_t endpoint_id)
+{
+    for (size_t idx = 0; idx < s_endpoint_count; ++idx) {
+        if (s_endpoints[idx] == endpoint_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int find_policy(uint32_t cluster_id, uint32_t attribute_id)
+{
+    for (size_t idx = 0; idx < generated_config::reporting::count; ++idx) {
+        const Policy &policy = generated_config::reporting::policies[idx];
+        if (policy.cluster_id == cluster_id && policy.attribute_id == attribute_id) {
+            return static_cast<int>(idx);
+        }
+    }
+    return -1;
+}
+
+Tracked *slot_for(uint16_t endpoint_id, uint8_t policy)
+{
+    Tracked *free_slot = nullptr;
+    for (Tracked &tracked : s_tracked) {
+        if (tracked.used && tracked.endpoint_id == endpoint_id && tracked.policy == policy) {
+            return &tracked;
+        }
+        if (!tracked.used && !free_slot) {
+            free_slot = &tracked;
+        }
+    }
+    if (free_slot) {
+        *free_slot = {endpoint_id, policy, false, false, 0, 0, 0};
+    }
+    return free_slot;
+}
+
+bool read_value(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, int64_t &out)
+{
+    esp_matter::attribute_t *attribute = esp_matter::attribute::get(endpoint_id, cluster_id, attribute_id);
+    esp_matter_attr_val_t val = esp_matter_invalid(nullptr);
+    if (!attribute || esp_matter::attribute::get_val(attribute, &val) != ESP_OK) {
+        return false;
+    }
+    // Nullable types share the storage of their base type.
+    switch (static_cast<esp_matter_val_type_t>(val.type & ~ESP_MATTER_VAL_NULLABLE_BASE)) {
+    case ESP_MATTER_VAL_TYPE_BOOLEAN:
+        out = val.val.b;
+        return true;
+    case ESP_MATTER_VAL_TYPE_UINT8:
+    case ESP_MATTER_VAL_TYPE_ENUM8:
+    case ESP_MATTER_VAL_TYPE_BITMAP8:
+        out = val.val.u8;
+        return true;
+    case ESP_MATTER_VAL_TYPE_INT8:
+        out = val.val.i8;
+        return true;
+    case ESP_MATTER_VAL_TYPE_UINT16:
+    case ESP_MATTER_VAL_TYPE_ENUM16:
+    case ESP_MATTER_VAL_TYPE_BITMAP16:
+        out = val.val.u16;
+        return true;
+    case ESP_MATTER_VAL_TYPE_INT16:
+        out = val.val.i16;
+        return true;
+    case ESP_MATTER_VAL_TYPE_UINT32:
+    case ESP_MATTER_VAL_TYPE_BITMAP32:
+        out = val.val.u32;
+        return true;
+    case ESP_MATTER_VAL_TYPE_INT32:
+        out = val.val.i32;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void report(Tracked &tracked, int64_t value, uint32_t now)
+{
+    const Policy &policy = generated_config::reporting::policies[tracked.policy];
+    tracked.pending = false;
+    tracked.reported_value = value;
+    tracked.reported_ms = now;
+    real_report_change(tracked.endpoint_id, policy.cluster_id, policy.attribute_id);
+}
+
+void flush_timer_cb(chip::System::Layer *, void *);
+
+void arm_flush_timer(uint32_t now)
+{
+    bool any = false;
+    uint32_t earliest_ms = 0;
+    for (const Tracked &tracked : s_tracked) {
+        if (tracked.used && tracked.pending &&
+            (!any || static_cast<int32_t>(tracked.flush_at_ms - earliest_ms) < 0)) {
+            earliest_ms = tracked.flush_at_ms;
+            any = true;
+        }
+    }
+    if (!any) {
+        chip::DeviceLayer::SystemLayer().CancelTimer(flush_timer_cb, nullptr);
+        return;
+    }
+    const int32_t delay_ms = static_cast<int32_t>(earliest_ms - now);
+    chip::DeviceLayer::SystemLayer().StartTimer(
+        chip::System::Clock::Milliseconds32(delay_ms > 0 ? static_cast<uint32_t>(delay_ms) : 0), flush_timer_cb,
+        nullptr);
+}
+
+// Runs on the CHIP task.
+void flush_timer_cb(chip::System::Layer *, void *)
+{
+    const uint32_t now = now_ms();
+    for (Tracked &tracked : s_tracked) {
+        if (!tracked.used || !tracked.pending || static_cast<int32_t>(now - tracked.flush_at_ms) < 0) {
+            continue;
+        }
+        const Policy &policy = generated_config::reporting::policies[tracked.policy];
+        int64_t value = 0;
+        if (!read_value(tracked.endpoint_id, policy.cluster_id, policy.attribute_id, value)) {
+            tracked.pending = false;
+            continue;
+        }
+        if (value == tracked.reported_value) {
+            // The fade came back to the value subscribers already have.
+            tracked.pending = false;
+            continue;
+        }
+        ++s_stats.flushed;
+        report(tracked, value, now);
+    }
+    arm_flush_timer(now);
+}
+
+void on_attribute_changed(chip::EndpointId endpoint_id, chip::ClusterId cluster_id, chip::AttributeId attribute_id)
+{
+    const int policy_index = is_tracked_endpoint(endpoint_id) ? find_policy(cluster_id, attribute_id) : -1;
+    int64_t value = 0;
+    if (policy_index < 0 || !read_value(endpoint_id, cluster_id, attribute_id, value)) {
+        real_report_change(endpoint_id, cluster_id, attribute_id);
+        return;
+    }
+    Tracked *tracked = slot_for(endpoint_id, static_cast<uint8_t>(policy_index));
+    if (!tracked) {
+        ++s_stats.untracked;
+        real_report_change(endpoint_id, cluster_id, attribute_id);
+        return;
+    }
+
+    const Policy &policy = generated_config::reporting::policies[policy_index];
+    const uint32_t now = now_ms();
+    const int64_t delta = value >= tracked->reported_value ? value - tracked->reported_value
+                                                           : tracked->reported_value - value;
+    const bool interval_passed = now - tracked->reported_ms >= policy.min_interval_ms;
+    if (!tracked->used || (interval_passed && delta >= policy.threshold)) {
+        tracked->used = true;
+        ++s_stats.passed;
+        report(*tracked, value, now);
+        arm_flush_timer(now);
+        return;
+    }
+
+    ++s_stats.suppressed;
+    if (tracked->pending) {
+        // The deadline set by the first held change stands, so a fade that
+        // keeps moving still gets its trailing report.
+        return;
+    }
+    tracked->pending = true;
+    // Held by the interval: due when it ends. Held only by the threshold:
+    // one interval after this change, the first one held back.
+    tracked->flush_at_ms = (interval_passed ? now : tracked->reported_ms) + policy.min_interval_ms;
+    arm_flush_timer(now);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t reporting_command(int, char **)
+{
+    print();
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+void track_endpoint(uint16_t endpoint_id)
+{
+    if (generated_config::reporting::count == 0 || is_tracked_endpoint(endpoint_id)) {
+        return;
+    }
+    if (s_endpoint_count == kMaxEndpoints) {
+        ESP_LOGW(TAG, "Too many endpoints; reports of endpoint %u are not throttled.", endpoint_id);
+        return;
+    }
+    s_endpoints[s_endpoint_count++] = endpoint_id;
+}
+
+Stats stats()
+{
+    return s_stats;
+}
+
+void print()
+{
+    printf("passed=%" PRIu32 " suppressed=%" PRIu32 " flushed=%" PRIu32 " untracked=%" PRIu32 "\n",
+           s_stats.passed, s_stats.suppressed, s_stats.flushed, s_stats.untracked);
+    for (size_t idx = 0; idx < generated_config::reporting::count; ++idx) {
+        const Policy &policy = generated_config::reporting::policies[idx];
+        printf("  cluster 0x%04" PRIX32 " attribute 0x%04" PRIX32 ": min %" PRIu32 " ms, threshold %" PRIu32 "\n",
+               policy.cluster_id, policy.attribute_id, policy.min_interval_ms, policy.threshold);
+    }
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "reporting",
+            .description = "Attribute report throttling counters. Usage: matter esp reporting",
+            .handler = reporting_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace report_throttle
+
+extern "C" void __wrap__Z38MatterReportingAttributeChangeCallbacktmm(chip::EndpointId endpoint_id,
+                                                                      chip::ClusterId cluster_id,
+                                                                      chip::AttributeId attribute_id)
+{
+    report_throttle::on_attribute_changed(endpoint_id, cluster_id, attribute_id);
+}
+
+extern "C" void __wrap__Z38MatterReportingAttributeChangeCallbackRKN4chip3app21ConcreteAttributePathE(
+    const chip::app::ConcreteAttributePath &path)
+{
+    report_throttle::on_attribute_changed(path.mEndpointId, path.mClusterId, path.mAttributeId);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <esp_err.h>
+
+#include <cstdint>
+
+namespace report_throttle {
+
+struct Stats {
+    uint32_t passed;      // changes reported as they happened
+    uint32_t suppressed;  // changes held back by a policy
+    uint32_t flushed;     // trailing reports carrying the final value
+    uint32_t untracked;   // policy matched but no slot was free
+};
+
+/**
+ * @brief Applies the YAML `reporting` policies to attributes of @p endpoint_id.
+ *
+ * Called by device modules for the endpoints they create. Without a call,
+ * or without a policy for the attribute, changes are reported as before.
+ *
+ * A policy reports a change only once `min_interval_ms` has passed since the
+ * previous report and the value moved by at least `threshold`. Changes held
+ * back are flushed once `min_interval_ms` has passed since the previous
+ * report (or since the first held change, if that came later), however
+ * often the value keeps moving, so subscribers always end up with the final
+ * value of a fade.
+ */
+void track_endpoint(uint16_t endpoint_id);
+
+Stats stats();
+void print();
+
+/** @brief Registers `matter esp reporting`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace report_throttle
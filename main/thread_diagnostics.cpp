@@ -0,0 +1,171 @@
+#include "thread_diagnostics.h"
+
+#include "generated_config.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#if CONFIG_OPENTHREAD_ENABLED
+#include <esp_openthread.h>
+#include <esp_openthread_lock.h>
+#include <esp_timer.h>
+#include <openthread/link.h>
+#include <openthread/message.h>
+#include <openthread/thread.h>
+#endif
+
+namespace thread_diagnostics {
+
+namespace {
+
+constexpr const char *TAG = "thread_diag";
+
+portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+Stats s_stats = {};
+
+#if CONFIG_OPENTHREAD_ENABLED
+// Each sample wakes the chip, so light-sleep builds sample twice a minute.
+constexpr uint64_t kSamplePeriodUs = (generated_config::power::light_sleep ? 30 : 1) * 1000 * 1000ULL;
+esp_timer_handle_t s_timer = nullptr;
+
+// Runs on the esp_timer task. Never waits for the OpenThread lock: a busy
+// stack skips the sample instead of stalling other timers.
+void sample(void *)
+{
+    if (!esp_openthread_lock_acquire(0)) {
+        portENTER_CRITICAL(&s_lock);
+        ++s_stats.lock_misses;
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+    otInstance *instance = esp_openthread_get_instance();
+    otBufferInfo buffers;
+    otMessageGetBufferInfo(instance, &buffers);
+    const otIpCounters *ip6 = otThreadGetIp6Counters(instance);
+    const otMacCounters *mac = otLinkGetCounters(instance);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.total_buffers = buffers.mTotalBuffers;
+    s_stats.free_buffers = buffers.mFreeBuffers;
+    if (s_stats.samples == 0 || buffers.mFreeBuffers < s_stats.min_free_buffers) {
+        s_stats.min_free_buffers = buffers.mFreeBuffers;
+    }
+    ++s_stats.samples;
+    s_stats.ip6_tx_failures = ip6->mTxFailure;
+    s_stats.ip6_rx_failures = ip6->mRxFailure;
+    s_stats.mac_tx_busy_channel = mac->mTxErrBusyChannel;
+    s_stats.mac_tx_cca_failures = mac->mTxErrCca;
+    s_stats.mac_tx_aborts = mac->mTxErrAbort;
+    s_stats.mac_rx_no_frame = mac->mRxErrNoFrame;
+    s_stats.mac_rx_other = mac->mRxErrOther;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_openthread_lock_release();
+}
+#endif // CONFIG_OPENTHREAD_ENABLED
+
+#if CONFIG_ENABLE_CHIP_SHELL
+esp_err_t thread_command(int argc, char **argv)
+{
+    if (argc > 0 && strcmp(argv[0], "reset") == 0) {
+        reset();
+        printf("Thread counters cleared.\n");
+        return ESP_OK;
+    }
+    print();
+    return ESP_OK;
+}
+#endif
+
+} // namespace
+
+esp_err_t start()
+{
+#if CONFIG_OPENTHREAD_ENABLED
+    if (s_timer) {
+        return ESP_OK;
+    }
+    const esp_timer_create_args_t args = {
+        .callback = sample,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "thread_diag",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&args, &s_timer);
+    if (err == ESP_OK) {
+        err = esp_timer_start_periodic(s_timer, kSamplePeriodUs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to start Thread diagnostics: %s", esp_err_to_name(err));
+    }
+    return err;
+#else
+    return ESP_OK;
+#endif
+}
+
+Stats stats()
+{
+    portENTER_CRITICAL(&s_lock);
+    const Stats copy = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+    return copy;
+}
+
+void reset()
+{
+#if CONFIG_OPENTHREAD_ENABLED
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    otInstance *instance = esp_openthread_get_instance();
+    otThreadResetIp6Counters(instance);
+    otLinkResetCounters(instance);
+    esp_openthread_lock_release();
+#endif
+    portENTER_CRITICAL(&s_lock);
+    s_stats = {};
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void print()
+{
+#if CONFIG_OPENTHREAD_ENABLED
+    const Stats s = stats();
+    printf("profile queues: netif=%d task=%d\n", APP_OT_NETIF_QUEUE_SIZE, APP_OT_TASK_QUEUE_SIZE);
+    printf("message buffers: total=%u free=%u min_free=%u (samples=%" PRIu32 " lock_misses=%" PRIu32 ")\n",
+           static_cast<unsigned int>(s.total_buffers), static_cast<unsigned int>(s.free_buffers),
+           static_cast<unsigned int>(s.min_free_buffers), s.samples, s.lock_misses);
+    printf("ip6 drops: tx=%" PRIu32 " rx=%" PRIu32 "\n", s.ip6_tx_failures, s.ip6_rx_failures);
+    printf("mac: tx_busy_channel=%" PRIu32 " tx_cca=%" PRIu32 " tx_abort=%" PRIu32 " rx_no_frame=%" PRIu32
+           " rx_other=%" PRIu32 "\n",
+           s.mac_tx_busy_channel, s.mac_tx_cca_failures, s.mac_tx_aborts, s.mac_rx_no_frame, s.mac_rx_other);
+#else
+    printf("OpenThread is not enabled in this build.\n");
+#endif
+}
+
+esp_err_t register_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t kCommands[] = {
+        {
+            .name = "thread",
+            .description = "OpenThread buffer usage and drop counters. Usage: matter esp thread [reset]",
+            .handler = thread_command,
+        },
+    };
+    return esp_matter::console::add_commands(kCommands, sizeof(kCommands) / sizeof(kCommands[0]));
+#else
+    return ESP_OK;
+#endif
+}
+
+} // namespace thread_diagnostics
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <esp_err.h>
+
+#include <cstdint>
+
+namespace thread_diagnostics {
+
+struct Stats {
+    uint16_t total_buffers;       // OpenThread message buffer pool size
+    uint16_t free_buffers;        // free buffers at the last sample
+    uint16_t min_free_buffers;    // low-water mark since boot or reset
+    uint32_t samples;
+    uint32_t lock_misses;         // samples skipped because the OT lock was busy
+    uint32_t ip6_tx_failures;     // IPv6 datagrams dropped before or during transmission
+    uint32_t ip6_rx_failures;     // IPv6 datagrams dropped on reception
+    uint32_t mac_tx_busy_channel;
+    uint32_t mac_tx_cca_failures;
+    uint32_t mac_tx_aborts;
+    uint32_t mac_rx_no_frame;
+    uint32_t mac_rx_other;
+};
+
+/**
+ * @brief Starts sampling OpenThread buffer usage and drop counters once a second.
+ *
+ * Light-sleep builds sample every 30 s so the timer does not keep the chip awake.
+ * Call after esp_matter::start(). No-op when OpenThread is not built in. The
+ * low-water mark of free message buffers and the failure counters are the
+ * evidence used to size `network.thread_profile` in the YAML.
+ */
+esp_err_t start();
+
+Stats stats();
+void reset();
+void print();
+
+/** @brief Registers `matter esp thread [reset]`. No-op without the CHIP shell. */
+esp_err_t register_commands();
+
+} // namespace thread_diagnostics
@@ -0,0 +1,86 @@
+#include "button_scan.h"
+
+/* Orders the event write before head (producer) and the read before tail (consumer). */
+#define BUTTON_SCAN_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+void button_scan_init(button_scan_t *scan, uint32_t gpio_mask, uint32_t active_low_mask, uint32_t debounce_samples)
+{
+    uint8_t *bytes = (uint8_t *) scan;
+    for (uint32_t idx = 0; idx < sizeof(*scan); ++idx) {
+        bytes[idx] = 0;
+    }
+    scan->gpio_mask = gpio_mask & ((1u << BUTTON_SCAN_MAX_GPIO) - 1u);
+    scan->active_low_mask = active_low_mask;
+    scan->debounce_samples = debounce_samples == 0 ? 1 : (debounce_samples > 255 ? 255 : debounce_samples);
+}
+
+static bool push(button_scan_t *scan, uint8_t gpio, bool pressed)
+{
+    const uint32_t head = scan->head;
+    const uint32_t tail = scan->tail;
+    if (head - tail >= BUTTON_SCAN_QUEUE_LEN) {
+        ++scan->dropped;
+        return false;
+    }
+    button_scan_event_t *event = &scan->events[head % BUTTON_SCAN_QUEUE_LEN];
+    event->gpio = gpio;
+    event->pressed = pressed ? 1 : 0;
+    event->reserved = 0;
+    event->tick = scan->ticks;
+    BUTTON_SCAN_FENCE();
+    scan->head = head + 1;
+    /* A non-empty queue means the HP core was already woken for it. */
+    return head == tail;
+}
+
+bool button_scan_step(button_scan_t *scan, uint32_t levels)
+{
+    bool wake = false;
+    ++scan->ticks;
+    const uint32_t active = (levels ^ scan->active_low_mask) & scan->gpio_mask;
+    for (uint8_t gpio = 0; gpio < BUTTON_SCAN_MAX_GPIO; ++gpio) {
+        const uint32_t bit = 1u << gpio;
+        if (!(scan->gpio_mask & bit)) {
+            continue;
+        }
+        uint8_t *level = &scan->integrator[gpio];
+        if (active & bit) {
+            if (*level < scan->debounce_samples) {
+                ++*level;
+            }
+        } else if (*level > 0) {
+            --*level;
+        }
+
+        const bool pressed = (scan->pressed_mask & bit) != 0;
+        if (!pressed && *level == scan->debounce_samples) {
+            scan->pressed_mask |= bit;
+            wake |= push(scan, gpio, true);
+        } else if (pressed && *level == 0) {
+            scan->pressed_mask &= ~bit;
+            wake |= push(scan, gpio, false);
+        }
+    }
+    if (wake) {
+        ++scan->wakeups;
+    }
+    return wake;
+}
+
+bool button_scan_pop(button_scan_t *scan, button_scan_event_t *out)
+{
+    const uint32_t tail = scan->tail;
+    if (scan->head == tail) {
+        return false;
+    }
+    BUTTON_SCAN_FENCE();
+    *out = scan->events[tail % BUTTON_SCAN_QUEUE_LEN];
+    BUTTON_SCAN_FENCE();
+    scan->tail = tail + 1;
+    return true;
+}
+
+bool button_scan_pending(const button_scan_t *scan)
+{
+    return scan->head != scan->tail;
+}
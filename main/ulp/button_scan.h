@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* LP IOs the LP core can read: GPIO0..GPIO7 on the ESP32-C6. */
+#define BUTTON_SCAN_MAX_GPIO 8
+#define BUTTON_SCAN_QUEUE_LEN 16
+
+typedef struct {
+    uint8_t gpio;
+    uint8_t pressed;
+    uint16_t reserved;
+    uint32_t tick; /* scan count when the edge was accepted */
+} button_scan_event_t;
+
+/*
+ * Button scanner shared between the LP core (producer) and the HP core
+ * (consumer) in RTC memory.
+ *
+ * The HP core fills the configuration with button_scan_init() before the LP
+ * core runs. The LP core calls button_scan_step() once per scan period with
+ * the raw levels of the LP IOs; an integrating debouncer turns them into
+ * press and release edges, which are queued with the scan tick they were
+ * accepted on. The HP core drains them with button_scan_pop(). Only head is
+ * written by the LP core and only tail by the HP core, so no lock is needed.
+ *
+ * Plain C with no ESP-IDF dependency: the same file is built into the LP
+ * core binary and can be driven on a host with a recorded GPIO trace.
+ */
+typedef struct {
+    /* Configuration, written by the HP core before the LP core starts. */
+    uint32_t gpio_mask;
+    uint32_t active_low_mask;
+    uint32_t debounce_samples;
+
+    /* LP core state. */
+    uint32_t ticks;
+    uint32_t pressed_mask;
+    uint8_t integrator[BUTTON_SCAN_MAX_GPIO];
+    uint32_t dropped;
+    uint32_t wakeups;
+
+    /* Event queue. */
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    button_scan_event_t events[BUTTON_SCAN_QUEUE_LEN];
+} button_scan_t;
+
+void button_scan_init(button_scan_t *scan, uint32_t gpio_mask, uint32_t active_low_mask, uint32_t debounce_samples);
+
+/*
+ * One scan of the LP core. @p levels has bit n set when LP IO n reads high.
+ * Returns true when an edge was queued and the HP core has not yet been told
+ * about earlier ones, i.e. when the LP core should wake it.
+ */
+bool button_scan_step(button_scan_t *scan, uint32_t levels);
+
+/* HP core: takes the oldest edge; false when the queue is empty. */
+bool button_scan_pop(button_scan_t *scan, button_scan_event_t *out);
+
+bool button_scan_pending(const button_scan_t *scan);
+
+#ifdef __cplusplus
+}
+#endif
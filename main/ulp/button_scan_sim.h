@@ -0,0 +1,61 @@
+#pragma once
+
+#include "button_scan.h"
+
+#include <cstdint>
+
+namespace device_modules::lp_buttons {
+
+/**
+ * @brief Host-side stand-in for the LP core and its LP IOs.
+ *
+ * Replays a GPIO trace through button_scan_step() at the scan period the
+ * firmware uses, so test/host/button_scan_test.cpp can check debouncing,
+ * event timing and how often the HP core would have been woken.
+ */
+class SimulatedLpCore {
+public:
+    SimulatedLpCore(uint32_t gpio_mask, uint32_t active_low_mask, uint32_t debounce_samples, uint32_t period_ms)
+        : m_period_ms(period_ms), m_levels(active_low_mask)
+    {
+        button_scan_init(&m_scan, gpio_mask, active_low_mask, debounce_samples);
+    }
+
+    /** Drives LP IO @p gpio to @p high from now on (a bounce is a few quick calls). */
+    void set_level(uint8_t gpio, bool high)
+    {
+        m_levels = high ? (m_levels | (1u << gpio)) : (m_levels & ~(1u << gpio));
+    }
+
+    /** Runs scans until @p until_ms; returns how many of them woke the HP core. */
+    uint32_t run_until(uint32_t until_ms)
+    {
+        uint32_t wakes = 0;
+        while (m_now_ms + m_period_ms <= until_ms) {
+            m_now_ms += m_period_ms;
+            wakes += button_scan_step(&m_scan, m_levels) ? 1 : 0;
+        }
+        return wakes;
+    }
+
+    /** Pops the next edge with its time in milliseconds, as the HP core reconstructs it. */
+    bool pop(button_scan_event_t &event, uint32_t &event_ms)
+    {
+        if (!button_scan_pop(&m_scan, &event)) {
+            return false;
+        }
+        event_ms = m_now_ms - (m_scan.ticks - event.tick) * m_period_ms;
+        return true;
+    }
+
+    const button_scan_t &scan() const { return m_scan; }
+    uint32_t now_ms() const { return m_now_ms; }
+
+private:
+    button_scan_t m_scan{};
+    uint32_t m_period_ms;
+    uint32_t m_levels;
+    uint32_t m_now_ms = 0;
+};
+
+} // namespace device_modules::lp_buttons
@@ -0,0 +1,28 @@
+/*
+ * LP core program: scans the button LP IOs once per LP timer period and
+ * wakes the HP core when a debounced edge is queued. Bounces and idle scans
+ * never reach the HP core.
+ */
+#include <stdint.h>
+
+#include "ulp_lp_core_gpio.h"
+#include "ulp_lp_core_utils.h"
+
+#include "button_scan.h"
+
+/* Shared with the HP core as ulp_scan. */
+button_scan_t scan;
+
+int main(void)
+{
+    uint32_t levels = 0;
+    for (int gpio = 0; gpio < BUTTON_SCAN_MAX_GPIO; ++gpio) {
+        if (scan.gpio_mask & (1u << gpio)) {
+            levels |= (uint32_t) (ulp_lp_core_gpio_get_level((lp_io_num_t) gpio) ? 1 : 0) << gpio;
+        }
+    }
+    if (button_scan_step(&scan, levels)) {
+        ulp_lp_core_wakeup_main_processor();
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "host_check.h"
+
+#include "ulp/button_scan_sim.h"
+
+using device_modules::lp_buttons::SimulatedLpCore;
+
+namespace {
+
+constexpr uint32_t kPeriodMs = 10;
+constexpr uint32_t kDebounce = 3;
+
+void test_press_and_release_are_timed_to_the_scan()
+{
+    // GPIO 2, active low, idles high.
+    SimulatedLpCore core(1u << 2, 1u << 2, kDebounce, kPeriodMs);
+    CHECK_EQ(core.run_until(100), 0);
+    core.set_level(2, false);
+    CHECK_EQ(core.run_until(300), 1);
+    core.set_level(2, true);
+    // The release queues behind the unread press, which already woke the HP core.
+    CHECK_EQ(core.run_until(500), 0);
+
+    button_scan_event_t event{};
+    uint32_t event_ms = 0;
+    CHECK(core.pop(event, event_ms));
+    CHECK_EQ(event.gpio, 2);
+    CHECK_EQ(event.pressed, 1);
+    CHECK_EQ(event_ms, 100 + kDebounce * kPeriodMs);
+    CHECK(core.pop(event, event_ms));
+    CHECK_EQ(event.pressed, 0);
+    CHECK_EQ(event_ms, 300 + kDebounce * kPeriodMs);
+    CHECK(!core.pop(event, event_ms));
+    CHECK_EQ(core.scan().wakeups, 1);
+}
+
+void test_bounces_collapse_into_one_edge()
+{
+    SimulatedLpCore core(1u << 0, 1u << 0, kDebounce, kPeriodMs);
+    core.run_until(100);
+    // Sampled at 110 low, 120 high, then low from 130: the integrator reaches
+    // the debounce count at 150.
+    core.set_level(0, false);
+    core.run_until(115);
+    core.set_level(0, true);
+    core.run_until(125);
+    core.set_level(0, false);
+    core.run_until(400);
+    core.set_level(0, true);
+    core.run_until(415);
+    core.set_level(0, false);
+    core.run_until(425);
+    core.set_level(0, true);
+    core.run_until(700);
+
+    button_scan_event_t event{};
+    uint32_t event_ms = 0;
+    CHECK(core.pop(event, event_ms));
+    CHECK_EQ(event.pressed, 1);
+    CHECK_EQ(event_ms, 150);
+    CHECK(core.pop(event, event_ms));
+    CHECK_EQ(event.pressed, 0);
+    CHECK(!core.pop(event, event_ms));
+}
+
+void test_short_glitches_are_ignored()
+{
+    SimulatedLpCore core(1u << 1, 0, kDebounce, kPeriodMs);
+    core.run_until(100);
+    // Active high, present for two scans only.
+    core.set_level(1, true);
+    core.run_until(120);
+    core.set_level(1, false);
+    CHECK_EQ(core.run_until(300), 0);
+    CHECK(!button_scan_pending(&core.scan()));
+}
+
+void test_full_queue_drops_and_wakes_again_once_drained()
+{
+    SimulatedLpCore core(1u << 3, 1u << 3, 1, kPeriodMs);
+    uint32_t wakes = 0;
+    uint32_t now = 0;
+    for (int press = 0; press < 10; ++press) {
+        core.set_level(3, false);
+        wakes += core.run_until(now += 20);
+        core.set_level(3, true);
+        wakes += core.run_until(now += 20);
+    }
+    // Twenty edges into sixteen slots, with one wake for the whole burst.
+    CHECK_EQ(wakes, 1);
+    CHECK_EQ(core.scan().dropped, 20 - BUTTON_SCAN_QUEUE_LEN);
+
+    button_scan_event_t event{};
+    uint32_t event_ms = 0;
+    uint32_t popped = 0;
+    while (core.pop(event, event_ms)) {
+        ++popped;
+    }
+    CHECK_EQ(popped, BUTTON_SCAN_QUEUE_LEN);
+    core.set_level(3, false);
+    CHECK_EQ(core.run_until(now += 20), 1);
+}
+
+void test_only_lp_ios_are_scanned()
+{
+    // GPIO 9 is not an LP IO; the mask drops it.
+    SimulatedLpCore core((1u << 9) | (1u << 4), 0, kDebounce, kPeriodMs);
+    CHECK_EQ(core.scan().gpio_mask, 1u << 4);
+    core.set_level(9, true);
+    CHECK_EQ(core.run_until(100), 0);
+    core.set_level(4, true);
+    CHECK_EQ(core.run_until(200), 1);
+}
+
+} // namespace
+
+int main()
+{
+    test_press_and_release_are_timed_to_the_scan();
+    test_bounces_collapse_into_one_edge();
+    test_short_glitches_are_ignored();
+    test_full_queue_drops_and_wakes_again_once_drained();
+    test_only_lp_ios_are_scanned();
+    return host_check_result("button_scan_test");
+}
@@ -0,0 +1,108 @@
+#include "host_check.h"
+
+#include "common/encoder_accumulator.h"
+#include "common/encoder_sim.h"
+
+using device_modules::encoder::EncoderAccumulator;
+using device_modules::encoder::SimulatedEncoder;
+
+namespace {
+
+// Four counts per detent, steps of 5 up to 40, accelerating above 10 detents/s.
+constexpr EncoderAccumulator::Params kParams = {4, 5, 40, 10};
+
+void poll(SimulatedEncoder &encoder, EncoderAccumulator &accumulator)
+{
+    accumulator.add_counts(encoder.take_delta());
+}
+
+void test_one_detent_is_one_step()
+{
+    SimulatedEncoder encoder(4);
+    EncoderAccumulator accumulator(kParams);
+    EncoderAccumulator::Step step{};
+
+    encoder.rotate(1);
+    poll(encoder, accumulator);
+    CHECK(accumulator.flush(200, step));
+    CHECK(step.up);
+    CHECK_EQ(step.detents, 1);
+    CHECK_EQ(step.size, 5);
+
+    encoder.rotate(-1);
+    poll(encoder, accumulator);
+    CHECK(accumulator.flush(200, step));
+    CHECK(!step.up);
+    CHECK_EQ(step.detents, -1);
+}
+
+void test_partial_detents_carry_over()
+{
+    SimulatedEncoder encoder(4);
+    EncoderAccumulator accumulator(kParams);
+    EncoderAccumulator::Step step{};
+
+    encoder.glitch(3);
+    poll(encoder, accumulator);
+    CHECK(!accumulator.flush(50, step));
+    CHECK_EQ(accumulator.pending_counts(), 3);
+
+    encoder.glitch(1);
+    poll(encoder, accumulator);
+    CHECK(accumulator.flush(50, step));
+    CHECK_EQ(step.detents, 1);
+    CHECK_EQ(accumulator.pending_counts(), 0);
+
+    // Bounce back and forth inside a detent never produces a step.
+    for (int n = 0; n < 10; ++n) {
+        encoder.glitch(2);
+        encoder.glitch(-2);
+        poll(encoder, accumulator);
+        CHECK(!accumulator.flush(50, step));
+    }
+}
+
+void test_intervals_coalesce()
+{
+    SimulatedEncoder encoder(4);
+    EncoderAccumulator accumulator(kParams);
+    EncoderAccumulator::Step step{};
+
+    // Three slow detents within one interval become one step of three.
+    encoder.rotate(3);
+    poll(encoder, accumulator);
+    CHECK(accumulator.flush(1000, step));
+    CHECK_EQ(step.detents, 3);
+    CHECK_EQ(step.size, 15);
+}
+
+void test_fast_spins_accelerate_up_to_the_cap()
+{
+    SimulatedEncoder encoder(4);
+    EncoderAccumulator accumulator(kParams);
+    EncoderAccumulator::Step step{};
+
+    // 20 detents/s is twice the threshold: double-size steps.
+    encoder.rotate(2);
+    poll(encoder, accumulator);
+    CHECK(accumulator.flush(100, step));
+    CHECK_EQ(step.size, 20);
+
+    // Far above the threshold the step is capped at max_step_size.
+    encoder.rotate(-6);
+    poll(encoder, accumulator);
+    CHECK(accumulator.flush(50, step));
+    CHECK(!step.up);
+    CHECK_EQ(step.size, 40);
+}
+
+} // namespace
+
+int main()
+{
+    test_one_detent_is_one_step();
+    test_partial_detents_carry_over();
+    test_intervals_coalesce();
+    test_fast_spins_accelerate_up_to_the_cap();
+    return host_check_result("encoder_test");
+}
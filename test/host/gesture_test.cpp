@@ -0,0 +1,112 @@
+#include "host_check.h"
+
+#include "common/gesture_classifier.h"
+
+#include <vector>
+
+using device_modules::button::Gesture;
+using device_modules::button::GestureClassifier;
+using device_modules::button::GesturePolicy;
+
+namespace {
+
+std::vector<Gesture> drain(GestureClassifier &classifier)
+{
+    std::vector<Gesture> out;
+    GestureClassifier::Event event{};
+    while (classifier.next(event)) {
+        out.push_back(event.gesture);
+    }
+    return out;
+}
+
+bool same(const std::vector<Gesture> &actual, std::initializer_list<Gesture> expected)
+{
+    return actual == std::vector<Gesture>(expected);
+}
+
+void test_hold_then_release_ends_the_hold_only()
+{
+    // Hold at 500 ms, Long at 5 s: a 6 s hold is a hold, not also a Long.
+    GestureClassifier classifier({GesturePolicy::Immediate, 1, 300, 500, 5000});
+    classifier.press(0);
+    classifier.poll(499);
+    CHECK(drain(classifier).empty());
+    classifier.poll(500);
+    CHECK(same(drain(classifier), {Gesture::HoldStart}));
+    classifier.poll(5000);
+    CHECK(drain(classifier).empty());
+    classifier.release(6000);
+    CHECK(same(drain(classifier), {Gesture::HoldEnd}));
+    classifier.poll(7000);
+    CHECK(drain(classifier).empty());
+    CHECK_EQ(classifier.stats(Gesture::Long).count, 0);
+}
+
+void test_long_press_without_hold()
+{
+    GestureClassifier classifier({GesturePolicy::Immediate, 1, 300, 0, 5000});
+    classifier.press(0);
+    classifier.release(5200);
+    CHECK(same(drain(classifier), {Gesture::Long}));
+}
+
+void test_immediate_double_click_undoes_single()
+{
+    GestureClassifier classifier({GesturePolicy::Immediate, 2, 300, 0, 0});
+    classifier.press(0);
+    classifier.release(80);
+    CHECK(same(drain(classifier), {Gesture::Single}));
+    classifier.press(200);
+    classifier.release(260);
+    CHECK(same(drain(classifier), {Gesture::Undo, Gesture::Double}));
+}
+
+void test_wait_policy_reports_once_the_window_closes()
+{
+    GestureClassifier classifier({GesturePolicy::Wait, 3, 300, 0, 0});
+    classifier.press(0);
+    classifier.release(80);
+    CHECK(drain(classifier).empty());
+
+    uint32_t deadline = 0;
+    CHECK(classifier.next_deadline_ms(deadline));
+    CHECK_EQ(deadline, 380);
+    classifier.poll(379);
+    CHECK(drain(classifier).empty());
+    classifier.poll(380);
+    CHECK(same(drain(classifier), {Gesture::Single}));
+
+    // Three clicks reach max_clicks and are reported on the last release.
+    for (uint32_t t = 1000; t < 1600; t += 200) {
+        classifier.press(t);
+        classifier.release(t + 60);
+    }
+    CHECK(same(drain(classifier), {Gesture::Triple}));
+    CHECK(!classifier.next_deadline_ms(deadline));
+}
+
+void test_hold_is_only_armed_on_the_first_press()
+{
+    // A click followed by a long press within the window is not a hold.
+    GestureClassifier classifier({GesturePolicy::Wait, 2, 300, 500, 0});
+    classifier.press(0);
+    classifier.release(50);
+    classifier.press(200);
+    classifier.poll(1000);
+    CHECK(drain(classifier).empty());
+    classifier.release(1100);
+    CHECK(same(drain(classifier), {Gesture::Double}));
+}
+
+} // namespace
+
+int main()
+{
+    test_hold_then_release_ends_the_hold_only();
+    test_long_press_without_hold();
+    test_immediate_double_click_undoes_single();
+    test_wait_policy_reports_once_the_window_closes();
+    test_hold_is_only_armed_on_the_first_press();
+    return host_check_result("gesture_test");
+}
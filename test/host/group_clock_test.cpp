@@ -0,0 +1,112 @@
+#include "host_check.h"
+
+#include "light/group_clock.h"
+#include "light/group_clock_sim.h"
+
+#include <cstdio>
+
+using device_modules::light::GroupClock;
+using device_modules::light::SimulatedSyncGroup;
+using device_modules::light::SyncMessage;
+using device_modules::light::SyncType;
+
+namespace {
+
+constexpr uint16_t kDomain = 7;
+constexpr uint32_t kBeaconMs = 1000;
+constexpr uint64_t kSecond = 1'000'000;
+
+void test_messages_round_trip()
+{
+    const SyncMessage sent = {SyncType::DelayResponse, kDomain, 0x1122334455667788ull, 42, 1, 1ull << 40, ~0ull};
+    uint8_t wire[device_modules::light::kSyncMessageSize];
+    encode_sync(sent, wire);
+
+    SyncMessage received{};
+    CHECK(decode_sync(wire, sizeof(wire), received));
+    CHECK(received.type == sent.type);
+    CHECK_EQ(received.domain, sent.domain);
+    CHECK(received.node_id == sent.node_id);
+    CHECK(received.peer_id == sent.peer_id);
+    CHECK(received.t1 == sent.t1 && received.t2 == sent.t2 && received.t3 == sent.t3);
+
+    CHECK(!decode_sync(wire, sizeof(wire) - 1, received));
+    wire[0] ^= 0xFF;
+    CHECK(!decode_sync(wire, sizeof(wire), received));
+}
+
+void test_other_domains_are_ignored()
+{
+    GroupClock clock;
+    clock.configure({5, kDomain, kBeaconMs}, 0);
+    SyncMessage beacon = {SyncType::Beacon, kDomain + 1, 1, 0, 123456789, 0, 0};
+    SyncMessage reply{};
+    CHECK(!clock.on_message(beacon, 1000, reply));
+    CHECK(!clock.synced());
+    CHECK_EQ(clock.stats(1000).ignored, 1);
+}
+
+// Four lights with +-100 ppm crystals booted at different times.
+SimulatedSyncGroup four_lights(uint32_t base_delay_us, uint32_t jitter_us)
+{
+    SimulatedSyncGroup group(kDomain, kBeaconMs, base_delay_us, jitter_us, 7);
+    group.add_node(0x10, 100, 5 * kSecond);
+    group.add_node(0x20, -100, 90 * kSecond);
+    group.add_node(0x30, 40, 1234567);
+    group.add_node(0x40, -60, 0);
+    return group;
+}
+
+void test_thread_link_converges_and_survives_a_leader_change()
+{
+    SimulatedSyncGroup group = four_lights(8000, 6000);
+    group.run_until(20 * kSecond);
+    for (size_t idx = 0; idx < 4; ++idx) {
+        CHECK(group.clock(idx).locked(group.local_now_us(idx)));
+        CHECK(group.clock(idx).stats(group.local_now_us(idx)).leader_id == 0x10);
+    }
+    CHECK(group.clock(0).leader(group.local_now_us(0)));
+
+    const SimulatedSyncGroup::ErrorStats steady = group.measure(80 * kSecond, 50'000);
+    std::printf("thread steady: max %llu us, avg %llu us\n", static_cast<unsigned long long>(steady.max_us),
+                static_cast<unsigned long long>(steady.avg_us));
+    CHECK(steady.max_us < 6000);
+    CHECK(steady.avg_us < 3000);
+
+    // The leader goes away: the next id takes over without a jump.
+    group.set_online(0, false);
+    const SimulatedSyncGroup::ErrorStats loss = group.measure(110 * kSecond, 50'000);
+    std::printf("thread leader loss: max %llu us\n", static_cast<unsigned long long>(loss.max_us));
+    CHECK(loss.max_us < 6000);
+    CHECK(group.clock(1).leader(group.local_now_us(1)));
+    CHECK(group.clock(2).stats(group.local_now_us(2)).leader_id == 0x20);
+
+    // It reboots with a fresh clock and must adopt the group time first.
+    group.set_online(0, true);
+    const SimulatedSyncGroup::ErrorStats back = group.measure(150 * kSecond, 50'000);
+    std::printf("thread leader back: max %llu us\n", static_cast<unsigned long long>(back.max_us));
+    CHECK(back.max_us < 6000);
+    CHECK(group.clock(0).locked(group.local_now_us(0)));
+}
+
+void test_wifi_link_converges()
+{
+    SimulatedSyncGroup group = four_lights(1500, 4000);
+    group.run_until(20 * kSecond);
+    const SimulatedSyncGroup::ErrorStats steady = group.measure(80 * kSecond, 50'000);
+    std::printf("wifi steady: max %llu us, avg %llu us\n", static_cast<unsigned long long>(steady.max_us),
+                static_cast<unsigned long long>(steady.avg_us));
+    CHECK(steady.max_us < 4000);
+    CHECK(steady.avg_us < 2000);
+}
+
+} // namespace
+
+int main()
+{
+    test_messages_round_trip();
+    test_other_domains_are_ignored();
+    test_thread_link_converges_and_survives_a_leader_change();
+    test_wifi_link_converges();
+    return host_check_result("group_clock_test");
+}
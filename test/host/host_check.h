@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+/*
+ * Minimal assertions for the host tests: a failed CHECK prints where and
+ * keeps going, and host_check_result() turns the tally into the exit code
+ * ctest reads.
+ */
+
+inline int &host_check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++host_check_failures();                                                      \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                     \
+    do {                                                                                               \
+        const long long check_actual = static_cast<long long>(actual);                                 \
+        const long long check_expected = static_cast<long long>(expected);                             \
+        if (check_actual != check_expected) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, \
+                         #actual, #expected, check_actual, check_expected);                            \
+            ++host_check_failures();                                                                   \
+        }                                                                                              \
+    } while (0)
+
+inline int host_check_result(const char *name)
+{
+    if (host_check_failures() != 0) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, host_check_failures());
+        return EXIT_FAILURE;
+    }
+    std::printf("%s: ok\n", name);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "host_check.h"
+
+#include "icd_estimator.h"
+#include "icd_sim.h"
+
+using icd::Estimator;
+using icd::Mode;
+
+namespace {
+
+// Idle 300 s, active 300 ms, threshold 1 s, polls every 5 s / 200 ms.
+constexpr Estimator::Params kParams = {300000, 300, 1000, 5000, 200};
+
+void test_idle_interval_ends_in_a_check_in_window()
+{
+    Estimator estimator(kParams, 0);
+    CHECK(estimator.mode() == Mode::Idle);
+    CHECK_EQ(estimator.poll_period_ms(), 5000);
+    CHECK_EQ(estimator.next_transition_ms(), 300000);
+
+    estimator.advance(300000);
+    CHECK(estimator.mode() == Mode::Active);
+    CHECK_EQ(estimator.poll_period_ms(), 200);
+    CHECK_EQ(estimator.totals().check_ins, 1);
+
+    estimator.advance(300300);
+    CHECK(estimator.mode() == Mode::Idle);
+    CHECK_EQ(estimator.totals().idle_ms, 300000);
+    CHECK_EQ(estimator.totals().active_ms, 300);
+    // 60 slow polls, one on entering active mode and one fast poll in it.
+    CHECK_EQ(estimator.totals().polls, 62);
+}
+
+void test_user_activity_extends_active_mode_to_the_threshold()
+{
+    Estimator estimator(kParams, 0);
+    estimator.user_event(1000);
+    CHECK(estimator.mode() == Mode::Active);
+    CHECK_EQ(estimator.next_transition_ms(), 1300);
+
+    estimator.user_event(1200);
+    CHECK_EQ(estimator.next_transition_ms(), 2200);
+    // A press that would shorten the window leaves it alone.
+    estimator.user_event(1201);
+    CHECK_EQ(estimator.next_transition_ms(), 2201);
+
+    estimator.advance(2201);
+    CHECK(estimator.mode() == Mode::Idle);
+    CHECK_EQ(estimator.totals().user_events, 3);
+    CHECK_EQ(estimator.totals().check_ins, 0);
+}
+
+void test_long_gaps_walk_every_check_in()
+{
+    Estimator estimator(kParams, 0);
+    estimator.advance(3600000);
+    // An hour holds eleven idle intervals plus their check-in windows.
+    CHECK_EQ(estimator.totals().check_ins, 11);
+    CHECK_EQ(estimator.totals().idle_ms + estimator.totals().active_ms, 3600000);
+}
+
+void test_presses_cost_current()
+{
+    const icd::CurrentProfile profile{};
+    const icd::Estimate quiet = icd::simulate(kParams, profile, 0, 24);
+    const icd::Estimate busy = icd::simulate(kParams, profile, 60, 24);
+    CHECK(quiet.average_ua > profile.sleep_ua);
+    CHECK(busy.average_ua > quiet.average_ua);
+    CHECK_EQ(busy.totals.user_events, 60 * 24);
+    CHECK(busy.active_permille > quiet.active_permille);
+    CHECK_EQ(icd::battery_life_hours(1000, 100), 10000);
+}
+
+} // namespace
+
+int main()
+{
+    test_idle_interval_ends_in_a_check_in_window();
+    test_user_activity_extends_active_mode_to_the_threshold();
+    test_long_gaps_walk_every_check_in();
+    test_presses_cost_current();
+    return host_check_result("icd_test");
+}
@@ -0,0 +1,24 @@
+#include "host_check.h"
+
+#include "mac_credentials.h"
+
+// The same pairs are pinned for tools/matter_credentials.py in
+// matter_credentials_test.py; a change to either side breaks one of them.
+
+int main()
+{
+    {
+        const uint8_t mac[6] = {0x60, 0x55, 0xF9, 0x12, 0x34, 0x56};
+        const mac_credentials::Credentials credentials = mac_credentials::derive(mac);
+        CHECK_EQ(credentials.passcode, 26345314u);
+        CHECK_EQ(credentials.discriminator, 431u);
+    }
+    {
+        // Derives 11111111, which is forbidden, and steps to the next code.
+        const uint8_t mac[6] = {0x5A, 0x5F, 0xFF, 0xB5, 0x55, 0x48};
+        const mac_credentials::Credentials credentials = mac_credentials::derive(mac);
+        CHECK_EQ(credentials.passcode, 11111112u);
+        CHECK_EQ(credentials.discriminator, 2743u);
+    }
+    return host_check_result("mac_credentials_test");
+}
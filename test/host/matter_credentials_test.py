@@ -0,0 +1,30 @@
+"""Pins tools/matter_credentials.py to the pairs in mac_credentials_test.cpp."""
+import pathlib
+import sys
+
+sys.path.insert(0, str(pathlib.Path(__file__).resolve().parents[2] / "tools"))
+
+from matter_credentials import derive_credentials, parse_mac  # noqa: E402
+
+CASES = [
+    ("60:55:F9:12:34:56", (26345314, 431)),
+    # Derives 11111111, which is forbidden, and steps to the next code.
+    ("5a-5f-ff-b5-55-48", (11111112, 2743)),
+]
+
+
+def main() -> int:
+    failures = 0
+    for text, expected in CASES:
+        got = derive_credentials(parse_mac(text))
+        if got != expected:
+            print(f"{text}: expected {expected}, got {got}")
+            failures += 1
+    if parse_mac("60:55:F9:12:34") is not None or parse_mac("zz5500000000") is not None:
+        print("parse_mac accepted a malformed MAC")
+        failures += 1
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
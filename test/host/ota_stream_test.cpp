@@ -0,0 +1,288 @@
+#include "host_check.h"
+
+#include "ota_stream.h"
+#include "ota_stream_sim.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using ota_stream::apply;
+using ota_stream::Decoder;
+using ota_stream::Error;
+using ota_stream::Kind;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+constexpr uint32_t kMinMatch = 4;
+
+// Test-side packer: the same format as tools/ota_pack.py, with a plain greedy
+// LZ search, which is enough to exercise every decoder state.
+
+void put_le32(Bytes &out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void put_extended(Bytes &out, uint32_t value)
+{
+    for (; value >= 255; value -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void put_sequence(Bytes &out, const uint8_t *literals, uint32_t literal_count, uint32_t offset, uint32_t match)
+{
+    const uint32_t lit_code = literal_count < 15 ? literal_count : 15;
+    const uint32_t match_code = match == 0 ? 0 : (match - kMinMatch < 15 ? match - kMinMatch : 15);
+    out.push_back(static_cast<uint8_t>(lit_code << 4 | match_code));
+    if (lit_code == 15) {
+        put_extended(out, literal_count - 15);
+    }
+    out.insert(out.end(), literals, literals + literal_count);
+    if (match != 0) {
+        out.push_back(static_cast<uint8_t>(offset));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+        if (match_code == 15) {
+            put_extended(out, match - kMinMatch - 15);
+        }
+    }
+}
+
+Bytes lz_compress(const Bytes &data, uint8_t window_bits)
+{
+    const size_t window = size_t{1} << window_bits;
+    Bytes out;
+    size_t literal_start = 0;
+    size_t pos = 0;
+    while (pos + kMinMatch <= data.size()) {
+        size_t best_len = 0;
+        size_t best_offset = 0;
+        const size_t first = pos > window ? pos - window : 0;
+        for (size_t candidate = first; candidate < pos; ++candidate) {
+            size_t len = 0;
+            while (pos + len < data.size() && data[candidate + len] == data[pos + len]) {
+                ++len;
+            }
+            if (len > best_len) {
+                best_len = len;
+                best_offset = pos - candidate;
+            }
+        }
+        if (best_len < kMinMatch) {
+            ++pos;
+            continue;
+        }
+        put_sequence(out, data.data() + literal_start, static_cast<uint32_t>(pos - literal_start),
+                     static_cast<uint32_t>(best_offset), static_cast<uint32_t>(best_len));
+        pos += best_len;
+        literal_start = pos;
+    }
+    if (literal_start < data.size() || out.empty()) {
+        put_sequence(out, data.data() + literal_start, static_cast<uint32_t>(data.size() - literal_start), 0, 0);
+    }
+    return out;
+}
+
+Bytes payload(Kind kind, uint8_t window_bits, uint32_t target_size, const Bytes &stream, uint32_t base_size)
+{
+    Bytes out(ota_stream::kMagic, ota_stream::kMagic + sizeof(ota_stream::kMagic));
+    out.push_back(ota_stream::kVersion);
+    out.push_back(static_cast<uint8_t>(kind));
+    out.push_back(window_bits);
+    out.push_back(0);
+    put_le32(out, target_size);
+    put_le32(out, static_cast<uint32_t>(stream.size()));
+    put_le32(out, base_size);
+    // MemoryImageIo leaves the hashes to the device's SlotIo.
+    out.resize(ota_stream::kHeaderSize, 0);
+    const Bytes body = lz_compress(stream, window_bits);
+    out.insert(out.end(), body.begin(), body.end());
+    return out;
+}
+
+void put_varint(Bytes &out, uint32_t value)
+{
+    for (; value >= 0x80; value >>= 7) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t zigzag(int32_t value)
+{
+    return value < 0 ? (static_cast<uint32_t>(-(value + 1)) << 1) | 1 : static_cast<uint32_t>(value) << 1;
+}
+
+// Delta operations; base_delta is relative to the end of the previous COPY or ADD.
+struct DeltaOps {
+    Bytes ops;
+    uint32_t base_pos = 0;
+
+    void copy(uint32_t base_offset, uint32_t len)
+    {
+        ops.push_back(0);
+        put_varint(ops, len);
+        put_varint(ops, zigzag(static_cast<int32_t>(base_offset - base_pos)));
+        base_pos = base_offset + len;
+    }
+
+    void add(uint32_t base_offset, const Bytes &base, const Bytes &target, uint32_t target_offset, uint32_t len)
+    {
+        ops.push_back(1);
+        put_varint(ops, len);
+        put_varint(ops, zigzag(static_cast<int32_t>(base_offset - base_pos)));
+        for (uint32_t idx = 0; idx < len; ++idx) {
+            ops.push_back(static_cast<uint8_t>(target[target_offset + idx] - base[base_offset + idx]));
+        }
+        base_pos = base_offset + len;
+    }
+
+    void data(const Bytes &target, uint32_t target_offset, uint32_t len)
+    {
+        ops.push_back(2);
+        put_varint(ops, len);
+        ops.insert(ops.end(), target.begin() + target_offset, target.begin() + target_offset + len);
+    }
+};
+
+Bytes pseudo_random(size_t size, uint32_t seed)
+{
+    Bytes out(size);
+    for (auto &byte : out) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+    return out;
+}
+
+// Something shaped like an app image: repeated tables, code-like noise, padding.
+Bytes image_like(size_t size, uint32_t seed)
+{
+    Bytes out;
+    const Bytes noise = pseudo_random(size / 3, seed);
+    while (out.size() < size) {
+        out.insert(out.end(), noise.begin(), noise.begin() + (out.size() % noise.size()) / 2 + 97);
+        for (uint32_t idx = 0; idx < 300; ++idx) {
+            out.push_back(static_cast<uint8_t>(idx % 24));
+        }
+        out.insert(out.end(), 500, 0xFF);
+    }
+    out.resize(size);
+    return out;
+}
+
+constexpr size_t kBlocks[] = {1, 3, 84, 85, 1024, 0};
+
+void test_magic_needs_every_byte()
+{
+    const uint8_t magic[] = {'O', 'T', 'A', 'Z', 1};
+    CHECK(Decoder::is_payload(magic, sizeof(magic)));
+    CHECK(Decoder::is_payload(magic, 4));
+    CHECK(!Decoder::is_payload(magic, 3));
+    CHECK(!Decoder::is_payload(magic, 1));
+    const uint8_t other[] = {'O', 'T', 'A', 'X'};
+    CHECK(!Decoder::is_payload(other, sizeof(other)));
+    // An app image starts with 0xE9 and never looks like a payload.
+    const uint8_t app[] = {0xE9, 0x03, 0x02, 0x20};
+    CHECK(!Decoder::is_payload(app, sizeof(app)));
+}
+
+void test_compressed_round_trip_in_any_block_size()
+{
+    const Bytes image = image_like(20000, 1);
+    // A 256-byte window wraps many times over the image.
+    for (uint8_t window_bits : {uint8_t{8}, uint8_t{12}}) {
+        const Bytes packed = payload(Kind::Compressed, window_bits, static_cast<uint32_t>(image.size()), image, 0);
+        for (size_t block : kBlocks) {
+            const ota_stream::ApplyResult result = apply(packed, {}, block);
+            CHECK(result.ok);
+            CHECK(result.image == image);
+            CHECK_EQ(result.window, size_t{1} << window_bits);
+        }
+        std::printf("compressed, window %u: %zu bytes for a %zu byte image\n", 1u << window_bits, packed.size(),
+                    image.size());
+    }
+}
+
+void test_delta_round_trip_in_any_block_size()
+{
+    const Bytes base = image_like(12000, 2);
+    // v2: a patched block, a moved function, new code and the rest unchanged.
+    Bytes target(base.begin(), base.begin() + 4000);
+    for (uint32_t idx = 4000; idx < 4600; ++idx) {
+        target.push_back(static_cast<uint8_t>(base[idx] + (idx % 7 == 0 ? 3 : 0)));
+    }
+    target.insert(target.end(), base.begin() + 9000, base.begin() + 10000);
+    const Bytes fresh = pseudo_random(700, 9);
+    target.insert(target.end(), fresh.begin(), fresh.end());
+    target.insert(target.end(), base.begin() + 4600, base.begin() + 9000);
+
+    DeltaOps delta;
+    delta.copy(0, 4000);
+    delta.add(4000, base, target, 4000, 600);
+    delta.copy(9000, 1000);
+    delta.data(target, 5600, 700);
+    delta.copy(4600, 4400);
+
+    const Bytes packed = payload(Kind::Delta, 12, static_cast<uint32_t>(target.size()), delta.ops,
+                                 static_cast<uint32_t>(base.size()));
+    for (size_t block : kBlocks) {
+        const ota_stream::ApplyResult result = apply(packed, base, block);
+        CHECK(result.ok);
+        CHECK(result.image == target);
+    }
+    std::printf("delta: %zu bytes for a %zu byte image\n", packed.size(), target.size());
+}
+
+void test_bad_payloads_are_refused()
+{
+    const Bytes image = image_like(3000, 3);
+    const Bytes packed = payload(Kind::Compressed, 10, static_cast<uint32_t>(image.size()), image, 0);
+
+    Bytes wrong_version = packed;
+    wrong_version[4] = ota_stream::kVersion + 1;
+    CHECK(apply(wrong_version, {}, 64).error == Error::BadHeader);
+
+    Bytes window_too_large = packed;
+    window_too_large[6] = ota_stream::kMaxWindowBits + 1;
+    CHECK(apply(window_too_large, {}, 64).error == Error::BadHeader);
+
+    const Bytes truncated(packed.begin(), packed.end() - 10);
+    const ota_stream::ApplyResult cut = apply(truncated, {}, 64);
+    CHECK(!cut.ok);
+    CHECK(cut.error == Error::Truncated);
+
+    Bytes trailing = packed;
+    trailing.push_back(0);
+    CHECK(apply(trailing, {}, 64).error == Error::Overrun);
+
+    // A delta reading past the base it was built against.
+    const Bytes base = image_like(1000, 4);
+    DeltaOps delta;
+    delta.copy(900, 200);
+    const Bytes out_of_range = payload(Kind::Delta, 10, 200, delta.ops, static_cast<uint32_t>(base.size()));
+    CHECK(apply(out_of_range, base, 64).error == Error::BaseRange);
+
+    // A base larger than the running slot is rejected before any write.
+    const Bytes too_large = payload(Kind::Delta, 10, 200, delta.ops, 5000);
+    const ota_stream::ApplyResult rejected = apply(too_large, base, 64);
+    CHECK(rejected.error == Error::Rejected);
+    CHECK(rejected.image.empty());
+}
+
+} // namespace
+
+int main()
+{
+    test_magic_needs_every_byte();
+    test_compressed_round_trip_in_any_block_size();
+    test_delta_round_trip_in_any_block_size();
+    test_bad_payloads_are_refused();
+    return host_check_result("ota_stream_test");
+}
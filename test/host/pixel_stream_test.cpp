@@ -0,0 +1,257 @@
+#include "host_check.h"
+
+#include "light/pixel_stream.h"
+#include "light/pixel_stream_sim.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using device_modules::light::PixelStream;
+using device_modules::light::SimulatedPixelOutput;
+using device_modules::light::StreamProtocol;
+
+namespace {
+
+constexpr size_t kPixels = 300;
+constexpr uint8_t kBytesPerPixel = 3;
+constexpr size_t kFrameBytes = kPixels * kBytesPerPixel;
+constexpr size_t kUniverseBytes = 510;
+constexpr uint16_t kDdpPort = 44048;
+constexpr uint16_t kE131Port = 45568;
+
+class Sender {
+public:
+    explicit Sender(uint16_t port) : m_socket(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP))
+    {
+        m_addr.sin_family = AF_INET;
+        m_addr.sin_port = htons(port);
+        m_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+    ~Sender() { close(m_socket); }
+
+    void send(const std::vector<uint8_t> &packet)
+    {
+        sendto(m_socket, packet.data(), packet.size(), 0, reinterpret_cast<const sockaddr *>(&m_addr), sizeof(m_addr));
+    }
+
+private:
+    int m_socket;
+    sockaddr_in m_addr{};
+};
+
+std::vector<uint8_t> frame_of(uint8_t seed)
+{
+    std::vector<uint8_t> frame(kFrameBytes);
+    for (size_t idx = 0; idx < frame.size(); ++idx) {
+        frame[idx] = static_cast<uint8_t>(seed + idx * 7);
+    }
+    return frame;
+}
+
+std::vector<uint8_t> ddp_packet(const std::vector<uint8_t> &frame, size_t offset, size_t length, bool push,
+                                uint8_t sequence)
+{
+    std::vector<uint8_t> packet = {static_cast<uint8_t>(0x40 | (push ? 0x01 : 0x00)), sequence, 0x0B, 1,
+                                   static_cast<uint8_t>(offset >> 24), static_cast<uint8_t>(offset >> 16),
+                                   static_cast<uint8_t>(offset >> 8), static_cast<uint8_t>(offset),
+                                   static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+    packet.insert(packet.end(), frame.begin() + offset, frame.begin() + offset + length);
+    return packet;
+}
+
+std::vector<uint8_t> e131_packet(const std::vector<uint8_t> &frame, uint16_t universe_index, uint8_t sequence)
+{
+    const size_t offset = universe_index * kUniverseBytes;
+    const size_t length = std::min(kUniverseBytes, frame.size() - offset);
+    std::vector<uint8_t> packet(126);
+    std::memcpy(packet.data() + 4, "ASC-E1.17\0\0\0", 12);
+    packet[21] = 0x04;  // root vector
+    packet[43] = 0x02;  // framing vector
+    packet[111] = sequence;
+    const uint16_t universe = static_cast<uint16_t>(1 + universe_index);
+    packet[113] = static_cast<uint8_t>(universe >> 8);
+    packet[114] = static_cast<uint8_t>(universe);
+    packet[117] = 0x02; // DMP set property
+    packet[123] = static_cast<uint8_t>((length + 1) >> 8);
+    packet[124] = static_cast<uint8_t>(length + 1);
+    packet.insert(packet.end(), frame.begin() + offset, frame.begin() + offset + length);
+    return packet;
+}
+
+// Counts frames that reach the strip mixed from two sent frames; every frame
+// the loopback test sends is a single value.
+class UniformCheckOutput : public SimulatedPixelOutput {
+public:
+    using SimulatedPixelOutput::SimulatedPixelOutput;
+
+    bool show(const uint8_t *framebuffer, uint8_t brightness) override
+    {
+        for (size_t idx = 1; idx < kFrameBytes; ++idx) {
+            if (framebuffer[idx] != framebuffer[0]) {
+                ++torn;
+                break;
+            }
+        }
+        return SimulatedPixelOutput::show(framebuffer, brightness);
+    }
+
+    uint32_t torn = 0;
+};
+
+PixelStream::Config config(StreamProtocol protocol, uint16_t port)
+{
+    return {protocol, port, 1, 60, 2500, SimulatedPixelOutput::steady_now_us};
+}
+
+void test_ddp_frame_spanning_two_packets()
+{
+    SimulatedPixelOutput output(kPixels, kBytesPerPixel);
+    PixelStream stream(output);
+    CHECK(stream.open(config(StreamProtocol::Ddp, kDdpPort)));
+    Sender sender(kDdpPort);
+
+    const std::vector<uint8_t> frame = frame_of(3);
+    sender.send(ddp_packet(frame, 0, 600, false, 1));
+    sender.send(ddp_packet(frame, 600, kFrameBytes - 600, true, 2));
+    for (int round = 0; round < 10 && output.shows() == 0; ++round) {
+        stream.poll(50);
+    }
+
+    // Full level latches the bytes unchanged.
+    CHECK(output.latched() == frame);
+    CHECK(stream.streaming());
+    const PixelStream::Stats stats = stream.stats();
+    CHECK_EQ(stats.packets, 2);
+    CHECK_EQ(stats.frames, 1);
+    CHECK_EQ(stats.sequence_gaps, 0);
+}
+
+void test_e131_frame_ends_with_the_last_universe()
+{
+    SimulatedPixelOutput output(kPixels, kBytesPerPixel);
+    PixelStream stream(output);
+    CHECK(stream.open(config(StreamProtocol::E131, kE131Port)));
+    Sender sender(kE131Port);
+
+    const std::vector<uint8_t> frame = frame_of(11);
+    sender.send(e131_packet(frame, 0, 0));
+    stream.poll(50);
+    CHECK_EQ(output.shows(), 0);
+    sender.send(e131_packet(frame, 1, 1));
+    for (int round = 0; round < 10 && output.shows() == 0; ++round) {
+        stream.poll(50);
+    }
+    CHECK(output.latched() == frame);
+    CHECK_EQ(stream.stats().frames, 1);
+}
+
+void test_foreign_packets_and_gaps_are_counted()
+{
+    SimulatedPixelOutput output(kPixels, kBytesPerPixel);
+    PixelStream stream(output);
+    CHECK(stream.open(config(StreamProtocol::Ddp, kDdpPort)));
+    Sender sender(kDdpPort);
+
+    const std::vector<uint8_t> frame = frame_of(5);
+    sender.send({0x00, 0x01, 0x02});
+    sender.send(ddp_packet(frame, 0, kFrameBytes, true, 1));
+    sender.send(ddp_packet(frame, 0, kFrameBytes, true, 4));
+    for (int round = 0; round < 10 && stream.stats().packets < 2; ++round) {
+        stream.poll(50);
+    }
+    const PixelStream::Stats stats = stream.stats();
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(stats.packets, 2);
+    CHECK_EQ(stats.sequence_gaps, 1);
+}
+
+void test_matter_level_scales_streamed_frames()
+{
+    SimulatedPixelOutput output(kPixels, kBytesPerPixel);
+    PixelStream stream(output);
+    CHECK(stream.open(config(StreamProtocol::Ddp, kDdpPort)));
+    Sender sender(kDdpPort);
+
+    const std::vector<uint8_t> frame(kFrameBytes, 200);
+    sender.send(ddp_packet(frame, 0, kFrameBytes, true, 0));
+    for (int round = 0; round < 10 && output.shows() == 0; ++round) {
+        stream.poll(50);
+    }
+    // Half level re-latches the streamed frame, not the solid colour.
+    stream.set_matter_state(true, 127, 0, 0, 255);
+    CHECK_EQ(output.latched()[0], (200 * 128) >> 8);
+    stream.set_matter_state(false, 127, 0, 0, 255);
+    CHECK_EQ(output.latched()[0], 0);
+}
+
+// 60 fps from a paced sender while another thread keeps re-latching through
+// set_matter_state(), as the CHIP task does: every frame must reach the strip
+// whole. The loopback fps and latency are printed as the reference for
+// `matter esp stream` on the device.
+void test_loopback_rate_and_latency()
+{
+    UniformCheckOutput output(kPixels, kBytesPerPixel);
+    PixelStream stream(output);
+    CHECK(stream.open(config(StreamProtocol::Ddp, kDdpPort)));
+
+    constexpr int kFrames = 90;
+    std::atomic<bool> done{false};
+    std::thread sender_thread([&done] {
+        Sender sender(kDdpPort);
+        const auto start = std::chrono::steady_clock::now();
+        for (int idx = 0; idx < kFrames; ++idx) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(idx * 1'000'000 / 60));
+            const std::vector<uint8_t> frame(kFrameBytes, static_cast<uint8_t>(idx));
+            sender.send(ddp_packet(frame, 0, 600, false, static_cast<uint8_t>(idx * 2 % 15 + 1)));
+            sender.send(ddp_packet(frame, 600, kFrameBytes - 600, true, static_cast<uint8_t>((idx * 2 + 1) % 15 + 1)));
+        }
+        done.store(true);
+    });
+    std::thread matter_thread([&stream, &done] {
+        while (!done.load()) {
+            stream.set_matter_state(true, 254, 255, 255, 255);
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        }
+    });
+
+    while (!done.load()) {
+        stream.poll(20);
+    }
+    sender_thread.join();
+    matter_thread.join();
+    stream.poll(20);
+
+    const PixelStream::Stats stats = stream.stats();
+    std::printf("loopback: %u frames of %zu pixels, %u.%u fps, latency avg %u us, max %u us\n",
+                static_cast<unsigned>(stats.frames), kPixels, static_cast<unsigned>(stats.fps_x10 / 10),
+                static_cast<unsigned>(stats.fps_x10 % 10), static_cast<unsigned>(stats.latency_avg_us),
+                static_cast<unsigned>(stats.latency_max_us));
+    CHECK_EQ(stats.packets, kFrames * 2);
+    CHECK_EQ(stats.frames + stats.coalesced, kFrames);
+    CHECK(stats.frames >= kFrames * 3 / 4);
+    CHECK(stats.fps_x10 >= 450 && stats.fps_x10 <= 650);
+    CHECK_EQ(stats.sequence_gaps, 0);
+    CHECK(stats.latency_avg_us < 5000);
+    CHECK_EQ(output.torn, 0);
+    CHECK_EQ(output.latched()[0], kFrames - 1);
+}
+
+} // namespace
+
+int main()
+{
+    test_ddp_frame_spanning_two_packets();
+    test_e131_frame_ends_with_the_last_universe();
+    test_foreign_packets_and_gaps_are_counted();
+    test_matter_level_scales_streamed_frames();
+    test_loopback_rate_and_latency();
+    return host_check_result("pixel_stream_test");
+}
@@ -0,0 +1,146 @@
+#include "host_check.h"
+
+#include "sensor/sensor_pipeline.h"
+#include "sensor/sensor_sim.h"
+
+#include <cstdio>
+
+using device_modules::sensor::SensorPipeline;
+using device_modules::sensor::SimulatedPresence;
+using device_modules::sensor::SimulatedSensor;
+
+namespace {
+
+constexpr uint64_t kDayMs = 24ull * 3600 * 1000;
+
+SensorPipeline pipeline_with(const SensorPipeline::Config &config)
+{
+    SensorPipeline pipeline;
+    pipeline.configure(config);
+    return pipeline;
+}
+
+void test_median_drops_a_single_spike()
+{
+    SensorPipeline pipeline = pipeline_with({false, 3, 0, 10, 0, 0, 0, 0});
+    int32_t out = 0;
+    CHECK(pipeline.on_sample(100, 0, out));
+    CHECK_EQ(out, 100);
+    CHECK(!pipeline.on_sample(100, 1000, out));
+    CHECK(!pipeline.on_sample(900, 2000, out));
+    CHECK(!pipeline.on_sample(100, 3000, out));
+    CHECK_EQ(pipeline.value(), 100);
+    CHECK_EQ(pipeline.stats().writes, 1);
+}
+
+void test_threshold_and_hysteresis()
+{
+    SensorPipeline pipeline = pipeline_with({false, 1, 0, 10, 5, 0, 0, 0});
+    int32_t out = 0;
+    pipeline.on_sample(100, 0, out);
+    CHECK(!pipeline.on_sample(109, 1000, out));
+    CHECK(pipeline.on_sample(112, 2000, out));
+    CHECK_EQ(out, 112);
+    // Turning back takes threshold + hysteresis.
+    CHECK(!pipeline.on_sample(100, 3000, out));
+    CHECK_EQ(pipeline.stats().held, 1);
+    CHECK(pipeline.on_sample(97, 4000, out));
+    CHECK_EQ(out, 97);
+    // Carrying on the same way only takes the threshold again.
+    CHECK(pipeline.on_sample(87, 5000, out));
+}
+
+void test_min_interval_defers_and_max_interval_refreshes()
+{
+    SensorPipeline pipeline = pipeline_with({false, 1, 0, 10, 0, 5000, 60000, 0});
+    int32_t out = 0;
+    pipeline.on_sample(100, 0, out);
+    CHECK(!pipeline.on_sample(150, 1000, out));
+    CHECK_EQ(pipeline.stats().deferred, 1);
+    CHECK_EQ(pipeline.next_due_ms(), 5000);
+    CHECK(!pipeline.poll(4999, out));
+    CHECK(pipeline.poll(5000, out));
+    CHECK_EQ(out, 150);
+
+    // A change below the threshold goes out once max_interval_ms has passed.
+    CHECK(!pipeline.on_sample(153, 6000, out));
+    CHECK_EQ(pipeline.next_due_ms(), 65000);
+    CHECK(pipeline.poll(65000, out));
+    CHECK_EQ(out, 153);
+    CHECK_EQ(pipeline.next_due_ms(), SensorPipeline::kNever);
+}
+
+void test_smoothing_converges_in_integers()
+{
+    SensorPipeline pipeline = pipeline_with({false, 1, 2, 1, 0, 0, 0, 0});
+    int32_t out = 0;
+    pipeline.on_sample(0, 0, out);
+    for (uint64_t idx = 1; idx <= 40; ++idx) {
+        pipeline.on_sample(1000, idx * 1000, out);
+    }
+    CHECK_EQ(pipeline.filtered(), 1000);
+    // Negative values round symmetrically.
+    SensorPipeline negative = pipeline_with({false, 1, 2, 1, 0, 0, 0, 0});
+    negative.on_sample(-1000, 0, out);
+    CHECK_EQ(negative.filtered(), -1000);
+}
+
+void test_occupancy_sets_at_once_and_clears_after_hold()
+{
+    SensorPipeline pipeline = pipeline_with({true, 1, 0, 0, 0, 0, 0, 30000});
+    int32_t out = 0;
+    CHECK(pipeline.on_sample(0, 0, out));
+    CHECK_EQ(out, 0);
+    CHECK(pipeline.on_sample(1, 1000, out));
+    CHECK_EQ(out, 1);
+    CHECK(!pipeline.on_sample(0, 2000, out));
+    CHECK_EQ(pipeline.next_due_ms(), 32000);
+    // Motion again before the hold ends restarts it.
+    CHECK(!pipeline.on_sample(1, 20000, out));
+    CHECK(!pipeline.on_sample(0, 21000, out));
+    CHECK(!pipeline.poll(32000, out));
+    CHECK(pipeline.poll(51000, out));
+    CHECK_EQ(out, 0);
+}
+
+// A day of temperature at the YAML defaults, on the `source: sim` profile.
+void test_simulated_day_of_temperature()
+{
+    SimulatedSensor sensor({2150, 150, 24 * 3600 * 1000, 15, 5, 300}, 3);
+    SensorPipeline pipeline = pipeline_with({false, 3, 2, 20, 5, 10000, 900000, 0});
+    const auto result = simulate(pipeline, sensor, kDayMs, 10000);
+    std::printf("temperature day: %u writes for %u raw changes, max error %u, mean %u.%03u (0.01 C)\n",
+                static_cast<unsigned>(result.stats.writes), static_cast<unsigned>(result.stats.raw_changes),
+                static_cast<unsigned>(result.max_error), static_cast<unsigned>(result.mean_error_x1000 / 1000),
+                static_cast<unsigned>(result.mean_error_x1000 % 1000));
+    CHECK_EQ(result.stats.samples, kDayMs / 10000);
+    CHECK(result.stats.writes * 20 < result.stats.raw_changes);
+    // Never further from the truth than threshold plus hysteresis.
+    CHECK(result.max_error <= 25);
+}
+
+void test_simulated_presence()
+{
+    SimulatedPresence presence({10 * 60 * 1000, 3 * 60 * 1000, 300}, 5);
+    SensorPipeline pipeline = pipeline_with({true, 1, 0, 0, 0, 0, 0, 30000});
+    const auto result = simulate(pipeline, presence, kDayMs, 1000);
+    std::printf("presence day: %u writes for %u raw changes\n", static_cast<unsigned>(result.stats.writes),
+                static_cast<unsigned>(result.stats.raw_changes));
+    // About one set and one clear per visit, far fewer than the PIR toggles.
+    CHECK(result.stats.writes * 5 < result.stats.raw_changes);
+    CHECK(result.stats.writes >= 2);
+}
+
+} // namespace
+
+int main()
+{
+    test_median_drops_a_single_spike();
+    test_threshold_and_hysteresis();
+    test_min_interval_defers_and_max_interval_refreshes();
+    test_smoothing_converges_in_integers();
+    test_occupancy_sets_at_once_and_clears_after_hold();
+    test_simulated_day_of_temperature();
+    test_simulated_presence();
+    return host_check_result("sensor_test");
+}
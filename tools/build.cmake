@@ -22,6 +22,7 @@ add_custom_target(
 set(CONFIG_YAML ${CMAKE_SOURCE_DIR}/config.yaml)
 set(GENERATED_HEADER ${CMAKE_BINARY_DIR}/generated_config.h)
 set(PARSED_CONFIG ${CMAKE_BINARY_DIR}/parsed_config.yaml)
+set(DEVICE_CONFIG_BLOB ${CMAKE_BINARY_DIR}/device_config.bin)
 
 add_custom_command(
     OUTPUT ${PARSED_CONFIG}
@@ -32,11 +33,12 @@ add_custom_command(
 )
 
 add_custom_command(
-    OUTPUT ${GENERATED_HEADER}
+    OUTPUT ${GENERATED_HEADER} ${DEVICE_CONFIG_BLOB}
     COMMAND ${PYTHON} ${CMAKE_SOURCE_DIR}/tools/render_config.py ${PARSED_CONFIG} ${GENERATED_HEADER} ${CMAKE_SOURCE_DIR}
     DEPENDS
         ${PARSED_CONFIG}
         ${CMAKE_SOURCE_DIR}/tools/render_config.py
+        ${CMAKE_SOURCE_DIR}/tools/config_layout.py
         ${CMAKE_SOURCE_DIR}/templates/sdkconfig.defaults_wifi
         ${CMAKE_SOURCE_DIR}/templates/sdkconfig.defaults_thread
         ${CMAKE_SOURCE_DIR}/templates/sdkconfig.defaults_wifi_thread
@@ -48,4 +50,4 @@ add_custom_command(
 )
 
 # Add a custom target to depend on the generated file. This ensures it's generated.
-add_custom_target(generate_config ALL DEPENDS ${GENERATED_HEADER} ${PARSED_CONFIG})
+add_custom_target(generate_config ALL DEPENDS ${GENERATED_HEADER} ${DEVICE_CONFIG_BLOB} ${PARSED_CONFIG})
@@ -0,0 +1,59 @@
+import argparse
+import re
+import subprocess
+import sys
+
+FUNCTION = re.compile(r"^[0-9a-f]+ <(.+)>:$")
+CALL_TARGET = re.compile(r"<([^<>+]+)>\s*$")
+
+
+def direct_callers(disassembly: str, symbols: set[str]) -> dict[str, set[str]]:
+    """Maps each symbol to the functions that branch to its entry point."""
+    callers: dict[str, set[str]] = {symbol: set() for symbol in symbols}
+    current = ""
+    for line in disassembly.splitlines():
+        header = FUNCTION.match(line)
+        if header:
+            current = header.group(1)
+            continue
+        target = CALL_TARGET.search(line)
+        if target and target.group(1) in symbols and target.group(1) != current:
+            callers[target.group(1)].add(current)
+    return callers
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Fail when a function wrapped with -Wl,--wrap is still called directly. "
+        "--wrap only redirects references between object files, so callers in the defining "
+        "object, or a symbol whose mangled name no longer matches, bypass the wrapper.")
+    parser.add_argument("--objdump", required=True, help="Toolchain objdump")
+    parser.add_argument("--allow", action="append", default=[],
+                        help="Symbol prefix of the code that owns the wraps and calls the real functions")
+    parser.add_argument("elf", help="Linked firmware ELF (build/<project>.elf)")
+    parser.add_argument("symbols", nargs="+", help="Wrapped symbols as passed to --wrap")
+    args = parser.parse_args()
+
+    disassembly = subprocess.run([args.objdump, "-d", "--no-show-raw-insn", args.elf],
+                                 check=True, capture_output=True, text=True).stdout
+    wrapped = set(args.symbols)
+    callers = direct_callers(disassembly, wrapped | {f"__wrap_{symbol}" for symbol in wrapped})
+
+    allowed = ("__wrap_", *args.allow)
+    errors = []
+    for symbol in sorted(wrapped):
+        # The wrappers reach the real function through __real_, and the wrapped
+        # overloads may call each other inside the defining object.
+        bypass = {caller for caller in callers[symbol] if not caller.startswith(allowed) and caller not in wrapped}
+        for caller in sorted(bypass):
+            errors.append(f"{symbol}: called directly from {caller}, bypassing __wrap_{symbol}")
+        if not callers[f"__wrap_{symbol}"] and not bypass:
+            print(f"check_wraps: {symbol} has no callers in {args.elf}", file=sys.stderr)
+
+    for error in errors:
+        print(f"check_wraps: {error}", file=sys.stderr)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
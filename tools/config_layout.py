@@ -0,0 +1,431 @@
+"""Binary layout shared by generated_config.h and the device config blob.
+
+Every struct is described once here. render_config.py turns the same ctypes
+instances into C++ initializers for the header and into the bytes of the
+partition blob, so both always agree. All fields are fixed-size and
+pointer-free; ctypes native alignment on a 64-bit host matches the ILP32
+RISC-V/Xtensa ABI for the types used (no pointers, 64-bit integers or floats).
+"""
+
+import ctypes
+import hashlib
+import zlib
+from typing import Any
+
+ID_LEN = 24
+NAME_LEN = 32
+VALUE_LEN = 48
+FEATURE_LEN = 20
+MAX_FEATURES = 5
+
+MAX_BUTTONS = 8
+MAX_ENCODERS = 4
+MAX_ENDPOINTS = 8
+
+BLOB_MAGIC = 0x47464344  # "DCFG" little-endian
+BLOB_VERSION = 2  # 2: the CRC also covers the header
+# Size of the devcfg partition in partitions.csv and the yml2esp templates.
+DEVCFG_PARTITION_SIZE = 0x1000
+
+SCALAR_TYPES = {
+    "bool": ctypes.c_bool,
+    "int": ctypes.c_int,
+    "int32_t": ctypes.c_int32,
+    "uint8_t": ctypes.c_uint8,
+    "uint16_t": ctypes.c_uint16,
+    "uint32_t": ctypes.c_uint32,
+}
+
+# (C++ struct name, namespace, [(field, type)]). Types are scalars, "char[N]",
+# "char[N][M]" or a previously declared struct name.
+STRUCTS: list[tuple[str, str, list[tuple[str, str]]]] = [
+    ("config_t", "button", [
+        ("id", f"char[{ID_LEN}]"),
+        ("gpio", "int"),
+        ("active_level", "int"),
+        ("long_press_time_ms", "int"),
+        ("short_press_timeout_ms", "int"),
+        ("identify_trigger_count", "int"),
+        ("identify_time_s", "int"),
+        ("mode", f"char[{ID_LEN}]"),
+        ("action_cluster", f"char[{ID_LEN}]"),
+        ("action_command", f"char[{ID_LEN}]"),
+        ("action_identify_time_s", "int"),
+        ("binding_endpoint", "uint16_t"),
+        ("target_endpoint", "uint16_t"),
+        ("driver", f"char[{ID_LEN}]"),
+        ("hold_time_ms", "int"),
+        ("action_move_rate", "int"),
+        ("factory_reset", "bool"),
+        ("gesture_policy", f"char[{ID_LEN}]"),
+        ("multi_click_window_ms", "int"),
+        ("double_action_cluster", f"char[{ID_LEN}]"),
+        ("double_action_command", f"char[{ID_LEN}]"),
+        ("triple_action_cluster", f"char[{ID_LEN}]"),
+        ("triple_action_command", f"char[{ID_LEN}]"),
+    ]),
+    ("config_t", "encoder", [
+        ("id", f"char[{ID_LEN}]"),
+        ("gpio_a", "int"),
+        ("gpio_b", "int"),
+        ("counts_per_detent", "int"),
+        ("step_size", "int"),
+        ("max_step_size", "int"),
+        ("coalesce_interval_ms", "int"),
+        ("acceleration_threshold_dps", "int"),
+        ("glitch_filter_ns", "int"),
+        ("mode", f"char[{ID_LEN}]"),
+        ("binding_endpoint", "uint16_t"),
+        ("target_endpoint", "uint16_t"),
+    ]),
+    ("optional_bool", "", [("has_value", "bool"), ("value", "bool")]),
+    ("optional_int", "", [("has_value", "bool"), ("value", "int32_t")]),
+    ("optional_string", "", [("has_value", "bool"), ("value", f"char[{VALUE_LEN}]")]),
+    ("string_list", "", [("count", "uint8_t"), ("items", f"char[{MAX_FEATURES}][{FEATURE_LEN}]")]),
+    ("identify_cluster_raw", "", [
+        ("present", "bool"),
+        ("enabled", "optional_bool"),
+        ("identify_time", "optional_int"),
+        ("identify_type", "optional_int"),
+    ]),
+    ("groups_cluster_raw", "", [("present", "bool"), ("enabled", "optional_bool")]),
+    ("scenes_management_cluster_raw", "", [
+        ("present", "bool"),
+        ("enabled", "optional_bool"),
+        ("scene_table_size", "optional_int"),
+    ]),
+    ("on_off_cluster_raw", "", [
+        ("present", "bool"),
+        ("enabled", "optional_bool"),
+        ("state", "optional_bool"),
+        ("features", "string_list"),
+    ]),
+    ("level_control_cluster_raw", "", [
+        ("present", "bool"),
+        ("enabled", "optional_bool"),
+        ("current_level", "optional_int"),
+        ("options", "optional_int"),
+        ("on_level", "optional_int"),
+        ("features", "string_list"),
+    ]),
+    ("color_control_cluster_raw", "", [
+        ("present", "bool"),
+        ("enabled", "optional_bool"),
+        ("color_mode", "optional_string"),
+        ("enhanced_color_mode", "optional_string"),
+        ("current_hue", "optional_int"),
+        ("current_saturation", "optional_int"),
+        ("color_temperature_mireds", "optional_int"),
+        ("remaining_time", "optional_int"),
+        ("features", "string_list"),
+    ]),
+    ("endpoint_raw", "", [
+        ("id", "uint16_t"),
+        ("device_type", f"char[{ID_LEN}]"),
+        ("identify", "identify_cluster_raw"),
+        ("groups", "groups_cluster_raw"),
+        ("scenes_management", "scenes_management_cluster_raw"),
+        ("on_off", "on_off_cluster_raw"),
+        ("level_control", "level_control_cluster_raw"),
+        ("color_control", "color_control_cluster_raw"),
+    ]),
+    ("device_info", "", [
+        ("device_type", f"char[{ID_LEN}]"),
+        ("device_name", f"char[{NAME_LEN}]"),
+        ("led_count", "int"),
+        ("led_rmt_gpio", "int"),
+        ("led_type", f"char[{ID_LEN}]"),
+    ]),
+    ("blob_header", "", [
+        ("magic", "uint32_t"),
+        ("version", "uint16_t"),
+        ("header_size", "uint16_t"),
+        ("layout_hash", "uint32_t"),
+        ("total_size", "uint32_t"),
+        ("crc32", "uint32_t"),
+        ("button_count", "uint8_t"),
+        ("encoder_count", "uint8_t"),
+        ("endpoint_count", "uint8_t"),
+        ("reserved", "uint8_t"),
+        ("device_offset", "uint32_t"),
+        ("button_offset", "uint32_t"),
+        ("encoder_offset", "uint32_t"),
+        ("endpoint_offset", "uint32_t"),
+    ]),
+]
+
+
+def _ctype_for(type_name: str, classes: dict[str, type]) -> Any:
+    if type_name.startswith("char["):
+        dims = [int(part.rstrip("]")) for part in type_name[len("char["):].split("[")]
+        ctype: Any = ctypes.c_char * dims[-1]
+        for dim in reversed(dims[:-1]):
+            ctype = ctype * dim
+        return ctype
+    if type_name in SCALAR_TYPES:
+        return SCALAR_TYPES[type_name]
+    return classes[type_name]
+
+
+def _build_classes() -> dict[str, type]:
+    classes: dict[str, type] = {}
+    for name, namespace, fields in STRUCTS:
+        key = f"{namespace}::{name}" if namespace else name
+        cls = type(key.replace("::", "_"), (ctypes.Structure,), {
+            "_fields_": [(field, _ctype_for(type_name, classes)) for field, type_name in fields],
+        })
+        classes[key] = cls
+    return classes
+
+
+CLASSES = _build_classes()
+ButtonConfig = CLASSES["button::config_t"]
+EncoderConfig = CLASSES["encoder::config_t"]
+EndpointRaw = CLASSES["endpoint_raw"]
+DeviceInfo = CLASSES["device_info"]
+BlobHeader = CLASSES["blob_header"]
+
+
+def layout_hash() -> int:
+    """Hash of every field name, type and offset; changes whenever the layout does."""
+    digest = hashlib.sha256()
+    for name, namespace, fields in STRUCTS:
+        cls = CLASSES[f"{namespace}::{name}" if namespace else name]
+        digest.update(f"{namespace}::{name}:{ctypes.sizeof(cls)};".encode())
+        for field, type_name in fields:
+            digest.update(f"{field}:{type_name}@{getattr(cls, field).offset};".encode())
+    return int.from_bytes(digest.digest()[:4], "little")
+
+
+def cpp_struct(name: str, fields: list[tuple[str, str]]) -> str:
+    lines = [f"struct {name} {{"]
+    for field, type_name in fields:
+        if type_name.startswith("char["):
+            lines.append(f"    char {field}{type_name[len('char'):]};")
+        else:
+            lines.append(f"    {type_name} {field};")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def set_string(target: Any, field: str, value: str | None, size: int) -> None:
+    encoded = (value or "").encode("utf-8")
+    if len(encoded) >= size:
+        raise ValueError(f"'{value}' is too long for field '{field}' (max {size - 1} bytes).")
+    setattr(target, field, encoded)
+
+
+def _optional_bool(value: bool | None) -> Any:
+    return CLASSES["optional_bool"](value is not None, bool(value))
+
+
+def _optional_int(value: int | None) -> Any:
+    return CLASSES["optional_int"](value is not None, int(value or 0))
+
+
+def _optional_string(value: str | None) -> Any:
+    result = CLASSES["optional_string"]()
+    result.has_value = value is not None
+    set_string(result, "value", value, VALUE_LEN)
+    return result
+
+
+def _string_list(values: list[str]) -> Any:
+    if len(values) > MAX_FEATURES:
+        raise ValueError(f"At most {MAX_FEATURES} features are supported per cluster, got {len(values)}.")
+    result = CLASSES["string_list"]()
+    result.count = len(values)
+    for idx, value in enumerate(values):
+        encoded = value.encode("utf-8")
+        if len(encoded) >= FEATURE_LEN:
+            raise ValueError(f"Feature name '{value}' is too long (max {FEATURE_LEN - 1} bytes).")
+        result.items[idx].value = encoded
+    return result
+
+
+def make_button(button: dict[str, Any]) -> Any:
+    cfg = ButtonConfig()
+    set_string(cfg, "id", button.get("id"), ID_LEN)
+    cfg.gpio = button.get("gpio", -1)
+    cfg.active_level = button.get("active_level", 0)
+    cfg.long_press_time_ms = button.get("long_press_time_ms", 5000)
+    cfg.short_press_timeout_ms = button.get("short_press_timeout_ms", 2000)
+    cfg.identify_trigger_count = button.get("identify_trigger_count", 5)
+    cfg.identify_time_s = button.get("identify_time_s", 10)
+    set_string(cfg, "mode", button.get("mode", "remote"), ID_LEN)
+    set_string(cfg, "action_cluster", button.get("action_cluster", "on_off"), ID_LEN)
+    set_string(cfg, "action_command", button.get("action_command", "toggle"), ID_LEN)
+    cfg.action_identify_time_s = button.get("action_identify_time_s", 10)
+    cfg.binding_endpoint = button.get("binding_endpoint", 0)
+    cfg.target_endpoint = button.get("target_endpoint", 0)
+    set_string(cfg, "driver", button.get("driver"), ID_LEN)
+    cfg.hold_time_ms = button.get("hold_time_ms", 500)
+    cfg.action_move_rate = button.get("action_move_rate", 64)
+    cfg.factory_reset = bool(button.get("factory_reset", True))
+    set_string(cfg, "gesture_policy", button.get("gesture_policy", "immediate"), ID_LEN)
+    cfg.multi_click_window_ms = button.get("multi_click_window_ms", 300)
+    for gesture in ("double", "triple"):
+        gesture_action = button.get(f"{gesture}_action") or {}
+        for field in ("cluster", "command"):
+            set_string(cfg, f"{gesture}_action_{field}", gesture_action.get(field), ID_LEN)
+    return cfg
+
+
+def make_encoder(encoder: dict[str, Any]) -> Any:
+    cfg = EncoderConfig()
+    set_string(cfg, "id", encoder.get("id"), ID_LEN)
+    cfg.gpio_a = encoder["gpio_a"]
+    cfg.gpio_b = encoder["gpio_b"]
+    cfg.counts_per_detent = encoder.get("counts_per_detent", 4)
+    cfg.step_size = encoder.get("step_size", 8)
+    cfg.max_step_size = encoder.get("max_step_size", 64)
+    cfg.coalesce_interval_ms = encoder.get("coalesce_interval_ms", 100)
+    cfg.acceleration_threshold_dps = encoder.get("acceleration_threshold_dps", 10)
+    cfg.glitch_filter_ns = encoder.get("glitch_filter_ns", 1000)
+    set_string(cfg, "mode", encoder.get("mode", "local"), ID_LEN)
+    cfg.binding_endpoint = encoder.get("binding_endpoint", 0)
+    cfg.target_endpoint = encoder.get("target_endpoint", 0)
+    return cfg
+
+
+def make_endpoint(endpoint: dict[str, Any]) -> Any:
+    raw = EndpointRaw()
+    raw.id = int(endpoint["id"])
+    set_string(raw, "device_type", endpoint.get("device_type"), ID_LEN)
+
+    identify = endpoint.get("identify") or {}
+    raw.identify.present = bool(identify.get("present"))
+    raw.identify.enabled = _optional_bool(identify.get("enabled"))
+    raw.identify.identify_time = _optional_int(identify.get("identify_time"))
+    raw.identify.identify_type = _optional_int(identify.get("identify_type"))
+
+    groups = endpoint.get("groups") or {}
+    raw.groups.present = bool(groups.get("present"))
+    raw.groups.enabled = _optional_bool(groups.get("enabled"))
+
+    scenes = endpoint.get("scenes_management") or {}
+    raw.scenes_management.present = bool(scenes.get("present"))
+    raw.scenes_management.enabled = _optional_bool(scenes.get("enabled"))
+    raw.scenes_management.scene_table_size = _optional_int(scenes.get("scene_table_size"))
+
+    on_off = endpoint.get("on_off") or {}
+    raw.on_off.present = bool(on_off.get("present"))
+    raw.on_off.enabled = _optional_bool(on_off.get("enabled"))
+    raw.on_off.state = _optional_bool(on_off.get("state"))
+    raw.on_off.features = _string_list(on_off.get("features") or [])
+
+    level = endpoint.get("level_control") or {}
+    raw.level_control.present = bool(level.get("present"))
+    raw.level_control.enabled = _optional_bool(level.get("enabled"))
+    raw.level_control.current_level = _optional_int(level.get("current_level"))
+    raw.level_control.options = _optional_int(level.get("options"))
+    raw.level_control.on_level = _optional_int(level.get("on_level"))
+    raw.level_control.features = _string_list(level.get("features") or [])
+
+    color = endpoint.get("color_control") or {}
+    raw.color_control.present = bool(color.get("present"))
+    raw.color_control.enabled = _optional_bool(color.get("enabled"))
+    raw.color_control.color_mode = _optional_string(color.get("color_mode"))
+    raw.color_control.enhanced_color_mode = _optional_string(color.get("enhanced_color_mode"))
+    raw.color_control.current_hue = _optional_int(color.get("current_hue"))
+    raw.color_control.current_saturation = _optional_int(color.get("current_saturation"))
+    raw.color_control.color_temperature_mireds = _optional_int(color.get("color_temperature_mireds"))
+    raw.color_control.remaining_time = _optional_int(color.get("remaining_time"))
+    raw.color_control.features = _string_list(color.get("features") or [])
+    return raw
+
+
+def make_device_info(data: dict[str, Any]) -> Any:
+    info = DeviceInfo()
+    set_string(info, "device_type", data.get("device_type", "light"), ID_LEN)
+    set_string(info, "device_name", data.get("device_name", "ESP32 Matter Device"), NAME_LEN)
+    led_strip = data.get("led_strip") or {}
+    info.led_count = int(led_strip.get("led_count", 0))
+    info.led_rmt_gpio = int(led_strip.get("rmt_gpio", -1))
+    set_string(info, "led_type", str(led_strip.get("type", "ws2812")), ID_LEN)
+    return info
+
+
+def build_records(data: dict[str, Any]) -> tuple[Any, list[Any], list[Any], list[Any]]:
+    buttons = [make_button(b) for b in data.get("buttons") or []]
+    encoders = [make_encoder(e) for e in data.get("encoders") or []]
+    endpoints = [make_endpoint(e) for e in data.get("endpoints") or []]
+    for label, records, limit in (("buttons", buttons, MAX_BUTTONS),
+                                  ("encoders", encoders, MAX_ENCODERS),
+                                  ("endpoints", endpoints, MAX_ENDPOINTS)):
+        if len(records) > limit:
+            raise ValueError(f"At most {limit} {label} are supported, got {len(records)}.")
+    return make_device_info(data), buttons, encoders, endpoints
+
+
+def _align(offset: int, alignment: int = 4) -> int:
+    return (offset + alignment - 1) & ~(alignment - 1)
+
+
+def pack_blob(data: dict[str, Any]) -> bytes:
+    device, buttons, encoders, endpoints = build_records(data)
+
+    header = BlobHeader()
+    header.magic = BLOB_MAGIC
+    header.version = BLOB_VERSION
+    header.header_size = ctypes.sizeof(BlobHeader)
+    header.layout_hash = layout_hash()
+    header.button_count = len(buttons)
+    header.encoder_count = len(encoders)
+    header.endpoint_count = len(endpoints)
+
+    body = bytearray()
+    offset = ctypes.sizeof(BlobHeader)
+
+    def append(records: list[Any]) -> int:
+        nonlocal offset
+        start = _align(offset)
+        body.extend(b"\0" * (start - offset))
+        for record in records:
+            body.extend(bytes(record))
+        offset = start + sum(ctypes.sizeof(r) for r in records)
+        return start
+
+    header.device_offset = append([device])
+    header.button_offset = append(buttons)
+    header.encoder_offset = append(encoders)
+    header.endpoint_offset = append(endpoints)
+    header.total_size = ctypes.sizeof(BlobHeader) + len(body)
+    header.crc32 = blob_crc(bytes(header) + bytes(body))
+    blob = bytes(header) + bytes(body)
+    if len(blob) > DEVCFG_PARTITION_SIZE:
+        raise ValueError(f"Device config needs {len(blob)} bytes, more than the {DEVCFG_PARTITION_SIZE} byte devcfg "
+                         f"partition; use fewer buttons, encoders or endpoints.")
+    return blob
+
+
+def blob_crc(blob: bytes) -> int:
+    """CRC-32 of the header and body, with the header's crc32 field taken as zero."""
+    header = BlobHeader.from_buffer_copy(blob)
+    header.crc32 = 0
+    return zlib.crc32(bytes(header) + blob[ctypes.sizeof(BlobHeader):header.total_size]) & 0xFFFFFFFF
+
+
+def cpp_value(value: Any, indent: int) -> str:
+    """Renders a ctypes value as a C++ aggregate initializer."""
+    pad = " " * indent
+    if isinstance(value, ctypes.Structure):
+        lines = ["{"]
+        for field, _ in value._fields_:
+            lines.append(f"{pad}    .{field} = {cpp_value(getattr(value, field), indent + 4)},")
+        lines.append(f"{pad}}}")
+        return "\n".join(lines)
+    if isinstance(value, ctypes.Array):
+        if value._type_ is ctypes.c_char:
+            return '"' + cpp_string_literal(value.value.decode("utf-8")) + '"'
+        items = ", ".join(cpp_value(item, indent) for item in value)
+        return "{" + items + "}"
+    if isinstance(value, bytes):
+        return '"' + cpp_string_literal(value.decode("utf-8")) + '"'
+    if isinstance(value, bool):
+        return "true" if value else "false"
+    return str(value)
+
+
+def cpp_string_literal(value: str) -> str:
+    return value.replace("\\", "\\\\").replace('"', '\\"')
@@ -0,0 +1,78 @@
+import argparse
+import re
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+DLOG_LINE = re.compile(r"DLOG:(\d+):(\d+):([0-9a-fA-F]+):([0-9a-fA-F]+):([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+)")
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXcsp%])")
+LEVELS = {1: "E", 2: "W", 3: "I", 4: "D", 5: "V"}
+
+
+class StringTable:
+    """Reads NUL-terminated strings out of the loadable sections of the firmware ELF."""
+
+    def __init__(self, path: str) -> None:
+        self._sections = []
+        with open(path, "rb") as f:
+            elf = ELFFile(f)
+            for section in elf.iter_sections():
+                if section["sh_addr"] and section["sh_type"] == "SHT_PROGBITS":
+                    self._sections.append((section["sh_addr"], section.data()))
+
+    def read(self, address: int) -> str | None:
+        for start, data in self._sections:
+            if start <= address < start + len(data):
+                end = data.find(b"\0", address - start)
+                return data[address - start:end].decode(errors="replace")
+        return None
+
+
+def format_record(strings: StringTable, fmt: str, args: list[int]) -> str:
+    words = iter(args)
+
+    def convert(match: re.Match) -> str:
+        flags, _, conv = match.groups()
+        if conv == "%":
+            return "%"
+        word = next(words, 0)
+        if conv == "s":
+            text = strings.read(word)
+            return f"%{flags}s" % (text if text is not None else f"<0x{word:08x}>")
+        if conv == "p":
+            return f"0x{word:x}"
+        if conv in "di":
+            word = word - (1 << 32) if word & 0x80000000 else word
+        if conv == "c":
+            return chr(word & 0xFF)
+        return f"%{flags}{conv}" % word
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Decode DLOG: lines captured from a device in deferred_log raw mode.")
+    parser.add_argument("elf", help="Firmware ELF the device is running (build/<project>.elf)")
+    parser.add_argument("log", nargs="?", help="Captured log (default: stdin)")
+    args = parser.parse_args()
+
+    strings = StringTable(args.elf)
+    stream = open(args.log, "r", encoding="utf-8", errors="replace") if args.log else sys.stdin
+    for line in stream:
+        match = DLOG_LINE.search(line)
+        if not match:
+            sys.stdout.write(line)
+            continue
+        timestamp, level, tag_addr, fmt_addr, *words = match.groups()
+        tag = strings.read(int(tag_addr, 16)) or f"<0x{tag_addr}>"
+        fmt = strings.read(int(fmt_addr, 16))
+        if fmt is None:
+            print(f"{LEVELS.get(int(level), '?')} ({timestamp}) {tag}: <unknown format 0x{fmt_addr}>")
+            continue
+        message = format_record(strings, fmt, [int(word, 16) for word in words])
+        print(f"{LEVELS.get(int(level), '?')} ({timestamp}) {tag}: {message}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
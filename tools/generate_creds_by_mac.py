@@ -2,56 +2,11 @@
 
 import argparse
 import sys
-import binascii
 import subprocess
 import re
 import os
 
-# Constantes (igual que antes)
-INVALID_PASSCODES = {
-    00000000, 11111111, 22222222, 33333333, 44444444,
-    55555555, 66666666, 77777777, 88888888, 99999999,
-    12345678, 87654321
-}
-FALLBACK_PASSCODE = 20202021
-FALLBACK_DISCRIMINATOR = 0xF00 # 3840
-
-# --- Funciones de generación (sin cambios) ---
-
-def mac_str_to_bytes(mac_str: str) -> bytes | None:
-    """Convierte una cadena MAC AA:BB:CC:DD:EE:FF a bytes."""
-    try:
-        mac_bytes = binascii.unhexlify(mac_str.replace(':', ''))
-        if len(mac_bytes) != 6:
-            raise ValueError("La MAC debe tener 6 bytes")
-        return mac_bytes
-    except (ValueError, binascii.Error) as e:
-        print(f"Error: Formato de MAC inválido '{mac_str}'. Debe ser como AA:BB:CC:DD:EE:FF. Detalles: {e}", file=sys.stderr)
-        return None
-
-def generate_discriminator_from_mac(mac_bytes: bytes) -> int:
-    """Genera el discriminador de 12 bits desde los bytes de la MAC."""
-    if len(mac_bytes) < 6:
-        print("Error: Se necesitan al menos 6 bytes de MAC para el discriminador.", file=sys.stderr)
-        return FALLBACK_DISCRIMINATOR
-    discriminator_val = (mac_bytes[4] << 8) | mac_bytes[5]
-    discriminator_val &= 0x0FFF
-    if discriminator_val in [0x000, 0xFFF, 0xFFE]:
-        print(f"Warning: Discriminador generado inválido/reservado (0x{discriminator_val:03X}). Usando fallback 0x{FALLBACK_DISCRIMINATOR:03X}", file=sys.stderr)
-        return FALLBACK_DISCRIMINATOR
-    return discriminator_val
-
-def generate_passcode_from_mac(mac_bytes: bytes) -> int:
-    """Genera el passcode de 8 dígitos desde los bytes de la MAC."""
-    if len(mac_bytes) < 4:
-        print("Error: Se necesitan al menos 4 bytes de MAC para el passcode.", file=sys.stderr)
-        return FALLBACK_PASSCODE
-    passcode_base = (mac_bytes[0] << 24) | (mac_bytes[1] << 16) | (mac_bytes[2] << 8) | mac_bytes[3]
-    passcode = (passcode_base % 99999998) + 1
-    if passcode in INVALID_PASSCODES:
-        print(f"Warning: Passcode generado inválido ({passcode:08}). Usando fallback {FALLBACK_PASSCODE}", file=sys.stderr)
-        return FALLBACK_PASSCODE
-    return passcode
+from matter_credentials import derive_credentials, parse_mac
 
 # --- Función para obtener MAC con esptool (sin cambios respecto a la última versión) ---
 
@@ -129,16 +84,17 @@ if __name__ == "__main__":
     # -----------------------------------------------------------
 
     # Si no era 'mac', convertir a bytes para generar los otros valores
-    mac_bytes = mac_str_to_bytes(mac_address_str)
+    mac_bytes = parse_mac(mac_address_str)
     if mac_bytes is None:
+        print(f"Error: Formato de MAC inválido '{mac_address_str}'. Debe ser como AA:BB:CC:DD:EE:FF.", file=sys.stderr)
         sys.exit(1)
 
+    # Misma derivación que generate_factory_bulk.py y el firmware (docs/codegen_guardrails.md).
+    passcode, discriminator = derive_credentials(mac_bytes)
     if args.get == 'passcode':
-        result = generate_passcode_from_mac(mac_bytes)
-        print(f"{result:08}")
+        print(f"{passcode:08}")
     elif args.get == 'discriminator':
-        result = generate_discriminator_from_mac(mac_bytes)
-        print(result)
+        print(discriminator)
     # El 'else' ya no es necesario porque argparse valida las choices
 
     sys.exit(0)
\ No newline at end of file
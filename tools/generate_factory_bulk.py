@@ -0,0 +1,461 @@
+"""Builds `fctry` NVS images for a batch of devices from a CSV of MAC addresses.
+
+Each line of the CSV holds a MAC and, optionally, a serial number (the MAC
+without separators otherwise); a header line is skipped. For every device the
+passcode and discriminator are derived from the MAC by matter_credentials.py
+(docs/codegen_guardrails.md), a DAC is issued under the PAI in certs/, and a
+`chip-factory` NVS image the size of the `fctry` partition is written. The
+PAI and the certification declaration are read once and handed to one worker
+process per CPU core. The manifest lists, per device, the credentials, the
+onboarding codes and the image to flash at the partition offset.
+
+    python tools/generate_factory_bulk.py macs.csv --out output_fabrica/batch1
+"""
+
+import argparse
+import base64
+import concurrent.futures
+import csv
+import datetime
+import hashlib
+import json
+import os
+import struct
+import sys
+import zlib
+from typing import Any
+
+import yaml
+from cryptography import x509
+from cryptography.hazmat.primitives import hashes, serialization
+from cryptography.hazmat.primitives.asymmetric import ec
+from cryptography.x509.oid import NameOID, ObjectIdentifier
+
+from matter_credentials import derive_credentials, parse_mac
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_ROOT = os.path.dirname(SCRIPT_DIR)
+
+SPAKE2P_SALT_BYTES = 32
+P256_ORDER = 0xFFFFFFFF00000000FFFFFFFFFFFFFFFFBCE6FAADA7179E84F3B9CAC2FC632551
+OID_MATTER_VID = ObjectIdentifier("1.3.6.1.4.1.37244.2.1")
+OID_MATTER_PID = ObjectIdentifier("1.3.6.1.4.1.37244.2.2")
+
+RENDEZVOUS_BLE = 0x02
+BASE38_ALPHABET = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ-."
+
+FACTORY_NAMESPACE = "chip-factory"
+NVS_PAGE_SIZE = 4096
+NVS_ENTRY_SIZE = 32
+NVS_ENTRIES_PER_PAGE = 126
+NVS_FIRST_ENTRY_OFFSET = 64
+NVS_PAGE_ACTIVE = 0xFFFFFFFE
+NVS_PAGE_FULL = 0xFFFFFFFC
+NVS_VERSION2 = 0xFE
+NVS_TYPE_U8 = 0x01
+NVS_TYPE_U32 = 0x04
+NVS_TYPE_STR = 0x21
+NVS_TYPE_BLOB_DATA = 0x42
+NVS_TYPE_BLOB_IDX = 0x48
+NVS_CHUNK_ANY = 0xFF
+NVS_MAX_KEY = 15
+
+
+# ---------------------------------------------------------------------------
+# Credentials
+# ---------------------------------------------------------------------------
+
+def spake2p_verifier(passcode: int, salt: bytes, iterations: int) -> bytes:
+    ws = hashlib.pbkdf2_hmac("sha256", struct.pack("<I", passcode), salt, iterations, 80)
+    w0 = int.from_bytes(ws[:40], "big") % P256_ORDER
+    w1 = int.from_bytes(ws[40:], "big") % P256_ORDER
+    point_l = ec.derive_private_key(w1, ec.SECP256R1()).public_key().public_bytes(
+        serialization.Encoding.X962, serialization.PublicFormat.UncompressedPoint)
+    return w0.to_bytes(32, "big") + point_l
+
+
+# ---------------------------------------------------------------------------
+# Onboarding codes
+# ---------------------------------------------------------------------------
+
+VERHOEFF_D = [
+    [0, 1, 2, 3, 4, 5, 6, 7, 8, 9], [1, 2, 3, 4, 0, 6, 7, 8, 9, 5],
+    [2, 3, 4, 0, 1, 7, 8, 9, 5, 6], [3, 4, 0, 1, 2, 8, 9, 5, 6, 7],
+    [4, 0, 1, 2, 3, 9, 5, 6, 7, 8], [5, 9, 8, 7, 6, 0, 4, 3, 2, 1],
+    [6, 5, 9, 8, 7, 1, 0, 4, 3, 2], [7, 6, 5, 9, 8, 2, 1, 0, 4, 3],
+    [8, 7, 6, 5, 9, 3, 2, 1, 0, 4], [9, 8, 7, 6, 5, 4, 3, 2, 1, 0],
+]
+VERHOEFF_P = [
+    [0, 1, 2, 3, 4, 5, 6, 7, 8, 9], [1, 5, 7, 6, 2, 8, 3, 0, 9, 4],
+    [5, 8, 0, 3, 7, 9, 6, 1, 4, 2], [8, 9, 1, 6, 0, 4, 3, 5, 2, 7],
+    [9, 4, 5, 3, 1, 2, 6, 8, 7, 0], [4, 2, 8, 6, 5, 7, 3, 9, 0, 1],
+    [2, 7, 9, 3, 8, 0, 6, 4, 1, 5], [7, 0, 4, 6, 9, 1, 3, 2, 5, 8],
+]
+VERHOEFF_INV = [0, 4, 3, 2, 1, 5, 6, 7, 8, 9]
+
+
+def verhoeff_digit(digits: str) -> str:
+    check = 0
+    for idx, char in enumerate(reversed(digits)):
+        check = VERHOEFF_D[check][VERHOEFF_P[(idx + 1) % 8][int(char)]]
+    return str(VERHOEFF_INV[check])
+
+
+def manual_code(passcode: int, discriminator: int) -> str:
+    short_discriminator = discriminator >> 8
+    chunk1 = short_discriminator >> 2
+    chunk2 = ((short_discriminator & 0x3) << 14) | (passcode & 0x3FFF)
+    chunk3 = passcode >> 14
+    digits = f"{chunk1:01}{chunk2:05}{chunk3:04}"
+    return digits + verhoeff_digit(digits)
+
+
+def base38(data: bytes) -> str:
+    out = []
+    for offset in range(0, len(data), 3):
+        chunk = data[offset:offset + 3]
+        value = int.from_bytes(chunk, "little")
+        for _ in range({1: 2, 2: 4, 3: 5}[len(chunk)]):
+            value, digit = divmod(value, 38)
+            out.append(BASE38_ALPHABET[digit])
+    return "".join(out)
+
+
+def qr_code(vendor_id: int, product_id: int, passcode: int, discriminator: int) -> str:
+    fields = [(0, 3), (vendor_id, 16), (product_id, 16), (0, 2), (RENDEZVOUS_BLE, 8),
+              (discriminator, 12), (passcode, 27), (0, 4)]
+    bits = 0
+    shift = 0
+    for value, width in fields:
+        bits |= (value & ((1 << width) - 1)) << shift
+        shift += width
+    return "MT:" + base38(bits.to_bytes(shift // 8, "little"))
+
+
+# ---------------------------------------------------------------------------
+# NVS image
+# ---------------------------------------------------------------------------
+
+def nvs_crc(data: bytes) -> int:
+    return zlib.crc32(data, 0xFFFFFFFF)
+
+
+class NvsImage:
+    """Minimal NVS v2 writer for one namespace, laid out the way
+    nvs_partition_gen.py does: pages fill in order, values never straddle
+    a page, the last page in use stays ACTIVE and the rest stay erased."""
+
+    def __init__(self, size: int, namespace: str):
+        if size % NVS_PAGE_SIZE or size < 2 * NVS_PAGE_SIZE:
+            raise ValueError(f"NVS partition size 0x{size:X} must be at least two 4 KB pages")
+        self.image = bytearray(b"\xff" * size)
+        self.page_count = size // NVS_PAGE_SIZE
+        self.page = -1
+        self.entry = NVS_ENTRIES_PER_PAGE
+        self.namespace_index = 1
+        self._open_page()
+        self._write_entry(0, NVS_TYPE_U8, NVS_CHUNK_ANY, namespace,
+                          bytes([self.namespace_index]) + b"\xff" * 7)
+
+    def _open_page(self) -> None:
+        if self.page >= 0:
+            self._set_page_state(NVS_PAGE_FULL)
+        self.page += 1
+        # NVS needs one erased page to garbage-collect into.
+        if self.page >= self.page_count - 1:
+            raise ValueError("factory data does not fit in the fctry partition")
+        self.entry = 0
+        self._set_page_state(NVS_PAGE_ACTIVE)
+
+    def _set_page_state(self, state: int) -> None:
+        header = struct.pack("<IIB", state, self.page, NVS_VERSION2) + b"\xff" * 19
+        header += struct.pack("<I", nvs_crc(header[4:28]))
+        base = self.page * NVS_PAGE_SIZE
+        self.image[base:base + 32] = header
+
+    def _reserve(self, span: int) -> int:
+        if self.entry + span > NVS_ENTRIES_PER_PAGE:
+            self._open_page()
+        base = self.page * NVS_PAGE_SIZE
+        for idx in range(self.entry, self.entry + span):
+            self.image[base + 32 + idx // 4] &= ~(1 << ((idx % 4) * 2)) & 0xFF
+        first = self.entry
+        self.entry += span
+        return base + NVS_FIRST_ENTRY_OFFSET + first * NVS_ENTRY_SIZE
+
+    def _write_entry(self, namespace: int, kind: int, chunk: int, key: str, data: bytes,
+                     payload: bytes = b"") -> None:
+        if len(key) > NVS_MAX_KEY:
+            raise ValueError(f"NVS key '{key}' is longer than {NVS_MAX_KEY} characters")
+        span = 1 + (len(payload) + NVS_ENTRY_SIZE - 1) // NVS_ENTRY_SIZE
+        offset = self._reserve(span)
+        entry = bytearray(struct.pack("<BBBB", namespace, kind, span, chunk))
+        entry += b"\x00" * 4
+        entry += key.encode("ascii").ljust(16, b"\x00")
+        entry += data
+        entry[4:8] = struct.pack("<I", nvs_crc(bytes(entry[0:4] + entry[8:32])))
+        self.image[offset:offset + NVS_ENTRY_SIZE] = entry
+        padded = payload.ljust((span - 1) * NVS_ENTRY_SIZE, b"\xff")
+        self.image[offset + NVS_ENTRY_SIZE:offset + NVS_ENTRY_SIZE + len(padded)] = padded
+
+    def _max_payload(self) -> int:
+        return (NVS_ENTRIES_PER_PAGE - 1) * NVS_ENTRY_SIZE
+
+    def put_u32(self, key: str, value: int) -> None:
+        self._write_entry(self.namespace_index, NVS_TYPE_U32, NVS_CHUNK_ANY, key,
+                          struct.pack("<I", value) + b"\xff" * 4)
+
+    def put_str(self, key: str, value: str) -> None:
+        payload = value.encode("utf-8") + b"\x00"
+        if len(payload) > self._max_payload():
+            raise ValueError(f"NVS string '{key}' is too long")
+        data = struct.pack("<HHI", len(payload), 0xFFFF, nvs_crc(payload))
+        self._write_entry(self.namespace_index, NVS_TYPE_STR, NVS_CHUNK_ANY, key, data, payload)
+
+    def put_blob(self, key: str, value: bytes) -> None:
+        if len(value) > self._max_payload():
+            raise ValueError(f"NVS blob '{key}' is too long")
+        data = struct.pack("<HHI", len(value), 0xFFFF, nvs_crc(value))
+        self._write_entry(self.namespace_index, NVS_TYPE_BLOB_DATA, 0, key, data, value)
+        index = struct.pack("<IBBH", len(value), 1, 0, 0xFFFF)
+        self._write_entry(self.namespace_index, NVS_TYPE_BLOB_IDX, NVS_CHUNK_ANY, key, index)
+
+
+# ---------------------------------------------------------------------------
+# Per-device work
+# ---------------------------------------------------------------------------
+
+_shared: dict[str, Any] = {}
+
+
+def init_worker(shared: dict[str, Any]) -> None:
+    _shared.clear()
+    _shared.update(shared)
+    _shared["pai_cert"] = x509.load_der_x509_certificate(shared["pai_cert_der"])
+    _shared["pai_key"] = serialization.load_pem_private_key(shared["pai_key_pem"], password=None)
+
+
+def issue_dac(serial: str) -> tuple[bytes, ec.EllipticCurvePrivateKey]:
+    pai_cert = _shared["pai_cert"]
+    pai_key = _shared["pai_key"]
+    key = ec.generate_private_key(ec.SECP256R1())
+    subject = x509.Name([
+        x509.NameAttribute(NameOID.COMMON_NAME, f"{_shared['cn_prefix']} {serial}"[:64]),
+        x509.NameAttribute(OID_MATTER_VID, f"{_shared['vendor_id']:04X}"),
+        x509.NameAttribute(OID_MATTER_PID, f"{_shared['product_id']:04X}"),
+    ])
+    not_before = datetime.datetime.now(datetime.timezone.utc).replace(microsecond=0)
+    cert = (
+        x509.CertificateBuilder()
+        .subject_name(subject)
+        .issuer_name(pai_cert.subject)
+        .public_key(key.public_key())
+        .serial_number(x509.random_serial_number())
+        .not_valid_before(not_before)
+        .not_valid_after(not_before + datetime.timedelta(days=_shared["lifetime_days"]))
+        .add_extension(x509.BasicConstraints(ca=False, path_length=None), critical=True)
+        .add_extension(x509.KeyUsage(digital_signature=True, content_commitment=False,
+                                     key_encipherment=False, data_encipherment=False,
+                                     key_agreement=False, key_cert_sign=False, crl_sign=False,
+                                     encipher_only=False, decipher_only=False), critical=True)
+        .add_extension(x509.SubjectKeyIdentifier.from_public_key(key.public_key()), critical=False)
+        .add_extension(x509.AuthorityKeyIdentifier.from_issuer_public_key(pai_cert.public_key()),
+                       critical=False)
+        .sign(pai_key, hashes.SHA256())
+    )
+    return cert.public_bytes(serialization.Encoding.DER), key
+
+
+def build_device(device: dict[str, Any]) -> dict[str, Any]:
+    mac = bytes.fromhex(device["mac"].replace(":", ""))
+    serial = device["serial"]
+    passcode, discriminator = derive_credentials(mac)
+    salt = os.urandom(SPAKE2P_SALT_BYTES)
+    verifier = spake2p_verifier(passcode, salt, _shared["iterations"])
+    dac_der, dac_key = issue_dac(serial)
+
+    nvs = NvsImage(_shared["partition_size"], FACTORY_NAMESPACE)
+    nvs.put_u32("discriminator", discriminator)
+    nvs.put_u32("iteration-count", _shared["iterations"])
+    nvs.put_str("salt", base64.b64encode(salt).decode())
+    nvs.put_str("verifier", base64.b64encode(verifier).decode())
+    # Read back by GetSetupPasscode() in main/app_main.cpp.
+    nvs.put_u32("pin-code", passcode)
+    nvs.put_blob("dac-cert", dac_der)
+    nvs.put_blob("dac-key", dac_key.private_numbers().private_value.to_bytes(32, "big"))
+    nvs.put_blob("dac-pub-key", dac_key.public_key().public_bytes(
+        serialization.Encoding.X962, serialization.PublicFormat.UncompressedPoint))
+    nvs.put_blob("pai-cert", _shared["pai_cert_der"])
+    nvs.put_blob("cert-dclrn", _shared["cd"])
+    nvs.put_u32("vendor-id", _shared["vendor_id"])
+    nvs.put_u32("product-id", _shared["product_id"])
+    nvs.put_str("vendor-name", _shared["vendor_name"])
+    nvs.put_str("product-name", _shared["product_name"])
+    nvs.put_str("serial-num", serial)
+    nvs.put_u32("hardware-ver", _shared["hardware_version"])
+    nvs.put_str("hw-ver-str", str(_shared["hardware_version"]))
+    nvs.put_str("mfg-date", _shared["mfg_date"])
+
+    image_path = os.path.join(_shared["out_dir"], f"{serial}-fctry.bin")
+    with open(image_path, "wb") as image_file:
+        image_file.write(nvs.image)
+    return {
+        "mac": device["mac"],
+        "serial": serial,
+        "passcode": f"{passcode:08}",
+        "discriminator": discriminator,
+        "qr_code": qr_code(_shared["vendor_id"], _shared["product_id"], passcode, discriminator),
+        "manual_code": manual_code(passcode, discriminator),
+        "image": os.path.relpath(image_path, _shared["out_dir"]),
+        "flash_offset": f"0x{_shared['partition_offset']:X}",
+    }
+
+
+# ---------------------------------------------------------------------------
+# Batch
+# ---------------------------------------------------------------------------
+
+def parse_int(value: Any, name: str) -> int:
+    try:
+        return int(str(value).strip(), 0)
+    except ValueError:
+        raise ValueError(f"fabrication.{name} must be an integer, got '{value}'") from None
+
+
+def read_devices(path: str) -> list[dict[str, str]]:
+    devices = []
+    seen_macs = set()
+    seen_serials = set()
+    with open(path, newline="", encoding="utf-8") as csv_file:
+        for line_no, row in enumerate(csv.reader(csv_file), start=1):
+            if not row or not row[0].strip() or row[0].lstrip().startswith("#"):
+                continue
+            mac = parse_mac(row[0])
+            if mac is None:
+                if not devices and line_no == 1:
+                    continue
+                raise ValueError(f"{path}:{line_no}: invalid MAC '{row[0].strip()}'")
+            mac_text = ":".join(f"{byte:02X}" for byte in mac)
+            serial = row[1].strip() if len(row) > 1 and row[1].strip() else mac.hex().upper()
+            if mac_text in seen_macs:
+                raise ValueError(f"{path}:{line_no}: duplicate MAC {mac_text}")
+            if serial in seen_serials:
+                raise ValueError(f"{path}:{line_no}: duplicate serial '{serial}'")
+            if len(serial) > 32 or any(char in serial for char in "/\\"):
+                raise ValueError(f"{path}:{line_no}: serial '{serial}' must be at most 32 characters "
+                                 "without path separators")
+            seen_macs.add(mac_text)
+            seen_serials.add(serial)
+            devices.append({"mac": mac_text, "serial": serial})
+    return devices
+
+
+def find_partition(partitions_path: str, label: str) -> tuple[int, int]:
+    with open(partitions_path, encoding="utf-8") as table:
+        for line in table:
+            fields = [field.strip() for field in line.split("#", 1)[0].split(",")]
+            if len(fields) >= 5 and fields[0] == label:
+                return int(fields[3], 0), int(fields[4], 0)
+    raise ValueError(f"No '{label}' partition in {partitions_path}")
+
+
+def load_pem_or_der_cert(path: str) -> bytes:
+    with open(path, "rb") as cert_file:
+        raw = cert_file.read()
+    if b"-----BEGIN" in raw:
+        return x509.load_pem_x509_certificate(raw).public_bytes(serialization.Encoding.DER)
+    return raw
+
+
+def write_manifest(out_dir: str, rows: list[dict[str, Any]], fmt: str) -> str:
+    path = os.path.join(out_dir, f"manifest.{fmt}")
+    with open(path, "w", newline="", encoding="utf-8") as manifest:
+        if fmt == "json":
+            json.dump(rows, manifest, indent=2)
+            manifest.write("\n")
+        else:
+            writer = csv.DictWriter(manifest, fieldnames=list(rows[0].keys()) if rows else ["mac"])
+            writer.writeheader()
+            writer.writerows(rows)
+    return path
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Generate fctry NVS images for a batch of MAC addresses.")
+    parser.add_argument("macs", help="CSV with one MAC per line and an optional serial number column")
+    parser.add_argument("--config", default=os.path.join(PROJECT_ROOT, "config.yaml"))
+    parser.add_argument("--partitions", default=os.path.join(PROJECT_ROOT, "partitions.csv"))
+    parser.add_argument("--pai-cert", default=os.path.join(PROJECT_ROOT, "certs", "PAI.crt"))
+    parser.add_argument("--pai-key", default=os.path.join(PROJECT_ROOT, "certs", "PAI.key"))
+    parser.add_argument("--cd", default=os.path.join(PROJECT_ROOT, "certs", "cd.der"))
+    parser.add_argument("--out", default=os.path.join(PROJECT_ROOT, "output_fabrica", "bulk"))
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                        help="worker processes (default: one per CPU core)")
+    parser.add_argument("--iterations", type=int, default=10000, help="SPAKE2+ PBKDF2 iterations")
+    parser.add_argument("--lifetime", type=int, default=3650, help="DAC validity in days")
+    parser.add_argument("--cn-prefix", default="Matter Test DAC")
+    parser.add_argument("--mfg-date", default=datetime.date.today().isoformat(), help="YYYY-MM-DD")
+    parser.add_argument("--manifest", choices=["csv", "json"], default="csv")
+    args = parser.parse_args()
+
+    try:
+        with open(args.config, encoding="utf-8") as config_file:
+            fabrication = (yaml.safe_load(config_file) or {}).get("fabrication") or {}
+        if not 1000 <= args.iterations <= 100000:
+            raise ValueError("--iterations must be between 1000 and 100000")
+        datetime.date.fromisoformat(args.mfg_date)
+        devices = read_devices(args.macs)
+        partition_offset, partition_size = find_partition(args.partitions, "fctry")
+        with open(args.pai_key, "rb") as key_file:
+            pai_key_pem = key_file.read()
+        with open(args.cd, "rb") as cd_file:
+            cd = cd_file.read()
+        shared = {
+            "vendor_id": parse_int(fabrication.get("vendor_id", "0xFFF1"), "vendor_id"),
+            "product_id": parse_int(fabrication.get("product_id", "0x8000"), "product_id"),
+            "vendor_name": str(fabrication.get("vendor_name", "")),
+            "product_name": str(fabrication.get("product_name", "")),
+            "hardware_version": parse_int(fabrication.get("hardware_version", 1), "hardware_version"),
+            "pai_cert_der": load_pem_or_der_cert(args.pai_cert),
+            "pai_key_pem": pai_key_pem,
+            "cd": cd,
+            "iterations": args.iterations,
+            "lifetime_days": args.lifetime,
+            "cn_prefix": args.cn_prefix,
+            "mfg_date": args.mfg_date,
+            "partition_offset": partition_offset,
+            "partition_size": partition_size,
+            "out_dir": os.path.abspath(args.out),
+        }
+        init_worker(shared)  # fail on a bad PAI before starting the pool
+    except (OSError, ValueError) as exc:
+        print(f"Error: {exc}", file=sys.stderr)
+        return 1
+
+    if not devices:
+        print(f"Error: no MAC addresses in {args.macs}", file=sys.stderr)
+        return 1
+    os.makedirs(shared["out_dir"], exist_ok=True)
+
+    jobs = max(1, min(args.jobs, len(devices)))
+    rows = []
+    try:
+        if jobs == 1:
+            rows = [build_device(device) for device in devices]
+        else:
+            with concurrent.futures.ProcessPoolExecutor(max_workers=jobs, initializer=init_worker,
+                                                        initargs=(shared,)) as pool:
+                rows = list(pool.map(build_device, devices, chunksize=max(1, len(devices) // (jobs * 4))))
+    except ValueError as exc:
+        print(f"Error: {exc}", file=sys.stderr)
+        return 1
+
+    manifest_path = write_manifest(shared["out_dir"], rows, args.manifest)
+    print(f"{len(rows)} devices, {jobs} workers, fctry at 0x{partition_offset:X} "
+          f"(0x{partition_size:X} bytes)")
+    print(f"Manifest: {manifest_path}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,40 @@
+"""Setup passcode and discriminator derived from a device MAC.
+
+The one implementation of the algorithm in docs/codegen_guardrails.md for the
+provisioning tools: generate_creds_by_mac.py (one device on a serial port)
+and generate_factory_bulk.py (a batch from a CSV) both use it, and the
+commissionable data provider in the firmware derives the same values, so a
+MAC gets the same credentials whichever path provisioned it.
+"""
+
+FALLBACK_PASSCODE = 20202021
+FALLBACK_DISCRIMINATOR = 3840
+# Trivial passcodes the Matter specification forbids.
+INVALID_PASSCODES = {
+    0, 11111111, 22222222, 33333333, 44444444, 55555555,
+    66666666, 77777777, 88888888, 99999999, 12345678, 87654321,
+}
+
+
+def parse_mac(text: str) -> bytes | None:
+    """Parses AA:BB:CC:DD:EE:FF, AA-BB-... or AABBCCDDEEFF; None when malformed."""
+    digits = text.strip().replace(":", "").replace("-", "")
+    if len(digits) != 12:
+        return None
+    try:
+        return bytes.fromhex(digits)
+    except ValueError:
+        return None
+
+
+def derive_credentials(mac: bytes) -> tuple[int, int]:
+    """Returns (passcode, discriminator) for a 6-byte MAC."""
+    mac48 = int.from_bytes(mac, "big")
+    pin_raw = (mac48 ^ (mac48 >> 12) ^ 0x5A5A5A5A5A5A) % 99999999
+    passcode = 10000000 + (pin_raw % 89999999)
+    # The range still contains trivial codes; step past them so every MAC
+    # keeps a passcode of its own.
+    while passcode in INVALID_PASSCODES:
+        passcode += 1
+    discriminator = (mac48 ^ (mac48 >> 24)) & 0x0FFF
+    return passcode, discriminator
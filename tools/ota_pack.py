@@ -0,0 +1,404 @@
+"""Builds compressed and delta OTA payloads for main/ota_stream.cpp.
+
+    python tools/ota_pack.py compress build/app.bin -o app.otaz
+    python tools/ota_pack.py delta --base v1.bin build/app.bin -o v1-to-v2.otaz
+    python tools/ota_pack.py apply v1-to-v2.otaz --base v1.bin -o check.bin
+
+The payload replaces the app binary given to CHIP's ota_image_tool.py
+create; the device expands it into the inactive slot as it downloads. A
+delta applies only on a device running exactly the --base image: the
+device compares the SHA-256 of its running slot before writing anything.
+Every payload is decoded again with `apply` before it is written, so a
+packing bug fails here rather than on a device.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import time
+
+MAGIC = b"OTAZ"
+VERSION = 1
+KIND_COMPRESSED = 1
+KIND_DELTA = 2
+HEADER_FORMAT = "<4sBBBBIII32s32s"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+MIN_WINDOW_BITS = 8
+MAX_WINDOW_BITS = 15
+
+MIN_MATCH = 4
+MAX_OFFSET = 0xFFFF
+CHAIN_DEPTH = 16
+
+OP_COPY = 0
+OP_ADD = 1
+OP_DATA = 2
+DELTA_KEY = 12
+DELTA_STEP = 3
+DELTA_HITS = 8
+DELTA_MIN_REGION = 24
+DELTA_GIVE_UP = 48
+
+
+# ---------------------------------------------------------------------------
+# LZ body
+# ---------------------------------------------------------------------------
+
+def run_length(a: bytes, i: int, j: int, limit: int) -> int:
+    """Bytes equal at a[i:] and a[j:], up to limit."""
+    length = 0
+    while length + 32 <= limit and a[i + length:i + length + 32] == a[j + length:j + length + 32]:
+        length += 32
+    while length < limit and a[i + length] == a[j + length]:
+        length += 1
+    return length
+
+
+def extended_length(value: int) -> bytes:
+    out = bytearray()
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+    return bytes(out)
+
+
+def lz_sequence(literals: bytes, offset: int, match: int) -> bytes:
+    lit_code = min(len(literals), 15)
+    match_code = min(match - MIN_MATCH, 15) if match else 0
+    out = bytearray([lit_code << 4 | match_code])
+    if lit_code == 15:
+        out += extended_length(len(literals) - 15)
+    out += literals
+    if match:
+        out += struct.pack("<H", offset)
+        if match_code == 15:
+            out += extended_length(match - MIN_MATCH - 15)
+    return bytes(out)
+
+
+def lz_compress(data: bytes, window_bits: int) -> bytes:
+    window = min(1 << window_bits, MAX_OFFSET)
+    size = len(data)
+    chains: dict[bytes, list[int]] = {}
+    out = bytearray()
+    literal_start = 0
+    pos = 0
+
+    def longest(at: int) -> tuple[int, int]:
+        best_len = best_offset = 0
+        for candidate in reversed(chains.get(data[at:at + MIN_MATCH], ())):
+            offset = at - candidate
+            if offset > window:
+                break
+            length = run_length(data, candidate, at, size - at)
+            if length > best_len:
+                best_len, best_offset = length, offset
+        return best_len, best_offset
+
+    def insert(at: int) -> None:
+        chain = chains.setdefault(data[at:at + MIN_MATCH], [])
+        chain.append(at)
+        if len(chain) > CHAIN_DEPTH:
+            del chain[0]
+
+    while pos + MIN_MATCH <= size:
+        best_len, best_offset = longest(pos)
+        insert(pos)
+        if best_len < MIN_MATCH:
+            pos += 1
+            continue
+        # Lazy matching: a longer match one byte later is worth a literal.
+        if pos + 1 + MIN_MATCH <= size:
+            next_len, _ = longest(pos + 1)
+            if next_len > best_len + 1:
+                pos += 1
+                continue
+        out += lz_sequence(data[literal_start:pos], best_offset, best_len)
+        end = pos + best_len
+        for inner in range(pos + 1, min(end, size - MIN_MATCH + 1)):
+            insert(inner)
+        pos = end
+        literal_start = pos
+    if literal_start < size or not out:
+        out += lz_sequence(data[literal_start:], 0, 0)
+    return bytes(out)
+
+
+def lz_decompress(body: bytes, stream_size: int, window_bits: int) -> bytes:
+    out = bytearray()
+    pos = 0
+
+    def extended(value: int) -> int:
+        nonlocal pos
+        while True:
+            byte = body[pos]
+            pos += 1
+            value += byte
+            if byte != 255:
+                return value
+
+    while len(out) < stream_size:
+        token = body[pos]
+        pos += 1
+        literals = token >> 4
+        if literals == 15:
+            literals = extended(15)
+        out += body[pos:pos + literals]
+        pos += literals
+        if len(out) >= stream_size:
+            break
+        offset = struct.unpack_from("<H", body, pos)[0]
+        pos += 2
+        match = (token & 0x0F) + MIN_MATCH
+        if match == 15 + MIN_MATCH:
+            match = extended(match)
+        if offset == 0 or offset > (1 << window_bits) or offset > len(out):
+            raise ValueError(f"bad LZ offset {offset} at output {len(out)}")
+        for _ in range(match):
+            out.append(out[-offset])
+    if len(out) != stream_size or pos != len(body):
+        raise ValueError("LZ body does not match its declared size")
+    return bytes(out)
+
+
+# ---------------------------------------------------------------------------
+# Delta operations
+# ---------------------------------------------------------------------------
+
+def varint(value: int) -> bytes:
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value: int) -> int:
+    return (value << 1) ^ (value >> 63) if value < 0 else value << 1
+
+
+def fuzzy_extent(base: bytes, b: int, target: bytes, t: int) -> tuple[int, int]:
+    """Length of base[b:] to reuse for target[t:] and its matches minus mismatches."""
+    limit = min(len(base) - b, len(target) - t)
+    score = best_score = best_len = length = 0
+    while length < limit:
+        chunk = min(16, limit - length)
+        if base[b + length:b + length + chunk] == target[t + length:t + length + chunk]:
+            score += chunk
+            length += chunk
+        else:
+            for _ in range(chunk):
+                score += 1 if base[b + length] == target[t + length] else -1
+                length += 1
+                if score > best_score:
+                    best_score, best_len = score, length
+                elif best_score - score > DELTA_GIVE_UP:
+                    return best_len, best_score
+            continue
+        if score > best_score:
+            best_score, best_len = score, length
+    return best_len, best_score
+
+
+def delta_ops(base: bytes, target: bytes) -> bytes:
+    index: dict[bytes, list[int]] = {}
+    for pos in range(0, len(base) - DELTA_KEY + 1, DELTA_STEP):
+        hits = index.setdefault(base[pos:pos + DELTA_KEY], [])
+        if len(hits) < DELTA_HITS:
+            hits.append(pos)
+
+    out = bytearray()
+    base_cursor = 0
+    literal_start = 0
+    pos = 0
+    last_base_end = 0
+    last_target_end = 0
+
+    def emit_data(end: int) -> None:
+        if end > literal_start:
+            out.append(OP_DATA)
+            out.extend(varint(end - literal_start))
+            out.extend(target[literal_start:end])
+
+    while pos + DELTA_KEY <= len(target):
+        candidates = []
+        predicted = last_base_end + (pos - last_target_end)
+        if 0 <= predicted < len(base) and base[predicted:predicted + MIN_MATCH] == target[pos:pos + MIN_MATCH]:
+            candidates.append(predicted)
+        key = target[pos:pos + DELTA_KEY]
+        # The base is indexed every DELTA_STEP bytes; one of the next few
+        # target positions lines up with an indexed one. Repeated keys (tables,
+        # padding) resolve to the hit nearest to where the last region left off.
+        for shift in range(DELTA_STEP):
+            hits = [hit - shift for hit in index.get(target[pos + shift:pos + shift + DELTA_KEY], ())
+                    if hit >= shift and base[hit - shift:hit - shift + DELTA_KEY] == key]
+            if hits:
+                candidates.append(min(hits, key=lambda hit: abs(hit - predicted)))
+                break
+        best = (0, 0, 0)
+        for candidate in candidates:
+            length, score = fuzzy_extent(base, candidate, target, pos)
+            if score > best[1]:
+                best = (length, score, candidate)
+        length, score, base_pos = best
+        if length < DELTA_MIN_REGION or score * 2 < length:
+            pos += 1
+            continue
+
+        emit_data(pos)
+        region = target[pos:pos + length]
+        source = base[base_pos:base_pos + length]
+        if region == source:
+            out.append(OP_COPY)
+            out.extend(varint(length))
+            out.extend(varint(zigzag(base_pos - base_cursor)))
+        else:
+            out.append(OP_ADD)
+            out.extend(varint(length))
+            out.extend(varint(zigzag(base_pos - base_cursor)))
+            out.extend(bytes((t - b) & 0xFF for t, b in zip(region, source)))
+        base_cursor = base_pos + length
+        pos += length
+        literal_start = pos
+        last_base_end = base_cursor
+        last_target_end = pos
+    emit_data(len(target))
+    return bytes(out)
+
+
+def apply_ops(ops: bytes, base: bytes) -> bytes:
+    out = bytearray()
+    pos = 0
+    base_cursor = 0
+
+    def read_varint() -> int:
+        nonlocal pos
+        value = shift = 0
+        while True:
+            byte = ops[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    while pos < len(ops):
+        opcode = ops[pos]
+        pos += 1
+        length = read_varint()
+        if opcode == OP_DATA:
+            out += ops[pos:pos + length]
+            pos += length
+            continue
+        if opcode not in (OP_COPY, OP_ADD):
+            raise ValueError(f"bad delta opcode {opcode}")
+        encoded = read_varint()
+        base_cursor += (encoded >> 1) ^ -(encoded & 1)
+        if base_cursor < 0 or base_cursor + length > len(base):
+            raise ValueError("delta reads outside the base image")
+        source = base[base_cursor:base_cursor + length]
+        if opcode == OP_COPY:
+            out += source
+        else:
+            out += bytes((b + d) & 0xFF for b, d in zip(source, ops[pos:pos + length]))
+            pos += length
+        base_cursor += length
+    return bytes(out)
+
+
+# ---------------------------------------------------------------------------
+# Payload
+# ---------------------------------------------------------------------------
+
+def pack(target: bytes, base: bytes | None, window_bits: int) -> bytes:
+    if base is None:
+        kind, stream, base_hash = KIND_COMPRESSED, target, bytes(32)
+    else:
+        kind, stream, base_hash = KIND_DELTA, delta_ops(base, target), hashlib.sha256(base).digest()
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, kind, window_bits, 0, len(target), len(stream),
+                         len(base) if base is not None else 0, base_hash, hashlib.sha256(target).digest())
+    return header + lz_compress(stream, window_bits)
+
+
+def unpack(payload: bytes, base: bytes | None) -> bytes:
+    if len(payload) < HEADER_SIZE:
+        raise ValueError("payload is shorter than its header")
+    (magic, version, kind, window_bits, _, target_size, stream_size, base_size, base_hash,
+     target_hash) = struct.unpack_from(HEADER_FORMAT, payload)
+    if magic != MAGIC or version != VERSION or not MIN_WINDOW_BITS <= window_bits <= MAX_WINDOW_BITS:
+        raise ValueError("not an OTAZ payload of this version")
+    stream = lz_decompress(payload[HEADER_SIZE:], stream_size, window_bits)
+    if kind == KIND_COMPRESSED:
+        image = stream
+    elif kind == KIND_DELTA:
+        if base is None:
+            raise ValueError("delta payload needs --base")
+        if len(base) < base_size or hashlib.sha256(base[:base_size]).digest() != base_hash:
+            raise ValueError("--base is not the image this delta was built against")
+        image = apply_ops(stream, base[:base_size])
+    else:
+        raise ValueError(f"unknown payload kind {kind}")
+    if len(image) != target_size or hashlib.sha256(image).digest() != target_hash:
+        raise ValueError("decoded image does not match the target hash")
+    return image
+
+
+def read_file(path: str) -> bytes:
+    with open(path, "rb") as handle:
+        return handle.read()
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Build or check compressed and delta OTA payloads.")
+    sub = parser.add_subparsers(dest="command", required=True)
+    for name in ("compress", "delta"):
+        cmd = sub.add_parser(name)
+        cmd.add_argument("image", help="new app binary (build/<project>.bin)")
+        cmd.add_argument("-o", "--output", required=True)
+        cmd.add_argument("--window-bits", type=int, default=MAX_WINDOW_BITS,
+                         help=f"LZ window of 2^bits bytes held in device RAM ({MIN_WINDOW_BITS}..{MAX_WINDOW_BITS})")
+        if name == "delta":
+            cmd.add_argument("--base", required=True, help="app binary the devices are running")
+    check = sub.add_parser("apply")
+    check.add_argument("payload")
+    check.add_argument("--base", help="running app binary, for deltas")
+    check.add_argument("-o", "--output")
+    args = parser.parse_args()
+
+    try:
+        if args.command == "apply":
+            image = unpack(read_file(args.payload), read_file(args.base) if args.base else None)
+            if args.output:
+                with open(args.output, "wb") as handle:
+                    handle.write(image)
+            print(f"OK: {len(image)} bytes, sha256 {hashlib.sha256(image).hexdigest()}")
+            return 0
+
+        if not MIN_WINDOW_BITS <= args.window_bits <= MAX_WINDOW_BITS:
+            raise ValueError(f"--window-bits must be between {MIN_WINDOW_BITS} and {MAX_WINDOW_BITS}")
+        target = read_file(args.image)
+        base = read_file(args.base) if args.command == "delta" else None
+        started = time.monotonic()
+        payload = pack(target, base, args.window_bits)
+        if unpack(payload, base) != target:
+            raise ValueError("payload does not decode to the image")
+        with open(args.output, "wb") as handle:
+            handle.write(payload)
+    except (OSError, ValueError, IndexError, struct.error) as exc:
+        print(f"Error: {exc}", file=sys.stderr)
+        return 1
+
+    print(f"{args.command}: {len(target)} -> {len(payload)} bytes "
+          f"({100 * len(payload) / max(len(target), 1):.1f}%), window {1 << args.window_bits} bytes, "
+          f"{time.monotonic() - started:.1f} s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,4 +1,6 @@
 import argparse
+import ipaddress
+import math
 import os
 from typing import Any, Iterable
 
@@ -7,6 +9,120 @@ import yaml
 TRUE_STRINGS = {"true", "yes", "1", "on"}
 FALSE_STRINGS = {"false", "no", "0", "off"}
 
+# OpenThread sizing presets selectable with `network.thread_profile`. Queue
+# sizes go into esp_openthread_platform_config_t; the rest are Kconfig values
+# that render_config.py writes into sdkconfig for Thread builds.
+THREAD_PROFILES: dict[str, dict[str, Any]] = {
+    "default": {
+        "netif_queue_size": 10,
+        "task_queue_size": 10,
+        "kconfig": {},
+    },
+    "low_memory_end_device": {
+        "netif_queue_size": 6,
+        "task_queue_size": 6,
+        "kconfig": {
+            "OPENTHREAD_MTD": True,
+            "OPENTHREAD_FTD": False,
+            "OPENTHREAD_NUM_MESSAGE_BUFFERS": 32,
+            "OPENTHREAD_TMF_ADDR_CACHE_ENTRIES": 8,
+        },
+    },
+    "router": {
+        "netif_queue_size": 24,
+        "task_queue_size": 24,
+        "kconfig": {
+            "OPENTHREAD_FTD": True,
+            "OPENTHREAD_MTD": False,
+            "OPENTHREAD_NUM_MESSAGE_BUFFERS": 128,
+            "OPENTHREAD_MLE_MAX_CHILDREN": 16,
+            "OPENTHREAD_TMF_ADDR_CACHE_ENTRIES": 32,
+        },
+    },
+}
+THREAD_OVERRIDE_KEYS = {"netif_queue_size", "task_queue_size", "message_buffers"}
+
+# Matter ICD timing for `power.source: battery`. Intervals follow the ICD
+# Management cluster; poll periods are the Thread data-poll rates of a sleepy
+# end device in idle and active mode.
+ICD_DEFAULTS = {
+    "idle_interval_s": 300,
+    "active_interval_ms": 300,
+    "active_threshold_ms": 1000,
+    "slow_poll_ms": 5000,
+    "fast_poll_ms": 200,
+}
+
+# UDP ports registered for DDP and E1.31 (sACN).
+STREAM_DEFAULT_PORTS = {"ddp": 4048, "e131": 5568}
+
+# `pwm_light` channel roles, in the order of PwmChannel in light_state.h.
+PWM_CHANNEL_ROLES = ("red", "green", "blue", "white", "cool", "warm")
+# LEDC timers run from the 80 MHz PLL: frequency * 2^resolution must fit in it.
+LEDC_SOURCE_CLOCK_HZ = 80_000_000
+
+# `light_sync` group address when none is given: all nodes of the Thread mesh
+# (realm-local) or of the Wi-Fi link.
+SYNC_DEFAULT_ADDRESSES = {"thread": "ff03::1", "wifi": "ff02::1", "wifi_thread": "ff02::1"}
+
+# LP IOs the ESP32-C6 LP core can sample (`power.lp_core.buttons`).
+LP_IO_COUNT = 8
+
+# `rules` limits: pending rules are a 32-bit mask on the device.
+MAX_RULES = 32
+MAX_RULE_ACTIONS = 8
+
+# Rule gestures, valued like Gesture in gesture_classifier.h. Long stays the
+# factory reset and Undo is internal.
+RULE_GESTURES = {"single": 0, "double": 1, "triple": 2, "hold": 4, "release": 5}
+
+# Rule action kinds, in the order of rules::Action in rule_engine.h.
+RULE_ACTIONS = ("on_off", "level", "level_step", "identify", "scene")
+RULE_ON_OFF_COMMANDS = {"off": 0, "on": 1, "toggle": 2}
+
+# `sensors`: endpoint device type -> sensor kind, kinds in the order of
+# sensor::Kind and sources in the order of sensor::Source (sensor_module.h).
+SENSOR_DEVICE_TYPES = {
+    "temperature_sensor": "temperature",
+    "humidity_sensor": "humidity",
+    "light_sensor": "illuminance",
+    "occupancy_sensor": "occupancy",
+}
+SENSOR_KINDS = ("temperature", "humidity", "illuminance", "occupancy")
+SENSOR_SOURCES = ("internal", "adc", "gpio", "sim")
+
+# Per kind: accepted sources and defaults. threshold and hysteresis are in
+# degrees, percent RH, or percent of the illuminance; occupancy only holds.
+SENSOR_DEFAULTS: dict[str, dict[str, Any]] = {
+    "temperature": {"sources": ("internal", "adc", "sim"), "period_ms": 10000, "median": 3, "smoothing": 2,
+                    "threshold": 0.2, "hysteresis": 0.05, "min_interval_s": 10, "max_interval_s": 900},
+    "humidity": {"sources": ("adc", "sim"), "period_ms": 10000, "median": 3, "smoothing": 2,
+                 "threshold": 1.0, "hysteresis": 0.2, "min_interval_s": 10, "max_interval_s": 900},
+    "illuminance": {"sources": ("adc", "sim"), "period_ms": 2000, "median": 3, "smoothing": 1,
+                    "threshold": 10.0, "hysteresis": 2.0, "min_interval_s": 2, "max_interval_s": 900},
+    "occupancy": {"sources": ("gpio", "sim"), "period_ms": 1000, "hold_s": 30},
+}
+
+# Attributes whose subscription reports can be throttled with `reporting`.
+# Cluster name -> (cluster id, {attribute name: attribute id}).
+REPORTABLE_ATTRIBUTES: dict[str, tuple[int, dict[str, int]]] = {
+    "identify": (0x0003, {"identify_time": 0x0000}),
+    "on_off": (0x0006, {"on_off": 0x0000}),
+    "level_control": (0x0008, {"current_level": 0x0000, "remaining_time": 0x0001}),
+    "color_control": (0x0300, {
+        "current_hue": 0x0000,
+        "current_saturation": 0x0001,
+        "remaining_time": 0x0002,
+        "current_x": 0x0003,
+        "current_y": 0x0004,
+        "color_temperature_mireds": 0x0007,
+    }),
+    "illuminance_measurement": (0x0400, {"measured_value": 0x0000}),
+    "temperature_measurement": (0x0402, {"measured_value": 0x0000}),
+    "relative_humidity_measurement": (0x0405, {"measured_value": 0x0000}),
+    "occupancy_sensing": (0x0406, {"occupancy": 0x0000}),
+}
+
 
 def parse_bool(value: Any) -> bool | None:
     if value is None:
@@ -33,6 +149,15 @@ def parse_int(value: Any) -> int | None:
         return None
 
 
+def parse_float(value: Any) -> float | None:
+    if value is None or isinstance(value, bool):
+        return None
+    try:
+        return float(value)
+    except (ValueError, TypeError):
+        return None
+
+
 def parse_string(value: Any) -> str | None:
     if value is None:
         return None
@@ -78,6 +203,18 @@ def extract_on_off_state(data: dict[str, Any]) -> bool | None:
     return None
 
 
+def parse_gesture_action(action: Any) -> dict[str, str] | None:
+    if not action:
+        return None
+    if not isinstance(action, dict):
+        raise ValueError("Button gesture actions must be mappings with 'cluster' and 'command'.")
+    cluster = (parse_string(action.get("cluster")) or "on_off").lower()
+    command = parse_string(action.get("command"))
+    if not command:
+        command = "identify" if cluster == "identify" else "toggle"
+    return {"cluster": cluster, "command": command.lower()}
+
+
 def parse_button_entry(button: dict[str, Any], default_mode: str) -> dict[str, Any]:
     if not isinstance(button, dict):
         raise ValueError("Each button entry must be a mapping.")
@@ -136,6 +273,31 @@ def parse_button_entry(button: dict[str, Any], default_mode: str) -> dict[str, A
     if not driver:
         driver = parse_string(button.get("driver"))
 
+    hold_time_ms = parse_int(button.get("hold_time_ms"))
+    if hold_time_ms is None:
+        hold_time_ms = 500
+
+    action_move_rate = parse_int(action.get("rate"))
+    if action_move_rate is None:
+        action_move_rate = 64
+
+    gesture_policy = parse_string(button.get("gesture_policy"))
+    gesture_policy = gesture_policy.lower() if gesture_policy else "immediate"
+    if gesture_policy not in ("immediate", "wait"):
+        raise ValueError(f"Unsupported gesture_policy '{gesture_policy}' (expected immediate or wait).")
+
+    multi_click_window_ms = parse_int(button.get("multi_click_window_ms"))
+    if multi_click_window_ms is None:
+        multi_click_window_ms = 300
+
+    double_action = parse_gesture_action(button.get("double_action"))
+    triple_action = parse_gesture_action(button.get("triple_action"))
+
+    # Hold-to-dim buttons keep the factory reset only when explicitly requested.
+    factory_reset = parse_bool(button.get("factory_reset"))
+    if factory_reset is None:
+        factory_reset = action_cluster != "level_control"
+
     return {
         "id": parse_string(button.get("id")),
         "gpio": int(gpio),
@@ -151,6 +313,68 @@ def parse_button_entry(button: dict[str, Any], default_mode: str) -> dict[str, A
         "binding_endpoint": int(binding_endpoint),
         "target_endpoint": int(target_endpoint),
         "driver": parse_string(driver),
+        "hold_time_ms": int(hold_time_ms),
+        "action_move_rate": int(action_move_rate),
+        "factory_reset": factory_reset,
+        "gesture_policy": gesture_policy,
+        "multi_click_window_ms": int(multi_click_window_ms),
+        "double_action": double_action,
+        "triple_action": triple_action,
+    }
+
+
+def parse_encoder_entry(encoder: dict[str, Any]) -> dict[str, Any]:
+    if not isinstance(encoder, dict):
+        raise ValueError("Each encoder entry must be a mapping.")
+
+    gpio_a = parse_int(encoder.get("gpio_a"))
+    gpio_b = parse_int(encoder.get("gpio_b"))
+    if gpio_a is None or gpio_b is None:
+        raise ValueError("Encoder definition requires valid 'gpio_a' and 'gpio_b' values.")
+
+    counts_per_detent = parse_int(encoder.get("counts_per_detent"))
+    if counts_per_detent is None or counts_per_detent <= 0:
+        counts_per_detent = 4
+
+    step_size = parse_int(encoder.get("step_size"))
+    if step_size is None or step_size <= 0:
+        step_size = 8
+
+    max_step_size = parse_int(encoder.get("max_step_size"))
+    if max_step_size is None or max_step_size < step_size:
+        max_step_size = max(step_size, 64)
+
+    coalesce_interval_ms = parse_int(encoder.get("coalesce_interval_ms"))
+    if coalesce_interval_ms is None or coalesce_interval_ms <= 0:
+        coalesce_interval_ms = 100
+
+    acceleration_threshold_dps = parse_int(encoder.get("acceleration_threshold_dps"))
+    if acceleration_threshold_dps is None:
+        acceleration_threshold_dps = 10
+
+    glitch_filter_ns = parse_int(encoder.get("glitch_filter_ns"))
+    if glitch_filter_ns is None:
+        glitch_filter_ns = 1000
+
+    mode = parse_string(encoder.get("mode"))
+    mode = mode.lower() if mode else "local"
+
+    binding_endpoint = parse_int(encoder.get("binding_endpoint"))
+    target_endpoint = parse_int(encoder.get("target_endpoint"))
+
+    return {
+        "id": parse_string(encoder.get("id")),
+        "gpio_a": int(gpio_a),
+        "gpio_b": int(gpio_b),
+        "counts_per_detent": int(counts_per_detent),
+        "step_size": int(min(step_size, 254)),
+        "max_step_size": int(min(max_step_size, 254)),
+        "coalesce_interval_ms": int(coalesce_interval_ms),
+        "acceleration_threshold_dps": int(acceleration_threshold_dps),
+        "glitch_filter_ns": int(glitch_filter_ns),
+        "mode": mode,
+        "binding_endpoint": int(binding_endpoint or 0),
+        "target_endpoint": int(target_endpoint or 0),
     }
 
 
@@ -209,6 +433,528 @@ def parse_endpoint_entry(endpoint: dict[str, Any]) -> dict[str, Any]:
     }
 
 
+def parse_thread_profile(network_config: dict[str, Any]) -> dict[str, Any]:
+    profile = str(network_config.get("thread_profile", "default")).lower()
+    if profile not in THREAD_PROFILES:
+        raise ValueError(
+            f"Unknown network.thread_profile '{profile}'. Supported values: {', '.join(THREAD_PROFILES)}."
+        )
+    preset = THREAD_PROFILES[profile]
+    kconfig = dict(preset["kconfig"])
+    resolved = {
+        "profile": profile,
+        "netif_queue_size": preset["netif_queue_size"],
+        "task_queue_size": preset["task_queue_size"],
+    }
+
+    overrides = network_config.get("thread") or {}
+    unknown = set(overrides) - THREAD_OVERRIDE_KEYS
+    if unknown:
+        raise ValueError(f"Unknown network.thread keys: {', '.join(sorted(unknown))}.")
+    for key in sorted(overrides):
+        value = parse_int(overrides[key])
+        if value is None or value <= 0:
+            raise ValueError(f"network.thread.{key} must be a positive integer.")
+        if key == "message_buffers":
+            kconfig["OPENTHREAD_NUM_MESSAGE_BUFFERS"] = value
+        else:
+            resolved[key] = value
+
+    resolved["kconfig"] = kconfig
+    return resolved
+
+
+def parse_power(power_config: dict[str, Any], connectivity: str, endpoints: list[dict[str, Any]],
+                encoders: list[dict[str, Any]], led_strip: dict[str, Any]) -> dict[str, Any]:
+    source = str(power_config.get("source", "mains")).lower()
+    if source not in {"mains", "battery"}:
+        raise ValueError("power.source must be 'mains' or 'battery'.")
+    icd_config = power_config.get("icd") or {}
+    unknown = set(icd_config) - set(ICD_DEFAULTS)
+    if unknown:
+        raise ValueError(f"Unknown power.icd keys: {', '.join(sorted(unknown))}.")
+    icd = {}
+    for key, default in ICD_DEFAULTS.items():
+        value = parse_int(icd_config.get(key, default))
+        if value is None or value <= 0:
+            raise ValueError(f"power.icd.{key} must be a positive integer.")
+        icd[key] = value
+
+    if source == "battery":
+        # Only a sleepy end device can live on a battery: no Wi-Fi, no LED
+        # drivers and no PCNT encoders keeping the chip awake.
+        if connectivity != "thread":
+            raise ValueError("power.source 'battery' requires network.connectivity 'thread'.")
+        non_switch = [ep.get("device_type") for ep in endpoints if ep.get("device_type") != "on_off_switch"]
+        if non_switch:
+            raise ValueError(
+                f"power.source 'battery' only supports on_off_switch endpoints, found: {', '.join(map(str, non_switch))}."
+            )
+        if encoders or led_strip:
+            raise ValueError("power.source 'battery' does not support encoders or led_strip.")
+        if icd["idle_interval_s"] * 1000 < icd["active_interval_ms"]:
+            raise ValueError("power.icd.idle_interval_s must be longer than active_interval_ms.")
+        if icd["fast_poll_ms"] > icd["slow_poll_ms"]:
+            raise ValueError("power.icd.fast_poll_ms must not exceed slow_poll_ms.")
+
+    # Battery nodes always sleep; mains nodes opt in to sleeping in standby.
+    light_sleep = parse_bool(power_config.get("light_sleep"))
+    if light_sleep is None or source == "battery":
+        light_sleep = source == "battery"
+    standby_budget_mw = parse_int(power_config.get("standby_budget_mw", 500))
+    if standby_budget_mw is None or standby_budget_mw <= 0:
+        raise ValueError("power.standby_budget_mw must be a positive integer.")
+
+    return {"source": source, "light_sleep": light_sleep, "standby_budget_mw": standby_budget_mw, "icd": icd}
+
+
+def parse_lp_core(power_config: dict[str, Any], buttons: list[dict[str, Any]]) -> dict[str, Any] | None:
+    lp_core = power_config.get("lp_core")
+    if not lp_core:
+        return None
+    if not isinstance(lp_core, dict):
+        raise ValueError("power.lp_core must be a mapping.")
+    if not parse_bool(lp_core.get("buttons")):
+        return None
+    scan_period_ms = parse_int(lp_core.get("scan_period_ms", 10))
+    debounce_ms = parse_int(lp_core.get("debounce_ms", 30))
+    if scan_period_ms is None or not 1 <= scan_period_ms <= 1000:
+        raise ValueError("power.lp_core.scan_period_ms must be between 1 and 1000.")
+    if debounce_ms is None or not scan_period_ms <= debounce_ms <= 255 * scan_period_ms:
+        raise ValueError("power.lp_core.debounce_ms must be between scan_period_ms and 255 scan periods.")
+    # The LP core only reaches LP IOs 0..7; other buttons stay on the HP core.
+    lp_gpios = [btn["gpio"] for btn in buttons if 0 <= btn["gpio"] < LP_IO_COUNT]
+    if not lp_gpios:
+        raise ValueError(f"power.lp_core.buttons needs at least one button on an LP IO (gpio 0..{LP_IO_COUNT - 1}).")
+    return {"scan_period_ms": scan_period_ms, "debounce_ms": debounce_ms}
+
+
+def parse_led_streaming(led_strip_config: dict[str, Any], connectivity: str, power: dict[str, Any]) -> dict[str, Any] | None:
+    streaming = led_strip_config.get("streaming")
+    if not streaming:
+        return None
+    if not isinstance(streaming, dict):
+        raise ValueError("led_strip.streaming must be a mapping.")
+    if connectivity not in {"wifi", "wifi_thread"}:
+        raise ValueError("led_strip.streaming needs Wi-Fi: set network.connectivity to 'wifi' or 'wifi_thread'.")
+    if power.get("light_sleep"):
+        raise ValueError("led_strip.streaming cannot be combined with power.light_sleep.")
+
+    protocol = str(streaming.get("protocol", "ddp")).lower()
+    if protocol not in STREAM_DEFAULT_PORTS:
+        raise ValueError("led_strip.streaming.protocol must be 'ddp' or 'e131'.")
+    resolved = {
+        "protocol": protocol,
+        "port": parse_int(streaming.get("port", STREAM_DEFAULT_PORTS[protocol])),
+        "universe": parse_int(streaming.get("universe", 1)),
+        "max_fps": parse_int(streaming.get("max_fps", 60)),
+        "timeout_ms": parse_int(streaming.get("timeout_ms", 2500)),
+    }
+    if resolved["port"] is None or not 1 <= resolved["port"] <= 65535:
+        raise ValueError("led_strip.streaming.port must be between 1 and 65535.")
+    if resolved["universe"] is None or not 1 <= resolved["universe"] <= 63999:
+        raise ValueError("led_strip.streaming.universe must be between 1 and 63999.")
+    if resolved["max_fps"] is None or not 1 <= resolved["max_fps"] <= 120:
+        raise ValueError("led_strip.streaming.max_fps must be between 1 and 120.")
+    if resolved["timeout_ms"] is None or resolved["timeout_ms"] <= 0:
+        raise ValueError("led_strip.streaming.timeout_ms must be a positive integer.")
+    return resolved
+
+
+def parse_led_power_limit(led_strip_config: dict[str, Any]) -> dict[str, Any] | None:
+    limit = led_strip_config.get("power_limit")
+    if not limit:
+        return None
+    if not isinstance(limit, dict):
+        raise ValueError("led_strip.power_limit must be a mapping.")
+    resolved = {
+        "budget_ma": parse_int(limit.get("budget_ma")),
+        "channel_ma": parse_int(limit.get("channel_ma", 20)),
+        "idle_ua": parse_int(limit.get("idle_ua", 1000)),
+    }
+    if resolved["budget_ma"] is None or resolved["budget_ma"] <= 0:
+        raise ValueError("led_strip.power_limit.budget_ma must be a positive integer.")
+    if resolved["channel_ma"] is None or not 1 <= resolved["channel_ma"] <= 1000:
+        raise ValueError("led_strip.power_limit.channel_ma must be between 1 and 1000.")
+    if resolved["idle_ua"] is None or not 0 <= resolved["idle_ua"] <= 65535:
+        raise ValueError("led_strip.power_limit.idle_ua must be between 0 and 65535.")
+    idle_ma = (parse_int(led_strip_config.get("led_count")) or 0) * resolved["idle_ua"] / 1000
+    if idle_ma >= resolved["budget_ma"]:
+        raise ValueError(
+            f"led_strip.power_limit.budget_ma ({resolved['budget_ma']}) is below the idle draw of the strip "
+            f"({idle_ma:.0f} mA)."
+        )
+    return resolved
+
+
+def parse_pwm_light(pwm_config: dict[str, Any], led_strip_config: dict[str, Any],
+                    power: dict[str, Any]) -> dict[str, Any] | None:
+    if not pwm_config:
+        return None
+    if not isinstance(pwm_config, dict):
+        raise ValueError("pwm_light must be a mapping.")
+    if led_strip_config:
+        raise ValueError("pwm_light and led_strip cannot both drive the light; keep one of them.")
+    if power.get("source") == "battery":
+        raise ValueError("power.source 'battery' does not support pwm_light.")
+
+    channels_config = pwm_config.get("channels") or {}
+    unknown = set(channels_config) - set(PWM_CHANNEL_ROLES)
+    if unknown:
+        raise ValueError(
+            f"Unknown pwm_light.channels: {', '.join(sorted(unknown))}. Supported: {', '.join(PWM_CHANNEL_ROLES)}."
+        )
+    channels = []
+    for role in PWM_CHANNEL_ROLES:
+        if role not in channels_config:
+            continue
+        gpio = parse_int(channels_config[role])
+        if gpio is None or gpio < 0:
+            raise ValueError(f"pwm_light.channels.{role} must be a GPIO number.")
+        channels.append({"role": role, "gpio": gpio})
+    roles = {channel["role"] for channel in channels}
+    if not roles:
+        raise ValueError("pwm_light.channels needs at least one channel.")
+    if roles & {"red", "green", "blue"} and not {"red", "green", "blue"} <= roles:
+        raise ValueError("pwm_light.channels: red, green and blue go together.")
+    if roles & {"cool", "warm"} and not {"cool", "warm"} <= roles:
+        raise ValueError("pwm_light.channels: cool and warm go together.")
+    gpios = [channel["gpio"] for channel in channels]
+    if len(set(gpios)) != len(gpios):
+        raise ValueError("pwm_light.channels: every channel needs its own GPIO.")
+
+    resolved = {
+        "frequency_hz": parse_int(pwm_config.get("frequency_hz", 4000)),
+        "resolution_bits": parse_int(pwm_config.get("resolution_bits", 14)),
+        "fade_ms": parse_int(pwm_config.get("fade_ms", 400)),
+        "cool_mireds": parse_int(pwm_config.get("cool_mireds", 153)),
+        "warm_mireds": parse_int(pwm_config.get("warm_mireds", 370)),
+        "channels": channels,
+    }
+    if resolved["resolution_bits"] is None or not 8 <= resolved["resolution_bits"] <= 20:
+        raise ValueError("pwm_light.resolution_bits must be between 8 and 20.")
+    if resolved["frequency_hz"] is None or resolved["frequency_hz"] <= 0:
+        raise ValueError("pwm_light.frequency_hz must be a positive integer.")
+    if resolved["frequency_hz"] << resolved["resolution_bits"] > LEDC_SOURCE_CLOCK_HZ:
+        max_hz = LEDC_SOURCE_CLOCK_HZ >> resolved["resolution_bits"]
+        raise ValueError(
+            f"pwm_light: {resolved['resolution_bits']}-bit duty allows at most {max_hz} Hz; "
+            "lower frequency_hz or resolution_bits."
+        )
+    if resolved["fade_ms"] is None or not 0 <= resolved["fade_ms"] <= 10000:
+        raise ValueError("pwm_light.fade_ms must be between 0 and 10000.")
+    cool, warm = resolved["cool_mireds"], resolved["warm_mireds"]
+    if cool is None or warm is None or not 0 < cool < warm <= 1000:
+        raise ValueError("pwm_light: cool_mireds must be lower than warm_mireds (both 1..1000).")
+    return resolved
+
+
+def parse_light_sync(sync_config: dict[str, Any], led_strip_config: dict[str, Any],
+                     pwm_light: dict[str, Any] | None, connectivity: str,
+                     power: dict[str, Any]) -> dict[str, Any] | None:
+    if not sync_config:
+        return None
+    if not isinstance(sync_config, dict):
+        raise ValueError("light_sync must be a mapping.")
+    if not led_strip_config and not pwm_light:
+        raise ValueError("light_sync needs a led_strip or pwm_light to render effects on.")
+    if power.get("light_sleep"):
+        raise ValueError("light_sync cannot be combined with power.light_sleep.")
+    resolved = {
+        "domain": parse_int(sync_config.get("domain", 1)),
+        "port": parse_int(sync_config.get("port", 5690)),
+        "beacon_interval_ms": parse_int(sync_config.get("beacon_interval_ms", 1000)),
+        "frame_ms": parse_int(sync_config.get("frame_ms", 20)),
+        "address": parse_string(sync_config.get("address")) or SYNC_DEFAULT_ADDRESSES.get(connectivity, "ff02::1"),
+    }
+    if resolved["domain"] is None or not 0 <= resolved["domain"] <= 0xFFFF:
+        raise ValueError("light_sync.domain must be between 0 and 65535.")
+    if resolved["port"] is None or not 1 <= resolved["port"] <= 0xFFFF:
+        raise ValueError("light_sync.port must be between 1 and 65535.")
+    if resolved["beacon_interval_ms"] is None or not 100 <= resolved["beacon_interval_ms"] <= 10000:
+        raise ValueError("light_sync.beacon_interval_ms must be between 100 and 10000.")
+    if resolved["frame_ms"] is None or not 10 <= resolved["frame_ms"] <= 100:
+        raise ValueError("light_sync.frame_ms must be between 10 and 100.")
+    try:
+        address = ipaddress.IPv6Address(resolved["address"])
+    except ValueError as exc:
+        raise ValueError(f"light_sync.address '{resolved['address']}' is not an IPv6 address.") from exc
+    if not address.is_multicast:
+        raise ValueError(f"light_sync.address '{resolved['address']}' must be an IPv6 multicast group.")
+    resolved["address"] = str(address)
+    return resolved
+
+
+# Threshold in YAML units -> units of the measured attribute.
+def sensor_units(kind: str, value: float) -> int:
+    if kind == "illuminance":
+        # MeasuredValue is 10000 * log10(lux) + 1, so a relative change is a fixed step.
+        return round(10000 * math.log10(1 + value / 100))
+    return round(value * 100)
+
+
+def parse_sensor_entry(sensor: Any, where: str, endpoints: dict[int, str]) -> dict[str, Any]:
+    if not isinstance(sensor, dict):
+        raise ValueError(f"{where} must be a mapping.")
+    endpoint = parse_int(sensor.get("endpoint"))
+    if endpoint not in endpoints or endpoints[endpoint] not in SENSOR_DEVICE_TYPES:
+        raise ValueError(f"{where}.endpoint must be the id of a {', '.join(SENSOR_DEVICE_TYPES)} endpoint.")
+    kind = SENSOR_DEVICE_TYPES[endpoints[endpoint]]
+    defaults = SENSOR_DEFAULTS[kind]
+
+    source = (parse_string(sensor.get("source")) or defaults["sources"][0]).lower()
+    if source not in defaults["sources"]:
+        raise ValueError(f"{where}.source must be one of {', '.join(defaults['sources'])} for {endpoints[endpoint]}.")
+    gpio = parse_int(sensor.get("gpio", -1))
+    if source in {"adc", "gpio"} and (gpio is None or not 0 <= gpio <= 30):
+        raise ValueError(f"{where}.gpio is required for source {source}.")
+
+    resolved = {
+        "endpoint": endpoint,
+        "kind": kind,
+        "source": source,
+        "gpio": gpio if source in {"adc", "gpio"} else -1,
+        "active_low": bool(parse_bool(sensor.get("active_low"))),
+        "adc": {"mv_min": 0, "mv_max": 0, "min": 0, "max": 0},
+        "period_ms": 0 if source == "gpio" else parse_int(sensor.get("period_ms", defaults["period_ms"])),
+        "median": 1,
+        "smoothing": 0,
+        "threshold": 0,
+        "hysteresis": 0,
+        "min_interval_ms": 0,
+        "max_interval_ms": 0,
+        "hold_ms": 0,
+    }
+    if resolved["period_ms"] is None or (source != "gpio" and not 100 <= resolved["period_ms"] <= 3_600_000):
+        raise ValueError(f"{where}.period_ms must be between 100 and 3600000.")
+
+    if source == "adc":
+        # Linear scale from millivolts to degrees, percent RH or lux.
+        adc = sensor.get("adc") or {}
+        mv_min, mv_max = parse_int(adc.get("mv_min")), parse_int(adc.get("mv_max"))
+        low, high = parse_float(adc.get("min")), parse_float(adc.get("max"))
+        if None in (mv_min, mv_max, low, high) or not 0 <= mv_min < mv_max <= 3300:
+            raise ValueError(f"{where}.adc needs mv_min < mv_max (0..3300) and the min and max they read as.")
+        scale = 1 if kind == "illuminance" else 100
+        resolved["adc"] = {"mv_min": mv_min, "mv_max": mv_max, "min": round(low * scale), "max": round(high * scale)}
+
+    if kind == "occupancy":
+        hold_s = parse_int(sensor.get("hold_s", defaults["hold_s"]))
+        if hold_s is None or not 0 <= hold_s <= 3600:
+            raise ValueError(f"{where}.hold_s must be between 0 and 3600.")
+        resolved["hold_ms"] = hold_s * 1000
+        return resolved
+
+    median = parse_int(sensor.get("median", defaults["median"]))
+    if median not in (1, 3, 5):
+        raise ValueError(f"{where}.median must be 1, 3 or 5.")
+    smoothing = parse_int(sensor.get("smoothing", defaults["smoothing"]))
+    if smoothing is None or not 0 <= smoothing <= 6:
+        raise ValueError(f"{where}.smoothing must be between 0 and 6.")
+    threshold = parse_float(sensor.get("threshold", defaults["threshold"]))
+    hysteresis = parse_float(sensor.get("hysteresis", defaults["hysteresis"]))
+    if threshold is None or threshold < 0 or hysteresis is None or hysteresis < 0:
+        raise ValueError(f"{where}.threshold and hysteresis must be >= 0.")
+    min_interval_s = parse_int(sensor.get("min_interval_s", defaults["min_interval_s"]))
+    max_interval_s = parse_int(sensor.get("max_interval_s", defaults["max_interval_s"]))
+    if min_interval_s is None or max_interval_s is None or not 0 <= min_interval_s <= 3600 or max_interval_s < 0:
+        raise ValueError(f"{where}: min_interval_s must be between 0 and 3600 and max_interval_s >= 0.")
+    if max_interval_s and max_interval_s < min_interval_s:
+        raise ValueError(f"{where}.max_interval_s must not be shorter than min_interval_s.")
+    resolved.update({
+        "median": median,
+        "smoothing": smoothing,
+        "threshold": sensor_units(kind, threshold),
+        "hysteresis": sensor_units(kind, hysteresis),
+        "min_interval_ms": min_interval_s * 1000,
+        "max_interval_ms": max_interval_s * 1000,
+    })
+    return resolved
+
+
+def parse_sensors(sensors_config: Any, endpoints: list[dict[str, Any]]) -> list[dict[str, Any]]:
+    if sensors_config and not isinstance(sensors_config, list):
+        raise ValueError("sensors must be a list.")
+    device_types = {endpoint["id"]: endpoint["device_type"] for endpoint in endpoints}
+    sensors = [parse_sensor_entry(sensor, f"sensors[{idx}]", device_types)
+               for idx, sensor in enumerate(sensors_config or [])]
+    # Exactly one source per sensor endpoint.
+    sources = [sensor["endpoint"] for sensor in sensors]
+    for endpoint_id, device_type in device_types.items():
+        if device_type in SENSOR_DEVICE_TYPES and sources.count(endpoint_id) != 1:
+            raise ValueError(f"Endpoint {endpoint_id} ({device_type}) needs exactly one entry in sensors.")
+    return sensors
+
+
+def parse_reporting(reporting_config: dict[str, Any]) -> list[dict[str, Any]]:
+    policies = []
+    for cluster, attributes in (reporting_config or {}).items():
+        if cluster not in REPORTABLE_ATTRIBUTES:
+            raise ValueError(
+                f"reporting: unsupported cluster '{cluster}'. Supported: {', '.join(REPORTABLE_ATTRIBUTES)}."
+            )
+        cluster_id, attribute_ids = REPORTABLE_ATTRIBUTES[cluster]
+        for attribute, policy in (attributes or {}).items():
+            if attribute not in attribute_ids:
+                raise ValueError(
+                    f"reporting.{cluster}: unsupported attribute '{attribute}'. "
+                    f"Supported: {', '.join(attribute_ids)}."
+                )
+            policy = policy or {}
+            min_interval_ms = parse_int(policy.get("min_interval_ms", 0))
+            threshold = parse_int(policy.get("threshold", 0))
+            if min_interval_ms is None or min_interval_ms < 0 or threshold is None or threshold < 0:
+                raise ValueError(f"reporting.{cluster}.{attribute}: min_interval_ms and threshold must be >= 0.")
+            if min_interval_ms == 0 and threshold > 0:
+                raise ValueError(f"reporting.{cluster}.{attribute}: threshold needs a min_interval_ms to flush on.")
+            policies.append({
+                "cluster": cluster,
+                "attribute": attribute,
+                "cluster_id": cluster_id,
+                "attribute_id": attribute_ids[attribute],
+                "min_interval_ms": min_interval_ms,
+                "threshold": threshold,
+            })
+    return policies
+
+
+def parse_rule_trigger(trigger: Any, where: str, buttons: list[dict[str, Any]],
+                       endpoint_ids: set[int]) -> dict[str, Any]:
+    if not isinstance(trigger, dict):
+        raise ValueError(f"{where}.trigger must be a mapping.")
+    kinds = [key for key in ("button", "attribute", "every_s") if key in trigger]
+    if len(kinds) != 1:
+        raise ValueError(f"{where}.trigger needs exactly one of button, attribute or every_s.")
+
+    if kinds[0] == "button":
+        button_id = parse_string(trigger.get("button"))
+        if not button_id or not any(button.get("id") == button_id for button in buttons):
+            raise ValueError(f"{where}.trigger.button '{button_id}' is not the id of a configured button.")
+        gesture = (parse_string(trigger.get("gesture")) or "single").lower()
+        if gesture not in RULE_GESTURES:
+            raise ValueError(f"{where}.trigger.gesture must be one of {', '.join(RULE_GESTURES)}.")
+        return {"kind": "button", "button": button_id, "gesture": gesture}
+
+    if kinds[0] == "every_s":
+        every_s = parse_int(trigger.get("every_s"))
+        if every_s is None or not 1 <= every_s <= 7 * 86400:
+            raise ValueError(f"{where}.trigger.every_s must be between 1 and 604800.")
+        return {"kind": "timer", "period_ms": every_s * 1000}
+
+    path = parse_string(trigger.get("attribute")) or ""
+    cluster, _, attribute = path.partition(".")
+    if cluster not in REPORTABLE_ATTRIBUTES or attribute not in REPORTABLE_ATTRIBUTES[cluster][1]:
+        supported = [f"{name}.{attr}" for name, (_, attrs) in REPORTABLE_ATTRIBUTES.items() for attr in attrs]
+        raise ValueError(f"{where}.trigger.attribute '{path}' is not supported. Supported: {', '.join(supported)}.")
+    endpoint = parse_int(trigger.get("endpoint"))
+    if endpoint not in endpoint_ids:
+        raise ValueError(f"{where}.trigger.endpoint must be the id of a configured endpoint.")
+    compares = [key for key in ("equals", "above", "below") if key in trigger]
+    if len(compares) > 1:
+        raise ValueError(f"{where}.trigger takes at most one of equals, above or below.")
+    compare = compares[0] if compares else "changed"
+    value = parse_int(trigger.get(compare)) if compares else 0
+    if value is None:
+        raise ValueError(f"{where}.trigger.{compare} must be a number or a boolean.")
+    for_s = parse_int(trigger.get("for_s", 0))
+    if for_s is None or not 0 <= for_s <= 86400:
+        raise ValueError(f"{where}.trigger.for_s must be between 0 and 86400.")
+    if for_s and compare == "changed":
+        raise ValueError(f"{where}.trigger.for_s needs an equals, above or below condition.")
+    return {
+        "kind": "attribute",
+        "endpoint": endpoint,
+        "cluster": cluster,
+        "attribute": attribute,
+        "cluster_id": REPORTABLE_ATTRIBUTES[cluster][0],
+        "attribute_id": REPORTABLE_ATTRIBUTES[cluster][1][attribute],
+        "compare": compare,
+        "value": value,
+        "period_ms": for_s * 1000,
+    }
+
+
+def parse_rule_action(action: Any, where: str, endpoint_ids: set[int]) -> dict[str, Any]:
+    if not isinstance(action, dict):
+        raise ValueError(f"{where} must be a mapping.")
+    kinds = [key for key in RULE_ACTIONS if key in action]
+    if len(kinds) != 1:
+        raise ValueError(f"{where} needs exactly one of {', '.join(RULE_ACTIONS)}.")
+    kind = kinds[0]
+    raw = action[kind]
+
+    group_id = 0
+    if kind == "on_off":
+        # YAML 1.1 reads unquoted on/off as booleans.
+        command = ("on" if raw else "off") if isinstance(raw, bool) else (parse_string(raw) or "").lower()
+        if command not in RULE_ON_OFF_COMMANDS:
+            raise ValueError(f"{where}.on_off must be on, off or toggle.")
+        value = RULE_ON_OFF_COMMANDS[command]
+    else:
+        value = parse_int(raw)
+        limits = {"level": (0, 254), "level_step": (-254, 254), "identify": (0, 0xFFFF), "scene": (0, 0xFF)}[kind]
+        if value is None or not limits[0] <= value <= limits[1] or (kind == "level_step" and value == 0):
+            raise ValueError(f"{where}.{kind} must be between {limits[0]} and {limits[1]}"
+                             f"{' and not 0' if kind == 'level_step' else ''}.")
+        if kind == "scene":
+            group_id = parse_int(action.get("group", 0))
+            if group_id is None or not 0 <= group_id <= 0xFFFF:
+                raise ValueError(f"{where}.group must be between 0 and 65535.")
+
+    if "endpoint" in action and "bound" in action:
+        raise ValueError(f"{where} takes either endpoint (local) or bound (through bindings), not both.")
+    bound = "bound" in action and action["bound"] is not False
+    key = "bound" if bound else "endpoint"
+    # 0 picks the default at runtime: the first light endpoint, or with
+    # `bound: true` the bindings of the first on_off_switch endpoint.
+    raw_endpoint = action.get(key, 0)
+    endpoint = 0 if raw_endpoint is True else parse_int(raw_endpoint)
+    if endpoint is None or (endpoint and endpoint not in endpoint_ids):
+        raise ValueError(f"{where}.{key} must be the id of a configured endpoint.")
+    return {"kind": kind, "bound": bound, "endpoint": endpoint, "value": value, "group_id": group_id}
+
+
+def parse_rules(rules_config: Any, buttons: list[dict[str, Any]],
+                endpoints: list[dict[str, Any]]) -> list[dict[str, Any]]:
+    if not rules_config:
+        return []
+    if not isinstance(rules_config, list):
+        raise ValueError("rules must be a list.")
+    if len(rules_config) > MAX_RULES:
+        raise ValueError(f"At most {MAX_RULES} rules are supported.")
+    endpoint_ids = {endpoint["id"] for endpoint in endpoints}
+    rules = []
+    for idx, rule in enumerate(rules_config):
+        where = f"rules[{idx}]"
+        if not isinstance(rule, dict):
+            raise ValueError(f"{where} must be a mapping.")
+        actions = rule.get("actions") or []
+        if not isinstance(actions, list) or not 1 <= len(actions) <= MAX_RULE_ACTIONS:
+            raise ValueError(f"{where}.actions must list 1 to {MAX_RULE_ACTIONS} actions.")
+        rules.append({
+            "name": parse_string(rule.get("name")) or f"rule{idx}",
+            "trigger": parse_rule_trigger(rule.get("trigger"), where, buttons, endpoint_ids),
+            "actions": [parse_rule_action(action, f"{where}.actions[{pos}]", endpoint_ids)
+                        for pos, action in enumerate(actions)],
+        })
+
+    # With the immediate policy a single click runs before a double click is
+    # known and is then undone, which only works for the button's own toggle.
+    for button in buttons:
+        gestures = {rule["trigger"]["gesture"] for rule in rules
+                    if rule["trigger"]["kind"] == "button" and rule["trigger"]["button"] == button["id"]}
+        multi_click = bool(button.get("double_action") or button.get("triple_action") or
+                           gestures & {"double", "triple"})
+        if "single" in gestures and multi_click and button.get("gesture_policy") != "wait":
+            raise ValueError(f"Button '{button['id']}' has a single-click rule and multi-click gestures; "
+                             "set its gesture_policy to wait.")
+        # The factory-reset long press is a hold that lasts long enough.
+        if gestures & {"hold", "release"} and button.get("factory_reset"):
+            raise ValueError(f"Button '{button['id']}' has hold rules and factory_reset; "
+                             "set its factory_reset to false or move the rules to another button.")
+    return rules
+
+
 def normalize_configuration(config: dict[str, Any]) -> dict[str, Any]:
     app_info = config.get("app", {}) if config else {}
     endpoints_yaml = app_info.get("endpoints", []) if app_info else []
@@ -225,9 +971,22 @@ def normalize_configuration(config: dict[str, Any]) -> dict[str, Any]:
     default_mode = "remote" if device_type == "switch" else "local"
     parsed_buttons = [parse_button_entry(btn, default_mode) for btn in buttons_yaml]
 
+    encoders_yaml = app_info.get("encoders", []) if app_info else []
+    parsed_encoders = [parse_encoder_entry(enc) for enc in encoders_yaml or []]
+
     led_strip_config = app_info.get("led_strip", {}) or {}
     network_config = app_info.get("network", {}) or {}
     connectivity = str(network_config.get("connectivity", "wifi")).lower()
+    ble_after_commissioning = str(network_config.get("ble_after_commissioning", "keep")).lower()
+    if ble_after_commissioning not in {"keep", "release"}:
+        raise ValueError("network.ble_after_commissioning must be 'keep' or 'release'.")
+    thread = parse_thread_profile(network_config)
+
+    power = parse_power(app_info.get("power") or {}, connectivity, parsed_endpoints, parsed_encoders, led_strip_config)
+    power["lp_core"] = parse_lp_core(app_info.get("power") or {}, parsed_buttons)
+    led_streaming = parse_led_streaming(led_strip_config, connectivity, power)
+    pwm_light = parse_pwm_light(app_info.get("pwm_light") or {}, led_strip_config, power)
+    light_sync = parse_light_sync(app_info.get("light_sync") or {}, led_strip_config, pwm_light, connectivity, power)
 
     raw_flash_size = app_info.get("flash_size") or app_info.get("flash")
     flash_size_str = parse_string(raw_flash_size)
@@ -248,13 +1007,26 @@ def normalize_configuration(config: dict[str, Any]) -> dict[str, Any]:
     return {
         "device_type": device_type,
         "device_name": app_info.get("device_name", "ESP32 Matter Device"),
-        "network": {"connectivity": connectivity},
+        "network": {
+            "connectivity": connectivity,
+            "ble_after_commissioning": ble_after_commissioning,
+            "thread": thread,
+        },
         "led_strip": {
             "led_count": parse_int(led_strip_config.get("led_count")) or 0,
             "rmt_gpio": parse_int(led_strip_config.get("rmt_gpio")) or -1,
             "type": parse_string(led_strip_config.get("type")) or "ws2812",
+            "streaming": led_streaming,
+            "power_limit": parse_led_power_limit(led_strip_config),
         } if led_strip_config else None,
+        "pwm_light": pwm_light,
+        "light_sync": light_sync,
+        "power": power,
+        "reporting": parse_reporting(app_info.get("reporting") or {}),
+        "rules": parse_rules(app_info.get("rules"), parsed_buttons, parsed_endpoints),
+        "sensors": parse_sensors(app_info.get("sensors"), parsed_endpoints),
         "buttons": parsed_buttons,
+        "encoders": parsed_encoders,
         "endpoints": parsed_endpoints,
         "flash": {"size": flash_size_str},
     }
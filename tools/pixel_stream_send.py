@@ -0,0 +1,116 @@
+"""Streams a test pattern to a light in DDP or E1.31 mode and reports the send rate.
+
+The light prints the receive side (`matter esp stream`): frames shown,
+frames per second and packet-to-frame latency. Pointed at 127.0.0.1, the
+same sender drives PixelStream built for a host with SimulatedPixelOutput.
+"""
+
+import argparse
+import colorsys
+import socket
+import struct
+import sys
+import time
+import uuid
+
+DDP_PORT = 4048
+E131_PORT = 5568
+DDP_MAX_DATA = 1440
+DDP_FLAGS_VERSION1 = 0x40
+DDP_FLAG_PUSH = 0x01
+DDP_ID_DISPLAY = 1
+DDP_TYPE_RGB8 = 0x0B
+DMX_SLOTS = 512
+
+
+def rainbow_frame(pixels: int, bytes_per_pixel: int, phase: float) -> bytes:
+    frame = bytearray()
+    for idx in range(pixels):
+        r, g, b = colorsys.hsv_to_rgb((phase + idx / max(pixels, 1)) % 1.0, 1.0, 1.0)
+        frame += bytes((int(r * 255), int(g * 255), int(b * 255)))
+        frame += bytes(bytes_per_pixel - 3)
+    return bytes(frame)
+
+
+def ddp_packets(frame: bytes, sequence: int) -> list[bytes]:
+    packets = []
+    for offset in range(0, len(frame), DDP_MAX_DATA):
+        chunk = frame[offset:offset + DDP_MAX_DATA]
+        last = offset + len(chunk) >= len(frame)
+        flags = DDP_FLAGS_VERSION1 | (DDP_FLAG_PUSH if last else 0)
+        header = struct.pack(">BBBBIH", flags, sequence, DDP_TYPE_RGB8, DDP_ID_DISPLAY, offset, len(chunk))
+        packets.append(header + chunk)
+    return packets
+
+
+def e131_packets(frame: bytes, bytes_per_pixel: int, first_universe: int, sequence: int, cid: bytes) -> list[bytes]:
+    universe_bytes = (DMX_SLOTS // bytes_per_pixel) * bytes_per_pixel
+    packets = []
+    for index, offset in enumerate(range(0, len(frame), universe_bytes)):
+        data = b"\x00" + frame[offset:offset + universe_bytes]
+        dmp = struct.pack(">HBBHHH", 0x7000 | (10 + len(data)), 0x02, 0xA1, 0, 1, len(data)) + data
+        source = b"pixel_stream_send".ljust(64, b"\x00")
+        framing = struct.pack(">HI64sBHBBH", 0x7000 | (77 + len(dmp)), 0x00000002, source, 100, 0,
+                              sequence, 0, first_universe + index) + dmp
+        root = struct.pack(">HH12sHI16s", 0x0010, 0, b"ASC-E1.17\x00\x00\x00", 0x7000 | (22 + len(framing)),
+                           0x00000004, cid) + framing
+        packets.append(root)
+    return packets
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("host", help="light IP address (127.0.0.1 for a host build)")
+    parser.add_argument("--protocol", choices=("ddp", "e131"), default="ddp")
+    parser.add_argument("--port", type=int, help="UDP port (default 4048 for DDP, 5568 for E1.31)")
+    parser.add_argument("--universe", type=int, default=1, help="first E1.31 universe")
+    parser.add_argument("--pixels", type=int, default=60)
+    parser.add_argument("--rgbw", action="store_true", help="send 4 bytes per pixel")
+    parser.add_argument("--fps", type=float, default=60.0)
+    parser.add_argument("--seconds", type=float, default=10.0)
+    args = parser.parse_args()
+
+    port = args.port or (DDP_PORT if args.protocol == "ddp" else E131_PORT)
+    bytes_per_pixel = 4 if args.rgbw else 3
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    cid = uuid.uuid4().bytes
+
+    interval = 1.0 / args.fps
+    start = time.perf_counter()
+    next_frame = start
+    frames = 0
+    packets = 0
+    late = 0
+    worst_jitter = 0.0
+    while True:
+        now = time.perf_counter()
+        if now - start >= args.seconds:
+            break
+        if now < next_frame:
+            time.sleep(next_frame - now)
+            now = time.perf_counter()
+        jitter = now - next_frame
+        worst_jitter = max(worst_jitter, jitter)
+        if jitter > interval:
+            late += 1
+            next_frame = now
+
+        frame = rainbow_frame(args.pixels, bytes_per_pixel, (now - start) / 4.0)
+        if args.protocol == "ddp":
+            batch = ddp_packets(frame, frames % 15 + 1)
+        else:
+            batch = e131_packets(frame, bytes_per_pixel, args.universe, frames % 256, cid)
+        for packet in batch:
+            sock.sendto(packet, (args.host, port))
+        packets += len(batch)
+        frames += 1
+        next_frame += interval
+
+    elapsed = time.perf_counter() - start
+    print(f"{frames} frames / {packets} packets in {elapsed:.2f} s: {frames / elapsed:.1f} fps, "
+          f"worst send jitter {worst_jitter * 1000:.2f} ms, {late} late frames")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,10 +1,13 @@
 import argparse
+import ctypes
 import os
 import shutil
 from typing import Any
 
 import yaml
 
+import config_layout as layout
+
 SDKCONFIG_TEMPLATE_MAP = {
     "wifi": "sdkconfig.defaults_wifi",
     "thread": "sdkconfig.defaults_thread",
@@ -17,59 +20,93 @@ PARTITION_TEMPLATE_MAP = {
     "16MB": "partitions.csv_16MB",
 }
 
-
-def optional_bool_literal(value: bool | None) -> str:
-    if value is None:
-        return "{false, false}"
-    return "{true, " + ("true" if value else "false") + "}"
-
-
-def optional_int_literal(value: int | None) -> str:
-    if value is None:
-        return "{false, 0}"
-    return f"{{true, {value}}}"
-
-
-def optional_string_literal(value: str | None) -> str:
-    if value is None:
-        return "{false, nullptr}"
-    return f'{{true, "{value}"}}'
+# Rough per-object costs of the esp_matter data model on a 32-bit target,
+# including the allocator's 8-byte rounding. Only used to size the model arena;
+# an underestimate spills to the heap and shows up in the high-water report.
+MODEL_ROOT_NODE_BYTES = 8192
+MODEL_ENDPOINT_BYTES = 384  # endpoint plus its descriptor cluster
+MODEL_CLUSTER_BYTES = 64
+MODEL_ATTRIBUTE_BYTES = 48
+MODEL_COMMAND_BYTES = 24
+MODEL_SENSOR_ATTRIBUTES = 5  # measurement cluster of a sensor endpoint
+MODEL_ARENA_HEADROOM = 1.25
+
+# PwmChannel values in light_state.h, indexed like parse_config.PWM_CHANNEL_ROLES.
+PWM_CHANNEL_ROLES = ("red", "green", "blue", "white", "cool", "warm")
+
+# rules::Trigger, rules::Compare and rules::Action values in rule_engine.h;
+# gestures are button::Gesture values in gesture_classifier.h.
+RULE_TRIGGERS = ("button", "attribute", "timer")
+RULE_COMPARES = ("changed", "equals", "above", "below")
+RULE_ACTIONS = ("on_off", "level", "level_step", "identify", "scene")
+RULE_GESTURES = {"single": 0, "double": 1, "triple": 2, "hold": 4, "release": 5}
+
+# Sensor endpoint device types; sensor::Kind and sensor::Source values in
+# sensor_module.h.
+SENSOR_DEVICE_TYPES = ("temperature_sensor", "humidity_sensor", "light_sensor", "occupancy_sensor")
+SENSOR_KINDS = ("temperature", "humidity", "illuminance", "occupancy")
+SENSOR_SOURCES = ("internal", "adc", "gpio", "sim")
+
+# (attributes, commands) per cluster, plus extras per feature.
+MODEL_CLUSTER_COSTS = {
+    "identify": ((3, 2), {}),
+    "groups": ((2, 6), {}),
+    "scenes_management": ((6, 9), {}),
+    "on_off": ((2, 3), {"lighting": (4, 3)}),
+    "level_control": ((5, 8), {"lighting": (4, 0)}),
+    "color_control": ((6, 0), {
+        "hue_saturation": (3, 7),
+        "enhanced_hue": (1, 4),
+        "color_loop": (5, 1),
+        "xy": (3, 3),
+        "color_temperature": (5, 3),
+    }),
+}
 
 
-def cpp_string_literal(value: str) -> str:
-    return value.replace("\\", "\\\\").replace('"', '\\"')
+def estimate_model_arena_size(endpoints: list[dict[str, Any]]) -> int:
+    total = MODEL_ROOT_NODE_BYTES
+    for endpoint in endpoints:
+        total += MODEL_ENDPOINT_BYTES
+        if endpoint.get("device_type") in SENSOR_DEVICE_TYPES:
+            # The measurement cluster, which config.yaml does not list.
+            total += MODEL_CLUSTER_BYTES + MODEL_SENSOR_ATTRIBUTES * MODEL_ATTRIBUTE_BYTES
+        for cluster, (base, feature_costs) in MODEL_CLUSTER_COSTS.items():
+            cluster_cfg = endpoint.get(cluster) or {}
+            if not cluster_cfg.get("present"):
+                continue
+            attributes, commands = base
+            for feature in cluster_cfg.get("features") or []:
+                extra_attributes, extra_commands = feature_costs.get(feature, (0, 0))
+                attributes += extra_attributes
+                commands += extra_commands
+            total += MODEL_CLUSTER_BYTES + attributes * MODEL_ATTRIBUTE_BYTES + commands * MODEL_COMMAND_BYTES
+    total = int(total * MODEL_ARENA_HEADROOM)
+    return (total + 511) & ~511
 
 
 def emit_header(output_path: str, data: dict[str, Any]) -> None:
-    device_type = data.get("device_type", "light")
-    device_name = data.get("device_name", "ESP32 Matter Device")
     network = data.get("network") or {}
     connectivity = str(network.get("connectivity", "wifi")).lower()
     flash = data.get("flash") or {}
     flash_size = str(flash.get("size", "4MB")).upper()
-    buttons = data.get("buttons") or []
     led_strip = data.get("led_strip")
-    endpoints = data.get("endpoints") or []
-
-    button_count = len(buttons)
     led_strip_count = int(led_strip.get("led_count", 0)) if led_strip else 0
 
-    feature_arrays: list[tuple[str, list[str]]] = []
-    normalized_endpoints = []
-    for idx, endpoint in enumerate(endpoints):
-        endpoint_copy = dict(endpoint)
-        for cluster_name in ("on_off", "level_control", "color_control"):
-            cluster = dict(endpoint_copy.get(cluster_name, {}))
-            features = cluster.get("features") or []
-            if features:
-                array_name = f"kEndpoint{idx}_{cluster_name}_features"
-                feature_arrays.append((array_name, features))
-                cluster["features_array"] = array_name
-            else:
-                cluster["features_array"] = None
-            cluster["features_count"] = len(features)
-            endpoint_copy[cluster_name] = cluster
-        normalized_endpoints.append(endpoint_copy)
+    device, buttons, encoders, endpoints = layout.build_records(data)
+    structs = {f"{ns}::{name}" if ns else name: (ns, name, fields) for name, ns, fields in layout.STRUCTS}
+
+    def write_struct(key: str) -> None:
+        _, name, fields = structs[key]
+        f.write(layout.cpp_struct(name, fields) + "\n")
+        f.write(f"static_assert(sizeof({name}) == {ctypes.sizeof(layout.CLASSES[key])}, "
+                f"\"layout must match tools/config_layout.py\");\n\n")
+
+    def write_array(type_name: str, name: str, records: list[Any]) -> None:
+        f.write(f"inline constexpr {type_name} {name}[] = {{\n")
+        for record in records:
+            f.write(f"    {layout.cpp_value(record, 4)},\n")
+        f.write("};\n")
 
     with open(output_path, "w", encoding="utf-8") as f:
         f.write("#pragma once\n\n")
@@ -79,140 +116,216 @@ def emit_header(output_path: str, data: dict[str, Any]) -> None:
 
         has_thread = connectivity in {"thread", "wifi_thread"}
         f.write(f"#define APP_NETWORK_CONNECTIVITY_THREAD {1 if has_thread else 0}\n")
-        f.write(f"#define BUTTON_COUNT {button_count}\n")
+        release_ble = network.get("ble_after_commissioning", "keep") == "release"
+        f.write(f"#define APP_BLE_RELEASE_AFTER_COMMISSIONING {1 if release_ble else 0}\n")
+        thread = network.get("thread") or {}
+        f.write(f"#define APP_OT_NETIF_QUEUE_SIZE {int(thread.get('netif_queue_size', 10))}\n")
+        f.write(f"#define APP_OT_TASK_QUEUE_SIZE {int(thread.get('task_queue_size', 10))}\n")
+        power = data.get("power") or {}
+        battery = power.get("source") == "battery"
+        f.write(f"#define APP_POWER_BATTERY {1 if battery else 0}\n")
+        lp_core = power.get("lp_core")
+        f.write(f"#define APP_LP_BUTTON_SCAN {1 if lp_core else 0}\n")
+        f.write(f"#define BUTTON_COUNT {len(buttons)}\n")
+        f.write(f"#define ENCODER_COUNT {len(encoders)}\n")
+        sensors = data.get("sensors") or []
+        f.write(f"#define SENSOR_COUNT {len(sensors)}\n")
+        # Simulated sources are for bench and test builds; no YAML without one compiles them in.
+        sensor_sim = any(sensor.get("source") == "sim" for sensor in sensors)
+        f.write(f"#define APP_SENSOR_SIM {1 if sensor_sim else 0}\n")
         f.write(f"#define LED_STRIP_LED_COUNT {led_strip_count}\n")
+        streaming = (led_strip or {}).get("streaming") if led_strip_count else None
+        f.write(f"#define APP_LED_STREAMING {1 if streaming else 0}\n")
+        power_limit = (led_strip or {}).get("power_limit") if led_strip_count else None
+        f.write(f"#define APP_LED_POWER_LIMIT {1 if power_limit else 0}\n")
+        pwm_light = data.get("pwm_light")
+        f.write(f"#define APP_LIGHT_PWM {1 if pwm_light else 0}\n")
+        light_sync = data.get("light_sync")
+        f.write(f"#define APP_LIGHT_SYNC {1 if light_sync else 0}\n")
         f.write(f"#define FLASH_SIZE_MB {flash_size[:-2]}\n\n")
 
-        f.write("namespace generated_config::button {\n")
-        f.write("struct config_t {\n")
-        f.write("    const char *id;\n")
-        f.write("    int gpio;\n")
-        f.write("    int active_level;\n")
-        f.write("    int long_press_time_ms;\n")
-        f.write("    int short_press_timeout_ms;\n")
-        f.write("    int identify_trigger_count;\n")
-        f.write("    int identify_time_s;\n")
-        f.write("    const char *mode;\n")
-        f.write("    const char *action_cluster;\n")
-        f.write("    const char *action_command;\n")
-        f.write("    int action_identify_time_s;\n")
-        f.write("    uint16_t binding_endpoint;\n")
-        f.write("    uint16_t target_endpoint;\n")
-        f.write("    const char *driver;\n")
-        f.write("};\n\n")
-        f.write(f"inline constexpr size_t count = {button_count};\n")
-        f.write("inline constexpr config_t configs[] = {\n")
-        for button in buttons:
-            id_literal = f'"{cpp_string_literal(button["id"])}"' if button.get("id") else "nullptr"
-            mode_literal = f'"{cpp_string_literal(button.get("mode", "remote"))}"'
-            cluster_literal = f'"{cpp_string_literal(button.get("action_cluster", "on_off"))}"'
-            command_literal = f'"{cpp_string_literal(button.get("action_command", "toggle"))}"'
-            driver_literal = (
-                f'"{cpp_string_literal(button["driver"])}"' if button.get("driver") else "nullptr"
-            )
-            f.write("    {\n")
-            f.write(f"        .id = {id_literal},\n")
-            f.write(f"        .gpio = {button.get('gpio', -1)},\n")
-            f.write(f"        .active_level = {button.get('active_level', 0)},\n")
-            f.write(f"        .long_press_time_ms = {button.get('long_press_time_ms', 5000)},\n")
-            f.write(f"        .short_press_timeout_ms = {button.get('short_press_timeout_ms', 2000)},\n")
-            f.write(f"        .identify_trigger_count = {button.get('identify_trigger_count', 5)},\n")
-            f.write(f"        .identify_time_s = {button.get('identify_time_s', 10)},\n")
-            f.write(f"        .mode = {mode_literal},\n")
-            f.write(f"        .action_cluster = {cluster_literal},\n")
-            f.write(f"        .action_command = {command_literal},\n")
-            f.write(f"        .action_identify_time_s = {button.get('action_identify_time_s', 10)},\n")
-            f.write(
-                f"        .binding_endpoint = static_cast<uint16_t>({button.get('binding_endpoint', 0)}),\n"
-            )
-            f.write(
-                f"        .target_endpoint = static_cast<uint16_t>({button.get('target_endpoint', 0)}),\n"
-            )
-            f.write(f"        .driver = {driver_literal},\n")
-            f.write("    },\n")
+        icd = power.get("icd") or {}
+        f.write("namespace generated_config::power {\n")
+        f.write(f"inline constexpr bool battery = {'true' if battery else 'false'};\n")
+        f.write(f"inline constexpr bool light_sleep = {'true' if power.get('light_sleep') else 'false'};\n")
+        f.write(f"inline constexpr uint32_t standby_budget_mw = {int(power.get('standby_budget_mw', 500))};\n")
+        f.write(f"inline constexpr uint32_t idle_interval_ms = {int(icd.get('idle_interval_s', 300)) * 1000};\n")
+        for key in ("active_interval_ms", "active_threshold_ms", "slow_poll_ms", "fast_poll_ms"):
+            f.write(f"inline constexpr uint32_t {key} = {int(icd.get(key, 0))};\n")
+        f.write("} // namespace generated_config::power\n\n")
+
+        if lp_core:
+            # A press is accepted after this many consecutive pressed scans.
+            period = int(lp_core["scan_period_ms"])
+            samples = -(-int(lp_core["debounce_ms"]) // period)
+            f.write("namespace generated_config::lp_core {\n")
+            f.write(f"inline constexpr uint32_t scan_period_ms = {period};\n")
+            f.write(f"inline constexpr uint32_t debounce_samples = {samples};\n")
+            f.write("} // namespace generated_config::lp_core\n\n")
+
+        if streaming:
+            f.write("namespace generated_config::led_stream {\n")
+            f.write(f"inline constexpr bool e131 = {'true' if streaming['protocol'] == 'e131' else 'false'};\n")
+            f.write(f"inline constexpr uint16_t port = {int(streaming['port'])};\n")
+            f.write(f"inline constexpr uint16_t universe = {int(streaming['universe'])};\n")
+            f.write(f"inline constexpr uint16_t max_fps = {int(streaming['max_fps'])};\n")
+            f.write(f"inline constexpr uint32_t timeout_ms = {int(streaming['timeout_ms'])};\n")
+            f.write("} // namespace generated_config::led_stream\n\n")
+
+        if power_limit:
+            f.write("namespace generated_config::led_power {\n")
+            f.write(f"inline constexpr uint32_t budget_ma = {int(power_limit['budget_ma'])};\n")
+            f.write(f"inline constexpr uint16_t channel_ma = {int(power_limit['channel_ma'])};\n")
+            f.write(f"inline constexpr uint16_t idle_ua = {int(power_limit['idle_ua'])};\n")
+            f.write("} // namespace generated_config::led_power\n\n")
+
+        if pwm_light:
+            f.write("namespace generated_config::pwm_light {\n")
+            f.write("struct channel_t {\n    uint8_t role; // device_modules::light::PwmChannel\n    int8_t gpio;\n};\n")
+            for key in ("frequency_hz", "fade_ms"):
+                f.write(f"inline constexpr uint32_t {key} = {int(pwm_light[key])};\n")
+            f.write(f"inline constexpr uint8_t resolution_bits = {int(pwm_light['resolution_bits'])};\n")
+            for key in ("cool_mireds", "warm_mireds"):
+                f.write(f"inline constexpr uint16_t {key} = {int(pwm_light[key])};\n")
+            f.write(f"inline constexpr size_t channel_count = {len(pwm_light['channels'])};\n")
+            f.write("inline constexpr channel_t channels[] = {\n")
+            for channel in pwm_light["channels"]:
+                role = PWM_CHANNEL_ROLES.index(channel["role"])
+                f.write(f"    {{{role}, {int(channel['gpio'])}}}, // {channel['role']}\n")
+            f.write("};\n")
+            f.write("} // namespace generated_config::pwm_light\n\n")
+
+        if light_sync:
+            f.write("namespace generated_config::light_sync {\n")
+            f.write(f"inline constexpr uint16_t domain = {int(light_sync['domain'])};\n")
+            f.write(f"inline constexpr uint16_t port = {int(light_sync['port'])};\n")
+            f.write(f"inline constexpr uint32_t beacon_interval_ms = {int(light_sync['beacon_interval_ms'])};\n")
+            f.write(f"inline constexpr uint32_t frame_ms = {int(light_sync['frame_ms'])};\n")
+            f.write(f"inline constexpr const char *address = \"{light_sync['address']}\";\n")
+            f.write("} // namespace generated_config::light_sync\n\n")
+
+        policies = data.get("reporting") or []
+        f.write("namespace generated_config::reporting {\n")
+        f.write("struct policy_t {\n    uint32_t cluster_id;\n    uint32_t attribute_id;\n"
+                "    uint32_t min_interval_ms;\n    uint32_t threshold;\n};\n")
+        f.write(f"inline constexpr size_t count = {len(policies)};\n")
+        f.write("inline constexpr policy_t policies[] = {\n")
+        for policy in policies:
+            f.write(f"    {{0x{policy['cluster_id']:04X}, 0x{policy['attribute_id']:04X}, "
+                    f"{policy['min_interval_ms']}, {policy['threshold']}}}, // {policy['cluster']}.{policy['attribute']}\n")
+        if not policies:
+            f.write("    {0, 0, 0, 0}, // placeholder, count is 0\n")
+        f.write("};\n")
+        f.write("} // namespace generated_config::reporting\n\n")
+
+        rules = data.get("rules") or []
+        actions = [action for rule in rules for action in rule["actions"]]
+        f.write("namespace generated_config::rules {\n")
+        f.write("struct action_t {\n    uint8_t kind; // device_modules::rules::Action\n    bool bound;\n"
+                "    uint16_t endpoint; // 0: default light endpoint, or default binding endpoint when bound\n"
+                "    int32_t value;\n    uint16_t group_id;\n};\n")
+        f.write("struct rule_t {\n    const char *name;\n    uint8_t trigger; // device_modules::rules::Trigger\n"
+                "    const char *button;\n    uint8_t gesture; // device_modules::button::Gesture\n"
+                "    uint16_t endpoint;\n    uint32_t cluster_id;\n    uint32_t attribute_id;\n"
+                "    uint8_t compare; // device_modules::rules::Compare\n    int32_t value;\n"
+                "    uint32_t period_ms; // timer period, or how long the attribute condition must hold\n"
+                "    uint16_t first_action;\n    uint8_t action_count;\n};\n")
+        f.write(f"inline constexpr size_t count = {len(rules)};\n")
+        f.write("inline constexpr rule_t rules[] = {\n")
+        first_action = 0
+        for rule in rules:
+            trigger = rule["trigger"]
+            kind = RULE_TRIGGERS.index(trigger["kind"])
+            button = "nullptr"
+            if trigger["kind"] == "button":
+                button = f"\"{layout.cpp_string_literal(trigger['button'])}\""
+            gesture = RULE_GESTURES.get(trigger.get("gesture"), 0)
+            compare = RULE_COMPARES.index(trigger.get("compare", "changed"))
+            f.write(f"    {{\"{layout.cpp_string_literal(rule['name'])}\", {kind}, {button}, {gesture}, "
+                    f"{int(trigger.get('endpoint', 0))}, 0x{trigger.get('cluster_id', 0):04X}, "
+                    f"0x{trigger.get('attribute_id', 0):04X}, {compare}, {int(trigger.get('value', 0))}, "
+                    f"{int(trigger.get('period_ms', 0))}, {first_action}, {len(rule['actions'])}}},\n")
+            first_action += len(rule["actions"])
+        if not rules:
+            f.write("    {\"\", 0, nullptr, 0, 0, 0, 0, 0, 0, 0, 0, 0}, // placeholder, count is 0\n")
+        f.write("};\n")
+        f.write("inline constexpr action_t actions[] = {\n")
+        for action in actions:
+            f.write(f"    {{{RULE_ACTIONS.index(action['kind'])}, {'true' if action['bound'] else 'false'}, "
+                    f"{int(action['endpoint'])}, {int(action['value'])}, {int(action['group_id'])}}}, "
+                    f"// {action['kind']}\n")
+        if not actions:
+            f.write("    {0, false, 0, 0, 0}, // placeholder\n")
         f.write("};\n")
+        f.write("} // namespace generated_config::rules\n\n")
+
+        f.write("namespace generated_config::sensor {\n")
+        f.write("struct sensor_t {\n    uint16_t endpoint;\n    uint8_t kind; // device_modules::sensor::Kind\n"
+                "    uint8_t source; // device_modules::sensor::Source\n    int8_t gpio;\n    bool active_low;\n"
+                "    int32_t adc_mv_min;\n    int32_t adc_mv_max;\n"
+                "    int32_t adc_min; // value at adc_mv_min: 0.01 C, 0.01 %RH or lux\n    int32_t adc_max;\n"
+                "    uint32_t period_ms; // 0: sampled on GPIO edges\n    uint8_t median;\n    uint8_t smoothing;\n"
+                "    int32_t threshold; // units of MeasuredValue\n    int32_t hysteresis;\n"
+                "    uint32_t min_interval_ms;\n    uint32_t max_interval_ms;\n    uint32_t hold_ms;\n};\n")
+        f.write(f"inline constexpr size_t count = {len(sensors)};\n")
+        f.write("inline constexpr sensor_t sensors[] = {\n")
+        for sensor in sensors:
+            adc = sensor["adc"]
+            f.write(f"    {{{int(sensor['endpoint'])}, {SENSOR_KINDS.index(sensor['kind'])}, "
+                    f"{SENSOR_SOURCES.index(sensor['source'])}, {int(sensor['gpio'])}, "
+                    f"{'true' if sensor['active_low'] else 'false'}, {int(adc['mv_min'])}, {int(adc['mv_max'])}, "
+                    f"{int(adc['min'])}, {int(adc['max'])}, {int(sensor['period_ms'])}, {int(sensor['median'])}, "
+                    f"{int(sensor['smoothing'])}, {int(sensor['threshold'])}, {int(sensor['hysteresis'])}, "
+                    f"{int(sensor['min_interval_ms'])}, {int(sensor['max_interval_ms'])}, {int(sensor['hold_ms'])}}}, "
+                    f"// {sensor['kind']} from {sensor['source']}\n")
+        if not sensors:
+            f.write("    {0, 0, 0, -1, false, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0}, // placeholder, count is 0\n")
+        f.write("};\n")
+        f.write("} // namespace generated_config::sensor\n\n")
+
+        f.write("namespace generated_config::button {\n")
+        write_struct("button::config_t")
+        f.write(f"inline constexpr size_t max_count = {layout.MAX_BUTTONS};\n")
+        f.write(f"inline constexpr size_t count = {len(buttons)};\n")
+        write_array("config_t", "configs", buttons)
         f.write("} // namespace generated_config::button\n\n")
 
-        if led_strip_count > 0 and led_strip:
-            f.write("namespace generated_config::led_strip {\n")
-            f.write(f"inline constexpr int rmt_gpio = {int(led_strip.get('rmt_gpio', -1))};\n")
-            led_type = led_strip.get("type", "ws2812")
-            f.write(f'inline constexpr const char *type = "{cpp_string_literal(str(led_type))}";\n')
-            f.write("} // namespace generated_config::led_strip\n\n")
+        f.write("namespace generated_config::encoder {\n")
+        write_struct("encoder::config_t")
+        f.write(f"inline constexpr size_t max_count = {layout.MAX_ENCODERS};\n")
+        f.write(f"inline constexpr size_t count = {len(encoders)};\n")
+        write_array("config_t", "configs", encoders)
+        f.write("} // namespace generated_config::encoder\n\n")
 
         f.write("namespace generated_config {\n\n")
-        f.write(f'inline constexpr const char *device_type = "{cpp_string_literal(device_type)}";\n')
-        f.write(f'inline constexpr const char *device_name = "{cpp_string_literal(device_name)}";\n\n')
-
-        f.write("struct optional_bool {\n    bool has_value;\n    bool value;\n};\n\n")
-        f.write("struct optional_int {\n    bool has_value;\n    int32_t value;\n};\n\n")
-        f.write("struct optional_string {\n    bool has_value;\n    const char *value;\n};\n\n")
-        f.write("struct string_list {\n    size_t count;\n    const char *const *items;\n};\n\n")
-
-        f.write("struct identify_cluster_raw {\n    bool present;\n    optional_bool enabled;\n    optional_int identify_time;\n    optional_int identify_type;\n};\n\n")
-        f.write("struct groups_cluster_raw {\n    bool present;\n    optional_bool enabled;\n};\n\n")
-        f.write("struct scenes_management_cluster_raw {\n    bool present;\n    optional_bool enabled;\n    optional_int scene_table_size;\n};\n\n")
-        f.write("struct on_off_cluster_raw {\n    bool present;\n    optional_bool enabled;\n    optional_bool state;\n    string_list features;\n};\n\n")
-        f.write("struct level_control_cluster_raw {\n    bool present;\n    optional_bool enabled;\n    optional_int current_level;\n    optional_int options;\n    optional_int on_level;\n    string_list features;\n};\n\n")
-        f.write("struct color_control_cluster_raw {\n    bool present;\n    optional_bool enabled;\n    optional_string color_mode;\n    optional_string enhanced_color_mode;\n    optional_int current_hue;\n    optional_int current_saturation;\n    optional_int color_temperature_mireds;\n    optional_int remaining_time;\n    string_list features;\n};\n\n")
-        f.write("struct endpoint_raw {\n    uint16_t id;\n    const char *device_type;\n    identify_cluster_raw identify;\n    groups_cluster_raw groups;\n    scenes_management_cluster_raw scenes_management;\n    on_off_cluster_raw on_off;\n    level_control_cluster_raw level_control;\n    color_control_cluster_raw color_control;\n};\n\n")
-
-        for name, values in feature_arrays:
-            items = ", ".join(f'"{cpp_string_literal(v)}"' for v in values)
-            f.write(f"inline constexpr const char *{name}[] = {{{items}}};\n")
-        if feature_arrays:
-            f.write("\n")
-
-        f.write("inline constexpr endpoint_raw endpoints[] = {\n")
-        for idx, endpoint in enumerate(normalized_endpoints):
-            f.write("    {\n")
-            f.write(f"        .id = {endpoint['id']},\n")
-            f.write(f"        .device_type = \"{cpp_string_literal(endpoint['device_type'])}\",\n")
-            for cluster_name in ("identify", "groups", "scenes_management", "on_off", "level_control", "color_control"):
-                cluster = endpoint[cluster_name]
-                f.write(f"        .{cluster_name} = {{\n")
-                if cluster_name == "identify":
-                    f.write(f"            .present = {'true' if cluster['present'] else 'false'},\n")
-                    f.write(f"            .enabled = {optional_bool_literal(cluster['enabled'])},\n")
-                    f.write(f"            .identify_time = {optional_int_literal(cluster['identify_time'])},\n")
-                    f.write(f"            .identify_type = {optional_int_literal(cluster['identify_type'])},\n")
-                elif cluster_name == "groups":
-                    f.write(f"            .present = {'true' if cluster['present'] else 'false'},\n")
-                    f.write(f"            .enabled = {optional_bool_literal(cluster['enabled'])},\n")
-                elif cluster_name == "scenes_management":
-                    f.write(f"            .present = {'true' if cluster['present'] else 'false'},\n")
-                    f.write(f"            .enabled = {optional_bool_literal(cluster['enabled'])},\n")
-                    f.write(f"            .scene_table_size = {optional_int_literal(cluster['scene_table_size'])},\n")
-                else:
-                    f.write(f"            .present = {'true' if cluster['present'] else 'false'},\n")
-                    f.write(f"            .enabled = {optional_bool_literal(cluster['enabled'])},\n")
-                    if cluster_name == "on_off":
-                        f.write(f"            .state = {optional_bool_literal(cluster['state'])},\n")
-                    elif cluster_name == "level_control":
-                        f.write(f"            .current_level = {optional_int_literal(cluster['current_level'])},\n")
-                        f.write(f"            .options = {optional_int_literal(cluster['options'])},\n")
-                        f.write(f"            .on_level = {optional_int_literal(cluster['on_level'])},\n")
-                    elif cluster_name == "color_control":
-                        f.write(f"            .color_mode = {optional_string_literal(cluster['color_mode'])},\n")
-                        f.write(f"            .enhanced_color_mode = {optional_string_literal(cluster['enhanced_color_mode'])},\n")
-                        f.write(f"            .current_hue = {optional_int_literal(cluster['current_hue'])},\n")
-                        f.write(f"            .current_saturation = {optional_int_literal(cluster['current_saturation'])},\n")
-                        f.write(f"            .color_temperature_mireds = {optional_int_literal(cluster['color_temperature_mireds'])},\n")
-                        f.write(f"            .remaining_time = {optional_int_literal(cluster['remaining_time'])},\n")
-                    features_ref = cluster.get("features_array") or "nullptr"
-                    features_count = cluster.get("features_count", 0)
-                    f.write(f"            .features = {{ {features_count}, {features_ref} }},\n")
-                f.write("        },\n")
-            f.write("    }")
-            if idx < len(normalized_endpoints) - 1:
-                f.write(",")
-            f.write("\n")
-        f.write("};\n\n")
+        for key in ("optional_bool", "optional_int", "optional_string", "string_list",
+                    "identify_cluster_raw", "groups_cluster_raw", "scenes_management_cluster_raw",
+                    "on_off_cluster_raw", "level_control_cluster_raw", "color_control_cluster_raw",
+                    "endpoint_raw", "device_info", "blob_header"):
+            write_struct(key)
+
+        f.write(f"inline constexpr uint32_t blob_magic = 0x{layout.BLOB_MAGIC:08X};\n")
+        f.write(f"inline constexpr uint16_t blob_version = {layout.BLOB_VERSION};\n")
+        f.write(f"inline constexpr uint32_t blob_layout_hash = 0x{layout.layout_hash():08X};\n\n")
+
+        f.write(f"inline constexpr device_info device = {layout.cpp_value(device, 0)};\n\n")
+
+        f.write(f"inline constexpr size_t max_endpoints = {layout.MAX_ENDPOINTS};\n")
+        write_array("endpoint_raw", "endpoints", endpoints)
+        f.write("\n")
 
         f.write("inline constexpr uint8_t num_endpoints = sizeof(endpoints) / sizeof(endpoint_raw);\n\n")
+        f.write("// Bytes reserved for the long-lived esp_matter data model (see model_arena.h).\n")
+        f.write(f"inline constexpr size_t model_arena_size = {estimate_model_arena_size(data.get('endpoints') or [])};\n\n")
         f.write("} // namespace generated_config\n")
 
 
+def emit_blob(output_path: str, data: dict[str, Any]) -> None:
+    blob = layout.pack_blob(data)
+    with open(output_path, "wb") as blob_file:
+        blob_file.write(blob)
+
+
 def find_template(project_root: str, script_dir: str, template_name: str) -> str:
     candidates = [
         os.path.join(project_root, "templates"),
@@ -268,6 +381,55 @@ def _format_kconfig_value(value: Any) -> str:
     return str(value)
 
 
+def battery_kconfig(icd: dict[str, Any]) -> dict[str, Any]:
+    """sdkconfig for a Thread sleepy end device that runs as a Matter ICD."""
+    return {
+        "ENABLE_ICD_SERVER": True,
+        "ENABLE_ICD_CIP": True,
+        # Slow polling beyond 15 s is only allowed for long idle time ICDs.
+        "ENABLE_ICD_LIT": int(icd["slow_poll_ms"]) > 15000,
+        "ICD_IDLE_MODE_INTERVAL_SEC": int(icd["idle_interval_s"]),
+        "ICD_ACTIVE_MODE_INTERVAL_MS": int(icd["active_interval_ms"]),
+        "ICD_ACTIVE_MODE_THRESHOLD_MS": int(icd["active_threshold_ms"]),
+        "ICD_SLOW_POLL_INTERVAL_MS": int(icd["slow_poll_ms"]),
+        "ICD_FAST_POLL_INTERVAL_MS": int(icd["fast_poll_ms"]),
+        "OPENTHREAD_MTD": True,
+        "OPENTHREAD_FTD": False,
+    }
+
+
+def light_sleep_kconfig(connectivity: str) -> dict[str, Any]:
+    """sdkconfig for automatic light sleep with tickless idle."""
+    overrides: dict[str, Any] = {
+        "PM_ENABLE": True,
+        "FREERTOS_USE_TICKLESS_IDLE": True,
+        "PM_SLP_IRAM_OPT": True,
+        "PM_RTOS_IDLE_OPT": True,
+        "ESP_PHY_MAC_BB_PD": True,
+    }
+    if connectivity in {"thread", "wifi_thread"}:
+        overrides["IEEE802154_SLEEP_ENABLE"] = True
+    return overrides
+
+
+def lp_core_kconfig() -> dict[str, Any]:
+    """sdkconfig for the LP core button scanner."""
+    return {
+        "ULP_COPROC_ENABLED": True,
+        "ULP_COPROC_TYPE_LP_CORE": True,
+        "ULP_COPROC_RESERVE_MEM": 8192,
+    }
+
+
+def streaming_kconfig(streaming: dict[str, Any], led_count: int) -> dict[str, Any]:
+    """sdkconfig for receiving pixel frames over UDP."""
+    # Room for two whole frames queued in lwIP while the strip is refreshed.
+    bytes_per_frame = max(led_count, 1) * 4
+    payload = 510 if streaming["protocol"] == "e131" else 1440
+    packets_per_frame = -(-bytes_per_frame // payload)
+    return {"LWIP_UDP_RECVMBOX_SIZE": max(6, min(64, 2 * packets_per_frame + 2))}
+
+
 def apply_kconfig_overrides(config_path: str, overrides: dict[str, Any]) -> None:
     if not os.path.exists(config_path):
         return
@@ -308,12 +470,27 @@ def main() -> None:
     parser.add_argument("normalized_config", help="Path to the normalized YAML produced by parse_config.py.")
     parser.add_argument("output_header", help="Path to the output C++ header file.")
     parser.add_argument("project_root", help="Project root used to locate sdkconfig templates.")
+    parser.add_argument(
+        "--blob",
+        help="Path of the device config partition image (default: device_config.bin next to the header).",
+    )
+    parser.add_argument(
+        "--blob-only",
+        action="store_true",
+        help="Only write the partition image, e.g. to produce per-SKU configs for an existing firmware.",
+    )
     args = parser.parse_args()
 
     with open(args.normalized_config, "r", encoding="utf-8") as normalized_file:
         data = yaml.safe_load(normalized_file) or {}
 
-    os.makedirs(os.path.dirname(os.path.abspath(args.output_header)), exist_ok=True)
+    output_dir = os.path.dirname(os.path.abspath(args.output_header))
+    os.makedirs(output_dir, exist_ok=True)
+    blob_path = args.blob or os.path.join(output_dir, "device_config.bin")
+    emit_blob(blob_path, data)
+    if args.blob_only:
+        print(f"Generated {blob_path} from {args.normalized_config}")
+        return
     emit_header(args.output_header, data)
 
     connectivity = (data.get("network") or {}).get("connectivity", "wifi")
@@ -349,6 +526,20 @@ def main() -> None:
         valid_options = ", ".join(sorted(SDKCONFIG_TEMPLATE_MAP))
         raise ValueError(f"Unsupported connectivity '{connectivity}'. Expected one of: {valid_options}.")
 
+    if connectivity in {"thread", "wifi_thread"}:
+        overrides.update(((data.get("network") or {}).get("thread") or {}).get("kconfig") or {})
+
+    power = data.get("power") or {}
+    if power.get("source") == "battery":
+        overrides.update(battery_kconfig(power.get("icd") or {}))
+    if power.get("light_sleep"):
+        overrides.update(light_sleep_kconfig(connectivity))
+    if power.get("lp_core"):
+        overrides.update(lp_core_kconfig())
+    led_strip = data.get("led_strip") or {}
+    if led_strip.get("streaming"):
+        overrides.update(streaming_kconfig(led_strip["streaming"], int(led_strip.get("led_count", 0))))
+
     apply_kconfig_overrides(sdkconfig_path, overrides)
     print(f"Generated {args.output_header} from {args.normalized_config}")
 
@@ -0,0 +1,118 @@
+import argparse
+import ctypes
+import sys
+from typing import Any
+
+import config_layout as layout
+
+
+def _check_record(cls: type, data: bytes, base: int, path: str, errors: list[str]) -> None:
+    """Checks that strings are NUL-terminated and bools hold 0 or 1, recursively."""
+    for field, ctype in cls._fields_:
+        offset = base + getattr(cls, field).offset
+        name = f"{path}.{field}"
+        if isinstance(ctype, type) and issubclass(ctype, ctypes.Structure):
+            _check_record(ctype, data, offset, name, errors)
+        elif isinstance(ctype, type) and issubclass(ctype, ctypes.Array):
+            _check_array(ctype, data, offset, name, errors)
+        elif ctype is ctypes.c_bool and data[offset] not in (0, 1):
+            errors.append(f"{name}: bool byte is {data[offset]}")
+
+
+def _check_array(ctype: Any, data: bytes, base: int, path: str, errors: list[str]) -> None:
+    if ctype._type_ is ctypes.c_char:
+        if b"\0" not in data[base:base + ctype._length_]:
+            errors.append(f"{path}: string is not NUL-terminated")
+        return
+    stride = ctypes.sizeof(ctype._type_)
+    for i in range(ctype._length_):
+        _check_array(ctype._type_, data, base + i * stride, f"{path}[{i}]", errors)
+
+
+def validate(data: bytes, partition_size: int) -> list[str]:
+    header_size = ctypes.sizeof(layout.BlobHeader)
+    if len(data) < header_size:
+        return [f"blob is {len(data)} bytes, smaller than the {header_size} byte header"]
+
+    header = layout.BlobHeader.from_buffer_copy(data)
+    if header.magic != layout.BLOB_MAGIC:
+        return [f"bad magic 0x{header.magic:08x}"]
+
+    errors = []
+    if header.version != layout.BLOB_VERSION:
+        errors.append(f"version {header.version}, expected {layout.BLOB_VERSION}")
+    if header.header_size != header_size:
+        errors.append(f"header_size {header.header_size}, expected {header_size}")
+    if header.layout_hash != layout.layout_hash():
+        errors.append(f"layout hash 0x{header.layout_hash:08x}, expected 0x{layout.layout_hash():08x}")
+    if header.total_size > partition_size:
+        errors.append(f"total_size {header.total_size} exceeds the {partition_size} byte partition")
+    if header.total_size > len(data):
+        errors.append(f"total_size {header.total_size} exceeds the {len(data)} byte file")
+    if errors:
+        return errors
+
+    crc = layout.blob_crc(data)
+    if crc != header.crc32:
+        errors.append(f"CRC 0x{crc:08x} != 0x{header.crc32:08x}")
+
+    sections = [
+        ("device", header.device_offset, 1, layout.DeviceInfo, 1),
+        ("buttons", header.button_offset, header.button_count, layout.ButtonConfig, layout.MAX_BUTTONS),
+        ("encoders", header.encoder_offset, header.encoder_count, layout.EncoderConfig, layout.MAX_ENCODERS),
+        ("endpoints", header.endpoint_offset, header.endpoint_count, layout.EndpointRaw, layout.MAX_ENDPOINTS),
+    ]
+    for label, offset, count, cls, limit in sections:
+        size = ctypes.sizeof(cls)
+        if count > limit:
+            errors.append(f"{label}: {count} records, at most {limit} supported")
+            continue
+        if offset % 4 or offset < header_size or offset + count * size > header.total_size:
+            errors.append(f"{label}: section at {offset} (+{count}x{size}) is out of range")
+            continue
+        for i in range(count):
+            _check_record(cls, data, offset + i * size, f"{label}[{i}]", errors)
+    return errors
+
+
+def summarize(data: bytes) -> str:
+    header = layout.BlobHeader.from_buffer_copy(data)
+    device = layout.DeviceInfo.from_buffer_copy(data, header.device_offset)
+    lines = [
+        f"device: {device.device_name.decode()} ({device.device_type.decode()})",
+        f"size: {header.total_size} bytes, crc32 0x{header.crc32:08x}, layout 0x{header.layout_hash:08x}",
+    ]
+    for i in range(header.endpoint_count):
+        endpoint = layout.EndpointRaw.from_buffer_copy(data, header.endpoint_offset + i * ctypes.sizeof(layout.EndpointRaw))
+        lines.append(f"endpoint {endpoint.id}: {endpoint.device_type.decode()}")
+    for i in range(header.button_count):
+        button = layout.ButtonConfig.from_buffer_copy(data, header.button_offset + i * ctypes.sizeof(layout.ButtonConfig))
+        lines.append(f"button {button.id.decode()}: gpio {button.gpio}")
+    for i in range(header.encoder_count):
+        encoder = layout.EncoderConfig.from_buffer_copy(data, header.encoder_offset + i * ctypes.sizeof(layout.EncoderConfig))
+        lines.append(f"encoder {encoder.id.decode()}: gpio {encoder.gpio_a}/{encoder.gpio_b}")
+    return "\n".join(lines)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Validate a device config blob before flashing it to the devcfg partition.")
+    parser.add_argument("blob", help="Path to the blob produced by render_config.py")
+    parser.add_argument("--partition-size", type=lambda v: int(v, 0), default=layout.DEVCFG_PARTITION_SIZE,
+                        help="Size of the devcfg partition (default: 0x1000)")
+    args = parser.parse_args()
+
+    with open(args.blob, "rb") as f:
+        data = f.read()
+
+    errors = validate(data, args.partition_size)
+    if errors:
+        for error in errors:
+            print(f"error: {error}", file=sys.stderr)
+        return 1
+
+    print(summarize(data))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())